@@ -0,0 +1,20 @@
+/**
+ * Module hooks for running src/ under plain Node
+ *
+ * The sources use extensionless relative imports and ESM syntax in .js files,
+ * both of which only the bundler resolves.
+ */
+
+const SRC_URL = new URL('../../src/', import.meta.url).href;
+const HAS_EXTENSION = /\.[cm]?js$/;
+
+export const resolve = async (specifier, context, nextResolve) => {
+  const fromSrc = context.parentURL && context.parentURL.startsWith(SRC_URL);
+  if (fromSrc && specifier.startsWith('.') && !HAS_EXTENSION.test(specifier)) {
+    return nextResolve(`${specifier}.js`, context);
+  }
+  return nextResolve(specifier, context);
+};
+
+export const load = async (url, context, nextLoad) =>
+  nextLoad(url, url.startsWith(SRC_URL) ? { ...context, format: 'module' } : context);
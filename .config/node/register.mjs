@@ -0,0 +1,9 @@
+/**
+ * Lets Node import the app sources as the bundler sees them
+ * Usage: node --import ./.config/node/register.mjs ...
+ * or import it before the first dynamic import of src/ (worker threads)
+ */
+
+import { register } from 'node:module';
+
+register('./hooks.mjs', import.meta.url);
@@ -0,0 +1,130 @@
+#!/usr/bin/env bash
+#
+# Reproducible build of the trimmed PDFium wasm used for decrypt-and-save
+#
+# Produces public/pdfium-$VARIANT.wasm. It is driven by the JS glue shipped in
+# @embedpdf/pdfium, so it is built with the same Emscripten release and
+# runtime settings as that package and only narrows what gets compiled and
+# exported. The general-purpose public/pdfium.wasm stays in place as the
+# fallback (see src/utils/pdfiumVariants.js). The memory64 variant is the
+# exception: the package glue only drives wasm32 modules, so its own glue is
+# kept as public/pdfium-memory64.js (bound in src/utils/pdfiumMemory64.js).
+#
+# Requirements: git, python3, a Linux host; depot_tools and emsdk are fetched
+# into $WORK_DIR on first run.
+#
+# Usage: npm run build:pdfium
+#        VARIANT=simd npm run build:pdfium
+#        VARIANT=memory64 npm run build:pdfium
+
+set -euo pipefail
+
+CONFIG_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT_DIR="$(cd "$CONFIG_DIR/../.." && pwd)"
+WORK_DIR="${WORK_DIR:-$ROOT_DIR/.pdfium-build}"
+
+# Keep these in step with the @embedpdf/pdfium version in package.json
+PDFIUM_REVISION="${PDFIUM_REVISION:-chromium/7390}"
+EMSDK_VERSION="${EMSDK_VERSION:-4.0.10}"
+EMBEDPDF_REF="${EMBEDPDF_REF:-main}"
+
+VARIANT="${VARIANT:-lite}"
+OUT_FILE="$ROOT_DIR/public/pdfium-$VARIANT.wasm"
+OUT_DIR="$WORK_DIR/pdfium/out/$VARIANT"
+GLUE_FILE=""
+
+# lite: smallest download. simd: same profile compiled with wasm SIMD128 and -O3
+# so the inflate/deflate, checksum and copy loops vectorize; it is only served
+# to browsers that validate a SIMD module (src/utils/pdfiumVariants.js).
+# memory64: 64-bit pointers and heap, for documents past the wasm32 2 GiB heap
+# and 4 GiB FPDF_FILEACCESS limits; only loaded for those documents, in
+# browsers that validate a memory64 module.
+# Threads are left out: they need cross-origin isolation, which GitHub Pages
+# cannot provide.
+case "$VARIANT" in
+  lite)
+    OPT_LEVEL="-Oz"
+    OPTIMIZE_FOR_SIZE=true
+    ;;
+  simd)
+    OPT_LEVEL="-O3"
+    OPTIMIZE_FOR_SIZE=false
+    # Picked up by every emcc/em++ invocation, including the GN/ninja compile
+    export EMCC_CFLAGS="-msimd128 ${EMCC_CFLAGS:-}"
+    EXTRA_WASM_OPT_FLAGS="--enable-simd ${EXTRA_WASM_OPT_FLAGS:-}"
+    ;;
+  memory64)
+    OPT_LEVEL="-O3"
+    OPTIMIZE_FOR_SIZE=false
+    export EMCC_CFLAGS="-sMEMORY64=1 ${EMCC_CFLAGS:-}"
+    EXTRA_CFLAGS="-sMAXIMUM_MEMORY=16GB ${EXTRA_CFLAGS:-}"
+    EXTRA_WASM_OPT_FLAGS="--enable-memory64 ${EXTRA_WASM_OPT_FLAGS:-}"
+    GLUE_FILE="$ROOT_DIR/public/pdfium-$VARIANT.js"
+    ;;
+  *)
+    echo "Unknown VARIANT: $VARIANT (expected lite, simd or memory64)" >&2
+    exit 1
+    ;;
+esac
+
+mkdir -p "$WORK_DIR"
+cd "$WORK_DIR"
+
+echo "==> Toolchains"
+[ -d depot_tools ] || git clone --depth 1 https://chromium.googlesource.com/chromium/tools/depot_tools.git
+[ -d emsdk ] || git clone --depth 1 https://github.com/emscripten-core/emsdk.git
+export PATH="$WORK_DIR/depot_tools:$PATH"
+./emsdk/emsdk install "$EMSDK_VERSION"
+./emsdk/emsdk activate "$EMSDK_VERSION"
+# shellcheck disable=SC1091
+source ./emsdk/emsdk_env.sh
+
+echo "==> PDFium $PDFIUM_REVISION"
+if [ ! -d pdfium ]; then
+  gclient config --unmanaged https://pdfium.googlesource.com/pdfium.git
+  echo "target_os = [ 'wasm' ]" >> .gclient
+fi
+gclient sync -r "pdfium@$PDFIUM_REVISION" --no-history --shallow
+
+# The wasm toolchain patches and the PDFiumExt helpers come from the package source
+[ -d embed-pdf-viewer ] || git clone --depth 1 --branch "$EMBEDPDF_REF" \
+  https://github.com/embedpdf/embed-pdf-viewer.git
+EMBEDPDF_PKG="$WORK_DIR/embed-pdf-viewer/packages/pdfium"
+(cd pdfium && git reset --hard -q && git apply "$EMBEDPDF_PKG"/build/patches/*.patch)
+
+echo "==> Compile ($VARIANT)"
+mkdir -p "$OUT_DIR"
+sed "s/^optimize_for_size = .*/optimize_for_size = $OPTIMIZE_FOR_SIZE/" \
+  "$CONFIG_DIR/args.gn" > "$OUT_DIR/args.gn"
+echo "target_os = \"wasm\"" >> "$OUT_DIR/args.gn"
+echo "target_cpu = \"wasm\"" >> "$OUT_DIR/args.gn"
+if [ -n "${EXTRA_GN_ARGS:-}" ]; then echo "$EXTRA_GN_ARGS" >> "$OUT_DIR/args.gn"; fi
+(cd pdfium && gn gen "$OUT_DIR" && ninja -C "$OUT_DIR" pdfium)
+
+echo "==> Link"
+EXPORTS="$(paste -sd, "$CONFIG_DIR/exports.txt")"
+# shellcheck disable=SC2086
+em++ "$OPT_LEVEL" -flto ${EXTRA_CFLAGS:-} \
+  -I pdfium/public \
+  "$EMBEDPDF_PKG"/src/*.cpp \
+  "$OUT_DIR/obj/libpdfium.a" \
+  -o "$OUT_DIR/pdfium.js" \
+  -sEXPORTED_FUNCTIONS="$EXPORTS" \
+  -sEXPORTED_RUNTIME_METHODS=cwrap,ccall,addFunction,removeFunction,wasmExports \
+  -sALLOW_TABLE_GROWTH=1 \
+  -sALLOW_MEMORY_GROWTH=1 \
+  -sMODULARIZE=1 \
+  -sEXPORT_ES6=1 \
+  -sENVIRONMENT=web,worker,node \
+  -sFILESYSTEM=0 \
+  -sASSERTIONS=0 \
+  -Wl,--gc-sections
+
+echo "==> Optimize"
+# shellcheck disable=SC2086
+wasm-opt "$OPT_LEVEL" --strip-debug --strip-producers ${EXTRA_WASM_OPT_FLAGS:-} \
+  "$OUT_DIR/pdfium.wasm" -o "$OUT_FILE"
+if [ -n "$GLUE_FILE" ]; then cp "$OUT_DIR/pdfium.js" "$GLUE_FILE"; fi
+
+echo "==> Done"
+ls -l "$ROOT_DIR/public/pdfium.wasm" "$OUT_FILE" ${GLUE_FILE:+"$GLUE_FILE"}
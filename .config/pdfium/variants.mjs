@@ -0,0 +1,37 @@
+/**
+ * Specialized PDFium builds from build.sh, next to the general-purpose pdfium.wasm
+ *
+ * Shared by the bundle (rspack.common.mjs), which ships the ones present in
+ * public/, and the Node CLI, which loads them from there.
+ */
+
+import crypto from 'crypto';
+import fs from 'fs';
+import path from 'path';
+
+const PDFIUM_WASM_VARIANTS = [
+  { name: 'simd', file: 'pdfium-simd.wasm', features: ['simd'] },
+  { name: 'lite', file: 'pdfium-lite.wasm' },
+  // Only for documents past the wasm32 limits; ships its own Emscripten glue
+  {
+    name: 'memory64',
+    file: 'pdfium-memory64.wasm',
+    glue: 'pdfium-memory64.js',
+    features: ['memory64'],
+    largeDocuments: true,
+  },
+];
+
+// Content hash of a shipped engine build, used as its persistent wasm cache key
+export const hashFile = (file) =>
+  crypto.createHash('sha256').update(fs.readFileSync(file)).digest('hex').slice(0, 16);
+
+/**
+ * Variants built into `dir`, with their content hashes
+ * @param {string} dir - Directory holding the builds (public/)
+ * @returns {Array<Object>} Entries in the PDFIUM_WASM_VARIANTS format of pdfiumVariants.js
+ */
+export const findPdfiumWasmVariants = (dir) =>
+  PDFIUM_WASM_VARIANTS.filter(({ file }) => fs.existsSync(path.join(dir, file))).map(
+    (variant) => ({ ...variant, hash: hashFile(path.join(dir, variant.file)) }),
+  );
@@ -1,11 +1,19 @@
 import { rspack } from '@rspack/core';
 import path from 'path';
+import { findPdfiumWasmVariants, hashFile } from '../pdfium/variants.mjs';
+
+const publicPath = '/pdf-password-remover/';
+
+const pdfiumWasmHash = hashFile(path.resolve(process.cwd(), 'public/pdfium.wasm'));
+
+// Specialized builds from .config/pdfium/build.sh, shipped only when present
+const pdfiumWasmVariants = findPdfiumWasmVariants(path.resolve(process.cwd(), 'public'));
 
 export default {
   entry: path.resolve(process.cwd(), 'src/index.jsx'),
   output: {
     filename: 'static/[name].[contenthash].js',
-    publicPath: '/pdf-password-remover/',
+    publicPath,
     clean: true,
   },
   resolve: {
@@ -61,7 +69,18 @@ export default {
   },
   plugins: [
     new rspack.CopyRspackPlugin({
-      patterns: [{ from: 'public/pdfium.wasm' }],
+      patterns: [
+        { from: 'public/pdfium.wasm' },
+        ...pdfiumWasmVariants.flatMap(({ file, glue }) =>
+          [file, glue].filter(Boolean).map((name) => ({ from: `public/${name}` })),
+        ),
+      ],
+    }),
+    new rspack.DefinePlugin({
+      // The engine loads its builds from the bundle, not from an absolute URL
+      'process.env.PDFIUM_WASM_BASE_URL': JSON.stringify(publicPath),
+      'process.env.PDFIUM_WASM_HASH': JSON.stringify(pdfiumWasmHash),
+      'process.env.PDFIUM_WASM_VARIANTS': JSON.stringify(JSON.stringify(pdfiumWasmVariants)),
     }),
   ],
 };
@@ -1,4 +1,5 @@
 import path from 'path';
+import zlib from 'zlib';
 import { RspackManifestPlugin } from 'rspack-manifest-plugin';
 import WorkboxPlugin from 'workbox-webpack-plugin';
 import FaviconsRspackPlugin from 'favicons-rspack-plugin';
@@ -7,7 +8,16 @@ import HtmlWebpackPlugin from 'html-webpack-plugin';
 import common from './rspack.common.mjs';
 import rspack from '@rspack/core';
 
-export default () => {
+// First-paint budget for the initial chunks. The engine (pdfiumRemover and the
+// @embedpdf/pdfium glue) lives in the worker chunk and the PDF parser in an
+// on-demand chunk; neither counts here
+const INITIAL_BUNDLE_BUDGET = 320 * 1024;
+const LAZY_CHUNK_BUDGET = 1024 * 1024;
+
+/**
+ * @param {Object} [env] - From `--env`; `budget` turns the size hints into errors
+ */
+export default (env = {}) => {
   const config = {
     ...common,
     mode: process.env.NODE_ENV === 'development' ? 'development' : 'production',
@@ -35,14 +45,41 @@ export default () => {
       new CompressionPlugin({
         filename: '[path][base].gz',
       }),
+      // Precompressed Brotli copies, served in place of the originals where the host negotiates
+      // them; the wasm builds are the bulk of the download
+      new CompressionPlugin({
+        filename: '[path][base].br',
+        algorithm: 'brotliCompress',
+        test: /\.(js|css|html|svg|wasm)$/,
+        compressionOptions: { params: { [zlib.constants.BROTLI_PARAM_QUALITY]: 11 } },
+      }),
       new RspackManifestPlugin({}),
-      new WorkboxPlugin.GenerateSW(),
+      new WorkboxPlugin.GenerateSW({
+        // Compressed copies are for the server. The wasm builds are kept by the engine's own
+        // content-addressed cache (pdfiumWasmLoader.js), so they are not precached as well;
+        // the large-document glue is cached on first use
+        exclude: [/\.map$/, /^manifest.*\.js$/, /\.(gz|br)$/, /\.wasm$/, /pdfium-memory64\./],
+        runtimeCaching: [
+          {
+            urlPattern: /pdfium-memory64\.js$/,
+            handler: 'CacheFirst',
+            options: { cacheName: 'pdfium-large-documents' },
+          },
+        ],
+      }),
     ],
     optimization: {
       splitChunks: {
         chunks: 'all',
       },
     },
+    performance: {
+      hints: env.budget ? 'error' : 'warning',
+      maxEntrypointSize: INITIAL_BUNDLE_BUDGET,
+      maxAssetSize: LAZY_CHUNK_BUDGET,
+      // Code only: the wasm builds, their glue and the compressed copies are not parsed on load
+      assetFilter: (file) => /\.(js|css)$/.test(file) && !path.basename(file).startsWith('pdfium'),
+    },
   };
 
   return config;
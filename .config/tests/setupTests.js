@@ -31,6 +31,9 @@ jest.mock('@embedpdf/pdfium', () => ({
           // Return a mock document pointer if binary is valid
           return wasmBinary && wasmBinary.byteLength > 0 ? 12345 : null;
         }),
+        FPDF_LoadCustomDocument: jest.fn((fileAccessPtr, password) => {
+          return wasmBinary && wasmBinary.byteLength > 0 ? 12345 : null;
+        }),
         FPDF_GetLastError: jest.fn(() => 0),
         FPDF_GetPageCount: jest.fn((docPtr) => {
           return docPtr ? 1 : 0;
@@ -45,6 +48,9 @@ jest.mock('@embedpdf/pdfium', () => ({
         // Return a mock document pointer if binary is valid
         return wasmBinary && wasmBinary.byteLength > 0 ? 12345 : null;
       }),
+      FPDF_LoadCustomDocument: jest.fn((fileAccessPtr, password) => {
+        return wasmBinary && wasmBinary.byteLength > 0 ? 12345 : null;
+      }),
       FPDF_GetLastError: jest.fn(() => 0),
       FPDF_GetPageCount: jest.fn((docPtr) => {
         return docPtr ? 1 : 0;
@@ -57,6 +63,30 @@ jest.mock('@embedpdf/pdfium', () => ({
   }),
 }));
 
+// Replace the real worker with an in-process fake that runs the worker handler
+// against the mocked PDFium module above (jsdom has no Worker support)
+jest.mock('../../src/utils/createPdfiumWorker', () => ({
+  createPdfiumWorker: jest.fn(() => {
+    const { createPdfiumWorkerHandler } = jest.requireActual(
+      '../../src/utils/pdfiumWorkerHandler',
+    );
+
+    const worker = {
+      onmessage: null,
+      onerror: null,
+      terminate: jest.fn(),
+    };
+    const handleMessage = createPdfiumWorkerHandler((message) => {
+      if (worker.onmessage) worker.onmessage({ data: message });
+    });
+    worker.postMessage = jest.fn((message) => {
+      handleMessage({ data: message });
+    });
+
+    return worker;
+  }),
+}));
+
 // Mock fetch for WebAssembly and other HTTP requests
 global.fetch = jest.fn((url) => {
   // Mock pdfium.wasm request
@@ -83,6 +113,14 @@ global.fetch = jest.fn((url) => {
   return Promise.reject(new Error(`Unmocked fetch: ${url}`));
 });
 
+// Web platform APIs the security-strip engine (src/utils/pdf) relies on that jsdom lacks
+if (typeof global.TextEncoder === 'undefined') {
+  global.TextEncoder = require('util').TextEncoder;
+}
+if (typeof global.DecompressionStream === 'undefined') {
+  global.DecompressionStream = require('stream/web').DecompressionStream;
+}
+
 // Mock URL.createObjectURL and URL.revokeObjectURL
 global.URL.createObjectURL = jest.fn((blob) => {
   return `blob:http://localhost/${Math.random()}`;
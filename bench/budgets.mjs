@@ -0,0 +1,26 @@
+/**
+ * Regression budgets for bench/compare.mjs
+ *
+ * Each budget is the slowdown (or growth) a metric may show against the
+ * baseline before the comparison fails. Timed metrics are also allowed their
+ * measured noise: the larger relative spread (max - min over median) of the
+ * baseline's and the current samples, times NOISE_MULTIPLIER. `minDeltaMs`
+ * keeps millisecond jitter on tiny stages from counting as a regression.
+ *
+ * `files` overrides the per-file budgets by corpus file name, e.g.
+ * `{ 'aes-128-100mb': { throughput: { maxDecrease: 0.25 } } }`.
+ */
+
+export const NOISE_MULTIPLIER = 1.5;
+
+export default {
+  // public/pdfium.wasm; deterministic, so no noise allowance
+  wasmBytes: { maxIncrease: 0.05 },
+  // Module fetch + compile + instantiate, median over the cold PDFium jobs
+  coldStart: { maxIncrease: 0.25, minDeltaMs: 20 },
+  // Decrypt MB/s per corpus file and engine
+  throughput: { maxDecrease: 0.15, minDeltaMs: 5 },
+  // Wall time of every other stage (read, init) per corpus file and engine
+  stages: { maxIncrease: 0.3, minDeltaMs: 5 },
+  files: {},
+};
@@ -0,0 +1,261 @@
+/**
+ * Benchmark regression gate
+ *
+ * Compares a bench run (run.mjs --json) with a stored baseline of the same
+ * corpus and fails when a metric regresses past its budget (budgets.mjs): the
+ * size of public/pdfium.wasm, the module's cold start, decrypt throughput per MB
+ * for every corpus file and engine, and the wall time of the other stages.
+ * Metrics only one side has are listed and skipped, so the corpus can grow.
+ *
+ * Timings only compare within one machine, so the baseline is machine-local
+ * (under the ignored .bench/) and recorded with --update. Without one the gate
+ * is skipped, or fails with --require-baseline (e.g. on a runner that restores
+ * its baseline from a cache).
+ *
+ * Usage: npm run bench:compare -- [results.json] [--baseline .bench/baseline.json]
+ *                                 [--json bench-results/bench-compare.json]
+ *                                 [--require-baseline]
+ *        npm run bench:compare -- [results.json] --update   # adopt as the baseline
+ */
+
+import fs from 'fs';
+import path from 'path';
+import { parseArgs } from 'util';
+import budgets, { NOISE_MULTIPLIER } from './budgets.mjs';
+
+const MB = 1024 * 1024;
+
+const { values: options, positionals } = parseArgs({
+  allowPositionals: true,
+  options: {
+    baseline: { type: 'string', default: '.bench/baseline.json' },
+    json: { type: 'string' },
+    update: { type: 'boolean', default: false },
+    'require-baseline': { type: 'boolean', default: false },
+  },
+});
+const resultsFile = positionals[0] || 'bench-results/bench-results.json';
+
+const readResults = (file) => {
+  const data = JSON.parse(fs.readFileSync(file, 'utf-8'));
+  if (data.version !== 1) throw new Error(`${file}: unsupported results version ${data.version}`);
+  return data;
+};
+
+const median = (values) => {
+  const sorted = [...values].sort((a, b) => a - b);
+  const middle = sorted.length >> 1;
+  return sorted.length % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+};
+
+// Relative spread of a set of samples; 0 when there are too few to tell
+const spread = (samples = []) =>
+  samples.length < 2 ? 0 : (Math.max(...samples) - Math.min(...samples)) / median(samples);
+
+/**
+ * Judge one metric
+ * `worse` is the relative regression (positive when the current run is worse);
+ * it may reach the budget, or the measured noise if that is larger
+ */
+const judge = ({ metric, subject, unit, baseline, current, worse, budget, noise = 0 }) => {
+  const limit = Math.max(budget, NOISE_MULTIPLIER * noise);
+  return { metric, subject, unit, baseline, current, worse, limit, regressed: worse > limit };
+};
+
+const budgetFor = (metric, file) => ({
+  ...budgets[metric],
+  ...(file && budgets.files[file] && budgets.files[file][metric]),
+});
+
+// Time metric: slower is worse, by more than the budget's minDeltaMs
+const judgeTime = ({ metric, subject, file, baseline, current, noise }) => {
+  const budget = budgetFor(metric, file);
+  const check = judge({
+    metric,
+    subject,
+    unit: 'ms',
+    baseline,
+    current,
+    worse: current / baseline - 1,
+    budget: budget.maxIncrease,
+    noise,
+  });
+  return { ...check, regressed: check.regressed && current - baseline > (budget.minDeltaMs ?? 0) };
+};
+
+const keyOf = (result) => `${result.file}/${result.engine}`;
+
+const throughputOf = (result) => result.sizeBytes / MB / (result.stages.decrypt.medianMs / 1000);
+
+const compare = (baseline, current) => {
+  const checks = [];
+  const skipped = [];
+
+  if (baseline.wasmBytes && current.wasmBytes) {
+    checks.push(
+      judge({
+        metric: 'wasmBytes',
+        subject: 'public/pdfium.wasm',
+        unit: 'bytes',
+        baseline: baseline.wasmBytes,
+        current: current.wasmBytes,
+        worse: current.wasmBytes / baseline.wasmBytes - 1,
+        budget: budgetFor('wasmBytes').maxIncrease,
+      }),
+    );
+  } else {
+    skipped.push('wasmBytes: public/pdfium.wasm missing from a run');
+  }
+
+  // Every PDFium job starts a fresh process, so each one is a cold start
+  const coldStarts = (data) =>
+    data.results
+      .filter((result) => result.ok && result.init && result.init.totalMs !== undefined)
+      .map((result) => result.init.totalMs);
+  const baseStarts = coldStarts(baseline);
+  const currentStarts = coldStarts(current);
+  if (baseStarts.length && currentStarts.length) {
+    checks.push(
+      judgeTime({
+        metric: 'coldStart',
+        subject: 'PDFium init',
+        baseline: median(baseStarts),
+        current: median(currentStarts),
+        noise: Math.max(spread(baseStarts), spread(currentStarts)),
+      }),
+    );
+  } else {
+    skipped.push('coldStart: no PDFium jobs on one side');
+  }
+
+  const baseResults = new Map(baseline.results.map((result) => [keyOf(result), result]));
+  for (const result of current.results) {
+    const key = keyOf(result);
+    const base = baseResults.get(key);
+    baseResults.delete(key);
+    if (!base || !base.ok) {
+      skipped.push(`${key}: no baseline result`);
+      continue;
+    }
+    if (!result.ok) {
+      checks.push({ metric: 'run', subject: key, regressed: true, error: result.error });
+      continue;
+    }
+
+    const budget = budgetFor('throughput', result.file);
+    const baseDecrypt = base.stages.decrypt;
+    const decrypt = result.stages.decrypt;
+    const check = judge({
+      metric: 'throughput',
+      subject: key,
+      unit: 'MB/s',
+      baseline: throughputOf(base),
+      current: throughputOf(result),
+      worse: 1 - throughputOf(result) / throughputOf(base),
+      budget: budget.maxDecrease,
+      noise: Math.max(spread(baseDecrypt.ms), spread(decrypt.ms)),
+    });
+    // The same file, so time lost is what the throughput drop costs
+    const lostMs = decrypt.medianMs - baseDecrypt.medianMs;
+    checks.push({ ...check, regressed: check.regressed && lostMs > (budget.minDeltaMs ?? 0) });
+
+    for (const [stage, timing] of Object.entries(result.stages)) {
+      if (stage === 'decrypt' || !base.stages[stage]) continue;
+      checks.push(
+        judgeTime({
+          metric: 'stages',
+          subject: `${key} ${stage}`,
+          file: result.file,
+          baseline: base.stages[stage].medianMs,
+          current: timing.medianMs,
+          noise: Math.max(spread(base.stages[stage].ms), spread(timing.ms)),
+        }),
+      );
+    }
+  }
+  baseResults.forEach((_, key) => skipped.push(`${key}: not in this run`));
+
+  return { checks, skipped };
+};
+
+const formatValue = (value, unit) => {
+  if (value === undefined) return '-';
+  if (unit === 'bytes') return `${(value / 1024).toFixed(1)} kB`;
+  return `${value.toFixed(1)} ${unit}`;
+};
+
+const formatPercent = (ratio) => `${ratio >= 0 ? '+' : ''}${(ratio * 100).toFixed(1)}%`;
+
+const printChecks = (checks) => {
+  console.log(
+    `${'metric'.padEnd(11)} ${'subject'.padEnd(34)} ${'baseline'.padStart(12)} ` +
+      `${'current'.padStart(12)} ${'worse'.padStart(8)} ${'limit'.padStart(8)}`,
+  );
+  for (const check of checks) {
+    const columns = check.error
+      ? [check.metric.padEnd(11), check.subject.padEnd(34), `FAILED: ${check.error}`]
+      : [
+          check.metric.padEnd(11),
+          check.subject.padEnd(34),
+          formatValue(check.baseline, check.unit).padStart(12),
+          formatValue(check.current, check.unit).padStart(12),
+          formatPercent(check.worse).padStart(8),
+          formatPercent(check.limit).padStart(8),
+          check.regressed ? 'REGRESSION' : '',
+        ];
+    console.log(columns.join(' ').trimEnd());
+  }
+};
+
+const main = () => {
+  const current = readResults(resultsFile);
+
+  if (options.update) {
+    fs.mkdirSync(path.dirname(path.resolve(options.baseline)), { recursive: true });
+    fs.writeFileSync(options.baseline, `${JSON.stringify(current, null, 2)}\n`);
+    console.log(`Baseline ${options.baseline} updated from ${resultsFile} (${current.commit})`);
+    return;
+  }
+
+  if (!fs.existsSync(options.baseline)) {
+    const record =
+      `record one on this machine with npm run bench:compare -- ${resultsFile} --update`;
+    if (options['require-baseline']) {
+      console.error(`No baseline at ${options.baseline}; ${record}`);
+      process.exitCode = 1;
+    } else {
+      console.warn(`Benchmark gate skipped: no baseline at ${options.baseline}; ${record}`);
+    }
+    return;
+  }
+  const baseline = readResults(options.baseline);
+
+  console.log(`Baseline ${baseline.commit} (${baseline.createdAt}), current ${current.commit}\n`);
+  if (baseline.node !== current.node || baseline.platform !== current.platform) {
+    console.warn(
+      `Runs differ in environment (${baseline.node} ${baseline.platform} vs ` +
+        `${current.node} ${current.platform}); timings may not be comparable\n`,
+    );
+  }
+
+  const { checks, skipped } = compare(baseline, current);
+  printChecks(checks);
+  if (skipped.length) console.log(`\nSkipped:\n${skipped.map((line) => `  ${line}`).join('\n')}`);
+
+  const regressions = checks.filter((check) => check.regressed);
+  console.log(
+    regressions.length
+      ? `\n${regressions.length} of ${checks.length} checks regressed`
+      : `\nAll ${checks.length} checks within budget`,
+  );
+
+  if (options.json) {
+    fs.mkdirSync(path.dirname(path.resolve(options.json)), { recursive: true });
+    const report = { baseline: baseline.commit, current: current.commit, checks, skipped };
+    fs.writeFileSync(options.json, `${JSON.stringify(report, null, 2)}\n`);
+  }
+
+  if (regressions.length) process.exitCode = 1;
+};
+
+main();
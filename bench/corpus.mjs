@@ -0,0 +1,375 @@
+/**
+ * Benchmark corpus
+ *
+ * Synthetic encrypted PDFs covering every standard security handler revision
+ * the app meets in practice (RC4 40/128-bit, AES-128, AES-256), with and
+ * without object streams, from 1 MB to 500 MB. Pages carry uncompressed image
+ * XObjects so size scales with page count the way scanned documents do.
+ *
+ * Files are generated on first use into .bench/corpus and reused afterwards;
+ * the generator is deterministic, so every machine benchmarks the same bytes.
+ */
+
+import fs from 'fs';
+import path from 'path';
+import crypto from 'crypto';
+import zlib from 'zlib';
+
+export const USER_PASSWORD = 'bench-user';
+export const OWNER_PASSWORD = 'bench-owner';
+
+// Bump when the generated bytes change, so stale corpora are rebuilt
+const GENERATOR_VERSION = 1;
+export const CORPUS_DIR = path.resolve(process.cwd(), `.bench/corpus/v${GENERATOR_VERSION}`);
+
+const MB = 1024 * 1024;
+const IMAGE_SIDE = 512; // 8-bit gray, 256 kB per page
+const OBJECTS_PER_STREAM = 100;
+const PERMISSIONS = -3904;
+
+const PASSWORD_PADDING = Buffer.from(
+  '28bf4e5e4e758a4164004e56fffa01082e2e00b6d0683e802f0ca9fe6453697a',
+  'hex',
+);
+
+export const SCHEMES = {
+  'rc4-40': { V: 1, R: 2, keyBytes: 5, method: 'rc4' },
+  'rc4-128': { V: 2, R: 3, keyBytes: 16, method: 'rc4' },
+  'aes-128': { V: 4, R: 4, keyBytes: 16, method: 'aesv2' },
+  'aes-256': { V: 5, R: 6, keyBytes: 32, method: 'aesv3' },
+};
+
+const CORPUS = [
+  ...Object.keys(SCHEMES).flatMap((scheme) => [1, 10].map((sizeMb) => ({ scheme, sizeMb }))),
+  { scheme: 'aes-128', sizeMb: 100 },
+  { scheme: 'aes-256', sizeMb: 100 },
+  { scheme: 'aes-128', sizeMb: 500 },
+  { scheme: 'rc4-128', sizeMb: 1, objectStreams: true },
+  { scheme: 'aes-128', sizeMb: 1, objectStreams: true },
+  { scheme: 'aes-128', sizeMb: 10, objectStreams: true },
+  { scheme: 'aes-128', sizeMb: 100, objectStreams: true },
+].map((entry) => ({
+  ...entry,
+  objectStreams: Boolean(entry.objectStreams),
+  name: `${entry.scheme}${entry.objectStreams ? '-objstm' : ''}-${entry.sizeMb}mb`,
+}));
+
+/**
+ * Corpus entries, optionally narrowed
+ * @param {Object} [options]
+ * @param {number} [options.maxSizeMb] - Skip files above this size
+ * @param {string} [options.filter] - Substring of the entry name
+ */
+export const getCorpus = ({ maxSizeMb = Infinity, filter } = {}) =>
+  CORPUS.filter((entry) => entry.sizeMb <= maxSizeMb && (!filter || entry.name.includes(filter)));
+
+// Deterministic byte source (AES-CTR keystream), so reruns produce identical files
+const createByteSource = (seed) => {
+  const key = crypto.createHash('sha256').update(seed).digest().subarray(0, 16);
+  const cipher = crypto.createCipheriv('aes-128-ctr', key, Buffer.alloc(16));
+  return (length) => cipher.update(Buffer.alloc(length));
+};
+
+const md5 = (...parts) => crypto.createHash('md5').update(Buffer.concat(parts)).digest();
+const sha = (algorithm, ...parts) =>
+  crypto.createHash(algorithm).update(Buffer.concat(parts)).digest();
+
+// Node's OpenSSL build may not ship RC4
+const rc4 = (key, data) => {
+  const state = Uint8Array.from({ length: 256 }, (_, i) => i);
+  for (let i = 0, j = 0; i < 256; i++) {
+    j = (j + state[i] + key[i % key.length]) & 0xff;
+    [state[i], state[j]] = [state[j], state[i]];
+  }
+  const out = Buffer.alloc(data.length);
+  for (let k = 0, i = 0, j = 0; k < data.length; k++) {
+    i = (i + 1) & 0xff;
+    j = (j + state[i]) & 0xff;
+    [state[i], state[j]] = [state[j], state[i]];
+    out[k] = data[k] ^ state[(state[i] + state[j]) & 0xff];
+  }
+  return out;
+};
+
+const aesCbc = (key, iv, data) => {
+  const cipher = crypto.createCipheriv(`aes-${key.length * 8}-cbc`, key, iv);
+  return Buffer.concat([iv, cipher.update(data), cipher.final()]);
+};
+
+const aesNoPadding = (mode, key, iv, data) => {
+  const cipher = crypto.createCipheriv(mode, key, iv);
+  cipher.setAutoPadding(false);
+  return Buffer.concat([cipher.update(data), cipher.final()]);
+};
+
+const padPassword = (password) =>
+  Buffer.concat([Buffer.from(password, 'latin1'), PASSWORD_PADDING]).subarray(0, 32);
+
+const xorKey = (key, value) => key.map((byte) => byte ^ value);
+
+// Algorithms 2-5: RC4 and AESV2 handlers
+const createLegacyHandler = ({ V, R, keyBytes, method }, id) => {
+  let ownerHash = md5(padPassword(OWNER_PASSWORD));
+  if (R >= 3) for (let i = 0; i < 50; i++) ownerHash = md5(ownerHash);
+  const ownerKey = ownerHash.subarray(0, keyBytes);
+  let owner = rc4(ownerKey, padPassword(USER_PASSWORD));
+  if (R >= 3) for (let i = 1; i <= 19; i++) owner = rc4(xorKey(ownerKey, i), owner);
+
+  const permissions = Buffer.alloc(4);
+  permissions.writeInt32LE(PERMISSIONS);
+  let fileKey = md5(padPassword(USER_PASSWORD), owner, permissions, id).subarray(0, keyBytes);
+  if (R >= 3) for (let i = 0; i < 50; i++) fileKey = md5(fileKey).subarray(0, keyBytes);
+
+  let user;
+  if (R === 2) {
+    user = rc4(fileKey, PASSWORD_PADDING);
+  } else {
+    user = rc4(fileKey, md5(PASSWORD_PADDING, id));
+    for (let i = 1; i <= 19; i++) user = rc4(xorKey(fileKey, i), user);
+    user = Buffer.concat([user, Buffer.alloc(16)]);
+  }
+
+  const cryptFilters =
+    method === 'aesv2'
+      ? ' /CF << /StdCF << /CFM /AESV2 /AuthEvent /DocOpen /Length 16 >> >> /StmF /StdCF /StrF /StdCF'
+      : '';
+  const dict =
+    `/Filter /Standard /V ${V} /R ${R} /Length ${keyBytes * 8}${cryptFilters}` +
+    ` /O <${owner.toString('hex')}> /U <${user.toString('hex')}> /P ${PERMISSIONS}`;
+
+  const objectKey = (num, gen) => {
+    const suffix = Buffer.from([num, num >> 8, num >> 16, gen, gen >> 8]);
+    const salt = method === 'aesv2' ? Buffer.from('sAlT') : Buffer.alloc(0);
+    return md5(fileKey, suffix, salt).subarray(0, Math.min(keyBytes + 5, 16));
+  };
+  return { dict, objectKey };
+};
+
+// Algorithm 2.B (revision 6 password hash)
+const hardenedHash = (password, salt, userKey) => {
+  let key = sha('sha256', password, salt, userKey);
+  for (let round = 0; ; round++) {
+    const block = Buffer.concat([password, key, userKey]);
+    const repeated = Buffer.concat(Array(64).fill(block));
+    const encrypted = aesNoPadding('aes-128-cbc', key.subarray(0, 16), key.subarray(16, 32), repeated);
+    const remainder = encrypted.subarray(0, 16).reduce((sum, byte) => sum + byte, 0) % 3;
+    key = sha(['sha256', 'sha384', 'sha512'][remainder], encrypted);
+    if (round >= 63 && encrypted[encrypted.length - 1] <= round - 31) break;
+  }
+  return key.subarray(0, 32);
+};
+
+// Algorithms 8-10: AESV3 handler
+const createModernHandler = (randomBytes) => {
+  const fileKey = randomBytes(32);
+  const userPassword = Buffer.from(USER_PASSWORD, 'utf8');
+  const ownerPassword = Buffer.from(OWNER_PASSWORD, 'utf8');
+  const noIv = Buffer.alloc(16);
+
+  const [userValidation, userKeySalt] = [randomBytes(8), randomBytes(8)];
+  const user = Buffer.concat([
+    hardenedHash(userPassword, userValidation, Buffer.alloc(0)),
+    userValidation,
+    userKeySalt,
+  ]);
+  const userKey = hardenedHash(userPassword, userKeySalt, Buffer.alloc(0));
+  const userEncrypted = aesNoPadding('aes-256-cbc', userKey, noIv, fileKey);
+
+  const [ownerValidation, ownerKeySalt] = [randomBytes(8), randomBytes(8)];
+  const owner = Buffer.concat([
+    hardenedHash(ownerPassword, ownerValidation, user),
+    ownerValidation,
+    ownerKeySalt,
+  ]);
+  const ownerKey = hardenedHash(ownerPassword, ownerKeySalt, user);
+  const ownerEncrypted = aesNoPadding('aes-256-cbc', ownerKey, noIv, fileKey);
+
+  const permsPlain = Buffer.concat([Buffer.alloc(4), Buffer.from([0xff, 0xff, 0xff, 0xff])]);
+  permsPlain.writeInt32LE(PERMISSIONS);
+  const permsBlock = Buffer.concat([permsPlain, Buffer.from('Tadb'), randomBytes(4)]);
+  const perms = aesNoPadding('aes-256-ecb', fileKey, null, permsBlock);
+
+  const dict =
+    '/Filter /Standard /V 5 /R 6 /Length 256' +
+    ' /CF << /StdCF << /CFM /AESV3 /AuthEvent /DocOpen /Length 32 >> >> /StmF /StdCF /StrF /StdCF' +
+    ` /O <${owner.toString('hex')}> /U <${user.toString('hex')}>` +
+    ` /OE <${ownerEncrypted.toString('hex')}> /UE <${userEncrypted.toString('hex')}>` +
+    ` /P ${PERMISSIONS} /Perms <${perms.toString('hex')}>`;
+  return { dict, objectKey: () => fileKey };
+};
+
+const createEncryptor = (scheme, id, randomBytes) => {
+  const { method } = SCHEMES[scheme];
+  const handler =
+    method === 'aesv3' ? createModernHandler(randomBytes) : createLegacyHandler(SCHEMES[scheme], id);
+  const encrypt = (num, gen, data) => {
+    const key = handler.objectKey(num, gen);
+    return method === 'rc4' ? rc4(key, data) : aesCbc(key, randomBytes(16), data);
+  };
+  return { dict: handler.dict, encrypt };
+};
+
+// Sequential file writer that records object offsets
+const createFileWriter = (file) => {
+  const fd = fs.openSync(file, 'w');
+  const offsets = new Map();
+  let position = 0;
+  const write = (data) => {
+    const buffer = typeof data === 'string' ? Buffer.from(data, 'latin1') : data;
+    fs.writeSync(fd, buffer);
+    position += buffer.length;
+  };
+  return {
+    write,
+    get position() {
+      return position;
+    },
+    offsets,
+    object: (num, body) => {
+      offsets.set(num, position);
+      write(`${num} 0 obj\n${body}\nendobj\n`);
+    },
+    stream: (num, dict, data) => {
+      offsets.set(num, position);
+      write(`${num} 0 obj\n<< ${dict} /Length ${data.length} >>\nstream\n`);
+      write(data);
+      write('\nendstream\nendobj\n');
+    },
+    close: () => fs.closeSync(fd),
+  };
+};
+
+const hex = (buffer) => `<${buffer.toString('hex')}>`;
+
+/**
+ * Write one corpus file
+ * @param {{name: string, scheme: string, sizeMb: number, objectStreams: boolean}} entry
+ * @param {string} file - Output path
+ */
+export const generateCorpusFile = (entry, file) => {
+  const randomBytes = createByteSource(entry.name);
+  const id = randomBytes(16);
+  const { dict: encryptDict, encrypt } = createEncryptor(entry.scheme, id, randomBytes);
+  const imageBytes = IMAGE_SIDE * IMAGE_SIDE;
+  const pageCount = Math.max(1, Math.round((entry.sizeMb * MB) / imageBytes));
+
+  // 1 catalog, 2 pages, 3 info, 4 font, then page/content/image triples
+  const pageNum = (index) => 5 + index * 3;
+  const encryptNum = pageNum(pageCount);
+  const plainObjects = [];
+  const writer = createFileWriter(file);
+  writer.write('%PDF-1.7\n%\xe2\xe3\xcf\xd3\n');
+
+  // Non-stream objects go straight out, or into object streams (whose strings stay plain)
+  const addObject = (num, body) => {
+    if (entry.objectStreams) plainObjects.push([num, body]);
+    else writer.object(num, body);
+  };
+  const addStream = (num, dict, data) => writer.stream(num, dict, encrypt(num, 0, data));
+
+  const kids = Array.from({ length: pageCount }, (_, i) => `${pageNum(i)} 0 R`).join(' ');
+  addObject(1, '<< /Type /Catalog /Pages 2 0 R >>');
+  addObject(2, `<< /Type /Pages /Kids [${kids}] /Count ${pageCount} >>`);
+  const title = encrypt(3, 0, Buffer.from(`Benchmark ${entry.name}`));
+  const producer = encrypt(3, 0, Buffer.from('pdf-password-remover bench'));
+  writer.object(3, `<< /Title ${hex(title)} /Producer ${hex(producer)} >>`);
+  addObject(4, '<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>');
+
+  for (let i = 0; i < pageCount; i++) {
+    const num = pageNum(i);
+    addObject(
+      num,
+      '<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792]' +
+        ` /Resources << /Font << /F1 4 0 R >> /XObject << /Im0 ${num + 2} 0 R >> >>` +
+        ` /Contents ${num + 1} 0 R >>`,
+    );
+    const content = `q 400 0 0 400 106 300 cm /Im0 Do Q BT /F1 24 Tf 72 720 Td (Page ${i + 1}) Tj ET`;
+    addStream(num + 1, '/Filter /FlateDecode', zlib.deflateSync(content));
+    addStream(
+      num + 2,
+      `/Type /XObject /Subtype /Image /Width ${IMAGE_SIDE} /Height ${IMAGE_SIDE}` +
+        ' /ColorSpace /DeviceGray /BitsPerComponent 8',
+      randomBytes(imageBytes),
+    );
+  }
+  writer.object(encryptNum, `<< ${encryptDict} >>`);
+
+  const trailer = `/Root 1 0 R /Info 3 0 R /Encrypt ${encryptNum} 0 R /ID [${hex(id)} ${hex(id)}]`;
+  if (!entry.objectStreams) {
+    const size = encryptNum + 1;
+    const xrefOffset = writer.position;
+    const rows = Array.from({ length: size }, (_, num) =>
+      num === 0
+        ? '0000000000 65535 f\r\n'
+        : `${String(writer.offsets.get(num)).padStart(10, '0')} 00000 n\r\n`,
+    );
+    writer.write(`xref\n0 ${size}\n${rows.join('')}`);
+    writer.write(`trailer\n<< /Size ${size} ${trailer} >>\nstartxref\n${xrefOffset}\n%%EOF\n`);
+    writer.close();
+    return;
+  }
+
+  const compressed = new Map();
+  let streamNum = encryptNum + 1;
+  for (let start = 0; start < plainObjects.length; start += OBJECTS_PER_STREAM, streamNum++) {
+    const batch = plainObjects.slice(start, start + OBJECTS_PER_STREAM);
+    const header = [];
+    const bodies = [];
+    let offset = 0;
+    batch.forEach(([num, body], index) => {
+      compressed.set(num, [streamNum, index]);
+      header.push(`${num} ${offset}`);
+      bodies.push(body);
+      offset += body.length + 1;
+    });
+    const headerText = `${header.join(' ')}\n`;
+    const data = zlib.deflateSync(Buffer.from(headerText + bodies.join('\n'), 'latin1'));
+    addStream(
+      streamNum,
+      `/Type /ObjStm /N ${batch.length} /First ${headerText.length} /Filter /FlateDecode`,
+      data,
+    );
+  }
+
+  // Cross-reference stream (never encrypted), W [1 4 2]
+  const xrefNum = streamNum;
+  const size = xrefNum + 1;
+  writer.offsets.set(xrefNum, writer.position);
+  const rows = Buffer.alloc(size * 7);
+  for (let num = 0; num < size; num++) {
+    const row = num * 7;
+    if (compressed.has(num)) {
+      const [stream, index] = compressed.get(num);
+      rows.writeUInt8(2, row);
+      rows.writeUInt32BE(stream, row + 1);
+      rows.writeUInt16BE(index, row + 5);
+    } else if (writer.offsets.has(num)) {
+      rows.writeUInt8(1, row);
+      rows.writeUInt32BE(writer.offsets.get(num), row + 1);
+    } else {
+      rows.writeUInt16BE(0xffff, row + 5);
+    }
+  }
+  const xrefOffset = writer.position;
+  writer.stream(
+    xrefNum,
+    `/Type /XRef /Size ${size} /W [1 4 2] ${trailer} /Filter /FlateDecode`,
+    zlib.deflateSync(rows),
+  );
+  writer.write(`startxref\n${xrefOffset}\n%%EOF\n`);
+  writer.close();
+};
+
+/**
+ * Path of a corpus file, generating it when missing
+ */
+export const ensureCorpusFile = (entry) => {
+  const file = path.join(CORPUS_DIR, `${entry.name}.pdf`);
+  if (!fs.existsSync(file)) {
+    fs.mkdirSync(CORPUS_DIR, { recursive: true });
+    const partial = `${file}.partial`;
+    generateCorpusFile(entry, partial);
+    fs.renameSync(partial, file);
+  }
+  return file;
+};
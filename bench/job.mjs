@@ -0,0 +1,103 @@
+/**
+ * One benchmark job: a corpus file through one engine, in a fresh process
+ *
+ * Runs as a child of run.mjs so every job starts cold and its wasm heap
+ * high-water mark belongs to that file alone (wasm memory never shrinks).
+ * Reports through process.send.
+ */
+
+import fs from 'fs';
+import path from 'path';
+import { pathToFileURL } from 'url';
+
+const PUBLIC_DIR = path.resolve(process.cwd(), 'public');
+
+// pdfiumRemover loads the build the app ships, read from public/ as a file: URL
+// (see pdfiumWasmLoader.js); set before the import, which reads it once
+process.env.PDFIUM_WASM_BASE_URL = pathToFileURL(PUBLIC_DIR).href + '/';
+
+const { getPdfiumInitMetrics, initPdfium, removeSecurity } = await import(
+  '../src/utils/pdfiumRemover.js'
+);
+
+let wasmMemory = null;
+
+const readMemory = () => {
+  const { heapUsed, arrayBuffers } = process.memoryUsage();
+  return {
+    jsHeapBytes: heapUsed,
+    arrayBufferBytes: arrayBuffers,
+    wasmHeapBytes: wasmMemory ? wasmMemory.buffer.byteLength : 0,
+  };
+};
+
+const median = (values) => {
+  const sorted = [...values].sort((a, b) => a - b);
+  const middle = sorted.length >> 1;
+  return sorted.length % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+};
+
+// Wall time of `run` per sample, plus the largest memory reading taken after each
+const measure = async (samples, run) => {
+  const ms = [];
+  const peak = { jsHeapBytes: 0, arrayBufferBytes: 0, wasmHeapBytes: 0 };
+  let result;
+  for (let i = 0; i < samples; i++) {
+    const start = performance.now();
+    result = await run();
+    ms.push(Math.round((performance.now() - start) * 1000) / 1000);
+    // Read before collecting, so the stage's own allocations still count
+    for (const [key, value] of Object.entries(readMemory())) peak[key] = Math.max(peak[key], value);
+    if (globalThis.gc) globalThis.gc();
+  }
+  return { stage: { ms, medianMs: median(ms), minMs: Math.min(...ms), ...peak }, result };
+};
+
+const readSource = async (file) => {
+  // Same shape File.arrayBuffer() hands the app: an exactly sized ArrayBuffer
+  const buffer = await fs.promises.readFile(file);
+  return buffer.byteOffset === 0 && buffer.byteLength === buffer.buffer.byteLength
+    ? buffer.buffer
+    : buffer.buffer.slice(buffer.byteOffset, buffer.byteOffset + buffer.byteLength);
+};
+
+const checkOutput = (output) => {
+  if (!(output instanceof ArrayBuffer)) throw new Error('No output produced');
+  const header = String.fromCharCode(...new Uint8Array(output, 0, 5));
+  if (header !== '%PDF-') throw new Error('Output is not a PDF');
+  return output.byteLength;
+};
+
+const runJob = async ({ file, engine, password, runs }) => {
+  const stages = {};
+  const read = await measure(1, () => readSource(file));
+  stages.read = read.stage;
+  const source = read.result;
+
+  let init = null;
+  if (engine === 'pdfium') {
+    const { stage, result } = await measure(1, () => initPdfium());
+    wasmMemory = result.pdfium.wasmExports.memory;
+    stages.init = stage;
+    init = getPdfiumInitMetrics();
+  }
+
+  const decrypt = await measure(runs, () => removeSecurity(source, password, { mode: engine }));
+  stages.decrypt = decrypt.stage;
+
+  return {
+    stages,
+    init,
+    outputBytes: checkOutput(decrypt.result),
+    peakRssBytes: process.resourceUsage().maxRSS * 1024,
+  };
+};
+
+process.once('message', async (job) => {
+  try {
+    process.send({ ok: true, ...(await runJob(job)) });
+  } catch (err) {
+    process.send({ ok: false, error: err.message });
+  }
+  process.disconnect();
+});
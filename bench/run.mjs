@@ -0,0 +1,135 @@
+/**
+ * Decrypt pipeline benchmark
+ *
+ * Runs the real removeSecurity (same pdfium.wasm the app ships, from public/)
+ * over the corpus in Node, one fresh process per file and engine, and reports
+ * wall time, wasm heap and JS heap per stage.
+ *
+ * Usage: npm run bench -- [--max-size 10] [--filter aes-128] [--engines pdfium,strip]
+ *                         [--runs 3] [--json bench-results/bench-results.json]
+ */
+
+import fs from 'fs';
+import path from 'path';
+import { fork, execSync } from 'child_process';
+import { parseArgs } from 'util';
+import { ensureCorpusFile, getCorpus, USER_PASSWORD } from './corpus.mjs';
+
+const ENGINES = ['pdfium', 'strip'];
+const REGISTER_URL = new URL('../.config/node/register.mjs', import.meta.url).href;
+const MB = 1024 * 1024;
+
+const { values: options } = parseArgs({
+  options: {
+    'max-size': { type: 'string' },
+    filter: { type: 'string' },
+    engines: { type: 'string', default: ENGINES.join(',') },
+    runs: { type: 'string', default: '3' },
+    json: { type: 'string' },
+  },
+});
+
+const engines = options.engines.split(',').filter(Boolean);
+const unknown = engines.filter((engine) => !ENGINES.includes(engine));
+if (unknown.length) throw new Error(`Unknown engine ${unknown.join(', ')}`);
+
+const runJob = (job) =>
+  new Promise((resolve) => {
+    const child = fork(new URL('./job.mjs', import.meta.url), {
+      execArgv: ['--expose-gc', '--import', REGISTER_URL],
+      stdio: ['ignore', 'ignore', 'inherit', 'ipc'],
+    });
+    let report = null;
+    child.on('message', (message) => {
+      report = message;
+    });
+    child.on('exit', (code) =>
+      resolve(report || { ok: false, error: `Job exited with code ${code} before reporting` }),
+    );
+    child.send(job);
+  });
+
+const readCommit = () => {
+  try {
+    return execSync('git rev-parse --short HEAD', { encoding: 'utf-8' }).trim();
+  } catch {
+    return null;
+  }
+};
+
+const formatMb = (bytes) => (bytes ? (bytes / MB).toFixed(1) : '-');
+const formatMs = (stage) => (stage ? stage.medianMs.toFixed(1) : '-');
+
+const printRow = (result) => {
+  if (!result.ok) {
+    console.log(`${result.file.padEnd(24)} ${result.engine.padEnd(7)} FAILED: ${result.error}`);
+    return;
+  }
+  const { read, init, decrypt } = result.stages;
+  const throughput = result.sizeBytes / MB / (decrypt.medianMs / 1000);
+  console.log(
+    [
+      result.file.padEnd(24),
+      result.engine.padEnd(7),
+      formatMs(read).padStart(9),
+      formatMs(init).padStart(9),
+      formatMs(decrypt).padStart(11),
+      throughput.toFixed(1).padStart(8),
+      formatMb(decrypt.wasmHeapBytes).padStart(10),
+      formatMb(decrypt.jsHeapBytes + decrypt.arrayBufferBytes).padStart(9),
+    ].join(' '),
+  );
+};
+
+const main = async () => {
+  const corpus = getCorpus({
+    maxSizeMb: options['max-size'] ? Number(options['max-size']) : Infinity,
+    filter: options.filter,
+  });
+  const runs = Math.max(1, Number(options.runs) || 1);
+
+  console.log(
+    `${'file'.padEnd(24)} ${'engine'.padEnd(7)}   read ms   init ms  decrypt ms     MB/s` +
+      '  wasm heap   JS heap',
+  );
+
+  const results = [];
+  for (const entry of corpus) {
+    const file = ensureCorpusFile(entry);
+    const sizeBytes = fs.statSync(file).size;
+    for (const engine of engines) {
+      const report = await runJob({ file, engine, password: USER_PASSWORD, runs });
+      const result = {
+        file: entry.name,
+        scheme: entry.scheme,
+        objectStreams: entry.objectStreams,
+        sizeBytes,
+        engine,
+        ...report,
+      };
+      printRow(result);
+      results.push(result);
+    }
+  }
+
+  if (options.json) {
+    const wasmFile = path.resolve(process.cwd(), 'public/pdfium.wasm');
+    const output = {
+      version: 1,
+      createdAt: new Date().toISOString(),
+      commit: readCommit(),
+      node: process.version,
+      platform: `${process.platform}-${process.arch}`,
+      runs,
+      wasmBytes: fs.existsSync(wasmFile) ? fs.statSync(wasmFile).size : null,
+      results,
+    };
+    fs.mkdirSync(path.dirname(path.resolve(options.json)), { recursive: true });
+    fs.writeFileSync(options.json, `${JSON.stringify(output, null, 2)}\n`);
+    console.log(`\nResults written to ${options.json}`);
+  }
+
+  if (results.some((result) => !result.ok)) process.exitCode = 1;
+};
+
+await main();
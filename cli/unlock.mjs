@@ -0,0 +1,198 @@
+/**
+ * Headless bulk unlock: every PDF under a directory, in parallel across cores
+ *
+ * Each worker thread (worker.mjs) hosts one PDFium instance from public/ and
+ * takes one file at a time, so memory stays bounded by the number of workers
+ * rather than the size of the run. Results are written under --out with the
+ * same relative paths; a file only appears there once it is complete.
+ *
+ * The password file holds one candidate per line; the empty password is always
+ * tried last. Each file is key-checked against every candidate before it is
+ * decrypted once, with the one that verifies.
+ *
+ * Usage: npm run unlock -- <dir> --passwords passwords.txt --out <dir>
+ *                          [--jobs 8] [--mode auto|strip|pdfium] [--compact] [--linearize]
+ *                          [--json report.json]
+ */
+
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { parseArgs } from 'util';
+import { fileURLToPath, pathToFileURL } from 'url';
+import { Worker } from 'worker_threads';
+import { findPdfiumWasmVariants } from '../.config/pdfium/variants.mjs';
+
+const MODES = ['auto', 'strip', 'pdfium'];
+const MB = 1024 * 1024;
+const PUBLIC_DIR = fileURLToPath(new URL('../public', import.meta.url));
+
+const {
+  values: options,
+  positionals: [inputDir],
+} = parseArgs({
+  allowPositionals: true,
+  options: {
+    passwords: { type: 'string', short: 'p' },
+    out: { type: 'string', short: 'o' },
+    jobs: { type: 'string', short: 'j', default: String(os.availableParallelism()) },
+    mode: { type: 'string', default: 'auto' },
+    linearize: { type: 'boolean', default: false },
+    compact: { type: 'boolean', default: false },
+    json: { type: 'string' },
+  },
+});
+
+if (!inputDir || !options.passwords || !options.out) {
+  throw new Error('Usage: unlock <dir> --passwords <file> --out <dir> [--jobs N] [--mode auto]');
+}
+if (!MODES.includes(options.mode)) throw new Error(`Unknown mode ${options.mode}`);
+
+// The workers load the same builds the app ships, from disk (see pdfiumVariants.js)
+process.env.PDFIUM_WASM_BASE_URL = pathToFileURL(PUBLIC_DIR).href + '/';
+process.env.PDFIUM_WASM_VARIANTS = JSON.stringify(findPdfiumWasmVariants(PUBLIC_DIR));
+
+const readPasswords = (file) => {
+  const lines = fs.readFileSync(file, 'utf-8').split(/\r?\n/).filter(Boolean);
+  return [...new Set([...lines, ''])];
+};
+
+const listPdfs = (dir, outDir) =>
+  fs
+    .readdirSync(dir, { recursive: true, withFileTypes: true })
+    .filter((entry) => entry.isFile() && /\.pdf$/i.test(entry.name))
+    .map((entry) => path.join(entry.parentPath ?? entry.path, entry.name))
+    .filter((file) => !file.startsWith(outDir + path.sep))
+    .sort();
+
+const formatMs = (ms) => (ms === undefined ? '-' : ms.toFixed(1));
+
+const printRow = (result) => {
+  if (!result.ok) {
+    console.log(`${result.file.padEnd(40)} FAILED: ${result.error}`);
+    return;
+  }
+  const throughput = result.bytesIn / MB / (result.ms / 1000);
+  console.log(
+    [
+      result.file.padEnd(40),
+      result.engine.padEnd(11),
+      formatMs(result.ms).padStart(9),
+      (result.bytesIn / MB).toFixed(1).padStart(8),
+      throughput.toFixed(1).padStart(8),
+      String(result.passwordIndex < 0 ? '-' : result.passwordIndex + 1).padStart(9),
+    ].join(' '),
+  );
+};
+
+const spawnWorker = () => new Worker(new URL('./worker.mjs', import.meta.url));
+
+// One file in flight per worker; a worker whose heap outgrew its work is replaced
+const runAll = (jobs, workerCount, onResult) =>
+  new Promise((resolve) => {
+    let next = 0;
+    let running = 0;
+
+    const start = (worker) => {
+      if (next >= jobs.length) {
+        worker.terminate();
+        if (running === 0) resolve();
+        return;
+      }
+      const job = jobs[next];
+      next += 1;
+      running += 1;
+
+      const onError = (err) => finish({ ok: false, error: err.message, crashed: true });
+      const finish = (reply) => {
+        running -= 1;
+        worker.off('message', finish);
+        worker.off('error', onError);
+        onResult(job, reply);
+        if (reply.recycle || reply.crashed) {
+          worker.terminate();
+          start(spawnWorker());
+        } else {
+          start(worker);
+        }
+      };
+      worker.once('message', finish);
+      worker.once('error', onError);
+      worker.postMessage({ id: next, ...job.message });
+    };
+
+    for (let i = 0; i < workerCount; i++) start(spawnWorker());
+  });
+
+const main = async () => {
+  const dir = path.resolve(inputDir);
+  const outDir = path.resolve(options.out);
+  const passwords = readPasswords(options.passwords);
+  const files = listPdfs(dir, outDir);
+  const workerCount = Math.max(1, Math.min(Number(options.jobs) || 1, files.length));
+
+  console.log(`${files.length} files, ${workerCount} workers, ${passwords.length} passwords\n`);
+  console.log(
+    `${'file'.padEnd(40)} ${'engine'.padEnd(11)}     total ms      MB     MB/s  password`,
+  );
+
+  const jobs = files.map((file) => {
+    const relative = path.relative(dir, file);
+    const output = path.join(outDir, relative);
+    fs.mkdirSync(path.dirname(output), { recursive: true });
+    return {
+      relative,
+      output,
+      // Written under a temporary name and moved into place once complete
+      message: {
+        input: file,
+        output: `${output}.partial`,
+        passwords,
+        mode: options.mode,
+        linearize: options.linearize,
+        compact: options.compact,
+      },
+    };
+  });
+
+  const results = [];
+  const runStart = performance.now();
+  await runAll(jobs, workerCount, (job, { id, recycle, crashed, ...reply }) => {
+    if (reply.ok) {
+      fs.renameSync(job.message.output, job.output);
+    } else {
+      fs.rmSync(job.message.output, { force: true });
+    }
+    const result = { file: job.relative, ...reply };
+    printRow(result);
+    results.push(result);
+  });
+  const totalMs = performance.now() - runStart;
+
+  const failed = results.filter((result) => !result.ok).length;
+  console.log(
+    `\n${results.length - failed} unlocked, ${failed} failed in ${(totalMs / 1000).toFixed(1)} s`,
+  );
+
+  if (options.json) {
+    const output = {
+      version: 1,
+      createdAt: new Date().toISOString(),
+      node: process.version,
+      platform: `${process.platform}-${process.arch}`,
+      workers: workerCount,
+      mode: options.mode,
+      linearize: options.linearize,
+      compact: options.compact,
+      totalMs,
+      results,
+    };
+    fs.mkdirSync(path.dirname(path.resolve(options.json)), { recursive: true });
+    fs.writeFileSync(options.json, `${JSON.stringify(output, null, 2)}\n`);
+    console.log(`Results written to ${options.json}`);
+  }
+
+  if (failed > 0) process.exitCode = 1;
+};
+
+await main();
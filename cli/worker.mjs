@@ -0,0 +1,152 @@
+/**
+ * CLI worker thread: one PDFium instance, one file at a time
+ *
+ * Runs the same removeSecurity as the app's web worker. Inputs are opened with
+ * fs.openAsBlob, so they stream into the wasm heap (or, past the planner's
+ * on-demand threshold, are read through the file descriptor) without a JS
+ * copy. PDFium hands over its output synchronously from inside
+ * FPDF_SaveAsCopy, where an fs.WriteStream could not drain, so WriteBlock
+ * chunks are coalesced and written straight through the descriptor.
+ *
+ * Protocol (worker_threads messages):
+ * - job:    { id, input, output, passwords, mode, linearize, compact }
+ * - result: { id, ok, engine, passwordIndex, bytesIn, bytesOut, ms, spans, error?, recycle? }
+ */
+
+import fs from 'fs';
+import { parentPort } from 'worker_threads';
+import '../.config/node/register.mjs';
+
+const { isPdfiumRecycleDue, removeSecurity } = await import('../src/utils/pdfiumRemover.js');
+const { registerFileRangeReader } = await import('../src/utils/pdfiumFileAccess.js');
+const { checkPasswords, readEncryption } = await import('../src/utils/pdf/encryption.js');
+
+const OUTPUT_BLOCK_SIZE = 1024 * 1024;
+
+// Positional writes, coalesced into OUTPUT_BLOCK_SIZE blocks
+const createFileWriter = (fd) => {
+  const block = new Uint8Array(OUTPUT_BLOCK_SIZE);
+  let used = 0;
+  let position = 0;
+
+  const writeAll = (bytes) => {
+    for (let offset = 0; offset < bytes.length; ) {
+      offset += fs.writeSync(fd, bytes, offset, bytes.length - offset, position + offset);
+    }
+    position += bytes.length;
+  };
+  const flush = () => {
+    writeAll(block.subarray(0, used));
+    used = 0;
+  };
+
+  return {
+    write: (chunk) => {
+      if (used + chunk.length > OUTPUT_BLOCK_SIZE) flush();
+      if (chunk.length >= OUTPUT_BLOCK_SIZE) {
+        writeAll(chunk);
+        return;
+      }
+      block.set(chunk, used);
+      used += chunk.length;
+    },
+    flush,
+    // Drop what a failed attempt wrote
+    reset: () => {
+      used = 0;
+      position = 0;
+      fs.ftruncateSync(fd, 0);
+    },
+    get size() {
+      return position + used;
+    },
+  };
+};
+
+// Last password that opened a file; vendors reuse theirs, so it is tried first
+let lastPassword = null;
+
+/**
+ * Candidates in the order to try them, and the index of the one the key check
+ * verified (-1 when none does, null when the check cannot tell)
+ */
+const rankPasswords = async (source, passwords) => {
+  const ordered = passwords.includes(lastPassword)
+    ? [lastPassword, ...passwords.filter((password) => password !== lastPassword)]
+    : passwords;
+  try {
+    const encryption = await readEncryption(source);
+    // Not encrypted: the engines pass the file through
+    if (!encryption) return { encrypted: false, ordered: [''], index: 0 };
+    return { encrypted: true, ordered, index: await checkPasswords(encryption, ordered) };
+  } catch {
+    // Malformed trailers or handlers the key check does not support: try each candidate
+    return { encrypted: true, ordered, index: null };
+  }
+};
+
+const isPasswordError = (err) => err.message.includes('password');
+
+const unlock = async ({ input, output, passwords, mode, linearize, compact }) => {
+  const start = performance.now();
+  const inputFd = fs.openSync(input, 'r');
+  const outputFd = fs.openSync(output, 'w');
+  try {
+    const source = await fs.openAsBlob(input);
+    registerFileRangeReader(source, (position, length) => {
+      const bytes = new Uint8Array(length);
+      return bytes.subarray(0, fs.readSync(inputFd, bytes, 0, length, position));
+    });
+
+    const { encrypted, ordered, index } = await rankPasswords(source, passwords);
+    if (index === -1) throw new Error(`None of the ${passwords.length} passwords opens this file`);
+    const attempts = index === null ? ordered.map((_, i) => i) : [index];
+
+    const writer = createFileWriter(outputFd);
+    let metrics = null;
+    for (const [attempt, candidate] of attempts.entries()) {
+      try {
+        await removeSecurity(source, ordered[candidate], {
+          mode,
+          linearize,
+          compact,
+          onChunk: writer.write,
+          onMetrics: (report) => {
+            metrics = report;
+          },
+        });
+        writer.flush();
+        if (ordered[candidate]) lastPassword = ordered[candidate];
+        return {
+          ok: true,
+          engine: metrics.engine,
+          passwordIndex: encrypted ? passwords.indexOf(ordered[candidate]) : -1,
+          bytesIn: source.size,
+          bytesOut: writer.size,
+          ms: performance.now() - start,
+          spans: metrics.spans,
+        };
+      } catch (err) {
+        if (!isPasswordError(err) || attempt === attempts.length - 1) throw err;
+        writer.reset();
+      }
+    }
+  } finally {
+    fs.closeSync(inputFd);
+    fs.closeSync(outputFd);
+  }
+};
+
+parentPort.on('message', async ({ id, ...job }) => {
+  try {
+    parentPort.postMessage({ id, ...(await unlock(job)), recycle: isPdfiumRecycleDue() });
+  } catch (err) {
+    parentPort.postMessage({
+      id,
+      ok: false,
+      error: err.message,
+      // A trap (e.g. out of memory inside PDFium) leaves the module unusable
+      recycle: isPdfiumRecycleDue() || err instanceof WebAssembly.RuntimeError,
+    });
+  }
+});
@@ -181,6 +181,21 @@ const config = [
     },
   },
 
+  // Benchmark, CLI and their module hooks (Node)
+  {
+    files: ['bench/**/*.mjs', 'cli/**/*.mjs', '.config/node/**/*.mjs'],
+    languageOptions: {
+      ecmaVersion: 'latest',
+      sourceType: 'module',
+      globals: {
+        ...globals.node,
+      },
+    },
+    rules: {
+      'no-console': 'off',
+    },
+  },
+
   // Ignore patterns
   {
     ignores: [
@@ -5,20 +5,57 @@ import { createGoogleTag } from './utils/createGoogleTag';
 import { usePdfiumPDFRemover } from './hooks/usePdfiumPDFRemover';
 import LogoPng from '../public/logo.png';
 
+const getProcessingLabel = (batchProgress, progress) => {
+  if (batchProgress) {
+    return `Processing ${batchProgress.completed + batchProgress.failed}/${batchProgress.total}...`;
+  }
+  // Output bytes against the input size; held below 100% until the job settles
+  if (progress?.bytesTotal) {
+    const percent = Math.min(99, Math.floor((100 * progress.bytesWritten) / progress.bytesTotal));
+    return `Processing ${percent}%...`;
+  }
+  return 'Processing...';
+};
+
 const App = () => {
-  const { processPDFWithPdfium } = usePdfiumPDFRemover();
+  const {
+    prewarm,
+    processPDFWithPdfium,
+    processPDFToStream,
+    processPDFBatch,
+    openDocument,
+    closeDocument,
+  } = usePdfiumPDFRemover();
   const {
     password,
     isProcessing,
     error,
     fileName,
     file,
+    files,
+    batchProgress,
     savePassword,
+    needsPassword,
+    progress,
+    linearize,
+    compact,
     handleFileChange,
     handlePasswordChange,
     handleSavePasswordChange,
+    handleLinearizeChange,
+    handleCompactChange,
     handleRemovePassword,
-  } = usePDFPasswordRemover(processPDFWithPdfium);
+    handleCancel,
+  } = usePDFPasswordRemover(processPDFWithPdfium, {
+    processPDFBatch,
+    processPDFToStream,
+    openDocument,
+    closeDocument,
+  });
+
+  const isBatch = files?.length > 1;
+  const isUnencrypted = !isBatch && needsPassword === false;
+  const processingLabel = getProcessingLabel(batchProgress, progress);
 
   useEffect(() => {
     createGoogleTag();
@@ -42,13 +79,20 @@ const App = () => {
               id="pdf-input"
               type="file"
               accept=".pdf,application/pdf"
+              multiple
+              onFocus={prewarm}
               onChange={handleFileChange}
               className={styles.fileInput}
               disabled={isProcessing}
             />
             {fileName && (
               <div className={styles.fileName}>
-                <span>Selected: {fileName}</span>
+                <span>Selected: {isBatch ? `${files.length} files` : fileName}</span>
+              </div>
+            )}
+            {isUnencrypted && (
+              <div className={styles.fileName}>
+                <span>This PDF is not password protected, no password needed</span>
               </div>
             )}
           </div>
@@ -84,17 +128,48 @@ const App = () => {
                 Save password for next time
               </label>
             </div>
+            <div className={styles.checkboxGroup}>
+              <input
+                id="linearize-checkbox"
+                type="checkbox"
+                checked={linearize}
+                onChange={handleLinearizeChange}
+                className={styles.checkbox}
+                disabled={isProcessing}
+              />
+              <label htmlFor="linearize-checkbox" className={styles.checkboxLabel}>
+                Optimize for fast web view
+              </label>
+            </div>
+            <div className={styles.checkboxGroup}>
+              <input
+                id="compact-checkbox"
+                type="checkbox"
+                checked={compact}
+                onChange={handleCompactChange}
+                className={styles.checkbox}
+                disabled={isProcessing}
+              />
+              <label htmlFor="compact-checkbox" className={styles.checkboxLabel}>
+                Reduce file size
+              </label>
+            </div>
           </div>
 
           {error && <div className={styles.error}>{error}</div>}
 
           <button
             onClick={handleRemovePassword}
-            disabled={isProcessing || !file || !password}
+            disabled={isProcessing || !file || (!password && !isUnencrypted)}
             className={styles.button}
           >
-            {isProcessing ? 'Processing...' : 'Remove Password & Download'}
+            {isProcessing ? processingLabel : 'Remove Password & Download'}
           </button>
+          {isProcessing && (
+            <button onClick={handleCancel} className={styles.cancelButton}>
+              Cancel
+            </button>
+          )}
         </div>
 
         <div className={styles.info}>
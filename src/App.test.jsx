@@ -3,7 +3,7 @@
  * Tests file input, password input, form submission, and error states
  */
 
-import { render, screen } from '@testing-library/react';
+import { render, screen, fireEvent } from '@testing-library/react';
 import userEvent from '@testing-library/user-event';
 import App from './App';
 
@@ -119,6 +119,21 @@ describe('App Component', () => {
       expect(mockHandleFileChange).toHaveBeenCalled();
     });
 
+    it('should pre-warm the engine when the file input gets focus', () => {
+      const prewarm = jest.fn();
+      mockUsePdfiumPDFRemover.mockReturnValue({
+        prewarm,
+        processPDFWithPdfium: jest.fn(),
+        isLoading: true,
+        isPdfiumAvailable: false,
+      });
+
+      render(<App />);
+      fireEvent.focus(screen.getByLabelText(/Select PDF File/i));
+
+      expect(prewarm).toHaveBeenCalled();
+    });
+
     it('should display selected file name when file is selected', () => {
       mockUsePDFPasswordRemover.mockReturnValueOnce({
         password: '',
@@ -137,6 +152,27 @@ describe('App Component', () => {
 
       expect(screen.getByText(/Selected: test.pdf/i)).toBeInTheDocument();
     });
+
+    it('should display the file count when several files are selected', () => {
+      const files = [new File(['a'], 'a.pdf'), new File(['b'], 'b.pdf')];
+      mockUsePDFPasswordRemover.mockReturnValueOnce({
+        password: '',
+        isProcessing: false,
+        error: '',
+        fileName: 'a.pdf',
+        file: files[0],
+        files,
+        savePassword: true,
+        handleFileChange: jest.fn(),
+        handlePasswordChange: jest.fn(),
+        handleSavePasswordChange: jest.fn(),
+        handleRemovePassword: jest.fn(),
+      });
+
+      render(<App />);
+
+      expect(screen.getByText(/Selected: 2 files/i)).toBeInTheDocument();
+    });
   });
 
   describe('Password Input Interactions', () => {
@@ -252,6 +288,29 @@ describe('App Component', () => {
       expect(button).toBeEnabled();
     });
 
+    it('should enable the button without a password for unencrypted files', () => {
+      mockUsePDFPasswordRemover.mockReturnValueOnce({
+        password: '',
+        isProcessing: false,
+        error: '',
+        fileName: 'test.pdf',
+        file: { name: 'test.pdf' },
+        files: [{ name: 'test.pdf' }],
+        needsPassword: false,
+        savePassword: true,
+        handleFileChange: jest.fn(),
+        handlePasswordChange: jest.fn(),
+        handleSavePasswordChange: jest.fn(),
+        handleRemovePassword: jest.fn(),
+      });
+
+      render(<App />);
+
+      const button = screen.getByRole('button', { name: /Remove Password & Download/i });
+      expect(button).toBeEnabled();
+      expect(screen.getByText(/not password protected/i)).toBeInTheDocument();
+    });
+
     it('should show processing text when isProcessing is true', () => {
       mockUsePDFPasswordRemover.mockReturnValueOnce({
         password: 'test123',
@@ -271,6 +330,31 @@ describe('App Component', () => {
       expect(screen.getByRole('button', { name: /Processing.../i })).toBeInTheDocument();
     });
 
+    it('should show the progress of the running job and let it be cancelled', async () => {
+      const user = userEvent.setup();
+      const handleCancel = jest.fn();
+      mockUsePDFPasswordRemover.mockReturnValueOnce({
+        password: 'test123',
+        isProcessing: true,
+        error: '',
+        fileName: 'test.pdf',
+        file: { name: 'test.pdf' },
+        savePassword: true,
+        progress: { engine: 'pdfium', bytesWritten: 420, bytesTotal: 1000 },
+        handleFileChange: jest.fn(),
+        handlePasswordChange: jest.fn(),
+        handleSavePasswordChange: jest.fn(),
+        handleRemovePassword: jest.fn(),
+        handleCancel,
+      });
+
+      render(<App />);
+
+      expect(screen.getByRole('button', { name: 'Processing 42%...' })).toBeInTheDocument();
+      await user.click(screen.getByRole('button', { name: 'Cancel' }));
+      expect(handleCancel).toHaveBeenCalled();
+    });
+
     it('should call handleRemovePassword when button is clicked', async () => {
       const user = userEvent.setup();
       const mockHandleRemovePassword = jest.fn();
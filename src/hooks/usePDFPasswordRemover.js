@@ -1,16 +1,51 @@
-import { useState, useEffect } from 'react';
-import { createPDFBuffer } from '../utils/createPDFBuffer';
-import { downloadBlob } from '../utils/downloadBlob';
+import { useState, useEffect, useRef } from 'react';
+import { planJob } from '../utils/pdfiumPlanner';
+import { downloadBlob, getUnlockedFileName, saveBlob } from '../utils/downloadBlob';
+import { BATCH_ARCHIVE_NAME, createArchiveSink, createFileSink } from '../utils/createFileSink';
+import { createBlobCollector, createZipWriter } from '../utils/createZipWriter';
+import { loadEncryption } from '../utils/loadEncryption';
 
 const STORAGE_KEY = 'pdfPasswordRemover_data';
 
-export const usePDFPasswordRemover = (processPDFWithPdfium) => {
+const isPasswordError = (err) =>
+  err.message.includes('password') || err.message.includes('PasswordException');
+
+/**
+ * Form state and actions for the password remover
+ * @param {Function} processPDFWithPdfium - Single-file processor (ArrayBuffer, password) => Blob
+ *   Processors receive `{signal, onProgress}` as their last argument (batches within the
+ *   callbacks), plus the `linearize` and `compact` output options, so a running job can
+ *   report progress and be cancelled. Batches also get
+ *   `onResult(file, blob)`, which appends each unlocked file to the ZIP archive
+ * @param {Object} [options]
+ * @param {Function} [options.processPDFBatch] - Batch processor used when several files are selected
+ * @param {Function} [options.processPDFToStream] - Streaming processor used for large files
+ * @param {Function} [options.openDocument] - Keeps the selected file resident in the engine
+ *   (File) => handle, so repeated password attempts skip reading and copying it again
+ * @param {Function} [options.closeDocument] - Releases a handle from openDocument
+ */
+export const usePDFPasswordRemover = (
+  processPDFWithPdfium,
+  { processPDFBatch, processPDFToStream, openDocument, closeDocument } = {},
+) => {
   const [file, setFile] = useState(null);
+  const [files, setFiles] = useState([]);
+  const [batchProgress, setBatchProgress] = useState(null);
   const [password, setPassword] = useState('');
   const [isProcessing, setIsProcessing] = useState(false);
   const [error, setError] = useState('');
   const [fileName, setFileName] = useState('');
   const [savePassword, setSavePassword] = useState(true);
+  // Whether the selected file has /Encrypt; null while unknown
+  const [needsPassword, setNeedsPassword] = useState(null);
+  // Latest engine progress of the running single-file job
+  const [progress, setProgress] = useState(null);
+  // Save outputs linearized, so viewers reading by byte ranges show page 1 first
+  const [linearize, setLinearize] = useState(false);
+  // Save outputs compacted: duplicate streams merged, objects packed into object streams
+  const [compact, setCompact] = useState(false);
+  const residentRef = useRef(null);
+  const abortRef = useRef(null);
 
   // Load last used password from localStorage on mount
   useEffect(() => {
@@ -32,11 +67,39 @@ export const usePDFPasswordRemover = (processPDFWithPdfium) => {
     }
   }, []);
 
+  // Check a single selected file for /Encrypt from its tail, then load an
+  // encrypted one into the engine once; released when the selection changes
+  useEffect(() => {
+    setNeedsPassword(null);
+    if (!file || files.length > 1) return undefined;
+    let selected = true;
+    const encrypted = loadEncryption()
+      .then(({ sniffEncryption }) => sniffEncryption(file))
+      .catch(() => null);
+    encrypted.then((value) => selected && setNeedsPassword(value));
+
+    const handle = encrypted
+      .then((value) => (value === false || !openDocument ? null : openDocument(file)))
+      .catch((err) => {
+        console.warn('Failed to keep document resident, reading it per attempt:', err);
+        return null;
+      });
+    residentRef.current = { file, handle };
+    return () => {
+      selected = false;
+      if (residentRef.current && residentRef.current.file === file) residentRef.current = null;
+      handle.then((resident) => resident && closeDocument && closeDocument(resident));
+    };
+    // eslint-disable-next-line react-hooks/exhaustive-deps
+  }, [file, files]);
+
   const handleFileChange = (e) => {
-    const selectedFile = e.target.files[0];
-    if (selectedFile) {
-      setFile(selectedFile);
-      setFileName(selectedFile.name);
+    const selectedFiles = Array.from(e.target.files || []);
+    if (selectedFiles.length > 0) {
+      setFile(selectedFiles[0]);
+      setFiles(selectedFiles);
+      setFileName(selectedFiles[0].name);
+      setBatchProgress(null);
       setError('');
     }
   };
@@ -74,51 +137,169 @@ export const usePDFPasswordRemover = (processPDFWithPdfium) => {
     }
   };
 
+  const handleLinearizeChange = (e) => {
+    setLinearize(e.target.checked);
+  };
+
+  const handleCompactChange = (e) => {
+    setCompact(e.target.checked);
+  };
+
+  /**
+   * Abort the running job; its worker is stopped, so the heap it used is released at once
+   */
+  const handleCancel = () => {
+    if (abortRef.current) abortRef.current.abort();
+  };
+
+  /**
+   * Unlock every selected file into one ZIP archive
+   * Each result is appended as soon as its worker finishes; with the File System
+   * Access API the archive streams to disk, elsewhere it is collected into a Blob
+   * and downloaded once
+   */
+  const handleRemoveBatch = async (signal) => {
+    let zip = null;
+    try {
+      // The save dialog must open before any other await to keep the user gesture
+      const sink = await createArchiveSink();
+      const collector = sink ? null : createBlobCollector('application/zip');
+      zip = createZipWriter(sink || collector.writable);
+
+      const results = await processPDFBatch(files, password, {
+        onProgress: setBatchProgress,
+        signal,
+        linearize,
+        compact,
+        onResult: (batchFile, blob) => zip.add(getUnlockedFileName(batchFile.name), blob),
+      });
+
+      if (signal.aborted || results.every((result) => result.error)) {
+        // Nothing worth keeping: discard the partial archive
+        await zip.abort(signal.reason);
+      } else {
+        await zip.close();
+        if (collector) saveBlob(collector.toBlob(), BATCH_ARCHIVE_NAME);
+      }
+
+      const failed = results.filter(
+        (result) => result.error && result.error.name !== 'AbortError',
+      );
+      if (failed.length > 0) {
+        const reason = failed.every((result) => isPasswordError(result.error))
+          ? 'incorrect password'
+          : failed[0].error.message;
+        setError(`${failed.length} of ${results.length} files failed (${reason})`);
+      }
+    } catch (err) {
+      if (zip) await zip.abort(err).catch(() => {});
+      // The user dismissed the save dialog
+      if (err.name !== 'AbortError') setError('Error processing PDFs: ' + err.message);
+    } finally {
+      abortRef.current = null;
+      setIsProcessing(false);
+    }
+  };
+
   const handleRemovePassword = async () => {
     if (!file) {
       setError('Please select a PDF file');
       return;
     }
 
-    if (!password) {
+    // Not encrypted: nothing to remove, the file is saved as it is (or only rewritten)
+    const isUnencrypted = needsPassword === false && files.length <= 1;
+    if (isUnencrypted && !linearize && !compact) {
+      setError('');
+      downloadBlob(file, fileName);
+      return;
+    }
+
+    if (!password && !isUnencrypted) {
       setError('Please enter the PDF password');
       return;
     }
 
     setIsProcessing(true);
     setError('');
+    const controller = new AbortController();
+    abortRef.current = controller;
+    const jobOptions = { signal: controller.signal, onProgress: setProgress, linearize, compact };
+
+    if (files.length > 1 && processPDFBatch) {
+      await handleRemoveBatch(controller.signal);
+      return;
+    }
 
     try {
-      // create PDF.js document object with password
-      const pdfDocument = await createPDFBuffer(file, password);
+      // Files large enough to be read on demand on this device
+      const isLargeFile = planJob(file).onDemand;
+
+      // Large outputs go straight to a file on disk when the browser supports it.
+      // The save dialog must open before any other await to keep the user gesture.
+      const sink = processPDFToStream && isLargeFile ? await createFileSink(fileName) : null;
+
+      // A resident copy is reused; otherwise the engine reads the File itself
+      const resident =
+        residentRef.current && residentRef.current.file === file
+          ? await residentRef.current.handle
+          : null;
+      const pdfDocument = resident || file;
+      // Cancelling stops the worker holding the resident copy; later attempts read the file
+      controller.signal.addEventListener('abort', () => {
+        if (resident && residentRef.current && residentRef.current.file === file) {
+          residentRef.current = { file, handle: Promise.resolve(null) };
+        }
+      });
 
-      // convert PDF to new PDF without password
-      const newPdf = await processPDFWithPdfium(pdfDocument, password);
+      if (sink) {
+        // stream the new PDF without password into the chosen file
+        await processPDFToStream(pdfDocument, password, sink, jobOptions);
+      } else {
+        // convert PDF to new PDF without password
+        const newPdf = await processPDFWithPdfium(pdfDocument, password, jobOptions);
 
-      // download the new PDF without password
-      downloadBlob(newPdf, fileName);
+        // download the new PDF without password
+        downloadBlob(newPdf, fileName);
+      }
 
       setIsProcessing(false);
     } catch (err) {
       setIsProcessing(false);
-      if (err.message.includes('password') || err.message.includes('PasswordException')) {
+      if (err.name === 'AbortError') {
+        // The user dismissed the save dialog or cancelled the job
+        return;
+      }
+      if (isPasswordError(err)) {
         setError('Incorrect password. Please try again.');
       } else {
         setError('Error processing PDF: ' + err.message);
       }
+    } finally {
+      abortRef.current = null;
+      setProgress(null);
     }
   };
 
   return {
     file,
+    files,
+    batchProgress,
     password,
     isProcessing,
     error,
     fileName,
     savePassword,
+    needsPassword,
+    progress,
+    linearize,
+    compact,
     handleFileChange,
     handlePasswordChange,
     handleSavePasswordChange,
+    handleLinearizeChange,
+    handleCompactChange,
     handleRemovePassword,
+    handleCancel,
   };
 };
@@ -6,20 +6,41 @@
 import { renderHook, act, waitFor } from '@testing-library/react';
 import { usePDFPasswordRemover } from './usePDFPasswordRemover';
 
-// Mock createPDFBuffer
-jest.mock('../utils/createPDFBuffer', () => ({
-  createPDFBuffer: jest.fn(async (file) => {
-    return file.arrayBuffer();
-  }),
-}));
-
 // Mock downloadBlob
 jest.mock('../utils/downloadBlob', () => ({
   downloadBlob: jest.fn(),
+  saveBlob: jest.fn(),
+  getUnlockedFileName: (fileName) => fileName.replace(/\.pdf$/i, '') + '_unlocked.pdf',
+}));
+
+// Mock createFileSink
+jest.mock('../utils/createFileSink', () => ({
+  BATCH_ARCHIVE_NAME: 'unlocked_pdfs.zip',
+  createFileSink: jest.fn(async () => null),
+  createArchiveSink: jest.fn(async () => null),
+}));
+
+// Mock the ZIP writer (jsdom has no WritableStream)
+jest.mock('../utils/createZipWriter', () => {
+  const zip = { add: jest.fn(async () => {}), close: jest.fn(async () => {}), abort: jest.fn() };
+  return {
+    mockZip: zip,
+    createZipWriter: jest.fn(() => zip),
+    createBlobCollector: jest.fn(() => ({ writable: {}, toBlob: () => new Blob(['zip']) })),
+  };
+});
+
+// Mock the /Encrypt sniff (unknown unless a test says otherwise)
+jest.mock('../utils/pdf/encryption', () => ({
+  sniffEncryption: jest.fn(async () => null),
 }));
 
 const mockDownloadBlob = require('../utils/downloadBlob').downloadBlob;
-const mockCreatePDFBuffer = require('../utils/createPDFBuffer').createPDFBuffer;
+const mockSaveBlob = require('../utils/downloadBlob').saveBlob;
+const mockCreateFileSink = require('../utils/createFileSink').createFileSink;
+const mockCreateArchiveSink = require('../utils/createFileSink').createArchiveSink;
+const { mockZip, createZipWriter: mockCreateZipWriter } = require('../utils/createZipWriter');
+const mockSniffEncryption = require('../utils/pdf/encryption').sniffEncryption;
 
 describe('usePDFPasswordRemover', () => {
   const mockProcessPDFWithPdfium = jest.fn(async (pdfData, password) => {
@@ -275,8 +296,6 @@ describe('usePDFPasswordRemover', () => {
     });
 
     it('should process PDF when file and password are provided', async () => {
-      mockCreatePDFBuffer.mockResolvedValue(new ArrayBuffer(10));
-
       const { result } = renderHook(() => usePDFPasswordRemover(mockProcessPDFWithPdfium));
 
       const mockFile = new File(['PDF content'], 'test.pdf');
@@ -295,20 +314,24 @@ describe('usePDFPasswordRemover', () => {
         await result.current.handleRemovePassword();
       });
 
-      expect(mockCreatePDFBuffer).toHaveBeenCalledWith(mockFile, 'correct');
-      expect(mockProcessPDFWithPdfium).toHaveBeenCalled();
+      // The File goes to the engine as is; it is not read on this thread
+      expect(mockProcessPDFWithPdfium).toHaveBeenCalledWith(
+        mockFile,
+        'correct',
+        expect.any(Object),
+      );
       expect(mockDownloadBlob).toHaveBeenCalled();
     });
 
     it('should set isProcessing to true during processing', async () => {
-      mockCreatePDFBuffer.mockImplementation(
+      const slowProcess = jest.fn(
         () =>
           new Promise((resolve) => {
-            setTimeout(() => resolve(new ArrayBuffer(10)), 100);
+            setTimeout(() => resolve(new Blob(['PDF'])), 100);
           }),
       );
 
-      const { result } = renderHook(() => usePDFPasswordRemover(mockProcessPDFWithPdfium));
+      const { result } = renderHook(() => usePDFPasswordRemover(slowProcess));
 
       const mockFile = new File(['PDF'], 'test.pdf');
 
@@ -332,9 +355,11 @@ describe('usePDFPasswordRemover', () => {
     });
 
     it('should handle processing errors', async () => {
-      mockCreatePDFBuffer.mockRejectedValue(new Error('File read error'));
+      const failingProcess = jest.fn(async () => {
+        throw new Error('File read error');
+      });
 
-      const { result } = renderHook(() => usePDFPasswordRemover(mockProcessPDFWithPdfium));
+      const { result } = renderHook(() => usePDFPasswordRemover(failingProcess));
 
       const mockFile = new File(['PDF'], 'test.pdf');
 
@@ -356,6 +381,495 @@ describe('usePDFPasswordRemover', () => {
     });
   });
 
+  describe('Streaming Output', () => {
+    const createLargeFile = () => {
+      const largeFile = new File(['PDF'], 'large.pdf');
+      Object.defineProperty(largeFile, 'size', { value: 128 * 1024 * 1024 });
+      return largeFile;
+    };
+
+    const selectFile = (result, selectedFile) => {
+      act(() => {
+        result.current.handleFileChange({ target: { files: [selectedFile] } });
+        result.current.handlePasswordChange({ target: { value: 'correct' } });
+      });
+    };
+
+    it('should stream large files into the chosen file sink', async () => {
+      const sink = { getWriter: jest.fn() };
+      mockCreateFileSink.mockResolvedValueOnce(sink);
+      const processPDFToStream = jest.fn(async () => ({ size: 10 }));
+
+      const { result } = renderHook(() =>
+        usePDFPasswordRemover(mockProcessPDFWithPdfium, { processPDFToStream }),
+      );
+      selectFile(result, createLargeFile());
+
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(mockCreateFileSink).toHaveBeenCalledWith('large.pdf');
+      expect(processPDFToStream).toHaveBeenCalledWith(
+        expect.any(File),
+        'correct',
+        sink,
+        expect.any(Object),
+      );
+      expect(mockDownloadBlob).not.toHaveBeenCalled();
+    });
+
+    it('should hand large files to the engine without reading them first', async () => {
+      const largeFile = createLargeFile();
+      const { result } = renderHook(() => usePDFPasswordRemover(mockProcessPDFWithPdfium));
+      selectFile(result, largeFile);
+
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(mockProcessPDFWithPdfium).toHaveBeenCalledWith(
+        largeFile,
+        'correct',
+        expect.any(Object),
+      );
+    });
+
+    it('should fall back to a regular download when no sink is available', async () => {
+      const processPDFToStream = jest.fn();
+
+      const { result } = renderHook(() =>
+        usePDFPasswordRemover(mockProcessPDFWithPdfium, { processPDFToStream }),
+      );
+      selectFile(result, createLargeFile());
+
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(processPDFToStream).not.toHaveBeenCalled();
+      expect(mockDownloadBlob).toHaveBeenCalled();
+    });
+
+    it('should not stream small files', async () => {
+      const processPDFToStream = jest.fn();
+
+      const { result } = renderHook(() =>
+        usePDFPasswordRemover(mockProcessPDFWithPdfium, { processPDFToStream }),
+      );
+      selectFile(result, new File(['PDF'], 'small.pdf'));
+
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(mockCreateFileSink).not.toHaveBeenCalled();
+      expect(mockDownloadBlob).toHaveBeenCalled();
+    });
+
+    it('should stay silent when the save dialog is dismissed', async () => {
+      const abortError = new Error('The user aborted a request.');
+      abortError.name = 'AbortError';
+      mockCreateFileSink.mockRejectedValueOnce(abortError);
+
+      const { result } = renderHook(() =>
+        usePDFPasswordRemover(mockProcessPDFWithPdfium, { processPDFToStream: jest.fn() }),
+      );
+      selectFile(result, createLargeFile());
+
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(result.current.error).toBe('');
+      expect(result.current.isProcessing).toBe(false);
+    });
+  });
+
+  describe('Encryption Sniffing', () => {
+    const select = (result, file) => {
+      act(() => {
+        result.current.handleFileChange({ target: { files: [file] } });
+      });
+    };
+
+    it('should report whether the selected file needs a password', async () => {
+      mockSniffEncryption.mockResolvedValueOnce(true);
+      const { result } = renderHook(() => usePDFPasswordRemover(mockProcessPDFWithPdfium));
+      const file = new File(['PDF content'], 'test.pdf');
+
+      expect(result.current.needsPassword).toBeNull();
+      select(result, file);
+
+      await waitFor(() => expect(result.current.needsPassword).toBe(true));
+      expect(mockSniffEncryption).toHaveBeenCalledWith(file);
+    });
+
+    it('should save unencrypted files as they are, without the engine', async () => {
+      mockSniffEncryption.mockResolvedValueOnce(false);
+      const openDocument = jest.fn();
+      const { result } = renderHook(() =>
+        usePDFPasswordRemover(mockProcessPDFWithPdfium, { openDocument }),
+      );
+      const file = new File(['PDF content'], 'plain.pdf');
+      select(result, file);
+      await waitFor(() => expect(result.current.needsPassword).toBe(false));
+
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(mockDownloadBlob).toHaveBeenCalledWith(file, 'plain.pdf');
+      expect(mockProcessPDFWithPdfium).not.toHaveBeenCalled();
+      expect(openDocument).not.toHaveBeenCalled();
+      expect(result.current.error).toBe('');
+    });
+  });
+
+  describe('Resident Document', () => {
+    const handle = { documentId: 1, size: 11 };
+    const openDocument = jest.fn(async () => handle);
+    const closeDocument = jest.fn(async () => {});
+    const renderResident = () =>
+      renderHook(() =>
+        usePDFPasswordRemover(mockProcessPDFWithPdfium, { openDocument, closeDocument }),
+      );
+    const select = (result, file, password) => {
+      act(() => {
+        result.current.handleFileChange({ target: { files: [file] } });
+        result.current.handlePasswordChange({ target: { value: password } });
+      });
+    };
+
+    it('should open the selected file once and reuse it for every attempt', async () => {
+      const { result } = renderResident();
+      const file = new File(['PDF content'], 'test.pdf');
+      select(result, file, 'wrong');
+
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+      act(() => {
+        result.current.handlePasswordChange({ target: { value: 'correct' } });
+      });
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(openDocument).toHaveBeenCalledTimes(1);
+      expect(openDocument).toHaveBeenCalledWith(file);
+      expect(mockProcessPDFWithPdfium).toHaveBeenNthCalledWith(
+        1,
+        handle,
+        'wrong',
+        expect.any(Object),
+      );
+      expect(mockProcessPDFWithPdfium).toHaveBeenNthCalledWith(
+        2,
+        handle,
+        'correct',
+        expect.any(Object),
+      );
+    });
+
+    it('should close the document when the selection changes or on unmount', async () => {
+      const { result, unmount } = renderResident();
+      select(result, new File(['a'], 'a.pdf'), 'correct');
+      select(result, new File(['b'], 'b.pdf'), 'correct');
+
+      await waitFor(() => expect(closeDocument).toHaveBeenCalledTimes(1));
+      expect(openDocument).toHaveBeenCalledTimes(2);
+
+      unmount();
+      await waitFor(() => expect(closeDocument).toHaveBeenCalledTimes(2));
+      expect(closeDocument).toHaveBeenCalledWith(handle);
+    });
+
+    it('should hand the File over per attempt when it cannot be kept resident', async () => {
+      openDocument.mockRejectedValueOnce(new Error('Out of wasm memory'));
+      const { result } = renderResident();
+      const file = new File(['PDF content'], 'test.pdf');
+      select(result, file, 'correct');
+
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(mockProcessPDFWithPdfium).toHaveBeenCalledWith(file, 'correct', expect.any(Object));
+      expect(mockDownloadBlob).toHaveBeenCalled();
+    });
+  });
+
+  describe('Progress and Cancellation', () => {
+    const select = (result, file) => {
+      act(() => {
+        result.current.handleFileChange({ target: { files: [file] } });
+        result.current.handlePasswordChange({ target: { value: 'correct' } });
+      });
+    };
+
+    it('should expose the progress of the running job', async () => {
+      let finish;
+      const processPDF = jest.fn((pdfData, password, { onProgress }) => {
+        onProgress({ engine: 'pdfium', bytesWritten: 50, bytesTotal: 200 });
+        return new Promise((resolve) => {
+          finish = () => resolve(new Blob(['PDF']));
+        });
+      });
+      const { result } = renderHook(() => usePDFPasswordRemover(processPDF));
+      select(result, new File(['PDF content'], 'test.pdf'));
+
+      let job;
+      act(() => {
+        job = result.current.handleRemovePassword();
+      });
+      await waitFor(() =>
+        expect(result.current.progress).toEqual(
+          expect.objectContaining({ bytesWritten: 50, bytesTotal: 200 }),
+        ),
+      );
+
+      await act(async () => {
+        finish();
+        await job;
+      });
+      expect(result.current.progress).toBeNull();
+    });
+
+    it('should abort the running job without reporting an error', async () => {
+      const processPDF = jest.fn(
+        (pdfData, password, { signal }) =>
+          new Promise((resolve, reject) => {
+            signal.addEventListener('abort', () => reject(signal.reason));
+          }),
+      );
+      const { result } = renderHook(() => usePDFPasswordRemover(processPDF));
+      select(result, new File(['PDF content'], 'test.pdf'));
+
+      let job;
+      act(() => {
+        job = result.current.handleRemovePassword();
+      });
+      await waitFor(() => expect(processPDF).toHaveBeenCalled());
+      await act(async () => {
+        result.current.handleCancel();
+        await job;
+      });
+
+      expect(processPDF.mock.calls[0][2].signal.aborted).toBe(true);
+      expect(result.current.isProcessing).toBe(false);
+      expect(result.current.error).toBe('');
+      expect(mockDownloadBlob).not.toHaveBeenCalled();
+    });
+  });
+
+  describe('Batch Mode', () => {
+    const selectFiles = (result, files) => {
+      act(() => {
+        result.current.handleFileChange({ target: { files } });
+        result.current.handlePasswordChange({ target: { value: 'correct' } });
+      });
+    };
+
+    it('should keep every selected file', () => {
+      const { result } = renderHook(() => usePDFPasswordRemover(mockProcessPDFWithPdfium));
+      const files = [new File(['a'], 'a.pdf'), new File(['b'], 'b.pdf')];
+
+      act(() => {
+        result.current.handleFileChange({ target: { files } });
+      });
+
+      expect(result.current.files).toEqual(files);
+      expect(result.current.file).toBe(files[0]);
+    });
+
+    it('should send multiple files to the batch processor and download one archive', async () => {
+      const files = [new File(['a'], 'a.pdf'), new File(['b'], 'b.pdf')];
+      const processPDFBatch = jest.fn(async (batchFiles, password, { onProgress, onResult }) => {
+        for (const file of batchFiles) await onResult(file, new Blob([file]));
+        onProgress({ completed: 2, failed: 0, total: 2, bytesDone: 2, bytesTotal: 2 });
+        return batchFiles.map((file) => ({ file }));
+      });
+
+      const { result } = renderHook(() =>
+        usePDFPasswordRemover(mockProcessPDFWithPdfium, { processPDFBatch }),
+      );
+      selectFiles(result, files);
+
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(processPDFBatch).toHaveBeenCalledWith(files, 'correct', expect.any(Object));
+      expect(mockProcessPDFWithPdfium).not.toHaveBeenCalled();
+      expect(mockZip.add).toHaveBeenCalledWith('b_unlocked.pdf', expect.any(Blob));
+      expect(mockZip.close).toHaveBeenCalled();
+      expect(mockDownloadBlob).not.toHaveBeenCalled();
+      expect(mockSaveBlob).toHaveBeenCalledTimes(1);
+      expect(mockSaveBlob).toHaveBeenCalledWith(expect.any(Blob), 'unlocked_pdfs.zip');
+      expect(result.current.batchProgress.completed).toBe(2);
+      expect(result.current.isProcessing).toBe(false);
+    });
+
+    it('should summarize failed files in the error message', async () => {
+      const files = [new File(['a'], 'a.pdf'), new File(['b'], 'b.pdf')];
+      const processPDFBatch = jest.fn(async (batchFiles) => [
+        { file: batchFiles[0] },
+        { file: batchFiles[1], error: new Error('Password required or incorrect password') },
+      ]);
+
+      const { result } = renderHook(() =>
+        usePDFPasswordRemover(mockProcessPDFWithPdfium, { processPDFBatch }),
+      );
+      selectFiles(result, files);
+
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(mockSaveBlob).toHaveBeenCalledTimes(1);
+      expect(result.current.error).toBe('1 of 2 files failed (incorrect password)');
+    });
+
+    it('should stream the archive to the chosen file when the browser supports it', async () => {
+      const files = [new File(['a'], 'a.pdf'), new File(['b'], 'b.pdf')];
+      const writable = {};
+      mockCreateArchiveSink.mockResolvedValueOnce(writable);
+      const processPDFBatch = jest.fn(async (batchFiles) => batchFiles.map((file) => ({ file })));
+
+      const { result } = renderHook(() =>
+        usePDFPasswordRemover(mockProcessPDFWithPdfium, { processPDFBatch }),
+      );
+      selectFiles(result, files);
+
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(mockCreateZipWriter).toHaveBeenCalledWith(writable);
+      expect(mockZip.close).toHaveBeenCalled();
+      expect(mockSaveBlob).not.toHaveBeenCalled();
+    });
+
+    it('should discard the archive when every file fails', async () => {
+      const files = [new File(['a'], 'a.pdf'), new File(['b'], 'b.pdf')];
+      const processPDFBatch = jest.fn(async (batchFiles) =>
+        batchFiles.map((file) => ({ file, error: new Error('incorrect password') })),
+      );
+
+      const { result } = renderHook(() =>
+        usePDFPasswordRemover(mockProcessPDFWithPdfium, { processPDFBatch }),
+      );
+      selectFiles(result, files);
+
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(mockZip.abort).toHaveBeenCalled();
+      expect(mockZip.close).not.toHaveBeenCalled();
+      expect(mockSaveBlob).not.toHaveBeenCalled();
+      expect(result.current.error).toBe('2 of 2 files failed (incorrect password)');
+    });
+  });
+
+  describe('Fast Web View', () => {
+    it('should be off until the user turns it on', () => {
+      const { result } = renderHook(() => usePDFPasswordRemover(mockProcessPDFWithPdfium));
+
+      expect(result.current.linearize).toBe(false);
+      act(() => {
+        result.current.handleLinearizeChange({ target: { checked: true } });
+      });
+      expect(result.current.linearize).toBe(true);
+    });
+
+    it('should ask the engine for linearized output', async () => {
+      const { result } = renderHook(() => usePDFPasswordRemover(mockProcessPDFWithPdfium));
+      const file = new File(['PDF content'], 'test.pdf');
+
+      act(() => {
+        result.current.handleFileChange({ target: { files: [file] } });
+        result.current.handlePasswordChange({ target: { value: 'correct' } });
+        result.current.handleLinearizeChange({ target: { checked: true } });
+      });
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(mockProcessPDFWithPdfium).toHaveBeenCalledWith(
+        file,
+        'correct',
+        expect.objectContaining({ linearize: true }),
+      );
+    });
+
+    it('should run unencrypted files through the engine to linearize them', async () => {
+      mockSniffEncryption.mockResolvedValueOnce(false);
+      const processPDF = jest.fn(async () => new Blob(['%PDF-linearized']));
+      const { result } = renderHook(() => usePDFPasswordRemover(processPDF));
+      const file = new File(['PDF content'], 'plain.pdf');
+
+      act(() => {
+        result.current.handleFileChange({ target: { files: [file] } });
+        result.current.handleLinearizeChange({ target: { checked: true } });
+      });
+      await waitFor(() => expect(result.current.needsPassword).toBe(false));
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(processPDF).toHaveBeenCalledWith(
+        file,
+        '',
+        expect.objectContaining({ linearize: true }),
+      );
+      expect(mockDownloadBlob).not.toHaveBeenCalledWith(file, 'plain.pdf');
+      expect(result.current.error).toBe('');
+    });
+  });
+
+  describe('Compact Output', () => {
+    it('should ask the engine for compacted output', async () => {
+      const { result } = renderHook(() => usePDFPasswordRemover(mockProcessPDFWithPdfium));
+      const file = new File(['PDF content'], 'test.pdf');
+
+      expect(result.current.compact).toBe(false);
+      act(() => {
+        result.current.handleFileChange({ target: { files: [file] } });
+        result.current.handlePasswordChange({ target: { value: 'correct' } });
+        result.current.handleCompactChange({ target: { checked: true } });
+      });
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(mockProcessPDFWithPdfium).toHaveBeenCalledWith(
+        file,
+        'correct',
+        expect.objectContaining({ compact: true, linearize: false }),
+      );
+    });
+
+    it('should run unencrypted files through the engine to compact them', async () => {
+      mockSniffEncryption.mockResolvedValueOnce(false);
+      const processPDF = jest.fn(async () => new Blob(['%PDF-compact']));
+      const { result } = renderHook(() => usePDFPasswordRemover(processPDF));
+      const file = new File(['PDF content'], 'plain.pdf');
+
+      act(() => {
+        result.current.handleFileChange({ target: { files: [file] } });
+        result.current.handleCompactChange({ target: { checked: true } });
+      });
+      await waitFor(() => expect(result.current.needsPassword).toBe(false));
+      await act(async () => {
+        await result.current.handleRemovePassword();
+      });
+
+      expect(processPDF).toHaveBeenCalledWith(file, '', expect.objectContaining({ compact: true }));
+    });
+  });
+
   describe('localStorage Integration', () => {
     it('should encode password before saving to localStorage', () => {
       const { result } = renderHook(() => usePDFPasswordRemover(mockProcessPDFWithPdfium));
@@ -1,42 +1,93 @@
-import { useState, useEffect } from 'react';
-import { pdfiumRemover } from '../utils/pdfiumRemover';
+import { useState, useEffect, useCallback, useRef } from 'react';
+import { getPdfiumEngine } from '../utils/pdfiumEngine';
+import { getPdfiumPool } from '../utils/pdfiumPool';
+
+// Browsers without requestIdleCallback (Safari) wait this long after mount instead
+const PREWARM_FALLBACK_DELAY = 200;
+
+const PASSWORD_ERROR_MESSAGE = 'Password required or incorrect password';
+
+const scheduleIdle = (callback) => {
+  if (typeof window.requestIdleCallback === 'function') {
+    const handle = window.requestIdleCallback(callback);
+    return () => window.cancelIdleCallback(handle);
+  }
+  const timer = setTimeout(callback, PREWARM_FALLBACK_DELAY);
+  return () => clearTimeout(timer);
+};
 
 /**
  * Hook for using pdfium.wasm for PDF password removal
  * Provides full PDF support with native password decryption
+ * All PDFium work runs in a dedicated worker so the UI stays responsive
+ * @param {Object} [options]
+ * @param {(metrics: Object) => void} [options.onMetrics] - Receives the per-stage report of
+ *   every job, single file or batch (see pdfiumMetrics)
  */
-export const usePdfiumPDFRemover = () => {
+export const usePdfiumPDFRemover = ({ onMetrics } = {}) => {
   const [isLoading, setIsLoading] = useState(true);
+  const [isReady, setIsReady] = useState(false);
+  const [initMetrics, setInitMetrics] = useState(null);
+  const prewarmRef = useRef(null);
+  const onMetricsRef = useRef(onMetrics);
+  onMetricsRef.current = onMetrics;
+  const wantsMetrics = Boolean(onMetrics);
 
-  useEffect(() => {
-    // pdfium.wasm initializes on first use
-    setIsLoading(false);
+  /**
+   * Start engine initialization (fetch + compile + PDFiumExt_Init) in the worker
+   * Called at idle time after mount and when the file input gets focus; repeated
+   * calls share the same initialization
+   * @returns {Promise<void>}
+   */
+  const prewarm = useCallback(() => {
+    if (!prewarmRef.current) {
+      prewarmRef.current = getPdfiumEngine()
+        .init()
+        .then(({ metrics }) => {
+          console.log('[Hook] Engine ready, time-to-ready:', metrics);
+          setInitMetrics(metrics);
+          setIsReady(true);
+        })
+        .catch((err) => {
+          // The engine retries initialization on the first real job
+          console.warn('[Hook] Engine pre-warm failed:', err);
+          prewarmRef.current = null;
+        })
+        .finally(() => setIsLoading(false));
+    }
+    return prewarmRef.current;
   }, []);
 
+  useEffect(() => scheduleIdle(prewarm), [prewarm]);
+
+  useEffect(() => {
+    if (!wantsMetrics) return undefined;
+    const report = (metrics) => onMetricsRef.current?.(metrics);
+    const unsubscribers = [
+      getPdfiumEngine().addMetricsListener(report),
+      getPdfiumPool().addMetricsListener(report),
+    ];
+    return () => unsubscribers.forEach((unsubscribe) => unsubscribe());
+  }, [wantsMetrics]);
+
   /**
    * Process a PDF file and remove password encryption using pdfium.wasm
-   * @param {ArrayBuffer} pdfData - The PDF file data as ArrayBuffer
+   * @param {ArrayBuffer|File|Object} pdfData - PDF bytes (transferred to the worker), a File the
+   *   worker reads on demand, or a handle from openDocument
    * @param {string} password - The password to use for decryption
-   * @returns {Promise<ArrayBuffer>} The decrypted PDF data
+   * @param {Object} [options] - `signal` (aborting stops the worker) and `onProgress` (output
+   *   bytes against the estimated total), see engine.removePassword
+   * @returns {Promise<Blob>} The decrypted PDF
    */
-  const processPDFWithPdfium = async (pdfData, password) => {
+  const processPDFWithPdfium = async (pdfData, password, options = {}) => {
     try {
       console.log('[Hook] Starting PDF processing with pdfium.wasm');
-      console.log('[Hook] PDF size:', pdfData.byteLength, 'bytes');
+      console.log('[Hook] PDF size:', pdfData.byteLength ?? pdfData.size, 'bytes');
       console.log('[Hook] Password length:', password.length, 'characters');
 
-      // Try direct decryption first (faster if supported)
-      let blob;
-      try {
-        console.log('[Hook] Attempting direct decryption...');
-        blob = await pdfiumRemover(pdfData, password);
-        console.log('[Hook] ✓ Direct decryption succeeded');
-      } catch (directErr) {
-        console.warn('[Hook] Direct decryption failed:', directErr.message);
-      }
+      const blob = await getPdfiumEngine().removePassword(pdfData, password, options);
 
       console.log('[Hook] Output size:', blob.size, 'bytes');
-      // Convert Blob to ArrayBuffer
       return blob;
     } catch (err) {
       console.error('[Hook] PDF processing error:', err);
@@ -44,9 +95,106 @@ export const usePdfiumPDFRemover = () => {
     }
   };
 
+  /**
+   * Process a PDF and stream the decrypted output into a WritableStream
+   * @param {ArrayBuffer|File|Object} pdfData - PDF bytes (transferred to the worker), a File the
+   *   worker reads on demand, or a handle from openDocument
+   * @param {string} password - The password to use for decryption
+   * @param {WritableStream} writable - Destination for the decrypted bytes
+   * @param {Object} [options] - `signal` and `onProgress`, as for processPDFWithPdfium
+   * @returns {Promise<{size: number}>} Number of bytes written
+   */
+  const processPDFToStream = async (pdfData, password, writable, options = {}) => {
+    console.log('[Hook] Streaming PDF output, input size:', pdfData.byteLength ?? pdfData.size);
+    const { size } = await getPdfiumEngine().removePasswordToStream(
+      pdfData,
+      password,
+      writable,
+      options,
+    );
+    console.log('[Hook] Streamed output size:', size, 'bytes');
+    return { size };
+  };
+
+  /**
+   * Keep a selected PDF resident in the worker between password attempts
+   * The worker reads the file into its wasm heap once; pass the handle to
+   * processPDFWithPdfium / processPDFToStream in place of the bytes
+   * @param {File} file - Selected PDF
+   * @returns {Promise<Object>} Document handle; release it with closeDocument
+   */
+  const openDocument = async (file) => {
+    const handle = await getPdfiumEngine().openDocument(file);
+    console.log('[Hook] Document resident in worker:', handle.size, 'bytes');
+    return handle;
+  };
+
+  /**
+   * Release a handle from openDocument
+   * @param {Object} handle
+   * @returns {Promise<void>}
+   */
+  const closeDocument = (handle) => getPdfiumEngine().closeDocument(handle);
+
+  /**
+   * Remove the password from many PDFs across the worker pool
+   * @param {File[]} files - PDFs to unlock
+   * @param {string} password - Password shared by every file
+   * @param {Object} [callbacks] - `onFileProgress` / `onProgress` listeners and an abort `signal`
+   * @returns {Promise<Array<{file: File, blob?: Blob, error?: Error}>>} Results in input order
+   */
+  const processPDFBatch = async (files, password, callbacks) => {
+    console.log('[Hook] Starting batch of', files.length, 'files');
+    const results = await getPdfiumPool().runBatch(files, password, callbacks);
+    console.log('[Hook] Batch finished:', results.filter((r) => r.blob).length, 'succeeded');
+    return results;
+  };
+
+  /**
+   * Unlock a PDF with whichever of several candidate passwords verifies
+   * Candidates are key-checked across the worker pool against /Encrypt alone;
+   * the document is loaded and saved once, with the winner. Files the key check
+   * cannot handle fall back to a full attempt per candidate
+   * @param {File} file - PDF to unlock
+   * @param {string[]} passwords - Candidate passwords
+   * @returns {Promise<{blob: Blob, password: string|null}>} The decrypted PDF and the
+   *   password that opened it (null when the file was not encrypted)
+   * @throws {Error} When no candidate opens the file
+   */
+  const processPDFWithCandidates = async (file, passwords) => {
+    console.log('[Hook] Checking', passwords.length, 'candidate passwords');
+    let match;
+    try {
+      match = await getPdfiumPool().findPassword(file, passwords);
+    } catch (err) {
+      console.warn('[Hook] Key check unavailable, trying candidates one by one:', err.message);
+      for (const password of passwords) {
+        try {
+          const blob = await getPdfiumEngine().removePassword(file, password);
+          return { blob, password };
+        } catch (attemptErr) {
+          if (attemptErr.message !== PASSWORD_ERROR_MESSAGE) throw attemptErr;
+        }
+      }
+      throw new Error(PASSWORD_ERROR_MESSAGE);
+    }
+
+    if (match.encrypted && match.index < 0) throw new Error(PASSWORD_ERROR_MESSAGE);
+    console.log('[Hook] Candidate', match.index, 'verified');
+    const blob = await getPdfiumEngine().removePassword(file, match.password || '');
+    return { blob, password: match.password };
+  };
+
   return {
     isLoading,
+    initMetrics,
+    prewarm,
     processPDFWithPdfium,
-    isPdfiumAvailable: !isLoading,
+    processPDFToStream,
+    processPDFBatch,
+    processPDFWithCandidates,
+    openDocument,
+    closeDocument,
+    isPdfiumAvailable: isReady,
   };
 };
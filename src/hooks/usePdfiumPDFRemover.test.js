@@ -1,27 +1,82 @@
 /**
  * Unit tests for usePdfiumPDFRemover hook
- * Tests WebAssembly initialization and PDF processing
+ * Tests worker engine wiring and PDF processing
  */
 
-import { renderHook, act } from '@testing-library/react';
+import { renderHook, act, waitFor } from '@testing-library/react';
 import { usePdfiumPDFRemover } from './usePdfiumPDFRemover';
 
-jest.mock('../utils/pdfiumRemover');
+jest.mock('../utils/pdfiumEngine');
+jest.mock('../utils/pdfiumPool');
 
-const mockPdfiumRemover = require('../utils/pdfiumRemover').pdfiumRemover;
+const mockGetPdfiumEngine = require('../utils/pdfiumEngine').getPdfiumEngine;
+const mockGetPdfiumPool = require('../utils/pdfiumPool').getPdfiumPool;
+const mockInit = jest.fn();
+const mockRemovePassword = jest.fn();
+const mockRemovePasswordToStream = jest.fn();
+const mockRunBatch = jest.fn();
+const mockFindPassword = jest.fn();
+const mockOpenDocument = jest.fn();
+const mockCloseDocument = jest.fn();
 
 describe('usePdfiumPDFRemover', () => {
   beforeEach(() => {
     jest.clearAllMocks();
+    mockInit.mockResolvedValue({ ready: true, metrics: { source: 'cache', totalMs: 5 } });
+    mockGetPdfiumEngine.mockReturnValue({
+      init: mockInit,
+      removePassword: mockRemovePassword,
+      removePasswordToStream: mockRemovePasswordToStream,
+      openDocument: mockOpenDocument,
+      closeDocument: mockCloseDocument,
+    });
+    mockGetPdfiumPool.mockReturnValue({ runBatch: mockRunBatch, findPassword: mockFindPassword });
   });
 
   describe('Initialization', () => {
     it('should initialize hook with default values', () => {
       const { result } = renderHook(() => usePdfiumPDFRemover());
 
+      expect(result.current.isLoading).toBe(true);
+      expect(result.current.isPdfiumAvailable).toBe(false);
+      expect(result.current.initMetrics).toBeNull();
+      expect(typeof result.current.processPDFWithPdfium).toBe('function');
+    });
+
+    it('should pre-warm the engine at idle time after mount', async () => {
+      const { result } = renderHook(() => usePdfiumPDFRemover());
+
+      await waitFor(() => {
+        expect(result.current.isPdfiumAvailable).toBe(true);
+      });
+
+      expect(mockInit).toHaveBeenCalledTimes(1);
       expect(result.current.isLoading).toBe(false);
+      expect(result.current.initMetrics).toEqual({ source: 'cache', totalMs: 5 });
+    });
+
+    it('should share one initialization between prewarm calls', async () => {
+      const { result } = renderHook(() => usePdfiumPDFRemover());
+
+      await act(async () => {
+        await Promise.all([result.current.prewarm(), result.current.prewarm()]);
+      });
+
+      expect(mockInit).toHaveBeenCalledTimes(1);
       expect(result.current.isPdfiumAvailable).toBe(true);
-      expect(typeof result.current.processPDFWithPdfium).toBe('function');
+    });
+
+    it('should report unavailable when initialization fails', async () => {
+      mockInit.mockRejectedValueOnce(new Error('network down'));
+
+      const { result } = renderHook(() => usePdfiumPDFRemover());
+
+      await act(async () => {
+        await result.current.prewarm();
+      });
+
+      expect(result.current.isLoading).toBe(false);
+      expect(result.current.isPdfiumAvailable).toBe(false);
     });
 
     it('should provide processPDFWithPdfium function', () => {
@@ -35,7 +90,7 @@ describe('usePdfiumPDFRemover', () => {
   describe('PDF Processing', () => {
     it('should process PDF successfully', async () => {
       const mockBlob = new Blob(['processed PDF'], { type: 'application/pdf' });
-      mockPdfiumRemover.mockResolvedValueOnce(mockBlob);
+      mockRemovePassword.mockResolvedValueOnce(mockBlob);
 
       const { result } = renderHook(() => usePdfiumPDFRemover());
 
@@ -48,13 +103,13 @@ describe('usePdfiumPDFRemover', () => {
         processedBlob = await result.current.processPDFWithPdfium(pdfData, password);
       });
 
-      expect(mockPdfiumRemover).toHaveBeenCalledWith(pdfData, password);
+      expect(mockRemovePassword).toHaveBeenCalledWith(pdfData, password, {});
       expect(processedBlob).toEqual(mockBlob);
     });
 
-    it('should return Blob from pdfiumRemover', async () => {
+    it('should return Blob from the engine', async () => {
       const mockBlob = new Blob(['test'], { type: 'application/pdf' });
-      mockPdfiumRemover.mockResolvedValueOnce(mockBlob);
+      mockRemovePassword.mockResolvedValueOnce(mockBlob);
 
       const { result } = renderHook(() => usePdfiumPDFRemover());
 
@@ -69,7 +124,7 @@ describe('usePdfiumPDFRemover', () => {
 
     it('should handle processing errors', async () => {
       const error = new Error('PDF processing failed');
-      mockPdfiumRemover.mockRejectedValueOnce(error);
+      mockRemovePassword.mockRejectedValueOnce(error);
 
       const { result } = renderHook(() => usePdfiumPDFRemover());
 
@@ -80,8 +135,8 @@ describe('usePdfiumPDFRemover', () => {
       ).rejects.toThrow();
     });
 
-    it('should pass correct parameters to pdfiumRemover', async () => {
-      mockPdfiumRemover.mockResolvedValueOnce(new Blob());
+    it('should pass correct parameters to the engine', async () => {
+      mockRemovePassword.mockResolvedValueOnce(new Blob());
 
       const { result } = renderHook(() => usePdfiumPDFRemover());
 
@@ -92,13 +147,13 @@ describe('usePdfiumPDFRemover', () => {
         await result.current.processPDFWithPdfium(pdfData, password);
       });
 
-      expect(mockPdfiumRemover).toHaveBeenCalledWith(pdfData, password);
+      expect(mockRemovePassword).toHaveBeenCalledWith(pdfData, password, {});
     });
   });
 
   describe('Multiple Processing', () => {
     it('should handle multiple PDF processing calls', async () => {
-      mockPdfiumRemover.mockResolvedValue(new Blob(['processed']));
+      mockRemovePassword.mockResolvedValue(new Blob(['processed']));
 
       const { result } = renderHook(() => usePdfiumPDFRemover());
 
@@ -110,13 +165,13 @@ describe('usePdfiumPDFRemover', () => {
         await result.current.processPDFWithPdfium(pdfData2, 'password2');
       });
 
-      expect(mockPdfiumRemover).toHaveBeenCalledTimes(2);
-      expect(mockPdfiumRemover).toHaveBeenNthCalledWith(1, pdfData1, 'password1');
-      expect(mockPdfiumRemover).toHaveBeenNthCalledWith(2, pdfData2, 'password2');
+      expect(mockRemovePassword).toHaveBeenCalledTimes(2);
+      expect(mockRemovePassword).toHaveBeenNthCalledWith(1, pdfData1, 'password1');
+      expect(mockRemovePassword).toHaveBeenNthCalledWith(2, pdfData2, 'password2');
     });
 
     it('should independently handle success and failure', async () => {
-      mockPdfiumRemover
+      mockRemovePassword
         .mockResolvedValueOnce(new Blob(['success']))
         .mockRejectedValueOnce(new Error('failure'));
 
@@ -136,17 +191,137 @@ describe('usePdfiumPDFRemover', () => {
     });
   });
 
-  describe('State Management', () => {
-    it('should maintain isPdfiumAvailable as true', () => {
+  describe('Streaming Processing', () => {
+    it('should stream output through the engine into the sink', async () => {
+      const sink = { getWriter: jest.fn() };
+      mockRemovePasswordToStream.mockResolvedValueOnce({ size: 42 });
+
       const { result } = renderHook(() => usePdfiumPDFRemover());
+      const pdfData = new ArrayBuffer(100);
+
+      const written = await result.current.processPDFToStream(pdfData, 'password', sink);
+
+      expect(mockRemovePasswordToStream).toHaveBeenCalledWith(pdfData, 'password', sink, {});
+      expect(written).toEqual({ size: 42 });
+    });
+  });
+
+  describe('Resident Documents', () => {
+    it('should open the file in the engine and close it by handle', async () => {
+      const handle = { documentId: 3, size: 8 };
+      mockOpenDocument.mockResolvedValueOnce(handle);
+
+      const { result } = renderHook(() => usePdfiumPDFRemover());
+      const file = new File(['%PDF-1.7'], 'a.pdf');
+      const opened = await result.current.openDocument(file);
+      await result.current.closeDocument(opened);
+
+      // The worker reads the File itself
+      expect(mockOpenDocument).toHaveBeenCalledWith(file);
+      expect(opened).toBe(handle);
+      expect(mockCloseDocument).toHaveBeenCalledWith(handle);
+    });
+  });
+
+  describe('Batch Processing', () => {
+    it('should run batches on the shared worker pool', async () => {
+      const files = [new File(['a'], 'a.pdf'), new File(['b'], 'b.pdf')];
+      const batchResults = files.map((file) => ({ file, blob: new Blob([file]) }));
+      const callbacks = { onProgress: jest.fn() };
+      mockRunBatch.mockResolvedValueOnce(batchResults);
+
+      const { result } = renderHook(() => usePdfiumPDFRemover());
+
+      const results = await result.current.processPDFBatch(files, 'password', callbacks);
+
+      expect(mockRunBatch).toHaveBeenCalledWith(files, 'password', callbacks);
+      expect(results).toBe(batchResults);
+    });
+  });
+
+  describe('Candidate Passwords', () => {
+    const file = new File(['%PDF-1.7'], 'statement.pdf');
+
+    it('should decrypt once, with the candidate that verifies', async () => {
+      mockFindPassword.mockResolvedValueOnce({ encrypted: true, index: 1, password: 'b' });
+      mockRemovePassword.mockResolvedValueOnce(new Blob(['ok']));
+
+      const { result } = renderHook(() => usePdfiumPDFRemover());
+      const unlocked = await result.current.processPDFWithCandidates(file, ['a', 'b', 'c']);
+
+      expect(mockFindPassword).toHaveBeenCalledWith(file, ['a', 'b', 'c']);
+      expect(mockRemovePassword).toHaveBeenCalledTimes(1);
+      expect(mockRemovePassword).toHaveBeenCalledWith(file, 'b');
+      expect(unlocked.password).toBe('b');
+    });
+
+    it('should reject without decrypting when no candidate verifies', async () => {
+      mockFindPassword.mockResolvedValueOnce({ encrypted: true, index: -1, password: null });
+
+      const { result } = renderHook(() => usePdfiumPDFRemover());
+
+      await expect(result.current.processPDFWithCandidates(file, ['a'])).rejects.toThrow(
+        'incorrect password',
+      );
+      expect(mockRemovePassword).not.toHaveBeenCalled();
+    });
+
+    it('should try each candidate in full when the key check is unsupported', async () => {
+      mockFindPassword.mockRejectedValueOnce(new Error('Unsupported security handler'));
+      mockRemovePassword
+        .mockRejectedValueOnce(new Error('Password required or incorrect password'))
+        .mockResolvedValueOnce(new Blob(['ok']));
+
+      const { result } = renderHook(() => usePdfiumPDFRemover());
+      const unlocked = await result.current.processPDFWithCandidates(file, ['a', 'b', 'c']);
+
+      expect(mockRemovePassword).toHaveBeenCalledTimes(2);
+      expect(unlocked.password).toBe('b');
+    });
+  });
+
+  describe('Job Metrics', () => {
+    it('should subscribe onMetrics to the engine and the pool while mounted', () => {
+      const listeners = [];
+      const unsubscribe = jest.fn();
+      const addMetricsListener = jest.fn((listener) => {
+        listeners.push(listener);
+        return unsubscribe;
+      });
+      mockGetPdfiumEngine.mockReturnValue({ init: mockInit, addMetricsListener });
+      mockGetPdfiumPool.mockReturnValue({ runBatch: mockRunBatch, addMetricsListener });
+      const onMetrics = jest.fn();
+
+      const { unmount } = renderHook(() => usePdfiumPDFRemover({ onMetrics }));
+      listeners.forEach((listener) => listener({ engine: 'pdfium' }));
+
+      expect(addMetricsListener).toHaveBeenCalledTimes(2);
+      expect(onMetrics).toHaveBeenCalledTimes(2);
+      expect(onMetrics).toHaveBeenCalledWith({ engine: 'pdfium' });
+
+      unmount();
+      expect(unsubscribe).toHaveBeenCalledTimes(2);
+    });
+  });
+
+  describe('State Management', () => {
+    it('should maintain isPdfiumAvailable as true once ready', async () => {
+      const { result, rerender } = renderHook(() => usePdfiumPDFRemover());
+
+      await waitFor(() => {
+        expect(result.current.isPdfiumAvailable).toBe(true);
+      });
+      rerender();
 
       expect(result.current.isPdfiumAvailable).toBe(true);
     });
 
-    it('should maintain isLoading as false after initialization', () => {
+    it('should maintain isLoading as false after initialization', async () => {
       const { result } = renderHook(() => usePdfiumPDFRemover());
 
-      expect(result.current.isLoading).toBe(false);
+      await waitFor(() => {
+        expect(result.current.isLoading).toBe(false);
+      });
     });
 
     it('should maintain processPDFWithPdfium consistency across renders', () => {
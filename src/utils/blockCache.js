@@ -0,0 +1,78 @@
+/**
+ * Fixed-size block cache with least-recently-used eviction
+ *
+ * Serves arbitrary byte ranges out of aligned blocks fetched through a
+ * synchronous `readBlock` callback, so repeated reads of the same region (xref
+ * tables, object streams) do not go back to the underlying file.
+ */
+
+const DEFAULT_BLOCK_SIZE = 256 * 1024;
+const DEFAULT_MAX_BLOCKS = 64;
+
+/**
+ * Create a block cache
+ * @param {Object} options
+ * @param {number} options.size - Total size of the underlying source in bytes
+ * @param {(position: number, length: number) => Uint8Array} options.readBlock - Synchronous reader
+ * @param {number} [options.blockSize] - Block size in bytes
+ * @param {number} [options.maxBlocks] - Number of blocks kept in memory
+ */
+export const createBlockCache = ({
+  size,
+  readBlock,
+  blockSize = DEFAULT_BLOCK_SIZE,
+  maxBlocks = DEFAULT_MAX_BLOCKS,
+}) => {
+  // Map iteration order doubles as the LRU order (oldest first)
+  const blocks = new Map();
+  const stats = { hits: 0, misses: 0 };
+
+  const getBlock = (index) => {
+    let block = blocks.get(index);
+    if (block) {
+      stats.hits += 1;
+      blocks.delete(index);
+    } else {
+      stats.misses += 1;
+      const start = index * blockSize;
+      const length = Math.min(blockSize, size - start);
+      block = readBlock(start, length);
+      // A short read (the file shrank, or an I/O error) is not kept; `read` fails on it
+      if (block.length < length) return block;
+      if (blocks.size >= maxBlocks) {
+        blocks.delete(blocks.keys().next().value);
+      }
+    }
+    blocks.set(index, block);
+    return block;
+  };
+
+  /**
+   * Copy `target.length` bytes starting at `position` into `target`
+   * @returns {boolean} false when the range is outside the source, or `readBlock` came
+   *   back short of it
+   */
+  const read = (position, target) => {
+    if (position < 0 || position + target.length > size) return false;
+
+    let copied = 0;
+    while (copied < target.length) {
+      const offset = position + copied;
+      const index = Math.floor(offset / blockSize);
+      const block = getBlock(index);
+      const blockOffset = offset - index * blockSize;
+      if (block.length <= blockOffset) return false;
+      const length = Math.min(block.length - blockOffset, target.length - copied);
+      target.set(block.subarray(blockOffset, blockOffset + length), copied);
+      copied += length;
+    }
+    return true;
+  };
+
+  /**
+   * Drop every cached block
+   */
+  const clear = () => blocks.clear();
+
+  return { read, clear, stats };
+};
@@ -0,0 +1,80 @@
+/**
+ * Unit tests for blockCache utility
+ * Tests range reads across block boundaries, LRU eviction and short reads
+ */
+
+import { createBlockCache } from './blockCache';
+
+describe('createBlockCache', () => {
+  const source = Uint8Array.from({ length: 1000 }, (_, i) => i % 251);
+  const createReader = () =>
+    jest.fn((position, length) => source.slice(position, position + length));
+
+  it('should copy ranges that span several blocks', () => {
+    const readBlock = createReader();
+    const cache = createBlockCache({ size: source.length, readBlock, blockSize: 64 });
+    const target = new Uint8Array(200);
+
+    expect(cache.read(500, target)).toBe(true);
+    expect(target).toEqual(source.slice(500, 700));
+  });
+
+  it('should serve repeated reads from memory', () => {
+    const readBlock = createReader();
+    const cache = createBlockCache({ size: source.length, readBlock, blockSize: 64 });
+
+    cache.read(10, new Uint8Array(10));
+    cache.read(20, new Uint8Array(10));
+
+    expect(readBlock).toHaveBeenCalledTimes(1);
+    expect(cache.stats).toEqual({ hits: 1, misses: 1 });
+  });
+
+  it('should evict the least recently used block', () => {
+    const readBlock = createReader();
+    const cache = createBlockCache({
+      size: source.length,
+      readBlock,
+      blockSize: 64,
+      maxBlocks: 2,
+    });
+
+    cache.read(0, new Uint8Array(1)); // block 0
+    cache.read(64, new Uint8Array(1)); // block 1
+    cache.read(0, new Uint8Array(1)); // block 0 becomes most recent
+    cache.read(128, new Uint8Array(1)); // evicts block 1
+    cache.read(0, new Uint8Array(1)); // still cached
+    cache.read(64, new Uint8Array(1)); // read again
+
+    expect(readBlock).toHaveBeenCalledTimes(4);
+  });
+
+  it('should read a short final block', () => {
+    const readBlock = createReader();
+    const cache = createBlockCache({ size: source.length, readBlock, blockSize: 64 });
+    const target = new Uint8Array(8);
+
+    expect(cache.read(992, target)).toBe(true);
+    expect(target).toEqual(source.slice(992));
+    expect(readBlock).toHaveBeenCalledWith(960, 40);
+  });
+
+  it('should reject ranges outside the source', () => {
+    const cache = createBlockCache({ size: source.length, readBlock: createReader() });
+
+    expect(cache.read(995, new Uint8Array(10))).toBe(false);
+    expect(cache.read(-1, new Uint8Array(1))).toBe(false);
+  });
+
+  it('should fail a read the source comes back short of, without caching it', () => {
+    // The file shrank after the size was taken: reads stop at byte 100
+    const readBlock = jest.fn((position, length) =>
+      source.slice(position, Math.min(position + length, 100)),
+    );
+    const cache = createBlockCache({ size: source.length, readBlock, blockSize: 64 });
+
+    expect(cache.read(96, new Uint8Array(8))).toBe(false);
+    expect(cache.read(96, new Uint8Array(8))).toBe(false);
+    expect(cache.stats.hits).toBe(0);
+  });
+});
@@ -0,0 +1,38 @@
+import { getUnlockedFileName } from './downloadBlob';
+
+/**
+ * Ask the user where to save the unlocked PDF and open a writable stream to it
+ * Uses the File System Access API so output can be streamed straight to disk
+ * Must be called from a user gesture (before any other await in the handler)
+ * @param {string} fileName - Original file name
+ * @returns {Promise<WritableStream|null>} Writable file stream, or null when unsupported
+ */
+export const createFileSink = async (fileName) => {
+  if (typeof window.showSaveFilePicker !== 'function') return null;
+
+  const handle = await window.showSaveFilePicker({
+    suggestedName: getUnlockedFileName(fileName),
+    types: [{ description: 'PDF document', accept: { 'application/pdf': ['.pdf'] } }],
+  });
+  return handle.createWritable();
+};
+
+/**
+ * Name offered for the archive of a batch
+ */
+export const BATCH_ARCHIVE_NAME = 'unlocked_pdfs.zip';
+
+/**
+ * Ask the user where to save the ZIP archive of a batch and open a writable stream to it
+ * Same rules as createFileSink: call it from the user gesture, before any other await
+ * @returns {Promise<WritableStream|null>} Writable file stream, or null when unsupported
+ */
+export const createArchiveSink = async () => {
+  if (typeof window.showSaveFilePicker !== 'function') return null;
+
+  const handle = await window.showSaveFilePicker({
+    suggestedName: BATCH_ARCHIVE_NAME,
+    types: [{ description: 'ZIP archive', accept: { 'application/zip': ['.zip'] } }],
+  });
+  return handle.createWritable();
+};
@@ -0,0 +1,52 @@
+/**
+ * Unit tests for createFileSink utility
+ * Tests File System Access API detection and save dialog options
+ */
+
+import { BATCH_ARCHIVE_NAME, createArchiveSink, createFileSink } from './createFileSink';
+
+describe('createFileSink', () => {
+  afterEach(() => {
+    delete window.showSaveFilePicker;
+  });
+
+  it('should return null when the File System Access API is unavailable', async () => {
+    await expect(createFileSink('test.pdf')).resolves.toBeNull();
+  });
+
+  it('should open a writable stream for the chosen file', async () => {
+    const writable = { getWriter: jest.fn() };
+    const handle = { createWritable: jest.fn(async () => writable) };
+    window.showSaveFilePicker = jest.fn(async () => handle);
+
+    const sink = await createFileSink('statement.pdf');
+
+    expect(sink).toBe(writable);
+    expect(window.showSaveFilePicker).toHaveBeenCalledWith(
+      expect.objectContaining({ suggestedName: 'statement_unlocked.pdf' }),
+    );
+  });
+
+  it('should propagate the AbortError when the dialog is dismissed', async () => {
+    const abortError = new Error('The user aborted a request.');
+    abortError.name = 'AbortError';
+    window.showSaveFilePicker = jest.fn(async () => {
+      throw abortError;
+    });
+
+    await expect(createFileSink('test.pdf')).rejects.toThrow(abortError);
+  });
+
+  it('should open the batch archive as a .zip', async () => {
+    const writable = { getWriter: jest.fn() };
+    window.showSaveFilePicker = jest.fn(async () => ({ createWritable: async () => writable }));
+
+    await expect(createArchiveSink()).resolves.toBe(writable);
+    expect(window.showSaveFilePicker).toHaveBeenCalledWith(
+      expect.objectContaining({
+        suggestedName: BATCH_ARCHIVE_NAME,
+        types: [expect.objectContaining({ accept: { 'application/zip': ['.zip'] } })],
+      }),
+    );
+  });
+});
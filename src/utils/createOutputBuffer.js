@@ -0,0 +1,88 @@
+/**
+ * Append-only output buffer for FPDF_SaveAsCopy
+ *
+ * WriteBlock hands over many small blocks. Appending them to one buffer that
+ * grows geometrically avoids one JS allocation per block and the final
+ * concatenation pass: the finished document is a single transferable
+ * ArrayBuffer.
+ *
+ * Where resizable ArrayBuffers are supported the buffer grows in place (the
+ * address space is reserved up front, pages are committed as it grows) and is
+ * handed over with transferToFixedLength (a single final copy where that is
+ * missing). Elsewhere growth reallocates, which still keeps the total copy
+ * cost linear in the output size.
+ */
+
+const MIN_CAPACITY = 64 * 1024;
+// Default limit, the wasm32 heap limit; memory64 jobs pass their build's larger one
+export const MAX_OUTPUT_BYTES = 2 * 1024 * 1024 * 1024;
+
+const supportsResizable = () => typeof ArrayBuffer.prototype.resize === 'function';
+
+/**
+ * @param {Object} [options]
+ * @param {number} [options.sizeHint] - Expected output size (e.g. the input size)
+ * @param {number} [options.maxByteLength] - Hard limit; appending past it throws
+ * @param {boolean} [options.resizable] - Use a resizable ArrayBuffer (default: when supported)
+ * @returns {{append: (bytes: Uint8Array) => void, length: number, finish: () => ArrayBuffer}}
+ */
+export const createOutputBuffer = ({
+  sizeHint = 0,
+  maxByteLength = MAX_OUTPUT_BYTES,
+  resizable = supportsResizable(),
+} = {}) => {
+  let capacity = Math.min(Math.max(MIN_CAPACITY, sizeHint), maxByteLength);
+  let buffer = null;
+  if (resizable) {
+    try {
+      buffer = new ArrayBuffer(capacity, { maxByteLength });
+    } catch {
+      // The reservation can fail where address space is short (32-bit)
+      resizable = false;
+    }
+  }
+  if (!buffer) buffer = new ArrayBuffer(capacity);
+  let bytes = new Uint8Array(buffer);
+  let length = 0;
+
+  const grow = (needed) => {
+    if (needed > maxByteLength) {
+      throw new RangeError(`Output exceeds ${maxByteLength} bytes`);
+    }
+    capacity = Math.min(Math.max(needed, capacity * 2), maxByteLength);
+    if (resizable) {
+      buffer.resize(capacity);
+    } else {
+      const next = new ArrayBuffer(capacity);
+      new Uint8Array(next).set(bytes.subarray(0, length));
+      buffer = next;
+    }
+    bytes = new Uint8Array(buffer);
+  };
+
+  return {
+    append: (chunk) => {
+      if (length + chunk.length > capacity) grow(length + chunk.length);
+      bytes.set(chunk, length);
+      length += chunk.length;
+    },
+
+    get length() {
+      return length;
+    },
+
+    /**
+     * Hand over the written bytes as an exactly sized, fixed-length ArrayBuffer
+     * The output buffer must not be used afterwards
+     */
+    finish: () => {
+      if (resizable) {
+        buffer.resize(length);
+        return typeof buffer.transferToFixedLength === 'function'
+          ? buffer.transferToFixedLength()
+          : buffer.slice(0);
+      }
+      return length === capacity ? buffer : buffer.slice(0, length);
+    },
+  };
+};
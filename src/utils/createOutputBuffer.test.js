@@ -0,0 +1,52 @@
+/**
+ * Unit tests for createOutputBuffer utility
+ * Tests appending, geometric growth and the hand-over of the finished buffer
+ */
+
+import { createOutputBuffer } from './createOutputBuffer';
+
+describe('createOutputBuffer', () => {
+  const block = (size, fill) => new Uint8Array(size).fill(fill);
+
+  describe.each([
+    ['resizable', true],
+    ['reallocating', false],
+  ])('%s', (_, resizable) => {
+    it('should return exactly the appended bytes', () => {
+      const output = createOutputBuffer({ resizable });
+      output.append(Uint8Array.of(1, 2, 3));
+      output.append(Uint8Array.of(4, 5));
+
+      const buffer = output.finish();
+
+      expect(buffer).toBeInstanceOf(ArrayBuffer);
+      expect(buffer.resizable).toBeFalsy();
+      expect(new Uint8Array(buffer)).toEqual(Uint8Array.of(1, 2, 3, 4, 5));
+    });
+
+    it('should grow past the size hint without losing data', () => {
+      const output = createOutputBuffer({ sizeHint: 1, resizable });
+      const blocks = [block(40000, 1), block(40000, 2), block(100000, 3)];
+      blocks.forEach((bytes) => output.append(bytes));
+
+      const result = new Uint8Array(output.finish());
+
+      expect(output.length).toBe(180000);
+      expect(result).toHaveLength(180000);
+      expect(result[39999]).toBe(1);
+      expect(result[40000]).toBe(2);
+      expect(result[179999]).toBe(3);
+    });
+
+    it('should refuse to grow past maxByteLength', () => {
+      const output = createOutputBuffer({ maxByteLength: 70000, resizable });
+      output.append(block(60000, 1));
+
+      expect(() => output.append(block(20000, 1))).toThrow('Output exceeds 70000 bytes');
+    });
+  });
+
+  it('should hand back an empty buffer when nothing was written', () => {
+    expect(createOutputBuffer().finish().byteLength).toBe(0);
+  });
+});
@@ -0,0 +1,7 @@
+/**
+ * Spawn a PDFium engine worker
+ * Kept in its own module so tests can replace the worker with an in-process fake
+ * @returns {Worker}
+ */
+export const createPdfiumWorker = () =>
+  new Worker(new URL('../workers/pdfium.worker.js', import.meta.url), { type: 'module' });
@@ -0,0 +1,236 @@
+/**
+ * Store-only ZIP archive written incrementally to a WritableStream
+ *
+ * Batch results are appended as each job finishes: a local header, then the
+ * decrypted PDF as it is (PDF streams are already compressed, so there is no
+ * deflate pass), and the central directory once the batch is done. Only the
+ * directory entries stay in memory; each Blob can be dropped once its entry is
+ * written. Entry data is written as the Blob itself, which
+ * FileSystemWritableFileStream and createBlobCollector both accept without
+ * copying it into JS memory; it is only read in slices for the CRC-32.
+ *
+ * Archives past 4 GiB or 65535 entries get ZIP64 end records.
+ */
+
+const CRC_CHUNK_SIZE = 4 * 1024 * 1024;
+const MAX_UINT16 = 0xffff;
+const MAX_UINT32 = 0xffffffff;
+
+const LOCAL_HEADER_SIZE = 30;
+const CENTRAL_HEADER_SIZE = 46;
+const ZIP64_OFFSET_EXTRA_SIZE = 12;
+const ZIP64_END_SIZE = 56;
+const ZIP64_LOCATOR_SIZE = 20;
+const END_SIZE = 22;
+
+// General purpose flag bit 11: names are UTF-8
+const FLAG_UTF8 = 0x0800;
+const VERSION_DEFAULT = 20;
+const VERSION_ZIP64 = 45;
+
+const encoder = new TextEncoder();
+
+const CRC_TABLE = (() => {
+  const table = new Uint32Array(256);
+  for (let n = 0; n < 256; n++) {
+    let c = n;
+    for (let k = 0; k < 8; k++) c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+    table[n] = c >>> 0;
+  }
+  return table;
+})();
+
+/**
+ * CRC-32 (ISO 3309) of a Blob, read in slices
+ */
+export const crc32 = async (blob) => {
+  let crc = MAX_UINT32;
+  for (let offset = 0; offset < blob.size; offset += CRC_CHUNK_SIZE) {
+    const bytes = new Uint8Array(await blob.slice(offset, offset + CRC_CHUNK_SIZE).arrayBuffer());
+    for (let i = 0; i < bytes.length; i++) {
+      crc = CRC_TABLE[(crc ^ bytes[i]) & 0xff] ^ (crc >>> 8);
+    }
+  }
+  return (crc ^ MAX_UINT32) >>> 0;
+};
+
+// MS-DOS date and time fields (local time, 2 second resolution, from 1980)
+const toDosDateTime = (date) => ({
+  time: (date.getHours() << 11) | (date.getMinutes() << 5) | (date.getSeconds() >> 1),
+  date:
+    (Math.max(date.getFullYear() - 1980, 0) << 9) | ((date.getMonth() + 1) << 5) | date.getDate(),
+});
+
+// "name.pdf", "name (2).pdf", ... so same-named inputs don't overwrite each other on extraction
+const createNamer = () => {
+  const used = new Set();
+  return (name) => {
+    let candidate = name;
+    for (let n = 2; used.has(candidate.toLowerCase()); n++) {
+      candidate = name.replace(/(\.[^./]*)?$/, (extension) => ` (${n})${extension}`);
+    }
+    used.add(candidate.toLowerCase());
+    return candidate;
+  };
+};
+
+const localHeader = (entry) => {
+  const bytes = new Uint8Array(LOCAL_HEADER_SIZE + entry.name.length);
+  const view = new DataView(bytes.buffer);
+  view.setUint32(0, 0x04034b50, true);
+  view.setUint16(4, VERSION_DEFAULT, true);
+  view.setUint16(6, FLAG_UTF8, true);
+  view.setUint16(8, 0, true); // stored
+  view.setUint16(10, entry.time, true);
+  view.setUint16(12, entry.date, true);
+  view.setUint32(14, entry.crc, true);
+  view.setUint32(18, entry.size, true);
+  view.setUint32(22, entry.size, true);
+  view.setUint16(26, entry.name.length, true);
+  view.setUint16(28, 0, true);
+  bytes.set(entry.name, LOCAL_HEADER_SIZE);
+  return bytes;
+};
+
+// Entries whose local header starts past 4 GiB carry their offset in a ZIP64 extra field
+const centralHeader = (entry) => {
+  const zip64 = entry.offset >= MAX_UINT32;
+  const extraSize = zip64 ? ZIP64_OFFSET_EXTRA_SIZE : 0;
+  const bytes = new Uint8Array(CENTRAL_HEADER_SIZE + entry.name.length + extraSize);
+  const view = new DataView(bytes.buffer);
+  const version = zip64 ? VERSION_ZIP64 : VERSION_DEFAULT;
+  view.setUint32(0, 0x02014b50, true);
+  view.setUint16(4, version, true);
+  view.setUint16(6, version, true);
+  view.setUint16(8, FLAG_UTF8, true);
+  view.setUint16(10, 0, true);
+  view.setUint16(12, entry.time, true);
+  view.setUint16(14, entry.date, true);
+  view.setUint32(16, entry.crc, true);
+  view.setUint32(20, entry.size, true);
+  view.setUint32(24, entry.size, true);
+  view.setUint16(28, entry.name.length, true);
+  view.setUint16(30, extraSize, true);
+  // Comment length, disk number, internal and external attributes stay 0
+  view.setUint32(42, zip64 ? MAX_UINT32 : entry.offset, true);
+  bytes.set(entry.name, CENTRAL_HEADER_SIZE);
+  if (zip64) {
+    const extra = CENTRAL_HEADER_SIZE + entry.name.length;
+    view.setUint16(extra, 0x0001, true);
+    view.setUint16(extra + 2, 8, true);
+    view.setBigUint64(extra + 4, BigInt(entry.offset), true);
+  }
+  return bytes;
+};
+
+const endRecords = (count, directoryOffset, directorySize) => {
+  const zip64 =
+    count >= MAX_UINT16 || directoryOffset >= MAX_UINT32 || directorySize >= MAX_UINT32;
+  const bytes = new Uint8Array((zip64 ? ZIP64_END_SIZE + ZIP64_LOCATOR_SIZE : 0) + END_SIZE);
+  const view = new DataView(bytes.buffer);
+  let at = 0;
+  if (zip64) {
+    const zip64EndOffset = directoryOffset + directorySize;
+    view.setUint32(0, 0x06064b50, true);
+    view.setBigUint64(4, BigInt(ZIP64_END_SIZE - 12), true);
+    view.setUint16(12, VERSION_ZIP64, true);
+    view.setUint16(14, VERSION_ZIP64, true);
+    view.setBigUint64(24, BigInt(count), true);
+    view.setBigUint64(32, BigInt(count), true);
+    view.setBigUint64(40, BigInt(directorySize), true);
+    view.setBigUint64(48, BigInt(directoryOffset), true);
+    view.setUint32(56, 0x07064b50, true);
+    view.setBigUint64(64, BigInt(zip64EndOffset), true);
+    view.setUint32(72, 1, true);
+    at = ZIP64_END_SIZE + ZIP64_LOCATOR_SIZE;
+  }
+  view.setUint32(at, 0x06054b50, true);
+  view.setUint16(at + 8, Math.min(count, MAX_UINT16), true);
+  view.setUint16(at + 10, Math.min(count, MAX_UINT16), true);
+  view.setUint32(at + 12, Math.min(directorySize, MAX_UINT32), true);
+  view.setUint32(at + 16, Math.min(directoryOffset, MAX_UINT32), true);
+  return bytes;
+};
+
+/**
+ * @param {WritableStream} writable - Destination (e.g. FileSystemWritableFileStream);
+ *   receives Uint8Array headers and Blob entry data
+ * @returns {{add: (name: string, blob: Blob, options?: {date?: Date}) => Promise<void>,
+ *   close: () => Promise<{entries: number, size: number}>, abort: (reason?: any) => Promise<void>}}
+ */
+export const createZipWriter = (writable) => {
+  const writer = writable.getWriter();
+  const uniqueName = createNamer();
+  const entries = [];
+  let position = 0;
+  // Entries are written one at a time, in the order add() was called
+  let queue = Promise.resolve();
+
+  const write = async (chunk) => {
+    await writer.ready;
+    await writer.write(chunk);
+    position += chunk instanceof Blob ? chunk.size : chunk.length;
+  };
+
+  const enqueue = (task) => {
+    const run = queue.then(task);
+    queue = run.catch(() => {});
+    return run;
+  };
+
+  return {
+    /**
+     * Append a file; resolves once its data has been handed to the stream
+     * @throws {RangeError} For files of 4 GiB and up (no engine produces them)
+     */
+    add: (name, blob, { date = new Date() } = {}) =>
+      enqueue(async () => {
+        if (blob.size >= MAX_UINT32) throw new RangeError(`${name} is too large for a ZIP entry`);
+        const entry = {
+          name: encoder.encode(uniqueName(name)),
+          crc: await crc32(blob),
+          size: blob.size,
+          offset: position,
+          ...toDosDateTime(date),
+        };
+        await write(localHeader(entry));
+        await write(blob);
+        entries.push(entry);
+      }),
+
+    /**
+     * Write the central directory and close the stream
+     */
+    close: () =>
+      enqueue(async () => {
+        const directoryOffset = position;
+        for (const entry of entries) await write(centralHeader(entry));
+        await write(endRecords(entries.length, directoryOffset, position - directoryOffset));
+        await writer.close();
+        return { entries: entries.length, size: position };
+      }),
+
+    /**
+     * Abandon the archive (a FileSystemWritableFileStream discards what was written)
+     */
+    abort: (reason) => writer.abort(reason),
+  };
+};
+
+/**
+ * In-memory destination for browsers without the File System Access API
+ * The parts are kept as written, so entry Blobs are not copied
+ * @param {string} type - MIME type of the finished Blob
+ * @returns {{writable: WritableStream, toBlob: () => Blob}}
+ */
+export const createBlobCollector = (type) => {
+  const parts = [];
+  return {
+    writable: new WritableStream({
+      write: (chunk) => {
+        parts.push(chunk);
+      },
+    }),
+    toBlob: () => new Blob(parts, { type }),
+  };
+};
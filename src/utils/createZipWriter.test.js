@@ -0,0 +1,124 @@
+/**
+ * Unit tests for the streamed ZIP writer
+ * Tests the store-only entry layout, CRC-32, name deduplication and write ordering
+ */
+
+import { crc32, createZipWriter } from './createZipWriter';
+
+// WritableStream stand-in that records every chunk it is handed
+const createRecordingStream = () => {
+  const chunks = [];
+  const writer = {
+    ready: Promise.resolve(),
+    write: jest.fn(async (chunk) => {
+      chunks.push(chunk);
+    }),
+    close: jest.fn(async () => {}),
+    abort: jest.fn(async () => {}),
+  };
+  return {
+    chunks,
+    writer,
+    writable: { getWriter: () => writer },
+    bytes: async () => new Uint8Array(await new Blob(chunks).arrayBuffer()),
+  };
+};
+
+const readEntries = (bytes) => {
+  const view = new DataView(bytes.buffer);
+  const end = bytes.length - 22;
+  expect(view.getUint32(end, true)).toBe(0x06054b50);
+  const count = view.getUint16(end + 10, true);
+  let at = view.getUint32(end + 16, true);
+  const entries = [];
+  for (let i = 0; i < count; i++) {
+    expect(view.getUint32(at, true)).toBe(0x02014b50);
+    const nameLength = view.getUint16(at + 28, true);
+    const offset = view.getUint32(at + 42, true);
+    const size = view.getUint32(at + 24, true);
+    const dataStart = offset + 30 + view.getUint16(offset + 26, true);
+    entries.push({
+      name: new TextDecoder().decode(bytes.subarray(at + 46, at + 46 + nameLength)),
+      method: view.getUint16(offset + 8, true),
+      crc: view.getUint32(at + 16, true),
+      data: new TextDecoder().decode(bytes.subarray(dataStart, dataStart + size)),
+    });
+    at += 46 + nameLength + view.getUint16(at + 30, true);
+  }
+  return entries;
+};
+
+describe('crc32', () => {
+  it('should match the standard check value', async () => {
+    await expect(crc32(new Blob(['123456789']))).resolves.toBe(0xcbf43926);
+    await expect(crc32(new Blob([]))).resolves.toBe(0);
+  });
+});
+
+describe('createZipWriter', () => {
+  it('should store each file uncompressed with its CRC-32', async () => {
+    const stream = createRecordingStream();
+    const zip = createZipWriter(stream.writable);
+
+    await zip.add('a_unlocked.pdf', new Blob(['%PDF-a']));
+    await zip.add('b_unlocked.pdf', new Blob(['%PDF-bb']));
+    const summary = await zip.close();
+
+    const bytes = await stream.bytes();
+    expect(summary).toEqual({ entries: 2, size: bytes.length });
+    expect(readEntries(bytes)).toEqual([
+      { name: 'a_unlocked.pdf', method: 0, crc: 0xa44ecfd4, data: '%PDF-a' },
+      { name: 'b_unlocked.pdf', method: 0, crc: 0xdb89e438, data: '%PDF-bb' },
+    ]);
+    expect(stream.writer.close).toHaveBeenCalled();
+  });
+
+  it('should hand entry data to the stream as the Blob itself', async () => {
+    const stream = createRecordingStream();
+    const zip = createZipWriter(stream.writable);
+    const blob = new Blob(['%PDF']);
+
+    await zip.add('a.pdf', blob);
+
+    expect(stream.chunks).toContain(blob);
+  });
+
+  it('should rename files that would collide on extraction', async () => {
+    const stream = createRecordingStream();
+    const zip = createZipWriter(stream.writable);
+
+    await Promise.all([
+      zip.add('report.pdf', new Blob(['1'])),
+      zip.add('Report.pdf', new Blob(['2'])),
+      zip.add('report.pdf', new Blob(['3'])),
+    ]);
+    await zip.close();
+
+    expect(readEntries(await stream.bytes()).map((entry) => entry.name)).toEqual([
+      'report.pdf',
+      'Report (2).pdf',
+      'report (3).pdf',
+    ]);
+  });
+
+  it('should write entries in the order they were added', async () => {
+    const stream = createRecordingStream();
+    const zip = createZipWriter(stream.writable);
+
+    const adds = ['a', 'b', 'c'].map((name) => zip.add(`${name}.pdf`, new Blob([name])));
+    await zip.close();
+    await Promise.all(adds);
+
+    expect(readEntries(await stream.bytes()).map((entry) => entry.data)).toEqual(['a', 'b', 'c']);
+  });
+
+  it('should abort the underlying stream', async () => {
+    const stream = createRecordingStream();
+    const zip = createZipWriter(stream.writable);
+    const reason = new Error('cancelled');
+
+    await zip.abort(reason);
+
+    expect(stream.writer.abort).toHaveBeenCalledWith(reason);
+  });
+});
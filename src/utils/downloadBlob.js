@@ -1,12 +1,22 @@
-export const downloadBlob = (pdfBlob, fileName) => {
+/**
+ * Name used for the unlocked copy: original filename with an _unlocked suffix
+ */
+export const getUnlockedFileName = (fileName) => {
+  const originalName = fileName.replace(/\.pdf$/i, '');
+  return `${originalName}_unlocked.pdf`;
+};
+
+/**
+ * Save a Blob through a synthetic download link
+ * @param {Blob} blob - Content to save
+ * @param {string} downloadName - Name offered for the download
+ */
+export const saveBlob = (blob, downloadName) => {
   // Create download link
-  const url = URL.createObjectURL(pdfBlob);
+  const url = URL.createObjectURL(blob);
   const a = document.createElement('a');
   a.href = url;
-
-  // Use original filename with _unlocked suffix
-  const originalName = fileName.replace(/\.pdf$/i, '');
-  a.download = `${originalName}_unlocked.pdf`;
+  a.download = downloadName;
 
   document.body.appendChild(a);
   a.click();
@@ -15,3 +25,8 @@ export const downloadBlob = (pdfBlob, fileName) => {
   // Clean up
   URL.revokeObjectURL(url);
 };
+
+export const downloadBlob = (pdfBlob, fileName) => {
+  // Use original filename with _unlocked suffix
+  saveBlob(pdfBlob, getUnlockedFileName(fileName));
+};
@@ -3,7 +3,7 @@
  * Tests PDF download functionality
  */
 
-import { downloadBlob } from './downloadBlob';
+import { downloadBlob, getUnlockedFileName, saveBlob } from './downloadBlob';
 
 describe('downloadBlob', () => {
   beforeEach(() => {
@@ -177,4 +177,24 @@ describe('downloadBlob', () => {
       expect(global.URL.createObjectURL).toHaveBeenCalledWith(mockBlob);
     });
   });
+
+  describe('getUnlockedFileName', () => {
+    it('should add the _unlocked suffix before the extension', () => {
+      expect(getUnlockedFileName('report.PDF')).toBe('report_unlocked.pdf');
+      expect(getUnlockedFileName('notes')).toBe('notes_unlocked.pdf');
+    });
+  });
+
+  describe('saveBlob', () => {
+    it('should offer the blob under the given name as it is', () => {
+      const mockBlob = new Blob(['zip'], { type: 'application/zip' });
+      const createElementSpy = jest.spyOn(document, 'createElement');
+
+      saveBlob(mockBlob, 'unlocked.zip');
+
+      expect(createElementSpy.mock.results[0].value.download).toBe('unlocked.zip');
+      expect(global.URL.createObjectURL).toHaveBeenCalledWith(mockBlob);
+      createElementSpy.mockRestore();
+    });
+  });
 });
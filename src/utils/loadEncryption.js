@@ -0,0 +1,8 @@
+/**
+ * On-demand chunk with the encryption sniff and password key checks (src/utils/pdf)
+ * The page only needs them once a file is chosen, so they stay out of the initial
+ * bundle; the prefetch hint fetches the chunk at idle time after first paint
+ * @returns {Promise<typeof import('./pdf/encryption')>}
+ */
+export const loadEncryption = () =>
+  import(/* webpackChunkName: "pdf-encryption", webpackPrefetch: true */ './pdf/encryption');
@@ -0,0 +1,30 @@
+/**
+ * Hand an unencrypted input back unchanged
+ *
+ * Shared by both removal engines for documents that turn out not to be
+ * encrypted.
+ */
+
+const PASSTHROUGH_CHUNK_SIZE = 4 * 1024 * 1024;
+
+/**
+ * @param {ArrayBuffer|Blob} source - Original input
+ * @param {(chunk: Uint8Array) => void|Promise<void>} [onChunk] - Streaming sink; File inputs
+ *   are sent in slices, each once the promise the sink returned for the last one settles
+ * @returns {Promise<ArrayBuffer|null>} - The input bytes, or null when streamed
+ */
+export const passThrough = async (source, onChunk) => {
+  if (!onChunk) {
+    return source instanceof Blob ? source.arrayBuffer() : source;
+  }
+
+  if (source instanceof Blob) {
+    for (let offset = 0; offset < source.size; offset += PASSTHROUGH_CHUNK_SIZE) {
+      const slice = source.slice(offset, offset + PASSTHROUGH_CHUNK_SIZE);
+      await onChunk(new Uint8Array(await slice.arrayBuffer()));
+    }
+  } else {
+    onChunk(new Uint8Array(source));
+  }
+  return null;
+};
@@ -0,0 +1,235 @@
+/**
+ * AES-CBC in plain JS (FIPS 197)
+ *
+ * Strings are short and numerous, so they are decrypted here rather than
+ * paying a Web Crypto round trip each. Revision 6 key derivation also needs
+ * unpadded AES-128-CBC encryption, which Web Crypto cannot express. Bulk
+ * stream data goes through Web Crypto instead (see securityHandler.js).
+ */
+
+const SBOX = new Uint8Array(256);
+const INV_SBOX = new Uint8Array(256);
+// Round tables: encryption T0..T3, decryption D0..D3
+const T = [0, 1, 2, 3].map(() => new Uint32Array(256));
+const D = [0, 1, 2, 3].map(() => new Uint32Array(256));
+
+const xtime = (value) => ((value << 1) ^ (value & 0x80 ? 0x1b : 0)) & 0xff;
+
+const multiply = (a, b) => {
+  let result = 0;
+  for (let i = 0; i < 8; i++) {
+    if (b & 1) result ^= a;
+    a = xtime(a);
+    b >>= 1;
+  }
+  return result;
+};
+
+const rotate = (word) => ((word >>> 8) | (word << 24)) >>> 0;
+
+// Build the S-box from the multiplicative inverse and affine transform
+(() => {
+  for (let x = 0; x < 256; x++) {
+    let inverse = 0;
+    if (x) {
+      for (inverse = 1; multiply(x, inverse) !== 1; inverse++);
+    }
+    let s = inverse;
+    for (let i = 1; i < 5; i++) s ^= ((inverse << i) | (inverse >>> (8 - i))) & 0xff;
+    s ^= 0x63;
+    SBOX[x] = s;
+    INV_SBOX[s] = x;
+  }
+
+  for (let x = 0; x < 256; x++) {
+    const s = SBOX[x];
+    let word = ((multiply(s, 2) << 24) | (s << 16) | (s << 8) | multiply(s, 3)) >>> 0;
+    const inv = INV_SBOX[x];
+    let invWord =
+      ((multiply(inv, 14) << 24) |
+        (multiply(inv, 9) << 16) |
+        (multiply(inv, 13) << 8) |
+        multiply(inv, 11)) >>>
+      0;
+    for (let t = 0; t < 4; t++) {
+      T[t][x] = word;
+      D[t][x] = invWord;
+      word = rotate(word);
+      invWord = rotate(invWord);
+    }
+  }
+})();
+
+const readWord = (bytes, offset) =>
+  ((bytes[offset] << 24) |
+    (bytes[offset + 1] << 16) |
+    (bytes[offset + 2] << 8) |
+    bytes[offset + 3]) >>>
+  0;
+
+const writeWord = (bytes, offset, word) => {
+  bytes[offset] = word >>> 24;
+  bytes[offset + 1] = word >>> 16;
+  bytes[offset + 2] = word >>> 8;
+  bytes[offset + 3] = word;
+};
+
+/**
+ * Expand a 16/24/32-byte key into encryption and decryption round keys
+ */
+const expandKey = (key) => {
+  const keyWords = key.length / 4;
+  if (![4, 6, 8].includes(keyWords)) throw new RangeError(`Invalid AES key length ${key.length}`);
+  const rounds = keyWords + 6;
+  const total = (rounds + 1) * 4;
+  const enc = new Uint32Array(total);
+
+  for (let i = 0; i < keyWords; i++) {
+    enc[i] = readWord(key, 4 * i);
+  }
+  let rcon = 1;
+  for (let i = keyWords; i < total; i++) {
+    let word = enc[i - 1];
+    if (i % keyWords === 0) {
+      word =
+        ((SBOX[(word >>> 16) & 0xff] << 24) |
+          (SBOX[(word >>> 8) & 0xff] << 16) |
+          (SBOX[word & 0xff] << 8) |
+          SBOX[word >>> 24]) ^
+        (rcon << 24);
+      rcon = xtime(rcon);
+    } else if (keyWords > 6 && i % keyWords === 4) {
+      word =
+        (SBOX[word >>> 24] << 24) |
+        (SBOX[(word >>> 16) & 0xff] << 16) |
+        (SBOX[(word >>> 8) & 0xff] << 8) |
+        SBOX[word & 0xff];
+    }
+    enc[i] = (enc[i - keyWords] ^ word) >>> 0;
+  }
+
+  // Equivalent inverse cipher: reversed round keys, InvMixColumns on the inner ones
+  const dec = new Uint32Array(total);
+  for (let round = 0; round <= rounds; round++) {
+    for (let col = 0; col < 4; col++) {
+      const word = enc[(rounds - round) * 4 + col];
+      dec[round * 4 + col] =
+        round === 0 || round === rounds
+          ? word
+          : (D[0][SBOX[word >>> 24]] ^
+              D[1][SBOX[(word >>> 16) & 0xff]] ^
+              D[2][SBOX[(word >>> 8) & 0xff]] ^
+              D[3][SBOX[word & 0xff]]) >>>
+            0;
+    }
+  }
+  return { enc, dec, rounds };
+};
+
+// Final round: S-box substitution only, no MixColumns
+const lastRound = (sbox, w0, w1, w2, w3, roundKey) =>
+  ((sbox[w0 >>> 24] << 24) |
+    (sbox[(w1 >>> 16) & 0xff] << 16) |
+    (sbox[(w2 >>> 8) & 0xff] << 8) |
+    sbox[w3 & 0xff]) ^
+  roundKey;
+
+const encryptBlock = (input, offset, output, outOffset, roundKeys, rounds) => {
+  const [t0, t1, t2, t3] = T;
+  let s0 = readWord(input, offset) ^ roundKeys[0];
+  let s1 = readWord(input, offset + 4) ^ roundKeys[1];
+  let s2 = readWord(input, offset + 8) ^ roundKeys[2];
+  let s3 = readWord(input, offset + 12) ^ roundKeys[3];
+  let k = 4;
+
+  for (let round = 1; round < rounds; round++, k += 4) {
+    const n0 = t0[s0 >>> 24] ^ t1[(s1 >>> 16) & 0xff] ^ t2[(s2 >>> 8) & 0xff] ^ t3[s3 & 0xff];
+    const n1 = t0[s1 >>> 24] ^ t1[(s2 >>> 16) & 0xff] ^ t2[(s3 >>> 8) & 0xff] ^ t3[s0 & 0xff];
+    const n2 = t0[s2 >>> 24] ^ t1[(s3 >>> 16) & 0xff] ^ t2[(s0 >>> 8) & 0xff] ^ t3[s1 & 0xff];
+    const n3 = t0[s3 >>> 24] ^ t1[(s0 >>> 16) & 0xff] ^ t2[(s1 >>> 8) & 0xff] ^ t3[s2 & 0xff];
+    s0 = n0 ^ roundKeys[k];
+    s1 = n1 ^ roundKeys[k + 1];
+    s2 = n2 ^ roundKeys[k + 2];
+    s3 = n3 ^ roundKeys[k + 3];
+  }
+
+  writeWord(output, outOffset, lastRound(SBOX, s0, s1, s2, s3, roundKeys[k]));
+  writeWord(output, outOffset + 4, lastRound(SBOX, s1, s2, s3, s0, roundKeys[k + 1]));
+  writeWord(output, outOffset + 8, lastRound(SBOX, s2, s3, s0, s1, roundKeys[k + 2]));
+  writeWord(output, outOffset + 12, lastRound(SBOX, s3, s0, s1, s2, roundKeys[k + 3]));
+};
+
+const decryptBlock = (input, offset, output, outOffset, roundKeys, rounds) => {
+  const [d0, d1, d2, d3] = D;
+  let s0 = readWord(input, offset) ^ roundKeys[0];
+  let s1 = readWord(input, offset + 4) ^ roundKeys[1];
+  let s2 = readWord(input, offset + 8) ^ roundKeys[2];
+  let s3 = readWord(input, offset + 12) ^ roundKeys[3];
+  let k = 4;
+
+  for (let round = 1; round < rounds; round++, k += 4) {
+    const n0 = d0[s0 >>> 24] ^ d1[(s3 >>> 16) & 0xff] ^ d2[(s2 >>> 8) & 0xff] ^ d3[s1 & 0xff];
+    const n1 = d0[s1 >>> 24] ^ d1[(s0 >>> 16) & 0xff] ^ d2[(s3 >>> 8) & 0xff] ^ d3[s2 & 0xff];
+    const n2 = d0[s2 >>> 24] ^ d1[(s1 >>> 16) & 0xff] ^ d2[(s0 >>> 8) & 0xff] ^ d3[s3 & 0xff];
+    const n3 = d0[s3 >>> 24] ^ d1[(s2 >>> 16) & 0xff] ^ d2[(s1 >>> 8) & 0xff] ^ d3[s0 & 0xff];
+    s0 = n0 ^ roundKeys[k];
+    s1 = n1 ^ roundKeys[k + 1];
+    s2 = n2 ^ roundKeys[k + 2];
+    s3 = n3 ^ roundKeys[k + 3];
+  }
+
+  writeWord(output, outOffset, lastRound(INV_SBOX, s0, s3, s2, s1, roundKeys[k]));
+  writeWord(output, outOffset + 4, lastRound(INV_SBOX, s1, s0, s3, s2, roundKeys[k + 1]));
+  writeWord(output, outOffset + 8, lastRound(INV_SBOX, s2, s1, s0, s3, roundKeys[k + 2]));
+  writeWord(output, outOffset + 12, lastRound(INV_SBOX, s3, s2, s1, s0, roundKeys[k + 3]));
+};
+
+/**
+ * AES-CBC decryption
+ * @param {Uint8Array} key - 16, 24 or 32 bytes
+ * @param {Uint8Array} iv - 16 bytes
+ * @param {Uint8Array} data - Ciphertext, a multiple of 16 bytes
+ * @param {Object} [options]
+ * @param {boolean} [options.padding=true] - Strip PKCS#7 padding
+ * @returns {Uint8Array}
+ */
+export const aesCbcDecrypt = (key, iv, data, { padding = true } = {}) => {
+  if (data.length % 16) throw new RangeError('AES ciphertext is not a multiple of 16 bytes');
+  const { dec, rounds } = expandKey(key);
+  const out = new Uint8Array(data.length);
+
+  for (let offset = 0; offset < data.length; offset += 16) {
+    decryptBlock(data, offset, out, offset, dec, rounds);
+    if (offset === 0) {
+      for (let i = 0; i < 16; i++) out[i] ^= iv[i];
+    } else {
+      for (let i = 0; i < 16; i++) out[offset + i] ^= data[offset - 16 + i];
+    }
+  }
+
+  if (!padding || !out.length) return out;
+  const pad = out[out.length - 1];
+  if (pad < 1 || pad > 16) throw new RangeError('Invalid AES padding');
+  return out.subarray(0, out.length - pad);
+};
+
+/**
+ * AES-CBC encryption without padding
+ * @param {Uint8Array} key - 16, 24 or 32 bytes
+ * @param {Uint8Array} iv - 16 bytes
+ * @param {Uint8Array} data - Plaintext, a multiple of 16 bytes
+ * @returns {Uint8Array}
+ */
+export const aesCbcEncrypt = (key, iv, data) => {
+  if (data.length % 16) throw new RangeError('AES plaintext is not a multiple of 16 bytes');
+  const { enc, rounds } = expandKey(key);
+  const out = new Uint8Array(data.length);
+  const block = new Uint8Array(16);
+
+  for (let offset = 0; offset < data.length; offset += 16) {
+    const previous = offset === 0 ? iv : out.subarray(offset - 16, offset);
+    for (let i = 0; i < 16; i++) block[i] = data[offset + i] ^ previous[i];
+    encryptBlock(block, 0, out, offset, enc, rounds);
+  }
+  return out;
+};
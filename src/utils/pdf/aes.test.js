@@ -0,0 +1,54 @@
+/**
+ * Unit tests for the AES-CBC implementation
+ * Tests FIPS 197 vectors, CBC chaining and PKCS#7 padding removal
+ */
+
+import { aesCbcDecrypt, aesCbcEncrypt } from './aes';
+
+const fromHex = (text) => Uint8Array.from(text.match(/../g), (pair) => parseInt(pair, 16));
+const hex = (bytes) => Array.from(bytes, (byte) => byte.toString(16).padStart(2, '0')).join('');
+
+describe('aes', () => {
+  const plaintext = fromHex('00112233445566778899aabbccddeeff');
+  const zeroIv = new Uint8Array(16);
+
+  it.each([
+    ['000102030405060708090a0b0c0d0e0f', '69c4e0d86a7b0430d8cdb78070b4c55a'],
+    ['000102030405060708090a0b0c0d0e0f1011121314151617', 'dda97ca4864cdfe06eaf70a0ec0d7191'],
+    [
+      '000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f',
+      '8ea2b7ca516745bfeafc49904b496089',
+    ],
+  ])('should match the FIPS 197 vector for key %s', (key, ciphertext) => {
+    // A single block with a zero IV is plain AES
+    expect(hex(aesCbcEncrypt(fromHex(key), zeroIv, plaintext))).toBe(ciphertext);
+    expect(aesCbcDecrypt(fromHex(key), zeroIv, fromHex(ciphertext), { padding: false })).toEqual(
+      plaintext,
+    );
+  });
+
+  it('should chain blocks and strip PKCS#7 padding', () => {
+    const key = fromHex('2b7e151628aed2a6abf7158809cf4f3c');
+    const iv = fromHex('000102030405060708090a0b0c0d0e0f');
+    const message = Uint8Array.from({ length: 37 }, (_, i) => i);
+    const padded = new Uint8Array(48);
+    padded.set(message);
+    padded.fill(11, 37);
+
+    const ciphertext = aesCbcEncrypt(key, iv, padded);
+
+    expect(aesCbcDecrypt(key, iv, ciphertext)).toEqual(message);
+  });
+
+  it('should reject invalid lengths and padding', () => {
+    const key = new Uint8Array(16);
+
+    expect(() => aesCbcDecrypt(key, zeroIv, new Uint8Array(15))).toThrow(RangeError);
+    expect(() => aesCbcDecrypt(new Uint8Array(10), zeroIv, new Uint8Array(16))).toThrow(
+      'Invalid AES key length',
+    );
+    // Last plaintext byte 0 is not a valid pad length
+    const ciphertext = aesCbcEncrypt(key, zeroIv, new Uint8Array(16));
+    expect(() => aesCbcDecrypt(key, zeroIv, ciphertext)).toThrow('Invalid AES padding');
+  });
+});
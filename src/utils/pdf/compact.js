@@ -0,0 +1,301 @@
+/**
+ * Compact output
+ *
+ * Rewrites an unencrypted PDF to take less space. Streams with identical
+ * dictionaries and data (images, fonts and ICC profiles some producers repeat
+ * on every page) are merged into one object, and so are the fonts, arrays and
+ * other passive objects that become identical once what they point at has
+ * been merged. Objects nothing refers to are dropped, and every remaining
+ * non-stream object is packed into FlateDecode object streams behind a
+ * cross-reference stream (PDF 1.5).
+ *
+ * Stream data is copied as it is; only the new object and cross-reference
+ * streams are compressed. The whole layout is worked out before any output is
+ * produced, so anything outside what it understands throws while the caller
+ * can still keep the file as it was.
+ */
+
+import { PdfDict, PdfRef } from './objects';
+import { deflate } from './filters';
+import { createRangeReader } from './rangeReader';
+import { loadObjects } from './objectReader';
+import { readXref } from './xref';
+import {
+  concatBytes,
+  createChunkWriter,
+  encodeLatin1,
+  renderValue,
+  serializeValue,
+} from './writer';
+import { BINARY_COMMENT, readVersion } from './stripSecurity';
+
+// Enough objects to amortize a stream's overhead, few enough that a viewer
+// looking up one of them does not inflate many others
+const OBJECTS_PER_STREAM = 100;
+
+// Dictionaries merged when identical; others (pages, annotations, outline
+// items) have an identity of their own even when their bytes match
+const MERGEABLE_TYPES = new Set(['Font', 'FontDescriptor', 'Encoding', 'ExtGState']);
+
+const STREAM_END = '\nendstream\nendobj\n';
+
+const latin1 = new TextDecoder('latin1');
+
+const toHex = (buffer) =>
+  Array.from(new Uint8Array(buffer), (byte) => byte.toString(16).padStart(2, '0')).join('');
+
+const bytesFor = (value) => {
+  let bytes = 1;
+  while (value >= 256 ** bytes) bytes++;
+  return bytes;
+};
+
+/**
+ * SHA-256 of the stream data that could have a twin: only streams whose length
+ * another stream shares are read
+ */
+const hashStreams = async (reader, objects) => {
+  const byLength = new Map();
+  for (const [num, { data }] of objects) {
+    if (!data) continue;
+    const length = data[1] - data[0];
+    if (!byLength.has(length)) byLength.set(length, []);
+    byLength.get(length).push(num);
+  }
+
+  const digests = new Map();
+  for (const [length, nums] of byLength) {
+    if (nums.length < 2) continue;
+    for (const num of nums) {
+      const data = await reader.read(objects.get(num).data[0], length);
+      digests.set(num, toHex(await crypto.subtle.digest('SHA-256', data)));
+    }
+  }
+  return digests;
+};
+
+const isMergeable = (object, digests, num) => {
+  if (object.data) return digests.has(num);
+  if (!(object.value instanceof PdfDict)) return true;
+  const type = object.value.get('Type');
+  return type !== undefined && MERGEABLE_TYPES.has(type.name);
+};
+
+/**
+ * Merge identical objects, repeating until a pass merges nothing: two fonts
+ * only match once their font files and widths have been merged
+ * @returns {Map<number, number>} Number of every merged object's survivor
+ */
+const mergeDuplicates = (objects, digests, resolve) => {
+  // Each merge only links an object to the one it matched; a later pass may merge
+  // that one in turn, so the survivor is the root of the chain (union-find style)
+  const merged = new Map();
+  const root = (num) => {
+    let top = num;
+    while (merged.has(top)) top = merged.get(top);
+    // Path compression: point the whole chain straight at its root
+    for (let next = num; next !== top; ) {
+      const parent = merged.get(next);
+      merged.set(next, top);
+      next = parent;
+    }
+    return top;
+  };
+  const survivor = (ref) => {
+    const num = resolve(ref);
+    return num === undefined ? undefined : root(num);
+  };
+
+  for (let changed = true; changed; ) {
+    changed = false;
+    const seen = new Map();
+    for (const [num, object] of objects) {
+      if (merged.has(num) || !isMergeable(object, digests, num)) continue;
+      const key = `${digests.get(num) ?? '-'} ${latin1.decode(renderValue(object, survivor))}`;
+      if (!seen.has(key)) {
+        seen.set(key, num);
+        continue;
+      }
+      merged.set(num, seen.get(key));
+      changed = true;
+    }
+  }
+  for (const num of merged.keys()) root(num);
+  return merged;
+};
+
+// Objects reachable from `starts` through their references, breadth first
+const reach = (objects, starts, survivor) => {
+  const order = [...new Set(starts)];
+  const seen = new Set(order);
+  for (let i = 0; i < order.length; i++) {
+    for (const { ref } of objects.get(order[i]).references) {
+      const num = survivor(ref);
+      if (num === undefined || seen.has(num)) continue;
+      seen.add(num);
+      order.push(num);
+    }
+  }
+  return order;
+};
+
+/**
+ * Object stream holding `items` (`{number, body}`), compressed
+ */
+const buildObjectStream = async (items) => {
+  let offset = 0;
+  const header = items
+    .map(({ number, body }) => {
+      const entry = `${number} ${offset}`;
+      offset += body.length + 1;
+      return entry;
+    })
+    .join(' ');
+  const first = header.length + 1;
+  const parts = [encodeLatin1(`${header}\n`)];
+  for (const { body } of items) parts.push(body, encodeLatin1('\n'));
+  const data = await deflate(concatBytes(parts));
+  return { dict: `/Type /ObjStm /N ${items.length} /First ${first} /Filter /FlateDecode`, data };
+};
+
+/**
+ * Cross-reference stream data for `entries` (`[type, field2, field3]` by number)
+ */
+const buildXrefData = (entries, widths) => {
+  const rowLength = widths.reduce((sum, width) => sum + width, 0);
+  const data = new Uint8Array(entries.length * rowLength);
+  entries.forEach((fields, index) => {
+    let position = index * rowLength;
+    fields.forEach((field, i) => {
+      for (let shift = widths[i] - 1; shift >= 0; shift--) {
+        data[position++] = Math.floor(field / 256 ** shift) % 256;
+      }
+    });
+  });
+  return data;
+};
+
+/**
+ * Compact an unencrypted PDF
+ * @param {ArrayBuffer|Blob} source - PDF bytes or a File/Blob (read in windows)
+ * @param {Object} [options]
+ * @param {(chunk: Uint8Array) => void|Promise<void>} [options.onChunk] - Streaming sink (see
+ *   createChunkWriter: a returned promise holds the next object back)
+ * @returns {Promise<ArrayBuffer|null>} - The compacted PDF, or null when it was streamed
+ *   through `onChunk`
+ * @throws {Error} For encrypted input and structures it does not support, before any output
+ */
+export const compact = async (source, { onChunk } = {}) => {
+  const reader = createRangeReader(source);
+  const version = await readVersion(reader);
+  const xref = await readXref(reader);
+  const { trailer } = xref;
+  if (trailer.has('Encrypt')) throw new Error('Encrypted files cannot be compacted');
+
+  const objects = await loadObjects(reader, xref);
+  const resolve = (ref) => {
+    if (!(ref instanceof PdfRef)) return undefined;
+    const object = objects.get(ref.num);
+    return object && object.gen === ref.gen ? ref.num : undefined;
+  };
+  const merged = mergeDuplicates(objects, await hashStreams(reader, objects), resolve);
+  const survivor = (ref) => {
+    const num = resolve(ref);
+    return num === undefined ? undefined : (merged.get(num) ?? num);
+  };
+
+  const rootNum = survivor(trailer.get('Root'));
+  if (rootNum === undefined) throw new Error('Trailer has no catalog');
+  const infoNum = survivor(trailer.get('Info'));
+  const order = reach(objects, infoNum === undefined ? [rootNum] : [rootNum, infoNum], survivor);
+  const numbers = new Map(order.map((num, index) => [num, index + 1]));
+  const renumber = (ref) => {
+    const num = survivor(ref);
+    return num === undefined ? undefined : numbers.get(num);
+  };
+
+  // Streams stay top-level objects, and so do indirect stream lengths, which a
+  // reader needs before it can get at any object stream
+  const lengths = new Set();
+  for (const num of order) {
+    const { value, data } = objects.get(num);
+    if (data) lengths.add(survivor(value.get('Length')));
+  }
+  const plain = order.filter((num) => objects.get(num).data || lengths.has(num));
+  const packed = order.filter((num) => !objects.get(num).data && !lengths.has(num));
+
+  // Everything but stream data is rendered up front
+  const plainItems = plain.map((num) => {
+    const object = objects.get(num);
+    const head = concatBytes([
+      encodeLatin1(`${numbers.get(num)} 0 obj\n`),
+      renderValue(object, renumber),
+      encodeLatin1(object.data ? '\nstream\n' : '\nendobj\n'),
+    ]);
+    return { num, head, data: object.data };
+  });
+  const objectStreams = [];
+  for (let i = 0; i < packed.length; i += OBJECTS_PER_STREAM) {
+    const items = packed.slice(i, i + OBJECTS_PER_STREAM).map((num) => ({
+      number: numbers.get(num),
+      body: renderValue(objects.get(num), renumber),
+    }));
+    objectStreams.push({
+      number: order.length + 1 + objectStreams.length,
+      count: items.length,
+      ...(await buildObjectStream(items)),
+    });
+  }
+  const xrefNum = order.length + objectStreams.length + 1;
+  const size = xrefNum + 1;
+
+  const trailerEntries = [`/Root ${numbers.get(rootNum)} 0 R`];
+  if (infoNum !== undefined) trailerEntries.push(`/Info ${numbers.get(infoNum)} 0 R`);
+  if (trailer.has('ID')) trailerEntries.push(`/ID ${serializeValue(trailer.get('ID'))}`);
+
+  const header = `%PDF-${Number(version) >= 1.5 ? version : '1.5'}\n${BINARY_COMMENT}`;
+  const entries = new Array(size);
+  entries[0] = [0, 0, 0xffff];
+
+  const writer = createChunkWriter({ onChunk });
+  writer.writeText(header);
+  for (const { num, head, data } of plainItems) {
+    entries[numbers.get(num)] = [1, writer.position, 0];
+    writer.write(head);
+    if (!data) continue;
+    writer.write(await reader.read(data[0], data[1] - data[0]));
+    writer.writeText(STREAM_END);
+    await writer.drain();
+  }
+  objectStreams.forEach(({ number }, streamIndex) => {
+    packed
+      .slice(streamIndex * OBJECTS_PER_STREAM, (streamIndex + 1) * OBJECTS_PER_STREAM)
+      .forEach((num, index) => {
+        entries[numbers.get(num)] = [2, number, index];
+      });
+  });
+  for (const { number, dict, data } of objectStreams) {
+    entries[number] = [1, writer.position, 0];
+    writer.writeText(`${number} 0 obj\n<< ${dict} /Length ${data.length} >>\nstream\n`);
+    writer.write(data);
+    writer.writeText(STREAM_END);
+    await writer.drain();
+  }
+
+  const xrefOffset = writer.position;
+  entries[xrefNum] = [1, xrefOffset, 0];
+  const widths = [1, bytesFor(Math.max(xrefOffset, xrefNum)), 2];
+  const xrefData = await deflate(buildXrefData(entries, widths));
+  writer.writeText(
+    `${xrefNum} 0 obj\n<< /Type /XRef /Size ${size} /W [${widths.join(' ')}] ` +
+      `${trailerEntries.join(' ')} /Filter /FlateDecode /Length ${xrefData.length} >>\nstream\n`,
+  );
+  writer.write(xrefData);
+  writer.writeText(`${STREAM_END}startxref\n${xrefOffset}\n%%EOF\n`);
+
+  if (onChunk) {
+    writer.flush();
+    return null;
+  }
+  return writer.toArrayBuffer();
+};
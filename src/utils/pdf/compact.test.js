@@ -0,0 +1,126 @@
+/**
+ * Unit tests for compact output
+ * Tests duplicate merging, object and cross-reference stream packing, and the
+ * inputs it refuses
+ */
+
+import { compact } from './compact';
+import { stripSecurity } from './stripSecurity';
+import { createRangeReader } from './rangeReader';
+import { loadObjects } from './objectReader';
+import { readXref } from './xref';
+import { buildPdf, fixture, PLAIN, PROTECTED, text } from './testPdf';
+
+const stream = (data, dict = '') =>
+  `<< ${dict}/Length ${data.length} >>\nstream\n${data}\nendstream`;
+
+const readObjects = async (buffer) => {
+  const reader = createRangeReader(buffer);
+  const xref = await readXref(reader);
+  return { xref, objects: [...(await loadObjects(reader, xref)).values()] };
+};
+
+const ofType = (objects, type) =>
+  objects.filter((object) => object.value.getName?.('Type') === type);
+
+describe('compact', () => {
+  // Two pages drawing the same image with the same font, each with its own copies
+  const twoPages = () =>
+    buildPdf([
+      '<< /Type /Catalog /Pages 2 0 R >>',
+      '<< /Type /Pages /Kids [3 0 R 4 0 R] /Count 2 >>',
+      '<< /Type /Page /Parent 2 0 R /Resources << /XObject << /Im1 5 0 R >> ' +
+        '/Font << /F1 7 0 R >> >> /Contents 9 0 R >>',
+      '<< /Type /Page /Parent 2 0 R /Resources << /XObject << /Im1 6 0 R >> ' +
+        '/Font << /F1 8 0 R >> >> /Contents 9 0 R >>',
+      stream('IMAGEDATA', '/Type /XObject /Subtype /Image /Width 3 /Height 1 '),
+      stream('IMAGEDATA', '/Type /XObject /Subtype /Image /Width 3 /Height 1 '),
+      '<< /Type /Font /Subtype /TrueType /BaseFont /Arial /FontDescriptor 10 0 R >>',
+      '<< /Type /Font /Subtype /TrueType /BaseFont /Arial /FontDescriptor 11 0 R >>',
+      stream('/Im1 Do BT /F1 12 Tf (x) Tj ET'),
+      '<< /Type /FontDescriptor /FontName /Arial /FontFile2 12 0 R >>',
+      '<< /Type /FontDescriptor /FontName /Arial /FontFile2 13 0 R >>',
+      stream('FONTDATA'),
+      stream('FONTDATA'),
+      // Nothing refers to this one
+      '<< /Type /Font /Subtype /Type1 /BaseFont /Unused >>',
+    ]);
+
+  it('should merge identical streams and the objects that only differ by them', async () => {
+    const { objects } = await readObjects(await compact(twoPages()));
+
+    expect(objects.filter((object) => object.data)).toHaveLength(3);
+    expect(ofType(objects, 'Font')).toHaveLength(1);
+    expect(ofType(objects, 'FontDescriptor')).toHaveLength(1);
+    expect(ofType(objects, 'Page')).toHaveLength(2);
+  });
+
+  it('should keep pages apart even when their bytes match', async () => {
+    const source = buildPdf([
+      '<< /Type /Catalog /Pages 2 0 R >>',
+      '<< /Type /Pages /Kids [3 0 R 4 0 R] /Count 2 >>',
+      '<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] >>',
+      '<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] >>',
+    ]);
+
+    const { objects } = await readObjects(await compact(source));
+
+    expect(ofType(objects, 'Page')).toHaveLength(2);
+    expect(ofType(objects, 'Pages')[0].value.get('Kids')).toHaveLength(2);
+  });
+
+  it('should pack non-stream objects behind a cross-reference stream', async () => {
+    const output = await compact(twoPages());
+    const { xref, objects } = await readObjects(output);
+
+    expect(text(output.slice(0, 8))).toBe('%PDF-1.5');
+    expect(xref.xrefStreams.size).toBe(1);
+    expect(xref.trailer.has('Root')).toBe(true);
+    const compressed = [...xref.entries.values()].filter((entry) => entry.type === 2);
+    expect(compressed).toHaveLength(objects.filter((object) => !object.data).length);
+  });
+
+  it('should leave indirect stream lengths outside object streams', async () => {
+    const source = buildPdf([
+      '<< /Type /Catalog /Pages 2 0 R >>',
+      '<< /Type /Pages /Kids [3 0 R] /Count 1 >>',
+      '<< /Type /Page /Parent 2 0 R /Contents 4 0 R >>',
+      '<< /Length 5 0 R >>\nstream\n0 0 m S\nendstream',
+      '7',
+    ]);
+
+    const output = await compact(source);
+    const xref = await readXref(createRangeReader(output));
+
+    expect(xref.entries.get(5).type).toBe(1);
+    expect(xref.entries.get(2).type).toBe(2);
+  });
+
+  it('should shrink the fixture and keep every page readable', async () => {
+    const source = await stripSecurity(fixture(PROTECTED), 'password');
+    const output = await compact(source);
+    const { xref, objects } = await readObjects(output);
+
+    expect(output.byteLength).toBeLessThan(source.byteLength);
+    expect(ofType(objects, 'Page')).toHaveLength(4);
+    expect(xref.trailer.has('ID')).toBe(true);
+  });
+
+  it('should stream the same bytes it returns when buffered', async () => {
+    const buffered = new Uint8Array(await compact(fixture(PLAIN)));
+    const chunks = [];
+
+    expect(await compact(fixture(PLAIN), { onChunk: (chunk) => chunks.push(chunk) })).toBeNull();
+    expect(new Uint8Array(await new Blob(chunks).arrayBuffer())).toEqual(buffered);
+  });
+
+  it('should reproduce a compacted file exactly', async () => {
+    const once = await compact(fixture(PLAIN));
+
+    expect(new Uint8Array(await compact(once))).toEqual(new Uint8Array(once));
+  });
+
+  it('should refuse encrypted files', async () => {
+    await expect(compact(fixture(PROTECTED))).rejects.toThrow('Encrypted');
+  });
+});
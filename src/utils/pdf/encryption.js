@@ -0,0 +1,97 @@
+/**
+ * Encryption dictionary lookup and password key checks
+ *
+ * A key check only needs /Encrypt and the first trailer /ID element, so a
+ * password can be tested without loading the document. `readEncryption`
+ * extracts both as plain data (the dictionary re-serialized) that can be
+ * posted to workers, and `checkPasswords` runs the standard security handler's
+ * key derivation against it. `sniffEncryption` answers whether there is an
+ * /Encrypt at all from the newest trailer alone.
+ */
+
+import { PdfDict, PdfRef, PdfString } from './objects';
+import { PdfParser } from './parser';
+import { createRangeReader } from './rangeReader';
+import { readIndirectObject } from './objectReader';
+import { readTrailer, readXref } from './xref';
+import { createSecurityHandler, IncorrectPasswordError } from './securityHandler';
+import { encodeLatin1, serializeValue } from './writer';
+
+/**
+ * Resolve the trailer's /Encrypt entry
+ * @returns {Promise<{dict: PdfDict, num: number|null}|null>} `num` is null for an inline
+ *   dictionary; null when the file is not encrypted
+ */
+export const resolveEncrypt = async (reader, entries, trailer) => {
+  const encrypt = trailer.get('Encrypt');
+  if (encrypt instanceof PdfDict) return { dict: encrypt, num: null };
+  if (!(encrypt instanceof PdfRef)) return null;
+
+  const entry = entries.get(encrypt.num);
+  if (!entry || entry.type !== 1) throw new Error('Encryption dictionary not found');
+  const object = await readIndirectObject(reader, entry.offset);
+  if (!(object.value instanceof PdfDict)) throw new Error('Malformed encryption dictionary');
+  return { dict: object.value, num: encrypt.num };
+};
+
+/**
+ * First element of the trailer /ID, which keys revisions 2-4
+ */
+export const readDocumentId = (trailer) => {
+  const ids = trailer.get('ID');
+  return Array.isArray(ids) && ids[0] instanceof PdfString ? ids[0].bytes : new Uint8Array(0);
+};
+
+// Windows small enough that a File sniff reads little more than its last section
+const SNIFF_WINDOW_SIZE = 64 * 1024;
+
+/**
+ * Whether the document is encrypted, from the newest trailer's /Encrypt entry
+ * Reads the tail of the file and the section `startxref` points at (a classic
+ * table, or only a cross-reference stream's dictionary); no object is parsed
+ * @param {ArrayBuffer|Blob} source - PDF bytes or a File/Blob
+ * @returns {Promise<boolean>}
+ * @throws {Error} When the tail is malformed; the engines' repair paths may still
+ *   open such files
+ */
+export const sniffEncryption = async (source) => {
+  const reader = createRangeReader(source, { windowSize: SNIFF_WINDOW_SIZE });
+  return (await readTrailer(reader)).has('Encrypt');
+};
+
+/**
+ * Read what a password key check needs, without touching any other object
+ * @param {ArrayBuffer|Blob} source - PDF bytes or a File/Blob (read in windows)
+ * @returns {Promise<{encrypt: string, id: Uint8Array}|null>} Serialized /Encrypt
+ *   dictionary and document ID, or null when the file is not encrypted
+ */
+export const readEncryption = async (source) => {
+  const reader = createRangeReader(source);
+  const { entries, trailer } = await readXref(reader);
+  const encrypt = await resolveEncrypt(reader, entries, trailer);
+  if (!encrypt) return null;
+  return { encrypt: serializeValue(encrypt.dict), id: readDocumentId(trailer) };
+};
+
+/**
+ * Test candidate passwords against the key check alone (Algorithms 2-7, or the
+ * SHA-256 based check for revisions 5-6)
+ * @param {{encrypt: string, id: Uint8Array}} encryption - From readEncryption
+ * @param {string[]} passwords - Candidates, tried in order
+ * @returns {Promise<number>} Index of the first candidate that verifies, or -1
+ * @throws {Error} When the security handler is not one this check supports
+ */
+export const checkPasswords = async (encryption, passwords) => {
+  const parser = new PdfParser(encodeLatin1(encryption.encrypt), 0, { complete: true });
+  const dict = parser.parseValue();
+
+  for (const [index, password] of passwords.entries()) {
+    try {
+      await createSecurityHandler(dict, encryption.id, password || '');
+      return index;
+    } catch (err) {
+      if (!(err instanceof IncorrectPasswordError)) throw err;
+    }
+  }
+  return -1;
+};
@@ -0,0 +1,73 @@
+/**
+ * Unit tests for the encryption dictionary lookup and password key checks
+ * Tests reading /Encrypt and /ID from the fixtures and checking candidates against them
+ */
+
+import { checkPasswords, readEncryption, sniffEncryption } from './encryption';
+import { buildLinearizedPdf, fixture, PLAIN, PROTECTED } from './testPdf';
+
+describe('readEncryption', () => {
+  it('should return the serialized /Encrypt dictionary and document ID', async () => {
+    const encryption = await readEncryption(fixture(PROTECTED));
+
+    // Plain data, so it can be posted to the workers
+    expect(encryption.encrypt).toMatch(/^<< .*\/Filter \/Standard/);
+    expect(encryption.id).toBeInstanceOf(Uint8Array);
+    expect(encryption.id.length).toBeGreaterThan(0);
+  });
+
+  it('should return null for unencrypted files', async () => {
+    expect(await readEncryption(fixture(PLAIN))).toBeNull();
+  });
+});
+
+describe('sniffEncryption', () => {
+  it('should tell encrypted from unencrypted files', async () => {
+    expect(await sniffEncryption(fixture(PROTECTED))).toBe(true);
+    expect(await sniffEncryption(fixture(PLAIN))).toBe(false);
+  });
+
+  it('should find /Encrypt in the first-page trailer of a linearized file', async () => {
+    const file = buildLinearizedPdf(['<< /Type /Catalog >>', '<< /Filter /Standard >>'], {
+      trailer: '/Root 1 0 R /Encrypt 2 0 R',
+    });
+
+    expect(await sniffEncryption(file)).toBe(true);
+  });
+
+  it('should read only the tail of a File', async () => {
+    const file = new File([fixture(PROTECTED)], 'protected.pdf');
+    const slice = jest.spyOn(file, 'slice');
+
+    expect(await sniffEncryption(file)).toBe(true);
+    const bytesRead = slice.mock.calls.reduce((total, [start, end]) => total + end - start, 0);
+    expect(bytesRead).toBeLessThan(file.size / 2);
+  });
+
+  it('should reject files without a readable trailer', async () => {
+    await expect(sniffEncryption(new ArrayBuffer(64))).rejects.toThrow('startxref');
+  });
+});
+
+describe('checkPasswords', () => {
+  it('should return the index of the first candidate that verifies', async () => {
+    const encryption = await readEncryption(fixture(PROTECTED));
+
+    await expect(checkPasswords(encryption, ['wrong', '', 'password'])).resolves.toBe(2);
+  });
+
+  it('should return -1 when no candidate verifies', async () => {
+    const encryption = await readEncryption(fixture(PROTECTED));
+
+    await expect(checkPasswords(encryption, ['wrong', 'Password'])).resolves.toBe(-1);
+    await expect(checkPasswords(encryption, [])).resolves.toBe(-1);
+  });
+
+  it('should throw for security handlers it does not support', async () => {
+    const encryption = { encrypt: '<< /Filter /Adobe.PubSec /V 4 /R 4 >>', id: new Uint8Array(0) };
+
+    await expect(checkPasswords(encryption, ['password'])).rejects.toThrow(
+      'Unsupported security handler',
+    );
+  });
+});
@@ -0,0 +1,129 @@
+/**
+ * Stream decoding for the structures the security-strip engine has to read
+ *
+ * Only cross-reference and object streams are ever decoded, and those are
+ * FlateDecode with an optional PNG predictor in practice. Content, image and
+ * font streams are decrypted but never decompressed. Encoding is limited to
+ * the FlateDecode streams the compact rewriter writes.
+ */
+
+import { PdfDict, isName } from './objects';
+
+// Run `data` through a platform (De)CompressionStream
+const transform = async (stream, data) => {
+  const writer = stream.writable.getWriter();
+  // Surfaces through the reader; awaiting here would deadlock on backpressure
+  writer.write(data).catch(() => {});
+  writer.close().catch(() => {});
+
+  const reader = stream.readable.getReader();
+  const chunks = [];
+  let length = 0;
+  for (;;) {
+    const { done, value } = await reader.read();
+    if (done) break;
+    chunks.push(value);
+    length += value.length;
+  }
+
+  const out = new Uint8Array(length);
+  let offset = 0;
+  for (const chunk of chunks) {
+    out.set(chunk, offset);
+    offset += chunk.length;
+  }
+  return out;
+};
+
+/**
+ * zlib inflate through the platform DecompressionStream
+ * @param {Uint8Array} data
+ * @returns {Promise<Uint8Array>}
+ */
+export const inflate = (data) => transform(new DecompressionStream('deflate'), data);
+
+/**
+ * zlib deflate through the platform CompressionStream, for the streams the
+ * compact rewriter creates (object and cross-reference streams)
+ * @param {Uint8Array} data
+ * @returns {Promise<Uint8Array>}
+ */
+export const deflate = (data) => transform(new CompressionStream('deflate'), data);
+
+const paeth = (left, up, upLeft) => {
+  const estimate = left + up - upLeft;
+  const distLeft = Math.abs(estimate - left);
+  const distUp = Math.abs(estimate - up);
+  const distUpLeft = Math.abs(estimate - upLeft);
+  if (distLeft <= distUp && distLeft <= distUpLeft) return left;
+  return distUp <= distUpLeft ? up : upLeft;
+};
+
+/**
+ * Undo PNG row predictors (Predictor >= 10)
+ * @param {Uint8Array} data - One filter-type byte followed by `columns` bytes per row
+ * @param {number} columns - Bytes per row
+ * @param {number} [bytesPerPixel=1]
+ * @returns {Uint8Array}
+ */
+export const decodePngPredictor = (data, columns, bytesPerPixel = 1) => {
+  const rowLength = columns + 1;
+  const rows = Math.floor(data.length / rowLength);
+  const out = new Uint8Array(rows * columns);
+
+  for (let row = 0; row < rows; row++) {
+    const type = data[row * rowLength];
+    const input = row * rowLength + 1;
+    const base = row * columns;
+    for (let i = 0; i < columns; i++) {
+      const raw = data[input + i];
+      const left = i >= bytesPerPixel ? out[base + i - bytesPerPixel] : 0;
+      const up = row > 0 ? out[base - columns + i] : 0;
+      const upLeft = row > 0 && i >= bytesPerPixel ? out[base - columns + i - bytesPerPixel] : 0;
+
+      let predicted = 0;
+      if (type === 1) predicted = left;
+      else if (type === 2) predicted = up;
+      else if (type === 3) predicted = (left + up) >> 1;
+      else if (type === 4) predicted = paeth(left, up, upLeft);
+      else if (type !== 0) throw new Error(`Unsupported PNG predictor type ${type}`);
+      out[base + i] = (raw + predicted) & 0xff;
+    }
+  }
+  return out;
+};
+
+/**
+ * Decode a (decrypted) stream according to its /Filter and /DecodeParms
+ * @param {PdfDict} dict - Stream dictionary
+ * @param {Uint8Array} data - Raw stream data
+ * @returns {Promise<Uint8Array>}
+ */
+export const decodeStream = async (dict, data) => {
+  const filter = dict.get('Filter');
+  const filters = Array.isArray(filter) ? filter : filter ? [filter] : [];
+  const params = dict.get('DecodeParms');
+  const paramsList = Array.isArray(params) ? params : [params];
+
+  let decoded = data;
+  for (const [index, name] of filters.entries()) {
+    if (!isName(name, 'FlateDecode')) {
+      throw new Error(`Unsupported filter ${name && name.name}`);
+    }
+    decoded = await inflate(decoded);
+
+    const parms = paramsList[index];
+    const predictor = parms instanceof PdfDict ? parms.get('Predictor') || 1 : 1;
+    if (predictor >= 10) {
+      const colors = parms.get('Colors') || 1;
+      const bitsPerComponent = parms.get('BitsPerComponent') || 8;
+      const columns = parms.get('Columns') || 1;
+      const bytesPerPixel = Math.max(1, Math.ceil((colors * bitsPerComponent) / 8));
+      const rowBytes = Math.ceil((colors * bitsPerComponent * columns) / 8);
+      decoded = decodePngPredictor(decoded, rowBytes, bytesPerPixel);
+    } else if (predictor !== 1) {
+      throw new Error(`Unsupported predictor ${predictor}`);
+    }
+  }
+  return decoded;
+};
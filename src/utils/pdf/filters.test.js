@@ -0,0 +1,80 @@
+/**
+ * Unit tests for stream decoding
+ * Tests FlateDecode (both ways), the PNG predictor and unsupported filter rejection
+ */
+
+import { deflateSync, inflateSync } from 'zlib';
+import { decodePngPredictor, decodeStream, deflate, inflate } from './filters';
+import { PdfDict, PdfName } from './objects';
+
+const dictOf = (entries) => {
+  const dict = new PdfDict();
+  for (const [key, value] of Object.entries(entries)) dict.set(key, value, 0, 0);
+  return dict;
+};
+
+describe('filters', () => {
+  describe('inflate', () => {
+    it('should inflate zlib data', async () => {
+      const data = Uint8Array.from({ length: 5000 }, (_, i) => i % 251);
+
+      expect(await inflate(new Uint8Array(deflateSync(data)))).toEqual(data);
+    });
+
+    it('should reject corrupt data', async () => {
+      await expect(inflate(Uint8Array.from([1, 2, 3, 4]))).rejects.toThrow();
+    });
+  });
+
+  describe('deflate', () => {
+    it('should produce zlib data', async () => {
+      const data = Uint8Array.from({ length: 5000 }, (_, i) => i % 7);
+
+      const compressed = await deflate(data);
+
+      expect(compressed.length).toBeLessThan(data.length);
+      expect(new Uint8Array(inflateSync(compressed))).toEqual(data);
+    });
+  });
+
+  describe('decodePngPredictor', () => {
+    it('should undo None, Sub and Up rows', () => {
+      // Two columns: row 0 uses None, row 1 Sub, row 2 Up
+      const encoded = Uint8Array.from([0, 10, 20, 1, 5, 1, 2, 1, 1]);
+
+      expect(decodePngPredictor(encoded, 2)).toEqual(Uint8Array.from([10, 20, 5, 6, 6, 7]));
+    });
+
+    it('should undo Average and Paeth rows', () => {
+      const encoded = Uint8Array.from([0, 100, 50, 3, 50, 0, 4, 1, 1]);
+
+      expect(decodePngPredictor(encoded, 2)).toEqual(Uint8Array.from([100, 50, 100, 75, 101, 76]));
+    });
+  });
+
+  describe('decodeStream', () => {
+    it('should return data without filters unchanged', async () => {
+      const data = Uint8Array.from([1, 2, 3]);
+
+      expect(await decodeStream(dictOf({}), data)).toBe(data);
+    });
+
+    it('should apply FlateDecode with a PNG predictor', async () => {
+      const rows = Uint8Array.from([2, 1, 2, 3, 2, 1, 1, 1]);
+      const dict = dictOf({
+        Filter: new PdfName('FlateDecode'),
+        DecodeParms: dictOf({ Predictor: 12, Columns: 3 }),
+      });
+
+      expect(await decodeStream(dict, new Uint8Array(deflateSync(rows)))).toEqual(
+        Uint8Array.from([1, 2, 3, 2, 3, 4]),
+      );
+    });
+
+    it('should reject filters it cannot decode', async () => {
+      const dict = dictOf({ Filter: new PdfName('LZWDecode') });
+
+      await expect(decodeStream(dict, new Uint8Array(4))).rejects.toThrow('LZWDecode');
+    });
+  });
+});
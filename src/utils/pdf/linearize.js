@@ -0,0 +1,415 @@
+/**
+ * Linearized ("fast web view") output
+ *
+ * Rewrites an unencrypted PDF in the layout of ISO 32000-1 annex F: the
+ * linearization dictionary and the first-page cross-reference section up
+ * front, then the catalog, the hint stream and every object page 1 needs,
+ * followed by the other pages, the objects they share and the main
+ * cross-reference table. A viewer reading by byte ranges can render page 1
+ * from the first /E bytes and find any other page through the hint tables.
+ *
+ * Objects are renumbered into that order: references are rewritten in place
+ * and stream data is copied as it is. Object streams are unpacked, since the
+ * hint tables address plain objects, and objects nothing refers to are
+ * dropped (an earlier linearization among them).
+ *
+ * The whole layout is worked out before any output is produced, so anything
+ * outside what it understands throws while the caller can still keep the
+ * file as it was.
+ */
+
+import { PdfDict, PdfRef } from './objects';
+import { createRangeReader } from './rangeReader';
+import { loadObjects } from './objectReader';
+import { readXref } from './xref';
+import {
+  concatBytes,
+  createChunkWriter,
+  encodeLatin1,
+  renderValue,
+  serializeValue,
+} from './writer';
+import { BINARY_COMMENT, readVersion } from './stripSecurity';
+
+// Width of the values only known once the layout is done, so the sections
+// holding them have a fixed length
+const FIELD_WIDTH = 10;
+
+const pad = (value) => String(value).padStart(FIELD_WIDTH, ' ');
+
+const bitsFor = (value) => {
+  let bits = 0;
+  while (value >= 2 ** bits) bits++;
+  return bits;
+};
+
+const minOf = (values) => values.reduce((min, value) => Math.min(min, value), Infinity);
+const maxOf = (values) => values.reduce((max, value) => Math.max(max, value), 0);
+
+// Visit the references in `value`, leaving out dictionary entries under `skipKey`
+const forEachRef = (value, visit, skipKey) => {
+  if (value instanceof PdfRef) {
+    visit(value);
+  } else if (Array.isArray(value)) {
+    for (const item of value) forEachRef(item, visit, skipKey);
+  } else if (value instanceof PdfDict) {
+    for (const [key, item] of value.entries) {
+      if (key !== skipKey) forEachRef(item, visit, skipKey);
+    }
+  }
+};
+
+/**
+ * Leaf pages in document order, and the intermediate nodes of the tree
+ */
+const collectPages = (objects, resolve, rootRef) => {
+  const pages = [];
+  const nodes = new Set();
+  const visit = (ref, depth) => {
+    const num = resolve(ref);
+    const node = objects.get(num);
+    if (!node || !(node.value instanceof PdfDict) || nodes.has(num) || depth > 64) {
+      throw new Error('Malformed page tree');
+    }
+    nodes.add(num);
+    const kids = node.value.get('Kids');
+    if (!Array.isArray(kids)) {
+      pages.push(num);
+      return;
+    }
+    for (const kid of kids) {
+      if (!(kid instanceof PdfRef)) throw new Error('Malformed page tree');
+      visit(kid, depth + 1);
+    }
+  };
+
+  const catalog = objects.get(resolve(rootRef));
+  const pagesRef = catalog && catalog.value instanceof PdfDict && catalog.value.get('Pages');
+  if (!(pagesRef instanceof PdfRef)) throw new Error('Catalog has no page tree');
+  visit(pagesRef, 0);
+  if (!pages.length) throw new Error('Document has no pages');
+  return { pages, nodes };
+};
+
+/**
+ * Objects reachable from `starts`, breadth first
+ */
+const reach = (objects, resolve, starts, { skipKey, isBoundary = () => false } = {}) => {
+  const found = [...starts];
+  const seen = new Set(found);
+  for (let i = 0; i < found.length; i++) {
+    forEachRef(
+      objects.get(found[i]).value,
+      (ref) => {
+        const num = resolve(ref);
+        if (num === undefined || seen.has(num) || isBoundary(num)) return;
+        seen.add(num);
+        found.push(num);
+      },
+      skipKey,
+    );
+  }
+  return found;
+};
+
+/**
+ * Assign the objects to the parts of annex F
+ * Page 1's section holds everything its page object leads to; later pages get
+ * the objects only they use, and objects used by several of them go to the
+ * shared section. The rest of the document follows the shared objects.
+ */
+const planParts = (objects, resolve, trailer) => {
+  const rootNum = resolve(trailer.get('Root'));
+  if (rootNum === undefined) throw new Error('Trailer has no /Root');
+  const { pages, nodes } = collectPages(objects, resolve, trailer.get('Root'));
+
+  // Page closures stop at other pages (annotation targets, destinations) and
+  // leave out /Parent, which leads back up the tree
+  const isBoundary = (num) => num === rootNum || nodes.has(num);
+  const pageObjects = pages.map((page) =>
+    reach(objects, resolve, [page], { skipKey: 'Parent', isBoundary }),
+  );
+
+  const firstPage = pageObjects[0];
+  const inFirstPage = new Set(firstPage);
+  const users = new Map();
+  for (const used of pageObjects.slice(1)) {
+    for (const num of used) {
+      if (!inFirstPage.has(num)) users.set(num, (users.get(num) || 0) + 1);
+    }
+  }
+  const laterPages = pageObjects
+    .slice(1)
+    .map((used) => used.filter((num) => !inFirstPage.has(num) && users.get(num) === 1));
+  const shared = [...users.keys()].filter((num) => users.get(num) > 1);
+
+  const info = resolve(trailer.get('Info'));
+  const placed = new Set([rootNum, ...firstPage, ...shared, ...laterPages.flat()]);
+  const rest = reach(objects, resolve, info === undefined ? [rootNum] : [rootNum, info]).filter(
+    (num) => !placed.has(num),
+  );
+
+  return { rootNum, pageObjects, firstPage, laterPages, shared, rest };
+};
+
+// Object bytes up to its stream data (or through endobj), under its new number
+const renderObject = (object, num, renumber) =>
+  concatBytes([
+    encodeLatin1(`${num} 0 obj\n`),
+    renderValue(object, renumber),
+    encodeLatin1(object.data ? '\nstream\n' : '\nendobj\n'),
+  ]);
+
+const STREAM_END = '\nendstream\nendobj\n';
+
+const createBitWriter = () => {
+  const bytes = [];
+  let current = 0;
+  let used = 0;
+  return {
+    write: (value, bits) => {
+      for (let bit = bits - 1; bit >= 0; bit--) {
+        current = (current << 1) | (Math.floor(value / 2 ** bit) % 2);
+        if (++used === 8) {
+          bytes.push(current);
+          current = 0;
+          used = 0;
+        }
+      }
+    },
+    // Every item of a hint table starts on a byte boundary
+    align: () => {
+      if (!used) return;
+      bytes.push(current << (8 - used));
+      current = 0;
+      used = 0;
+    },
+    get length() {
+      return bytes.length;
+    },
+    toBytes: () => Uint8Array.from(bytes),
+  };
+};
+
+/**
+ * Page offset and shared object hint tables (annex F.4)
+ * Offsets are those of the file without the hint stream, as the tables require.
+ * Content stream fields repeat the page lengths, as viewers ignore them.
+ * @returns {{data: Uint8Array, sharedOffset: number}}
+ */
+const buildHintTables = ({ pages, firstPageOffset, groups, firstPageGroups, shared }) => {
+  const bits = createBitWriter();
+  const writeItem = (values, width) => {
+    for (const value of values) bits.write(value, width);
+    bits.align();
+  };
+
+  const leastObjects = minOf(pages.map((page) => page.objects));
+  const leastLength = minOf(pages.map((page) => page.length));
+  const objectBits = bitsFor(maxOf(pages.map((page) => page.objects - leastObjects)));
+  const lengthBits = bitsFor(maxOf(pages.map((page) => page.length - leastLength)));
+  const sharedCountBits = bitsFor(maxOf(pages.map((page) => page.sharedIds.length)));
+  const sharedIdBits = bitsFor(maxOf(pages.flatMap((page) => page.sharedIds)));
+
+  bits.write(leastObjects, 32);
+  bits.write(firstPageOffset, 32);
+  bits.write(objectBits, 16);
+  bits.write(leastLength, 32);
+  bits.write(lengthBits, 16);
+  bits.write(0, 32); // least content stream offset
+  bits.write(0, 16);
+  bits.write(leastLength, 32); // least content stream length
+  bits.write(lengthBits, 16);
+  bits.write(sharedCountBits, 16);
+  bits.write(sharedIdBits, 16);
+  bits.write(0, 16); // fractional positions: none
+  bits.write(1, 16);
+  writeItem(pages.map((page) => page.objects - leastObjects), objectBits);
+  writeItem(pages.map((page) => page.length - leastLength), lengthBits);
+  writeItem(pages.map((page) => page.sharedIds.length), sharedCountBits);
+  writeItem(pages.flatMap((page) => page.sharedIds), sharedIdBits);
+  writeItem(pages.map((page) => page.length - leastLength), lengthBits);
+
+  const sharedOffset = bits.length;
+  const leastGroup = minOf(groups);
+  const groupBits = bitsFor(maxOf(groups.map((length) => length - leastGroup)));
+  bits.write(shared ? shared.number : 0, 32);
+  bits.write(shared ? shared.offset : 0, 32);
+  bits.write(firstPageGroups, 32);
+  bits.write(groups.length, 32);
+  bits.write(0, 16); // one object per group
+  bits.write(leastGroup, 32);
+  bits.write(groupBits, 16);
+  writeItem(groups.map((length) => length - leastGroup), groupBits);
+  writeItem(groups.map(() => 0), 1); // no MD5 signatures
+
+  return { data: bits.toBytes(), sharedOffset };
+};
+
+const xrefEntry = (offset) => `${String(offset).padStart(10, '0')} 00000 n\r\n`;
+
+/**
+ * Linearize an unencrypted PDF
+ * @param {ArrayBuffer|Blob} source - PDF bytes or a File/Blob (read in windows)
+ * @param {Object} [options]
+ * @param {(chunk: Uint8Array) => void|Promise<void>} [options.onChunk] - Streaming sink (see
+ *   createChunkWriter: a returned promise holds the next object back)
+ * @returns {Promise<ArrayBuffer|null>} - The linearized PDF, or null when it was streamed
+ *   through `onChunk`
+ * @throws {Error} For encrypted input and structures it does not support, before any output
+ */
+export const linearize = async (source, { onChunk } = {}) => {
+  const reader = createRangeReader(source);
+  const version = await readVersion(reader);
+  const xref = await readXref(reader);
+  const { trailer } = xref;
+  if (trailer.has('Encrypt')) throw new Error('Encrypted files cannot be linearized');
+
+  const objects = await loadObjects(reader, xref);
+  const resolve = (ref) => {
+    if (!(ref instanceof PdfRef)) return undefined;
+    const object = objects.get(ref.num);
+    return object && object.gen === ref.gen ? ref.num : undefined;
+  };
+  const { rootNum, pageObjects, firstPage, laterPages, shared, rest } = planParts(
+    objects,
+    resolve,
+    trailer,
+  );
+
+  // The main section (object 0 up to the first-page section) holds pages 2..n,
+  // the shared objects and the rest; the first-page section is numbered after it
+  const mainNums = [...laterPages.flat(), ...shared, ...rest];
+  const firstSectionStart = mainNums.length + 1;
+  const linearizationNum = firstSectionStart;
+  const catalogNum = firstSectionStart + 1;
+  const hintNum = firstSectionStart + 2;
+  const numbers = new Map(mainNums.map((num, index) => [num, index + 1]));
+  numbers.set(rootNum, catalogNum);
+  firstPage.forEach((num, index) => numbers.set(num, hintNum + 1 + index));
+  const firstSectionCount = 3 + firstPage.length;
+  const size = firstSectionStart + firstSectionCount;
+  const renumber = (ref) => {
+    const num = resolve(ref);
+    return num === undefined ? undefined : numbers.get(num);
+  };
+
+  const render = (num) => {
+    const object = objects.get(num);
+    const head = renderObject(object, numbers.get(num), renumber);
+    const dataLength = object.data ? object.data[1] - object.data[0] : 0;
+    const length = head.length + dataLength + (object.data ? STREAM_END.length : 0);
+    return { number: numbers.get(num), head, data: object.data, length, offset: 0 };
+  };
+  const catalog = render(rootNum);
+  const firstItems = firstPage.map(render);
+  const mainItems = mainNums.map(render);
+
+  const pageNum = numbers.get(firstPage[0]);
+  const pageCount = pageObjects.length;
+  const linearizationDict = (fields) =>
+    `${linearizationNum} 0 obj\n<< /Linearized 1 /L ${pad(fields.length)} ` +
+    `/H [ ${pad(fields.hintOffset)} ${pad(fields.hintLength)} ] /O ${pageNum} ` +
+    `/E ${pad(fields.end)} /N ${pageCount} /T ${pad(fields.mainEntry)} >>\nendobj\n`;
+
+  const trailerEntries = [`/Root ${catalogNum} 0 R`];
+  const infoNum = renumber(trailer.get('Info'));
+  if (infoNum !== undefined) trailerEntries.push(`/Info ${infoNum} 0 R`);
+  if (trailer.has('ID')) trailerEntries.push(`/ID ${serializeValue(trailer.get('ID'))}`);
+  const firstXref = (offsets, mainXrefOffset) =>
+    `xref\n${firstSectionStart} ${firstSectionCount}\n${offsets.map(xrefEntry).join('')}` +
+    `trailer\n<< /Size ${size} ${trailerEntries.join(' ')} /Prev ${pad(mainXrefOffset)} >>\n` +
+    'startxref\n0\n%%EOF\n';
+
+  // Layout without the hint stream first: the hint tables are expressed in it
+  const header = `%PDF-${version}\n${BINARY_COMMENT}`;
+  const firstXrefOffset =
+    header.length +
+    linearizationDict({ length: 0, hintOffset: 0, hintLength: 0, end: 0, mainEntry: 0 }).length;
+  const prefixLength = firstXrefOffset + firstXref(new Array(firstSectionCount).fill(0), 0).length;
+  catalog.offset = prefixLength;
+  const hintOffset = prefixLength + catalog.length;
+  let position = hintOffset;
+  for (const item of [...firstItems, ...mainItems]) {
+    item.offset = position;
+    position += item.length;
+  }
+  const firstPageEnd = hintOffset + firstItems.reduce((sum, item) => sum + item.length, 0);
+
+  const sharedIds = new Map(firstPage.map((num, index) => [num, index]));
+  shared.forEach((num, index) => sharedIds.set(num, firstPage.length + index));
+  const pageLength = (items) => items.reduce((sum, item) => sum + item.length, 0);
+  let mainIndex = 0;
+  const laterPageItems = laterPages.map((nums) => {
+    mainIndex += nums.length;
+    return mainItems.slice(mainIndex - nums.length, mainIndex);
+  });
+  const sharedItems = mainItems.slice(mainIndex, mainIndex + shared.length);
+  const { data: hintData, sharedOffset } = buildHintTables({
+    pages: [
+      { objects: firstItems.length, length: pageLength(firstItems), sharedIds: [] },
+      ...laterPageItems.map((items, index) => ({
+        objects: items.length,
+        length: pageLength(items),
+        sharedIds: pageObjects[index + 1]
+          .filter((num) => sharedIds.has(num))
+          .map((num) => sharedIds.get(num)),
+      })),
+    ],
+    firstPageOffset: hintOffset,
+    groups: [...firstItems, ...sharedItems].map((item) => item.length),
+    firstPageGroups: firstItems.length,
+    shared: sharedItems[0],
+  });
+  const hintHead = encodeLatin1(
+    `${hintNum} 0 obj\n<< /S ${sharedOffset} /Length ${hintData.length} >>\nstream\n`,
+  );
+  const hintLength = hintHead.length + hintData.length + STREAM_END.length;
+
+  // Then everything after the hint stream moves up by its length
+  for (const item of [...firstItems, ...mainItems]) item.offset += hintLength;
+  const mainXrefOffset = position + hintLength;
+  const mainXref =
+    `xref\n0 ${firstSectionStart}\n0000000000 65535 f\r\n` +
+    mainItems.map((item) => xrefEntry(item.offset)).join('') +
+    `trailer\n<< /Size ${firstSectionStart} >>\nstartxref\n${firstXrefOffset}\n%%EOF\n`;
+  const fileLength = mainXrefOffset + mainXref.length;
+
+  const writer = createChunkWriter({ onChunk });
+  writer.writeText(header);
+  writer.writeText(
+    linearizationDict({
+      length: fileLength,
+      hintOffset,
+      hintLength,
+      end: firstPageEnd + hintLength,
+      mainEntry: mainXrefOffset + `xref\n0 ${firstSectionStart}`.length,
+    }),
+  );
+  const firstOffsets = [header.length, catalog.offset, hintOffset];
+  for (const item of firstItems) firstOffsets.push(item.offset);
+  writer.writeText(firstXref(firstOffsets, mainXrefOffset));
+
+  const writeItem = async (item) => {
+    if (writer.position !== item.offset) throw new Error(`Object ${item.number} is out of place`);
+    writer.write(item.head);
+    if (item.data) {
+      const [start, end] = item.data;
+      writer.write(await reader.read(start, end - start));
+      writer.writeText(STREAM_END);
+    }
+    await writer.drain();
+  };
+  await writeItem(catalog);
+  writer.write(hintHead);
+  writer.write(hintData);
+  writer.writeText(STREAM_END);
+  for (const item of [...firstItems, ...mainItems]) await writeItem(item);
+  writer.writeText(mainXref);
+
+  if (onChunk) {
+    writer.flush();
+    return null;
+  }
+  return writer.toArrayBuffer();
+};
@@ -0,0 +1,152 @@
+/**
+ * Unit tests for linearized output
+ * Tests the annex F layout (parameter dictionary, first-page section, hint
+ * stream, shared objects), renumbering, and the inputs it refuses
+ */
+
+import { linearize } from './linearize';
+import { stripSecurity } from './stripSecurity';
+import { createRangeReader } from './rangeReader';
+import { createLengthResolver, readIndirectObject } from './objectReader';
+import { readXref } from './xref';
+import { buildPdf, fixture, PLAIN, PROTECTED, text } from './testPdf';
+
+const stream = (data) => `<< /Length ${data.length} >>\nstream\n${data}\nendstream`;
+
+const readLinearizationDict = (buffer) => {
+  const dict = /<< \/Linearized 1 (.*?) >>/.exec(text(buffer.slice(0, 1024)))[1];
+  const fields = {};
+  for (const [, key, list, number] of dict.matchAll(/\/(\w) (?:\[\s*(.*?)\s*\]|\s*(\d+))/g)) {
+    fields[key] = list ? list.split(/\s+/).map(Number) : Number(number);
+  }
+  return fields;
+};
+
+// Every object of the output in file order, with its offset
+const readObjects = async (buffer) => {
+  const reader = createRangeReader(buffer);
+  const { entries } = await readXref(reader);
+  const resolveLength = createLengthResolver(reader, entries);
+  const located = [...entries.values()].filter((entry) => entry.type === 1);
+  located.sort((a, b) => a.offset - b.offset);
+  return Promise.all(
+    located.map(async ({ offset }) => ({
+      offset,
+      ...(await readIndirectObject(reader, offset, { resolveLength })),
+    })),
+  );
+};
+
+const labelOf = ({ value }) => {
+  if (value.has('Linearized')) return 'Linearized';
+  if (value.has('S')) return 'Hint';
+  return value.getName('Type') || 'Content';
+};
+
+describe('linearize', () => {
+  // Page 1 draws its own content; pages 2 and 3 share a font
+  const threePages = () =>
+    buildPdf([
+      '<< /Type /Catalog /Pages 2 0 R >>',
+      '<< /Type /Pages /Kids [3 0 R 4 0 R 5 0 R] /Count 3 >>',
+      '<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Contents 6 0 R >>',
+      '<< /Type /Page /Parent 2 0 R /Resources << /Font << /F1 8 0 R >> >> /Contents 7 0 R >>',
+      '<< /Type /Page /Parent 2 0 R /Resources << /Font << /F1 8 0 R >> >> /Contents 9 0 R >>',
+      stream('0 0 m 612 792 l S'),
+      stream('BT /F1 12 Tf (two) Tj ET'),
+      '<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>',
+      stream('BT /F1 12 Tf (three) Tj ET'),
+    ]);
+
+  it('should lay the file out as annex F describes', async () => {
+    const output = await linearize(threePages());
+
+    const objects = await readObjects(output);
+    expect(objects.map(labelOf)).toEqual([
+      'Linearized',
+      'Catalog',
+      'Hint',
+      'Page',
+      'Content',
+      'Page',
+      'Content',
+      'Page',
+      'Content',
+      'Font',
+      'Pages',
+    ]);
+  });
+
+  it('should describe the file in its linearization dictionary', async () => {
+    const output = await linearize(threePages());
+    const fields = readLinearizationDict(output);
+    const objects = await readObjects(output);
+    const firstPage = objects.find((object) => object.num === fields.O);
+    const hint = objects.find((object) => object.offset === fields.H[0]);
+
+    expect(fields.L).toBe(output.byteLength);
+    expect(fields.N).toBe(3);
+    expect(firstPage.value.getName('Type')).toBe('Page');
+    expect(text(output.slice(fields.H[0] + fields.H[1] - 7, fields.H[0] + fields.H[1]))).toBe(
+      'endobj\n',
+    );
+    expect(hint.value.get('S')).toBeLessThan(hint.value.get('Length'));
+    // Page 1 and its content end at /E; page 2 starts there
+    expect(objects.filter((object) => object.offset < fields.E).map(labelOf)).toEqual([
+      'Linearized',
+      'Catalog',
+      'Hint',
+      'Page',
+      'Content',
+    ]);
+    expect(text(output.slice(fields.T + 1, fields.T + 19))).toBe('0000000000 65535 f');
+  });
+
+  it('should keep every object of the fixture readable under its new number', async () => {
+    const output = await linearize(fixture(PLAIN));
+    const xref = await readXref(createRangeReader(output));
+
+    // Numbered 1..n without gaps, each where the cross-reference tables say
+    const objects = await readObjects(output);
+    const numbers = objects.map((object) => object.num).sort((a, b) => a - b);
+    expect(numbers).toEqual(objects.map((_, index) => index + 1));
+    expect(objects.filter((object) => object.value.getName?.('Type') === 'Page')).toHaveLength(4);
+    expect(xref.trailer.has('Root')).toBe(true);
+    expect(xref.trailer.has('ID')).toBe(true);
+  });
+
+  it('should unpack object streams', async () => {
+    const unlocked = await stripSecurity(fixture(PROTECTED), 'password');
+
+    const xref = await readXref(createRangeReader(await linearize(unlocked)));
+
+    expect(xref.hasCompressed).toBe(false);
+    expect(xref.xrefStreams.size).toBe(0);
+  });
+
+  it('should stream the same bytes it returns when buffered', async () => {
+    const buffered = new Uint8Array(await linearize(fixture(PLAIN)));
+    const chunks = [];
+
+    expect(await linearize(fixture(PLAIN), { onChunk: (chunk) => chunks.push(chunk) })).toBeNull();
+    expect(new Uint8Array(await new Blob(chunks).arrayBuffer())).toEqual(buffered);
+  });
+
+  it('should reproduce a linearized file exactly', async () => {
+    const once = await linearize(fixture(PLAIN));
+
+    expect(new Uint8Array(await linearize(once))).toEqual(new Uint8Array(once));
+  });
+
+  it('should refuse encrypted files', async () => {
+    await expect(linearize(fixture(PROTECTED))).rejects.toThrow('Encrypted');
+  });
+
+  it('should refuse a document without pages before producing output', async () => {
+    const onChunk = jest.fn();
+    const source = buildPdf(['<< /Type /Catalog >>']);
+
+    await expect(linearize(source, { onChunk })).rejects.toThrow('page tree');
+    expect(onChunk).not.toHaveBeenCalled();
+  });
+});
@@ -0,0 +1,80 @@
+/**
+ * MD5 (RFC 1321)
+ *
+ * Required by the standard security handler for revisions 2-4; Web Crypto
+ * does not offer it.
+ */
+
+const SHIFTS = [
+  7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14,
+  20, 5, 9, 14, 20, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 6, 10, 15, 21, 6,
+  10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+];
+
+const CONSTANTS = Int32Array.from({ length: 64 }, (_, i) =>
+  Math.floor(Math.abs(Math.sin(i + 1)) * 2 ** 32),
+);
+
+/**
+ * @param {Uint8Array} data
+ * @returns {Uint8Array} 16-byte digest
+ */
+export const md5 = (data) => {
+  // Pad to 56 mod 64, then append the bit length as 64-bit little endian
+  const paddedLength = (((data.length + 8) >>> 6) + 1) << 6;
+  const padded = new Uint8Array(paddedLength);
+  padded.set(data);
+  padded[data.length] = 0x80;
+  const view = new DataView(padded.buffer);
+  view.setUint32(paddedLength - 8, (data.length * 8) >>> 0, true);
+  view.setUint32(paddedLength - 4, Math.floor(data.length / 0x20000000), true);
+
+  let a0 = 0x67452301;
+  let b0 = 0xefcdab89 | 0;
+  let c0 = 0x98badcfe | 0;
+  let d0 = 0x10325476;
+  const words = new Int32Array(16);
+
+  for (let chunk = 0; chunk < paddedLength; chunk += 64) {
+    for (let i = 0; i < 16; i++) words[i] = view.getInt32(chunk + i * 4, true);
+
+    let a = a0;
+    let b = b0;
+    let c = c0;
+    let d = d0;
+    for (let i = 0; i < 64; i++) {
+      let f;
+      let g;
+      if (i < 16) {
+        f = (b & c) | (~b & d);
+        g = i;
+      } else if (i < 32) {
+        f = (d & b) | (~d & c);
+        g = (5 * i + 1) & 15;
+      } else if (i < 48) {
+        f = b ^ c ^ d;
+        g = (3 * i + 5) & 15;
+      } else {
+        f = c ^ (b | ~d);
+        g = (7 * i) & 15;
+      }
+      const rotated = (a + f + CONSTANTS[i] + words[g]) | 0;
+      a = d;
+      d = c;
+      c = b;
+      b = (b + ((rotated << SHIFTS[i]) | (rotated >>> (32 - SHIFTS[i])))) | 0;
+    }
+    a0 = (a0 + a) | 0;
+    b0 = (b0 + b) | 0;
+    c0 = (c0 + c) | 0;
+    d0 = (d0 + d) | 0;
+  }
+
+  const digest = new Uint8Array(16);
+  const out = new DataView(digest.buffer);
+  out.setInt32(0, a0, true);
+  out.setInt32(4, b0, true);
+  out.setInt32(8, c0, true);
+  out.setInt32(12, d0, true);
+  return digest;
+};
@@ -0,0 +1,31 @@
+/**
+ * Unit tests for the MD5 implementation
+ * Tests the RFC 1321 test suite and multi-block inputs
+ */
+
+import { md5 } from './md5';
+
+const hex = (bytes) => Array.from(bytes, (byte) => byte.toString(16).padStart(2, '0')).join('');
+const ascii = (text) => Uint8Array.from(text, (char) => char.charCodeAt(0));
+
+describe('md5', () => {
+  it.each([
+    ['', 'd41d8cd98f00b204e9800998ecf8427e'],
+    ['a', '0cc175b9c0f1b6a831c399e269772661'],
+    ['abc', '900150983cd24fb0d6963f7d28e17f72'],
+    ['message digest', 'f96b697d7cb7938d525a2f31aaf161d0'],
+    ['abcdefghijklmnopqrstuvwxyz', 'c3fcd3d76192e4007dfb496cca67e13b'],
+    [
+      '12345678901234567890123456789012345678901234567890123456789012345678901234567890',
+      '57edf4a22be3c955ac49da2e2107b67a',
+    ],
+  ])('should hash "%s"', (input, expected) => {
+    expect(hex(md5(ascii(input)))).toBe(expected);
+  });
+
+  it('should handle inputs right at the padding boundary', () => {
+    // 55 bytes fit one block with the length, 56 need a second one
+    expect(hex(md5(new Uint8Array(55)))).toBe('c9ea3314b91c9fd4e38f9432064fd1f2');
+    expect(hex(md5(new Uint8Array(56)))).toBe('e3c4dd21a9171fd39d208efa09bf7883');
+  });
+});
@@ -0,0 +1,201 @@
+/**
+ * Reads one indirect object from the input without touching its neighbours
+ *
+ * Stream data is located but not read; callers fetch it only when they need
+ * to transform it.
+ */
+
+import { PdfDict, PdfRef, isName } from './objects';
+import { PdfParser, TruncatedError } from './parser';
+import { decodeStream } from './filters';
+
+const INITIAL_WINDOW = 16 * 1024;
+
+/**
+ * Parse with `parse(parser)` over a window at `offset`, growing the window
+ * until the parse no longer runs off its end
+ */
+export const parseAt = async (reader, offset, parse, initialWindow = INITIAL_WINDOW) => {
+  for (let length = initialWindow; ; length *= 4) {
+    const bytes = await reader.read(offset, length);
+    try {
+      const complete = offset + bytes.length >= reader.size;
+      return parse(new PdfParser(bytes, offset, { complete }));
+    } catch (err) {
+      if (!(err instanceof TruncatedError) || offset + bytes.length >= reader.size) throw err;
+    }
+  }
+};
+
+/**
+ * Read the indirect object at `offset`
+ * @param {Object} reader - See createRangeReader
+ * @param {number} offset - File offset of `num gen obj`
+ * @param {Object} [options]
+ * @param {(ref: PdfRef) => Promise<number>} [options.resolveLength] - Resolves an indirect
+ *   stream /Length; without it such streams are rejected
+ * @returns {Promise<{num, gen, value, start, end, streamStart?, dataStart?, dataEnd?}>}
+ *   `end` is just past `endobj`; `streamStart` is the offset of the `stream` keyword
+ */
+export const readIndirectObject = async (reader, offset, { resolveLength } = {}) => {
+  const head = await parseAt(reader, offset, (parser) => {
+    const { num, gen } = parser.parseObjectHeader();
+    const value = parser.parseValue();
+    parser.skipWhitespace();
+    const streamStart = parser.offset;
+    if (value instanceof PdfDict && parser.parseStreamStart()) {
+      return { num, gen, value, streamStart, dataStart: parser.offset };
+    }
+    parser.expectKeyword('endobj');
+    return { num, gen, value, end: parser.offset };
+  });
+
+  if (head.dataStart === undefined) return { ...head, start: offset };
+
+  let length = head.value.get('Length');
+  if (length instanceof PdfRef) {
+    if (!resolveLength) throw new Error(`Indirect stream length in object ${head.num}`);
+    length = await resolveLength(length);
+  }
+  if (!Number.isInteger(length) || length < 0) {
+    throw new Error(`Invalid stream length in object ${head.num}`);
+  }
+
+  const dataEnd = head.dataStart + length;
+  if (dataEnd > reader.size) throw new Error(`Stream of object ${head.num} runs past end of file`);
+
+  const end = await parseAt(
+    reader,
+    dataEnd,
+    (parser) => {
+      parser.expectKeyword('endstream');
+      parser.expectKeyword('endobj');
+      return parser.offset;
+    },
+    256,
+  );
+  return { ...head, start: offset, dataEnd, end };
+};
+
+/**
+ * Decoded contents of object stream `num`
+ * @param {Object} reader - See createRangeReader
+ * @param {Map<number, Object>} entries - Cross-reference entries (see readXref)
+ * @param {number} num - Object number of the stream
+ * @param {Object} [handler] - Security handler of an encrypted file
+ * @returns {Promise<{dict: PdfDict, data: Uint8Array, offsets: number[]}>} `offsets` holds
+ *   where each contained object starts in `data`, by index
+ */
+export const readObjectStream = async (reader, entries, num, handler) => {
+  const entry = entries.get(num);
+  if (!entry || entry.type !== 1) throw new Error(`Object stream ${num} not found`);
+  const object = await readIndirectObject(reader, entry.offset);
+  const raw = await reader.read(object.dataStart, object.dataEnd - object.dataStart);
+  const data =
+    handler && handler.isStreamEncrypted(object.value)
+      ? await handler.decryptStream(object.num, object.gen, raw)
+      : raw;
+  const dict = object.value;
+  const decoded = await decodeStream(dict, data);
+
+  const header = new PdfParser(decoded, 0, { complete: true });
+  const offsets = [];
+  for (let i = 0; i < dict.get('N'); i++) {
+    header.readInteger();
+    offsets.push(dict.get('First') + header.readInteger());
+  }
+  return { dict, data: decoded, offsets };
+};
+
+/**
+ * Resolves indirect integers (stream lengths), including ones stored in
+ * object streams, which have to be decrypted and inflated first
+ * @param {Object} reader - See createRangeReader
+ * @param {Map<number, Object>} entries - Cross-reference entries (see readXref)
+ * @param {Object} [handler] - Security handler of an encrypted file
+ * @returns {(ref: PdfRef) => Promise<number>}
+ */
+export const createLengthResolver = (reader, entries, handler) => {
+  const objectStreams = new Map();
+
+  const readCompressed = async (entry) => {
+    if (!objectStreams.has(entry.stream)) {
+      objectStreams.set(entry.stream, readObjectStream(reader, entries, entry.stream, handler));
+    }
+    const { data, offsets } = await objectStreams.get(entry.stream);
+    if (entry.index >= offsets.length) throw new Error(`Object ${entry.index} not in stream`);
+    const parser = new PdfParser(data.subarray(offsets[entry.index]), 0, { complete: true });
+    return parser.parseValue();
+  };
+
+  return async (ref) => {
+    const entry = entries.get(ref.num);
+    let value;
+    if (entry && entry.type === 1) {
+      value = (await readIndirectObject(reader, entry.offset)).value;
+    } else if (entry && entry.type === 2) {
+      value = await readCompressed(entry);
+    }
+    if (!Number.isInteger(value)) throw new Error(`Unresolvable stream length ${ref.num}`);
+    return value;
+  };
+};
+
+// Value of an object and the references in it, from a buffer holding the object
+const parseBody = (bytes, base, { header }) => {
+  const references = [];
+  const parser = new PdfParser(bytes, base, { complete: true, references });
+  if (header) parser.parseObjectHeader();
+  parser.skipWhitespace();
+  const start = parser.offset;
+  const value = parser.parseValue();
+  return { value, bytes: bytes.slice(start - base, parser.offset - base), base: start, references };
+};
+
+/**
+ * Every object of an unencrypted file, by number, for the rewriters that
+ * renumber them: plain objects are parsed where they sit (stream data is only
+ * located), compressed ones out of their stream. Cross-reference and object
+ * streams themselves are left out.
+ * @param {Object} reader - See createRangeReader
+ * @param {Object} xref - See readXref
+ * @returns {Promise<Map<number, Object>>} `{gen, value, bytes, base, references, data}` by
+ *   number: `bytes` is the value's source from file offset `base`, `references` the spans
+ *   of the references in it (see PdfParser) and `data` the `[start, end]` of stream data
+ */
+export const loadObjects = async (reader, { entries, xrefStreams }) => {
+  const resolveLength = createLengthResolver(reader, entries);
+  const objects = new Map();
+
+  for (const [num, entry] of entries) {
+    if (num === 0 || entry.type !== 1 || xrefStreams.has(num)) continue;
+    const object = await readIndirectObject(reader, entry.offset, { resolveLength });
+    if (object.num !== num || object.gen !== entry.gen) {
+      throw new Error(`Object ${num} ${entry.gen} not found at ${entry.offset}`);
+    }
+    const isStream = object.dataStart !== undefined;
+    const type = object.value instanceof PdfDict ? object.value.get('Type') : undefined;
+    if (isStream && (isName(type, 'XRef') || isName(type, 'ObjStm'))) continue;
+
+    const headEnd = isStream ? object.streamStart : object.end;
+    const bytes = await reader.read(object.start, headEnd - object.start);
+    objects.set(num, {
+      gen: object.gen,
+      ...parseBody(bytes, object.start, { header: true }),
+      data: isStream ? [object.dataStart, object.dataEnd] : null,
+    });
+  }
+
+  const objectStreams = new Map();
+  for (const [num, entry] of entries) {
+    if (entry.type !== 2) continue;
+    if (!objectStreams.has(entry.stream)) {
+      objectStreams.set(entry.stream, await readObjectStream(reader, entries, entry.stream));
+    }
+    const { data, offsets } = objectStreams.get(entry.stream);
+    if (entry.index >= offsets.length) throw new Error(`Object ${num} not in its object stream`);
+    const bytes = data.subarray(offsets[entry.index]);
+    objects.set(num, { gen: 0, ...parseBody(bytes, 0, { header: false }), data: null });
+  }
+  return objects;
+};
@@ -0,0 +1,65 @@
+/**
+ * PDF object model used by the security-strip engine
+ *
+ * Numbers, booleans, null and arrays map to their JS counterparts. Names,
+ * references, strings and dictionaries get small classes; strings and
+ * dictionary values remember their byte span in the file so they can be
+ * rewritten in place without re-serializing the surrounding object.
+ */
+
+export class PdfName {
+  constructor(name) {
+    this.name = name;
+  }
+}
+
+export class PdfRef {
+  constructor(num, gen) {
+    this.num = num;
+    this.gen = gen;
+  }
+}
+
+export class PdfString {
+  /**
+   * @param {Uint8Array} bytes - Decoded string bytes
+   * @param {number} start - File offset of the opening delimiter
+   * @param {number} end - File offset just past the closing delimiter
+   */
+  constructor(bytes, start, end) {
+    this.bytes = bytes;
+    this.start = start;
+    this.end = end;
+  }
+}
+
+export class PdfDict {
+  constructor() {
+    this.entries = new Map();
+    // Key -> [start, end) file span of the value
+    this.spans = new Map();
+  }
+
+  get(key) {
+    return this.entries.get(key);
+  }
+
+  has(key) {
+    return this.entries.has(key);
+  }
+
+  set(key, value, start, end) {
+    this.entries.set(key, value);
+    this.spans.set(key, [start, end]);
+  }
+
+  /**
+   * Name value of `key`, or undefined when absent or not a name
+   */
+  getName(key) {
+    const value = this.entries.get(key);
+    return value instanceof PdfName ? value.name : undefined;
+  }
+}
+
+export const isName = (value, name) => value instanceof PdfName && value.name === name;
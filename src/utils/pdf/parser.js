@@ -0,0 +1,362 @@
+/**
+ * PDF object parser
+ *
+ * Parses direct objects and indirect object headers out of a byte window of
+ * the file. Running past the end of the window raises a TruncatedError, so the
+ * caller can retry with a larger window instead of scanning the whole file.
+ */
+
+import { PdfDict, PdfName, PdfRef, PdfString } from './objects';
+
+/**
+ * The window ended before the object did
+ */
+export class TruncatedError extends Error {
+  constructor() {
+    super('Unexpected end of data');
+    this.name = 'TruncatedError';
+  }
+}
+
+const CHAR_CODE = (char) => char.charCodeAt(0);
+const LF = 0x0a;
+const CR = 0x0d;
+
+// Whitespace per ISO 32000-1 table 1
+const isWhitespace = (byte) =>
+  byte === 0x20 || byte === LF || byte === CR || byte === 0x09 || byte === 0x0c || byte === 0x00;
+
+// ( ) < > [ ] { } / %
+const isDelimiter = (byte) =>
+  byte === 0x28 ||
+  byte === 0x29 ||
+  byte === 0x3c ||
+  byte === 0x3e ||
+  byte === 0x5b ||
+  byte === 0x5d ||
+  byte === 0x7b ||
+  byte === 0x7d ||
+  byte === 0x2f ||
+  byte === 0x25;
+
+const isRegular = (byte) => !isWhitespace(byte) && !isDelimiter(byte);
+const isDigit = (byte) => byte >= 0x30 && byte <= 0x39;
+
+const hexValue = (byte) => {
+  if (byte >= 0x30 && byte <= 0x39) return byte - 0x30;
+  if (byte >= 0x41 && byte <= 0x46) return byte - 0x37;
+  if (byte >= 0x61 && byte <= 0x66) return byte - 0x57;
+  return -1;
+};
+
+const ESCAPES = {
+  [CHAR_CODE('n')]: LF,
+  [CHAR_CODE('r')]: CR,
+  [CHAR_CODE('t')]: 0x09,
+  [CHAR_CODE('b')]: 0x08,
+  [CHAR_CODE('f')]: 0x0c,
+};
+
+export class PdfParser {
+  /**
+   * @param {Uint8Array} bytes - Window of the file
+   * @param {number} [base] - File offset of bytes[0]
+   * @param {Object} [options]
+   * @param {boolean} [options.complete] - The window holds all remaining data, so its end
+   *   terminates tokens instead of raising TruncatedError
+   * @param {Array} [options.references] - Receives `{ref, start, end}` for every reference
+   *   parsed, with its file span, so it can be rewritten in place
+   */
+  constructor(bytes, base = 0, { complete = false, references = null } = {}) {
+    this.bytes = bytes;
+    this.base = base;
+    this.complete = complete;
+    this.references = references;
+    this.pos = 0;
+  }
+
+  /** Whether the read position is at the end of the window */
+  get atEnd() {
+    return this.pos >= this.bytes.length;
+  }
+
+  /** File offset of the read position */
+  get offset() {
+    return this.base + this.pos;
+  }
+
+  peek() {
+    if (this.pos >= this.bytes.length) throw new TruncatedError();
+    return this.bytes[this.pos];
+  }
+
+  skipWhitespace() {
+    const { bytes } = this;
+    while (this.pos < bytes.length) {
+      const byte = bytes[this.pos];
+      if (isWhitespace(byte)) {
+        this.pos++;
+      } else if (byte === 0x25) {
+        // Comment runs to the end of the line
+        while (this.pos < bytes.length && bytes[this.pos] !== LF && bytes[this.pos] !== CR) {
+          this.pos++;
+        }
+      } else {
+        return;
+      }
+    }
+    if (!this.complete) throw new TruncatedError();
+  }
+
+  /**
+   * Read a run of regular characters (keyword or number)
+   */
+  readRegular() {
+    const start = this.pos;
+    while (this.pos < this.bytes.length && isRegular(this.bytes[this.pos])) this.pos++;
+    // A token touching the end of the window might continue past it
+    if (this.atEnd && !this.complete) throw new TruncatedError();
+    return String.fromCharCode(...this.bytes.subarray(start, this.pos));
+  }
+
+  /**
+   * Consume `keyword`, throwing if the next token is something else
+   */
+  expectKeyword(keyword) {
+    this.skipWhitespace();
+    const start = this.pos;
+    const token = this.readRegular();
+    if (token !== keyword) {
+      throw new SyntaxError(`Expected ${keyword} at ${this.base + start}, found "${token}"`);
+    }
+  }
+
+  /**
+   * Whether the next token is `keyword`; consumes it when it is
+   */
+  matchKeyword(keyword) {
+    this.skipWhitespace();
+    const start = this.pos;
+    if (this.atEnd || !isRegular(this.peek())) return false;
+    if (this.readRegular() === keyword) return true;
+    this.pos = start;
+    return false;
+  }
+
+  readInteger() {
+    this.skipWhitespace();
+    const start = this.pos;
+    const token = this.readRegular();
+    if (!/^\d+$/.test(token)) {
+      throw new SyntaxError(`Expected integer at ${this.base + start}, found "${token}"`);
+    }
+    return Number(token);
+  }
+
+  /**
+   * Parse `num gen obj`
+   * @returns {{num: number, gen: number}}
+   */
+  parseObjectHeader() {
+    const num = this.readInteger();
+    const gen = this.readInteger();
+    this.expectKeyword('obj');
+    return { num, gen };
+  }
+
+  /**
+   * Parse a direct object at the read position
+   */
+  parseValue() {
+    this.skipWhitespace();
+    const byte = this.peek();
+
+    if (byte === 0x2f) return this.parseName();
+    if (byte === 0x28) return this.parseLiteralString();
+    if (byte === 0x3c) {
+      if (this.pos + 1 >= this.bytes.length) throw new TruncatedError();
+      return this.bytes[this.pos + 1] === 0x3c ? this.parseDict() : this.parseHexString();
+    }
+    if (byte === 0x5b) return this.parseArray();
+
+    const start = this.pos;
+    const token = this.readRegular();
+    if (token === 'true') return true;
+    if (token === 'false') return false;
+    if (token === 'null') return null;
+
+    const number = Number(token);
+    if (token === '' || Number.isNaN(number)) {
+      throw new SyntaxError(`Unexpected token "${token}" at ${this.base + start}`);
+    }
+
+    // `num gen R` is a reference
+    if (/^\d+$/.test(token)) {
+      const afterNumber = this.pos;
+      this.skipWhitespace();
+      if (!this.atEnd && isDigit(this.peek())) {
+        const gen = this.readRegular();
+        this.skipWhitespace();
+        if (/^\d+$/.test(gen) && !this.atEnd && this.peek() === CHAR_CODE('R')) {
+          this.pos++;
+          if (this.atEnd && !this.complete) throw new TruncatedError();
+          if (this.atEnd || !isRegular(this.bytes[this.pos])) {
+            const ref = new PdfRef(number, Number(gen));
+            if (this.references) {
+              this.references.push({ ref, start: this.base + start, end: this.offset });
+            }
+            return ref;
+          }
+        }
+      }
+      this.pos = afterNumber;
+    }
+    return number;
+  }
+
+  parseName() {
+    this.pos++; // '/'
+    const start = this.pos;
+    while (this.pos < this.bytes.length && isRegular(this.bytes[this.pos])) this.pos++;
+    if (this.atEnd && !this.complete) throw new TruncatedError();
+
+    const raw = this.bytes.subarray(start, this.pos);
+    let name = '';
+    for (let i = 0; i < raw.length; i++) {
+      // #xx escapes
+      if (raw[i] === 0x23 && i + 2 < raw.length) {
+        const value = (hexValue(raw[i + 1]) << 4) | hexValue(raw[i + 2]);
+        if (value >= 0) {
+          name += String.fromCharCode(value);
+          i += 2;
+          continue;
+        }
+      }
+      name += String.fromCharCode(raw[i]);
+    }
+    return new PdfName(name);
+  }
+
+  parseLiteralString() {
+    const { bytes } = this;
+    const start = this.pos;
+    this.pos++; // '('
+    const out = [];
+    let depth = 1;
+
+    while (this.pos < bytes.length) {
+      const byte = bytes[this.pos++];
+      if (byte === 0x5c) {
+        if (this.pos >= bytes.length) break;
+        const next = bytes[this.pos++];
+        if (ESCAPES[next] !== undefined) {
+          out.push(ESCAPES[next]);
+        } else if (next >= 0x30 && next <= 0x37) {
+          // Up to three octal digits
+          let value = next - 0x30;
+          for (let i = 0; i < 2 && this.pos < bytes.length; i++) {
+            const digit = bytes[this.pos];
+            if (digit < 0x30 || digit > 0x37) break;
+            value = value * 8 + digit - 0x30;
+            this.pos++;
+          }
+          out.push(value & 0xff);
+        } else if (next === CR) {
+          // Line continuation
+          if (this.pos < bytes.length && bytes[this.pos] === LF) this.pos++;
+        } else if (next !== LF) {
+          out.push(next);
+        }
+      } else if (byte === CR) {
+        // Unescaped end-of-line markers read as a single LF
+        if (this.pos < bytes.length && bytes[this.pos] === LF) this.pos++;
+        out.push(LF);
+      } else {
+        if (byte === 0x28) depth++;
+        if (byte === 0x29 && --depth === 0) {
+          return new PdfString(Uint8Array.from(out), this.base + start, this.base + this.pos);
+        }
+        out.push(byte);
+      }
+    }
+    throw new TruncatedError();
+  }
+
+  parseHexString() {
+    const { bytes } = this;
+    const start = this.pos;
+    this.pos++; // '<'
+    const out = [];
+    let high = -1;
+
+    while (this.pos < bytes.length) {
+      const byte = bytes[this.pos++];
+      if (byte === 0x3e) {
+        if (high >= 0) out.push(high << 4);
+        return new PdfString(Uint8Array.from(out), this.base + start, this.base + this.pos);
+      }
+      const value = hexValue(byte);
+      if (value < 0) continue; // whitespace
+      if (high < 0) {
+        high = value;
+      } else {
+        out.push((high << 4) | value);
+        high = -1;
+      }
+    }
+    throw new TruncatedError();
+  }
+
+  parseArray() {
+    this.pos++; // '['
+    const items = [];
+    for (;;) {
+      this.skipWhitespace();
+      if (this.peek() === 0x5d) {
+        this.pos++;
+        return items;
+      }
+      items.push(this.parseValue());
+    }
+  }
+
+  parseDict() {
+    this.pos += 2; // '<<'
+    const dict = new PdfDict();
+    for (;;) {
+      this.skipWhitespace();
+      const byte = this.peek();
+      if (byte === 0x3e) {
+        if (this.pos + 1 >= this.bytes.length) throw new TruncatedError();
+        if (this.bytes[this.pos + 1] !== 0x3e) {
+          throw new SyntaxError(`Malformed dictionary end at ${this.offset}`);
+        }
+        this.pos += 2;
+        return dict;
+      }
+      if (byte !== 0x2f) throw new SyntaxError(`Expected name key at ${this.offset}`);
+
+      const key = this.parseName().name;
+      this.skipWhitespace();
+      const start = this.offset;
+      const value = this.parseValue();
+      dict.set(key, value, start, this.offset);
+    }
+  }
+
+  /**
+   * After a stream dictionary: consume `stream` and its end-of-line marker
+   * @returns {boolean} Whether a stream follows (false when `endobj` is next)
+   */
+  parseStreamStart() {
+    if (!this.matchKeyword('stream')) return false;
+    // CRLF or LF, tolerating a lone CR
+    if (this.peek() === CR) {
+      this.pos++;
+      if (this.peek() === LF) this.pos++;
+    } else if (this.peek() === LF) {
+      this.pos++;
+    }
+    return true;
+  }
+}
@@ -0,0 +1,112 @@
+/**
+ * Unit tests for the PDF object parser
+ * Tests direct objects, string decoding, value spans and window truncation
+ */
+
+import { PdfDict, PdfName, PdfRef, PdfString } from './objects';
+import { PdfParser, TruncatedError } from './parser';
+
+const ascii = (text) => Uint8Array.from(text, (char) => char.charCodeAt(0));
+const parse = (text, base) => new PdfParser(ascii(text), base, { complete: true }).parseValue();
+const text = (string) => String.fromCharCode(...string.bytes);
+
+describe('PdfParser', () => {
+  describe('Direct Objects', () => {
+    it('should parse numbers, booleans and null', () => {
+      expect(parse('42')).toBe(42);
+      expect(parse('-3.5')).toBe(-3.5);
+      expect(parse('.5')).toBe(0.5);
+      expect(parse('true')).toBe(true);
+      expect(parse('false')).toBe(false);
+      expect(parse('null')).toBeNull();
+    });
+
+    it('should tell references from consecutive numbers', () => {
+      expect(parse('12 0 R')).toEqual(new PdfRef(12, 0));
+      expect(parse('[1 2 3]')).toEqual([1, 2, 3]);
+      expect(parse('[1 0 R 2]')).toEqual([new PdfRef(1, 0), 2]);
+    });
+
+    it('should decode name escapes', () => {
+      expect(parse('/Type')).toEqual(new PdfName('Type'));
+      expect(parse('/A#20B')).toEqual(new PdfName('A B'));
+    });
+
+    it('should parse dictionaries and remember value spans', () => {
+      const dict = parse('<< /Length 12 0 R /Filter /FlateDecode >>', 100);
+
+      expect(dict).toBeInstanceOf(PdfDict);
+      expect(dict.get('Length')).toEqual(new PdfRef(12, 0));
+      expect(dict.getName('Filter')).toBe('FlateDecode');
+      expect(dict.spans.get('Length')).toEqual([111, 117]);
+    });
+
+    it('should collect references with their spans on request', () => {
+      const references = [];
+      const parser = new PdfParser(ascii('[1 0 R << /P 23 0 R >> 4 5]'), 100, {
+        complete: true,
+        references,
+      });
+
+      parser.parseValue();
+
+      expect(references).toEqual([
+        { ref: new PdfRef(1, 0), start: 101, end: 106 },
+        { ref: new PdfRef(23, 0), start: 113, end: 119 },
+      ]);
+    });
+
+    it('should skip comments', () => {
+      expect(parse('% comment\n[1 % inside\n 2]')).toEqual([1, 2]);
+    });
+  });
+
+  describe('Strings', () => {
+    it('should decode literal string escapes', () => {
+      expect(text(parse('(a\\(b\\)c)'))).toBe('a(b)c');
+      expect(text(parse('(\\n\\r\\t\\\\)'))).toBe('\n\r\t\\');
+      expect(text(parse('(\\101\\0612)'))).toBe('A12');
+      expect(text(parse('(nested (parens) ok)'))).toBe('nested (parens) ok');
+    });
+
+    it('should normalize end-of-line markers and honor line continuations', () => {
+      expect(text(parse('(a\r\nb\rc)'))).toBe('a\nb\nc');
+      expect(text(parse('(a\\\r\nb)'))).toBe('ab');
+    });
+
+    it('should decode hex strings, padding an odd final digit', () => {
+      expect(Array.from(parse('<48 65 6C>').bytes)).toEqual([0x48, 0x65, 0x6c]);
+      expect(Array.from(parse('<ABC>').bytes)).toEqual([0xab, 0xc0]);
+    });
+
+    it('should record the span of the string in the file', () => {
+      const string = parse('(abc)', 10);
+
+      expect(string).toBeInstanceOf(PdfString);
+      expect([string.start, string.end]).toEqual([10, 15]);
+    });
+  });
+
+  describe('Indirect Objects', () => {
+    it('should parse the object header and detect a stream', () => {
+      const parser = new PdfParser(ascii('7 0 obj\n<< /Length 3 >>\nstream\r\nabc\nendstream'));
+
+      expect(parser.parseObjectHeader()).toEqual({ num: 7, gen: 0 });
+      parser.parseValue();
+      expect(parser.parseStreamStart()).toBe(true);
+      expect(parser.offset).toBe(32);
+    });
+
+    it('should report truncation when the window ends mid-object', () => {
+      expect(() => new PdfParser(ascii('<< /Key (unterminated')).parseValue()).toThrow(
+        TruncatedError,
+      );
+      // A number at the end of a window might still turn out to be a reference
+      expect(() => new PdfParser(ascii('<< /Length 12 ')).parseValue()).toThrow(TruncatedError);
+    });
+
+    it('should reject malformed syntax', () => {
+      expect(() => parse('<< 1 2 >>')).toThrow(SyntaxError);
+    });
+  });
+});
@@ -0,0 +1,175 @@
+/**
+ * Render-free document probe for intake triage
+ *
+ * Answers what a router needs before any decrypt: file size, header version,
+ * page count and the encryption algorithm, revision and permissions. Only the
+ * cross-reference chain, the trailer, /Encrypt, the catalog and the page-tree
+ * root are read; no page, content stream or PDFium instance is touched.
+ *
+ * /Count is a plain integer, so it is readable in an encrypted file as long as
+ * the catalog and page-tree root sit outside object streams. Compressed ones
+ * need the stream decrypted, which is tried with the empty user password only
+ * (files with just an owner password); otherwise `pageCount` is null.
+ */
+
+import { PdfDict, PdfRef } from './objects';
+import { PdfParser } from './parser';
+import { createRangeReader } from './rangeReader';
+import { readIndirectObject, readObjectStream } from './objectReader';
+import { readXref } from './xref';
+import { readDocumentId, resolveEncrypt } from './encryption';
+import { createSecurityHandler } from './securityHandler';
+import { readVersion } from './stripSecurity';
+
+// Windows small enough that a File probe reads little more than its tail and two objects
+const PROBE_WINDOW_SIZE = 64 * 1024;
+
+// ISO 32000-2 table 22: /P bit (1-based) of each permission
+const PERMISSION_BITS = {
+  print: 3,
+  modify: 4,
+  copy: 5,
+  annotate: 6,
+  fillForms: 9,
+  extract: 10,
+  assemble: 11,
+  printHighQuality: 12,
+};
+
+const CRYPT_ALGORITHMS = { V2: 'RC4', AESV2: 'AES-128', AESV3: 'AES-256', None: 'none' };
+
+// Method and key size of the stream crypt filter (the one that guards page content)
+const describeCipher = (encrypt) => {
+  const version = encrypt.get('V') || 0;
+  if (version < 4) {
+    return { algorithm: 'RC4', keyBits: version === 1 ? 40 : encrypt.get('Length') || 40 };
+  }
+
+  const name = encrypt.getName('StmF') || 'Identity';
+  if (name === 'Identity') return { algorithm: 'none', keyBits: null };
+  const filters = encrypt.get('CF');
+  const filter = filters instanceof PdfDict ? filters.get(name) : undefined;
+  const algorithm =
+    filter instanceof PdfDict ? CRYPT_ALGORITHMS[filter.getName('CFM') || 'None'] : undefined;
+  if (algorithm === 'AES-128') return { algorithm, keyBits: 128 };
+  if (algorithm === 'AES-256') return { algorithm, keyBits: 256 };
+  if (algorithm !== 'RC4') return { algorithm: algorithm || null, keyBits: null };
+
+  // Crypt filter lengths are given in bytes by most writers, bits by some
+  const length = filter.get('Length');
+  const bits = Number.isInteger(length) && length <= 32 ? length * 8 : length;
+  return { algorithm, keyBits: bits || encrypt.get('Length') || 128 };
+};
+
+/**
+ * Plain-data summary of an /Encrypt dictionary
+ * @param {PdfDict} encrypt
+ * @returns {{filter: string|null, version: number, revision: number|null, algorithm:
+ *   string|null, keyBits: number|null, encryptMetadata: boolean, permissions: number|null,
+ *   allowed: Object<string, boolean>|null}} `algorithm` is 'RC4', 'AES-128', 'AES-256',
+ *   'none' (identity crypt filter) or null when unknown; `permissions` the signed /P value
+ *   and `allowed` its bits by name (null without /P, e.g. public-key handlers)
+ */
+export const describeEncryption = (encrypt) => {
+  const permissions = Number.isInteger(encrypt.get('P')) ? encrypt.get('P') | 0 : null;
+  const allowed =
+    permissions === null
+      ? null
+      : Object.fromEntries(
+          Object.entries(PERMISSION_BITS).map(([name, bit]) => [
+            name,
+            (permissions & (1 << (bit - 1))) !== 0,
+          ]),
+        );
+  const revision = encrypt.get('R');
+
+  return {
+    filter: encrypt.getName('Filter') || null,
+    version: encrypt.get('V') || 0,
+    revision: Number.isInteger(revision) ? revision : null,
+    ...describeCipher(encrypt),
+    encryptMetadata: encrypt.get('EncryptMetadata') !== false,
+    permissions,
+    allowed,
+  };
+};
+
+/**
+ * Object resolver for a handful of dictionaries: plain objects are parsed where
+ * they sit, compressed ones out of their (possibly decrypted) object stream
+ * @param {() => Promise<Object|null>} getHandler - Security handler for object streams;
+ *   null when they cannot be decrypted
+ */
+const createResolver = (reader, entries, getHandler) => {
+  const objectStreams = new Map();
+
+  const readCompressed = async (entry) => {
+    if (!objectStreams.has(entry.stream)) {
+      const loading = getHandler().then((handler) =>
+        handler === null ? null : readObjectStream(reader, entries, entry.stream, handler),
+      );
+      objectStreams.set(entry.stream, loading);
+    }
+    const stream = await objectStreams.get(entry.stream);
+    if (!stream || entry.index >= stream.offsets.length) return undefined;
+    const parser = new PdfParser(stream.data.subarray(stream.offsets[entry.index]), 0, {
+      complete: true,
+    });
+    return parser.parseValue();
+  };
+
+  return async (value) => {
+    if (!(value instanceof PdfRef)) return value;
+    const entry = entries.get(value.num);
+    if (entry && entry.type === 1) return (await readIndirectObject(reader, entry.offset)).value;
+    if (entry && entry.type === 2) return readCompressed(entry);
+    return undefined;
+  };
+};
+
+/**
+ * Read the metadata intake routing needs, without loading any page
+ * @param {ArrayBuffer|Blob} source - PDF bytes or a File/Blob (read in small windows)
+ * @returns {Promise<{size: number, version: string|null, pageCount: number|null,
+ *   encrypted: boolean, encryption: Object|null}>} `encryption` as from describeEncryption;
+ *   `pageCount` is the page-tree root /Count, null when it cannot be read without a password
+ *   or the catalog is damaged
+ * @throws {Error} When the cross-reference chain or /Encrypt is unreadable; the engines'
+ *   repair paths may still open such files
+ */
+export const probeDocument = async (source) => {
+  const reader = createRangeReader(source, { windowSize: PROBE_WINDOW_SIZE });
+  const version = await readVersion(reader).catch(() => null);
+  const { entries, trailer } = await readXref(reader);
+  const encrypt = await resolveEncrypt(reader, entries, trailer);
+
+  // Key derivation only runs when an encrypted object stream holds the page tree
+  let handler;
+  const getHandler = () => {
+    if (!handler) {
+      handler = encrypt
+        ? createSecurityHandler(encrypt.dict, readDocumentId(trailer), '').catch(() => null)
+        : Promise.resolve(undefined);
+    }
+    return handler;
+  };
+  const resolve = createResolver(reader, entries, getHandler);
+
+  let pageCount = null;
+  try {
+    const catalog = await resolve(trailer.get('Root'));
+    const pages = catalog instanceof PdfDict ? await resolve(catalog.get('Pages')) : undefined;
+    const count = pages instanceof PdfDict ? pages.get('Count') : undefined;
+    if (Number.isInteger(count)) pageCount = Math.max(0, count);
+  } catch {
+    // A damaged catalog leaves the count unknown; the rest of the probe still stands
+  }
+
+  return {
+    size: reader.size,
+    version,
+    pageCount,
+    encrypted: Boolean(encrypt),
+    encryption: encrypt ? describeEncryption(encrypt.dict) : null,
+  };
+};
@@ -0,0 +1,110 @@
+/**
+ * Unit tests for the render-free document probe
+ * Tests page counts, encryption summaries and permissions from the fixtures and
+ * from built files and dictionaries
+ */
+
+import { describeEncryption, probeDocument } from './probe';
+import { PdfParser } from './parser';
+import { buildPdf, fixture, PLAIN, PROTECTED } from './testPdf';
+
+const ascii = (text) => Uint8Array.from(text, (char) => char.charCodeAt(0));
+const dict = (text) => new PdfParser(ascii(text), 0, { complete: true }).parseValue();
+
+// Minimal file with a catalog and page-tree root (objects given as text)
+const buildFile = (objects, trailer) => buildPdf(objects, { trailer, version: '1.7' });
+
+describe('probeDocument', () => {
+  it('should read the page count of an unencrypted file', async () => {
+    const file = fixture(PLAIN);
+
+    expect(await probeDocument(file)).toEqual({
+      size: file.byteLength,
+      version: '1.4',
+      pageCount: 4,
+      encrypted: false,
+      encryption: null,
+    });
+  });
+
+  it('should summarize the encryption of a protected file', async () => {
+    const probe = await probeDocument(new File([fixture(PROTECTED)], 'x'));
+
+    expect(probe.encrypted).toBe(true);
+    expect(probe.encryption).toMatchObject({
+      filter: 'Standard',
+      version: 4,
+      revision: 4,
+      algorithm: 'AES-128',
+      keyBits: 128,
+    });
+    // The page tree sits in an object stream only the user password decrypts
+    expect(probe.pageCount).toBeNull();
+  });
+
+  it('should read /Count where it sits, even in an encrypted file', async () => {
+    const file = buildFile(
+      [
+        '<< /Type /Catalog /Pages 2 0 R >>',
+        '<< /Type /Pages /Kids [] /Count 12 >>',
+        '<< /Filter /Standard /V 2 /R 3 /Length 128 /P -44 /O (x) /U (y) >>',
+      ],
+      '/Root 1 0 R /Encrypt 3 0 R',
+    );
+    const probe = await probeDocument(file);
+
+    expect(probe.pageCount).toBe(12);
+    expect(probe.encryption).toMatchObject({ algorithm: 'RC4', keyBits: 128, revision: 3 });
+  });
+
+  it('should leave the page count unknown when the catalog is damaged', async () => {
+    const file = buildFile(['<< /Type /Catalog /Pages 9 0 R >>']);
+
+    expect((await probeDocument(file)).pageCount).toBeNull();
+  });
+
+  it('should reject files without a readable trailer', async () => {
+    await expect(probeDocument(new ArrayBuffer(64))).rejects.toThrow('startxref');
+  });
+});
+
+describe('describeEncryption', () => {
+  it('should name the stream cipher', () => {
+    const aes256 = dict(
+      '<< /Filter /Standard /V 5 /R 6 /StmF /StdCF /StrF /StdCF ' +
+        '/CF << /StdCF << /CFM /AESV3 /Length 32 >> >> /P -4 >>',
+    );
+
+    expect(describeEncryption(aes256)).toMatchObject({ algorithm: 'AES-256', keyBits: 256 });
+    expect(describeEncryption(dict('<< /Filter /Standard /V 1 /R 2 /P -4 >>'))).toMatchObject({
+      algorithm: 'RC4',
+      keyBits: 40,
+    });
+    expect(describeEncryption(dict('<< /Filter /Standard /V 4 /R 4 /P -4 >>')).algorithm).toBe(
+      'none',
+    );
+  });
+
+  it('should decode the permission bits of /P', () => {
+    // Print (bit 3) and copy (bit 5) only, with the reserved high bits set
+    const { permissions, allowed } = describeEncryption(dict('<< /V 2 /R 3 /P -4076 >>'));
+
+    expect(permissions).toBe(-4076);
+    expect(allowed).toEqual({
+      print: true,
+      modify: false,
+      copy: true,
+      annotate: false,
+      fillForms: false,
+      extract: false,
+      assemble: false,
+      printHighQuality: false,
+    });
+  });
+
+  it('should leave permissions unknown without /P', () => {
+    const summary = describeEncryption(dict('<< /Filter /Adobe.PubSec /V 4 >>'));
+
+    expect(summary).toMatchObject({ filter: 'Adobe.PubSec', permissions: null, allowed: null });
+  });
+});
@@ -0,0 +1,49 @@
+/**
+ * Random access over the input for the security-strip engine
+ *
+ * An ArrayBuffer is served by views into it. A File/Blob is read through one
+ * sliding window, which suits the engine's mostly ascending access pattern
+ * without holding the whole file in memory.
+ */
+
+const WINDOW_SIZE = 1024 * 1024;
+
+/**
+ * @param {ArrayBuffer|Blob} source
+ * @param {Object} [options]
+ * @param {number} [options.windowSize] - Blob read granularity
+ * @returns {{size: number, read: (position: number, length: number) => Promise<Uint8Array>}}
+ *   `read` clamps to the end of the input; the result may be a view, copy it to keep it
+ */
+export const createRangeReader = (source, { windowSize = WINDOW_SIZE } = {}) => {
+  if (!(source instanceof Blob)) {
+    const bytes = new Uint8Array(source);
+    return {
+      size: bytes.length,
+      read: async (position, length) =>
+        bytes.subarray(position, Math.min(bytes.length, position + length)),
+    };
+  }
+
+  let windowStart = 0;
+  let windowBytes = new Uint8Array(0);
+
+  const readSlice = async (start, end) =>
+    new Uint8Array(await source.slice(start, end).arrayBuffer());
+
+  return {
+    size: source.size,
+    read: async (position, length) => {
+      const end = Math.min(source.size, position + length);
+      if (position >= windowStart && end <= windowStart + windowBytes.length) {
+        return windowBytes.subarray(position - windowStart, end - windowStart);
+      }
+      // Large reads (stream data) bypass the window
+      if (end - position > windowSize) return readSlice(position, end);
+
+      windowStart = position;
+      windowBytes = await readSlice(position, Math.min(source.size, position + windowSize));
+      return windowBytes.subarray(0, end - position);
+    },
+  };
+};
@@ -0,0 +1,63 @@
+/**
+ * Unit tests for the strip engine's range reader
+ * Tests ArrayBuffer views and windowed Blob reads
+ */
+
+import { createRangeReader } from './rangeReader';
+
+const bytes = Uint8Array.from({ length: 100 }, (_, i) => i);
+
+// jsdom's Blob cannot be read back, so slices serve their bytes directly
+class FakeBlob extends Blob {
+  constructor(data) {
+    super([]);
+    this.data = data;
+    this.slices = [];
+  }
+
+  get size() {
+    return this.data.length;
+  }
+
+  slice(start, end) {
+    this.slices.push([start, end]);
+    const data = this.data.slice(start, end);
+    return { arrayBuffer: async () => data.buffer };
+  }
+}
+
+describe('createRangeReader', () => {
+  it('should serve an ArrayBuffer through views, clamped to its end', async () => {
+    const reader = createRangeReader(bytes.buffer);
+
+    expect(reader.size).toBe(100);
+    expect(await reader.read(10, 3)).toEqual(Uint8Array.from([10, 11, 12]));
+    expect(await reader.read(98, 10)).toEqual(Uint8Array.from([98, 99]));
+  });
+
+  it('should read a Blob through a sliding window', async () => {
+    const blob = new FakeBlob(bytes);
+    const reader = createRangeReader(blob, { windowSize: 16 });
+
+    expect(await reader.read(0, 4)).toEqual(Uint8Array.from([0, 1, 2, 3]));
+    expect(await reader.read(8, 4)).toEqual(Uint8Array.from([8, 9, 10, 11]));
+    expect(await reader.read(20, 2)).toEqual(Uint8Array.from([20, 21]));
+    expect(blob.slices).toEqual([
+      [0, 16],
+      [20, 36],
+    ]);
+  });
+
+  it('should read large ranges directly without moving the window', async () => {
+    const blob = new FakeBlob(bytes);
+    const reader = createRangeReader(blob, { windowSize: 16 });
+    await reader.read(0, 4);
+
+    expect((await reader.read(30, 40)).length).toBe(40);
+    expect(await reader.read(4, 2)).toEqual(Uint8Array.from([4, 5]));
+    expect(blob.slices).toEqual([
+      [0, 16],
+      [30, 70],
+    ]);
+  });
+});
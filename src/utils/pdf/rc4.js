@@ -0,0 +1,30 @@
+/**
+ * RC4 stream cipher, used by security handler revisions 2-4
+ */
+
+/**
+ * @param {Uint8Array} key
+ * @param {Uint8Array} data
+ * @returns {Uint8Array} Output of the same length (RC4 is its own inverse)
+ */
+export const rc4 = (key, data) => {
+  const state = new Uint8Array(256);
+  for (let i = 0; i < 256; i++) state[i] = i;
+  for (let i = 0, j = 0; i < 256; i++) {
+    j = (j + state[i] + key[i % key.length]) & 0xff;
+    const swap = state[i];
+    state[i] = state[j];
+    state[j] = swap;
+  }
+
+  const out = new Uint8Array(data.length);
+  for (let k = 0, i = 0, j = 0; k < data.length; k++) {
+    i = (i + 1) & 0xff;
+    j = (j + state[i]) & 0xff;
+    const swap = state[i];
+    state[i] = state[j];
+    state[j] = swap;
+    out[k] = data[k] ^ state[(state[i] + state[j]) & 0xff];
+  }
+  return out;
+};
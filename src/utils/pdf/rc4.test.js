@@ -0,0 +1,26 @@
+/**
+ * Unit tests for the RC4 cipher
+ * Tests published test vectors and that decryption inverts encryption
+ */
+
+import { rc4 } from './rc4';
+
+const hex = (bytes) => Array.from(bytes, (byte) => byte.toString(16).padStart(2, '0')).join('');
+const ascii = (text) => Uint8Array.from(text, (char) => char.charCodeAt(0));
+
+describe('rc4', () => {
+  it.each([
+    ['Key', 'Plaintext', 'bbf316e8d940af0ad3'],
+    ['Wiki', 'pedia', '1021bf0420'],
+    ['Secret', 'Attack at dawn', '45a01f645fc35b383552544b9bf5'],
+  ])('should encrypt with key "%s"', (key, plaintext, expected) => {
+    expect(hex(rc4(ascii(key), ascii(plaintext)))).toBe(expected);
+  });
+
+  it('should decrypt what it encrypted', () => {
+    const key = Uint8Array.from([1, 2, 3, 4, 5]);
+    const data = Uint8Array.from({ length: 1000 }, (_, i) => i & 0xff);
+
+    expect(rc4(key, rc4(key, data))).toEqual(data);
+  });
+});
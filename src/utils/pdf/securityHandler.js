@@ -0,0 +1,306 @@
+/**
+ * Standard security handler (ISO 32000-2 section 7.6.4)
+ *
+ * Derives the file key from the user or owner password for revisions 2-6 and
+ * decrypts strings and streams object by object: RC4 and AESV2 with per-object
+ * keys, AESV3 with the file key.
+ */
+
+import { md5 } from './md5';
+import { rc4 } from './rc4';
+import { aesCbcDecrypt, aesCbcEncrypt } from './aes';
+import { PdfDict, PdfString, isName } from './objects';
+
+// Padding string from Algorithm 2, step a
+const PASSWORD_PADDING = Uint8Array.from([
+  0x28, 0xbf, 0x4e, 0x5e, 0x4e, 0x75, 0x8a, 0x41, 0x64, 0x00, 0x4e, 0x56, 0xff, 0xfa, 0x01, 0x08,
+  0x2e, 0x2e, 0x00, 0xb6, 0xd0, 0x68, 0x3e, 0x80, 0x2f, 0x0c, 0xa9, 0xfe, 0x64, 0x53, 0x69, 0x7a,
+]);
+const AES_SALT = Uint8Array.from([0x73, 0x41, 0x6c, 0x54]); // "sAlT"
+const NO_METADATA_MARKER = Uint8Array.from([0xff, 0xff, 0xff, 0xff]);
+// Stream decryption switches to Web Crypto above this size
+const SUBTLE_MIN_BYTES = 4096;
+
+/**
+ * The password matches neither the user nor the owner password
+ */
+export class IncorrectPasswordError extends Error {
+  constructor() {
+    super('Password required or incorrect password');
+    this.name = 'IncorrectPasswordError';
+  }
+}
+
+const concat = (...parts) => {
+  const out = new Uint8Array(parts.reduce((sum, part) => sum + part.length, 0));
+  let offset = 0;
+  for (const part of parts) {
+    out.set(part, offset);
+    offset += part.length;
+  }
+  return out;
+};
+
+const equalBytes = (a, b, length) => {
+  if (a.length < length || b.length < length) return false;
+  for (let i = 0; i < length; i++) if (a[i] !== b[i]) return false;
+  return true;
+};
+
+const sameBytes = (a, b) => a.length === b.length && equalBytes(a, b, a.length);
+
+const xorKey = (key, value) => key.map((byte) => byte ^ value);
+
+const encodeUtf8 = (text) => new TextEncoder().encode(text);
+
+/**
+ * Byte encodings to try for a password: Latin-1 first for revisions 2-4, whose
+ * passwords are PDFDocEncoding, then UTF-8 as PDFium receives it
+ */
+const passwordCandidates = (password, revision) => {
+  const utf8 = encodeUtf8(password);
+  if (revision >= 5) return [utf8.subarray(0, 127)];
+
+  const candidates = [];
+  if ([...password].every((char) => char.charCodeAt(0) < 256)) {
+    candidates.push(Uint8Array.from(password, (char) => char.charCodeAt(0)));
+  }
+  if (!candidates.length || !sameBytes(candidates[0], utf8)) candidates.push(utf8);
+  return candidates;
+};
+
+const padPassword = (password) => {
+  const padded = new Uint8Array(32);
+  padded.set(password.subarray(0, 32));
+  padded.set(PASSWORD_PADDING.subarray(0, 32 - Math.min(32, password.length)), password.length);
+  return padded;
+};
+
+const stringBytes = (value) => (value instanceof PdfString ? value.bytes : new Uint8Array(0));
+
+// Algorithm 2: file key from a padded user password (revisions 2-4)
+const computeLegacyKey = (paddedPassword, params) => {
+  const { owner, permissions, id, revision, keyLength, encryptMetadata } = params;
+  const permissionBytes = new Uint8Array(4);
+  new DataView(permissionBytes.buffer).setInt32(0, permissions, true);
+
+  let key = md5(
+    concat(
+      paddedPassword,
+      owner.subarray(0, 32),
+      permissionBytes,
+      id,
+      revision >= 4 && !encryptMetadata ? NO_METADATA_MARKER : new Uint8Array(0),
+    ),
+  ).subarray(0, keyLength);
+  if (revision >= 3) {
+    for (let i = 0; i < 50; i++) key = md5(key).subarray(0, keyLength);
+  }
+  return key;
+};
+
+// Algorithms 4-6: does `key` reproduce /U
+const checkLegacyUserKey = (key, params) => {
+  const { user, id, revision } = params;
+  if (revision === 2) return equalBytes(rc4(key, PASSWORD_PADDING), user, 32);
+
+  let hash = rc4(key, md5(concat(PASSWORD_PADDING, id)));
+  for (let i = 1; i <= 19; i++) hash = rc4(xorKey(key, i), hash);
+  return equalBytes(hash, user, 16);
+};
+
+// Algorithm 7: recover the padded user password from /O with the owner password
+const recoverUserPassword = (ownerPassword, params) => {
+  const { owner, revision, keyLength } = params;
+  let hash = md5(padPassword(ownerPassword));
+  if (revision >= 3) {
+    for (let i = 0; i < 50; i++) hash = md5(hash);
+  }
+  const key = hash.subarray(0, keyLength);
+
+  if (revision === 2) return rc4(key, owner.subarray(0, 32));
+  let userPassword = owner.subarray(0, 32);
+  for (let i = 19; i >= 0; i--) userPassword = rc4(xorKey(key, i), userPassword);
+  return userPassword;
+};
+
+const deriveLegacyKey = (password, params) => {
+  for (const candidate of passwordCandidates(password, params.revision)) {
+    const userKey = computeLegacyKey(padPassword(candidate), params);
+    if (checkLegacyUserKey(userKey, params)) return userKey;
+
+    const ownerKey = computeLegacyKey(recoverUserPassword(candidate, params), params);
+    if (checkLegacyUserKey(ownerKey, params)) return ownerKey;
+  }
+  throw new IncorrectPasswordError();
+};
+
+const digest = async (algorithm, data) =>
+  new Uint8Array(await globalThis.crypto.subtle.digest(algorithm, data));
+
+// Algorithm 2.B (revision 6), or plain SHA-256 for revision 5
+const hashModern = async (password, salt, userData, revision) => {
+  let hash = await digest('SHA-256', concat(password, salt, userData));
+  if (revision === 5) return hash;
+
+  for (let round = 0; ; round++) {
+    const unit = concat(password, hash, userData);
+    const repeated = new Uint8Array(unit.length * 64);
+    for (let i = 0; i < 64; i++) repeated.set(unit, i * unit.length);
+
+    const encrypted = aesCbcEncrypt(hash.subarray(0, 16), hash.subarray(16, 32), repeated);
+    let sum = 0;
+    for (let i = 0; i < 16; i++) sum += encrypted[i];
+    hash = await digest(['SHA-256', 'SHA-384', 'SHA-512'][sum % 3], encrypted);
+
+    if (round >= 63 && encrypted[encrypted.length - 1] <= round - 31) break;
+  }
+  return hash.subarray(0, 32);
+};
+
+// Algorithm 2.A: file key for revisions 5 and 6
+const deriveModernKey = async (password, params, encrypt) => {
+  const { owner, user, revision } = params;
+  const [candidate] = passwordCandidates(password, revision);
+  const zeroIv = new Uint8Array(16);
+  const userKeyBytes = user.subarray(0, 48);
+
+  const ownerHash = await hashModern(candidate, owner.subarray(32, 40), userKeyBytes, revision);
+  if (equalBytes(ownerHash, owner, 32)) {
+    const ownerKeySalt = owner.subarray(40, 48);
+    const intermediate = await hashModern(candidate, ownerKeySalt, userKeyBytes, revision);
+    const ownerEncrypted = stringBytes(encrypt.get('OE')).subarray(0, 32);
+    return aesCbcDecrypt(intermediate, zeroIv, ownerEncrypted, { padding: false });
+  }
+
+  const userHash = await hashModern(candidate, user.subarray(32, 40), new Uint8Array(0), revision);
+  if (equalBytes(userHash, user, 32)) {
+    const userKeySalt = user.subarray(40, 48);
+    const intermediate = await hashModern(candidate, userKeySalt, new Uint8Array(0), revision);
+    const userEncrypted = stringBytes(encrypt.get('UE')).subarray(0, 32);
+    return aesCbcDecrypt(intermediate, zeroIv, userEncrypted, { padding: false });
+  }
+
+  throw new IncorrectPasswordError();
+};
+
+const CRYPT_METHODS = { V2: 'rc4', AESV2: 'aesv2', AESV3: 'aesv3', None: 'none' };
+
+// Method of the crypt filter named by /StmF or /StrF
+const resolveCryptFilter = (encrypt, key) => {
+  if (encrypt.get('V') < 4) return 'rc4';
+
+  const name = encrypt.getName(key) || 'Identity';
+  if (name === 'Identity') return 'none';
+  const filters = encrypt.get('CF');
+  const filter = filters instanceof PdfDict ? filters.get(name) : undefined;
+  const method = filter instanceof PdfDict ? CRYPT_METHODS[filter.getName('CFM') || 'None'] : null;
+  if (!method) throw new Error(`Unsupported crypt filter ${name}`);
+  return method;
+};
+
+const getKeyLength = (encrypt, version) => {
+  if (version === 1) return 5;
+  if (version >= 5) return 32;
+
+  let bits = encrypt.get('Length') || 40;
+  if (version === 4) {
+    const filters = encrypt.get('CF');
+    const filter = filters instanceof PdfDict ? filters.get(encrypt.getName('StmF')) : undefined;
+    const filterLength = filter instanceof PdfDict ? filter.get('Length') : undefined;
+    // Crypt filter lengths are given in bytes by most writers, bits by some
+    if (Number.isInteger(filterLength)) bits = filterLength <= 32 ? filterLength * 8 : filterLength;
+    if (filter instanceof PdfDict && isName(filter.get('CFM'), 'AESV2')) bits = 128;
+  }
+  return Math.min(16, Math.max(5, Math.floor(bits / 8)));
+};
+
+const aesDecrypt = async (key, data) => {
+  // Too short to hold an IV and a block: PDFium treats these as empty too
+  if (data.length < 32) return new Uint8Array(0);
+  const iv = data.subarray(0, 16);
+  const body = data.subarray(16);
+
+  const subtle = globalThis.crypto?.subtle;
+  if (subtle && body.length >= SUBTLE_MIN_BYTES) {
+    const cryptoKey = await subtle.importKey('raw', key, 'AES-CBC', false, ['decrypt']);
+    return new Uint8Array(await subtle.decrypt({ name: 'AES-CBC', iv }, cryptoKey, body));
+  }
+  return aesCbcDecrypt(key, iv, body);
+};
+
+/**
+ * Authenticate against an /Encrypt dictionary
+ * @param {PdfDict} encrypt - Encryption dictionary
+ * @param {Uint8Array} id - First element of the trailer /ID
+ * @param {string} password - User or owner password
+ * @returns {Promise<Object>} Handler with `decryptString`, `decryptStream`, `isStreamEncrypted`
+ * @throws {IncorrectPasswordError}
+ */
+export const createSecurityHandler = async (encrypt, id, password) => {
+  if (!isName(encrypt.get('Filter'), 'Standard')) {
+    throw new Error(`Unsupported security handler ${encrypt.getName('Filter')}`);
+  }
+  const version = encrypt.get('V') || 0;
+  const revision = encrypt.get('R');
+  if (![1, 2, 4, 5].includes(version) || !(revision >= 2 && revision <= 6)) {
+    throw new Error(`Unsupported encryption V${version} R${revision}`);
+  }
+
+  const params = {
+    owner: stringBytes(encrypt.get('O')),
+    user: stringBytes(encrypt.get('U')),
+    permissions: encrypt.get('P') | 0,
+    id,
+    revision,
+    keyLength: getKeyLength(encrypt, version),
+    encryptMetadata: encrypt.get('EncryptMetadata') !== false,
+  };
+
+  const fileKey =
+    revision >= 5
+      ? await deriveModernKey(password, params, encrypt)
+      : deriveLegacyKey(password, params);
+  const stringMethod = resolveCryptFilter(encrypt, 'StrF');
+  const streamMethod = resolveCryptFilter(encrypt, 'StmF');
+
+  const objectKey = (num, gen, method) => {
+    if (method === 'aesv3') return fileKey;
+    const suffix = Uint8Array.from([num, num >> 8, num >> 16, gen, gen >> 8]);
+    const hash = md5(concat(fileKey, suffix, method === 'aesv2' ? AES_SALT : new Uint8Array(0)));
+    return hash.subarray(0, Math.min(fileKey.length + 5, 16));
+  };
+
+  return {
+    /**
+     * Whether a stream's data is encrypted (metadata may be exempt, /Identity is)
+     */
+    isStreamEncrypted: (dict) => {
+      if (streamMethod === 'none') return false;
+      if (!params.encryptMetadata && isName(dict.get('Type'), 'Metadata')) return false;
+      const filter = dict.get('Filter');
+      const filters = Array.isArray(filter) ? filter : [filter];
+      if (filters.some((name) => isName(name, 'Crypt'))) {
+        throw new Error('Per-stream crypt filters are not supported');
+      }
+      return true;
+    },
+
+    /** Whether strings need decrypting at all */
+    encryptsStrings: stringMethod !== 'none',
+
+    decryptString: (num, gen, bytes) => {
+      if (stringMethod === 'none') return bytes;
+      const key = objectKey(num, gen, stringMethod);
+      if (stringMethod === 'rc4') return rc4(key, bytes);
+      if (bytes.length < 32) return new Uint8Array(0);
+      return aesCbcDecrypt(key, bytes.subarray(0, 16), bytes.subarray(16));
+    },
+
+    decryptStream: async (num, gen, bytes) => {
+      const key = objectKey(num, gen, streamMethod);
+      if (streamMethod === 'rc4') return rc4(key, bytes);
+      return aesDecrypt(key, bytes);
+    },
+  };
+};
@@ -0,0 +1,116 @@
+/**
+ * Unit tests for the standard security handler
+ * Tests password authentication (Algorithms 2-7) and per-object decryption
+ */
+
+import fs from 'fs';
+import path from 'path';
+import { createSecurityHandler, IncorrectPasswordError } from './securityHandler';
+import { createRangeReader } from './rangeReader';
+import { readIndirectObject } from './objectReader';
+import { readXref } from './xref';
+import { md5 } from './md5';
+import { rc4 } from './rc4';
+import { PdfDict, PdfName, PdfString } from './objects';
+
+const PADDING = Uint8Array.from([
+  0x28, 0xbf, 0x4e, 0x5e, 0x4e, 0x75, 0x8a, 0x41, 0x64, 0x00, 0x4e, 0x56, 0xff, 0xfa, 0x01, 0x08,
+  0x2e, 0x2e, 0x00, 0xb6, 0xd0, 0x68, 0x3e, 0x80, 0x2f, 0x0c, 0xa9, 0xfe, 0x64, 0x53, 0x69, 0x7a,
+]);
+const ID = Uint8Array.from({ length: 16 }, (_, i) => i * 7);
+const PERMISSIONS = -44;
+const FIXTURE = path.join(process.cwd(), 'e2e/assets/file-sample_150kB-protected.pdf');
+
+const ascii = (text) => Uint8Array.from(text, (char) => char.charCodeAt(0));
+const concat = (...parts) => Uint8Array.from(parts.flatMap((part) => Array.from(part)));
+const pad = (password) => concat(ascii(password), PADDING).subarray(0, 32);
+const string = (bytes) => new PdfString(bytes, 0, 0);
+
+const dictOf = (entries) => {
+  const dict = new PdfDict();
+  for (const [key, value] of Object.entries(entries)) dict.set(key, value, 0, 0);
+  return dict;
+};
+
+// Revision 2 /Encrypt dictionary built with Algorithms 3 and 4, plus its file key
+const createRevision2 = (userPassword, ownerPassword) => {
+  const owner = rc4(md5(pad(ownerPassword)).subarray(0, 5), pad(userPassword));
+  const permissions = Uint8Array.from([0, 8, 16, 24].map((shift) => PERMISSIONS >> shift));
+  const fileKey = md5(concat(pad(userPassword), owner, permissions, ID)).subarray(0, 5);
+  const encrypt = dictOf({
+    Filter: new PdfName('Standard'),
+    V: 1,
+    R: 2,
+    O: string(owner),
+    U: string(rc4(fileKey, PADDING)),
+    P: PERMISSIONS,
+  });
+  return { encrypt, fileKey };
+};
+
+const readFixtureEncrypt = async () => {
+  const reader = createRangeReader(new Uint8Array(fs.readFileSync(FIXTURE)).buffer);
+  const { entries, trailer } = await readXref(reader);
+  const encryptEntry = entries.get(trailer.get('Encrypt').num);
+  const { value } = await readIndirectObject(reader, encryptEntry.offset);
+  return { encrypt: value, id: trailer.get('ID')[0].bytes };
+};
+
+describe('createSecurityHandler', () => {
+  describe('Revision 2 (RC4 40-bit)', () => {
+    it.each([['userpw'], ['ownerpw']])('should accept "%s"', async (password) => {
+      const { encrypt, fileKey } = createRevision2('userpw', 'ownerpw');
+      const handler = await createSecurityHandler(encrypt, ID, password);
+      const objectKey = md5(concat(fileKey, [12, 0, 0, 0, 0])).subarray(0, 10);
+
+      expect(Array.from(handler.decryptString(12, 0, rc4(objectKey, ascii('Title'))))).toEqual(
+        Array.from(ascii('Title')),
+      );
+    });
+
+    it('should reject a wrong password', async () => {
+      const { encrypt } = createRevision2('userpw', 'ownerpw');
+
+      await expect(createSecurityHandler(encrypt, ID, 'nope')).rejects.toBeInstanceOf(
+        IncorrectPasswordError,
+      );
+    });
+
+    it('should accept an empty user password', async () => {
+      const { encrypt } = createRevision2('', 'ownerpw');
+      const handler = await createSecurityHandler(encrypt, ID, '');
+
+      expect(handler.encryptsStrings).toBe(true);
+      expect(handler.isStreamEncrypted(dictOf({}))).toBe(true);
+    });
+  });
+
+  describe('Revision 4 (AESV2)', () => {
+    it('should authenticate the fixture password', async () => {
+      const { encrypt, id } = await readFixtureEncrypt();
+
+      expect(encrypt.get('R')).toBe(4);
+      await expect(createSecurityHandler(encrypt, id, 'password')).resolves.toBeTruthy();
+      await expect(createSecurityHandler(encrypt, id, 'wrong')).rejects.toBeInstanceOf(
+        IncorrectPasswordError,
+      );
+    });
+  });
+
+  describe('Unsupported input', () => {
+    it('should reject other security handlers', async () => {
+      const encrypt = dictOf({ Filter: new PdfName('Adobe.PubSec'), V: 4, R: 4 });
+
+      await expect(createSecurityHandler(encrypt, ID, '')).rejects.toThrow('Adobe.PubSec');
+    });
+
+    it('should reject per-stream crypt filters', async () => {
+      const { encrypt } = createRevision2('', 'ownerpw');
+      const handler = await createSecurityHandler(encrypt, ID, '');
+
+      expect(() => handler.isStreamEncrypted(dictOf({ Filter: new PdfName('Crypt') }))).toThrow(
+        'crypt filters',
+      );
+    });
+  });
+});
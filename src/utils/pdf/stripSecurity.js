@@ -0,0 +1,327 @@
+/**
+ * Security-strip engine: password removal without PDFium
+ *
+ * Walks the cross-reference table instead of the page tree, decrypts each
+ * string and stream in place, drops /Encrypt and writes a new cross-reference
+ * section. Objects that need no change are copied through byte for byte, and
+ * stream data is never decompressed, so big image-heavy files cost little
+ * more than a decrypting copy.
+ *
+ * When encryption only starts with an incremental update (e.g. a signed
+ * original encrypted later), the revisions before it are kept as they are and
+ * the output is one more update over them: only objects of the encrypted
+ * revisions are written again, and the new section's /Prev leads to the
+ * original ones. Signatures over those revisions keep their byte ranges.
+ *
+ * Anything outside what it understands throws; callers fall back to PDFium.
+ */
+
+import { PdfDict, PdfString, isName } from './objects';
+import { createRangeReader } from './rangeReader';
+import { createLengthResolver, readIndirectObject } from './objectReader';
+import { findRevisionEnd, readXref } from './xref';
+import { createSecurityHandler } from './securityHandler';
+import { readDocumentId, resolveEncrypt } from './encryption';
+import { createChunkWriter, encodeLatin1, serializeString, serializeValue } from './writer';
+import { passThrough } from '../passThrough';
+
+const HEADER_PATTERN = /^%PDF-(\d\.\d)/;
+const COPY_CHUNK_SIZE = 4 * 1024 * 1024;
+// Marks the output as binary for transfer tools
+export const BINARY_COMMENT = '%\xe2\xe3\xcf\xd3\n';
+
+const collectStrings = (value, out) => {
+  if (value instanceof PdfString) {
+    out.push(value);
+  } else if (Array.isArray(value)) {
+    for (const item of value) collectStrings(item, out);
+  } else if (value instanceof PdfDict) {
+    for (const item of value.entries.values()) collectStrings(item, out);
+  }
+  return out;
+};
+
+const bytesNeeded = (value) => {
+  let bytes = 1;
+  while (value >= 256 ** bytes) bytes++;
+  return bytes;
+};
+
+/**
+ * Version from the `%PDF-x.y` header
+ */
+export const readVersion = async (reader) => {
+  const head = String.fromCharCode(...(await reader.read(0, 16)));
+  const match = HEADER_PATTERN.exec(head);
+  if (!match) throw new Error('Missing %PDF header');
+  return match[1];
+};
+
+/**
+ * The oldest revisions, as far as none of them is encrypted, when an update
+ * over them can replace the encrypted rest: `end` is where they stop, `xrefOffset`
+ * the newest of their sections and `kept` the objects they still define.
+ * Undefined otherwise, including files whose revisions are not in file order
+ * (linearized ones)
+ */
+const findPlainRevisions = async (reader, { sections }) => {
+  const oldestFirst = [...sections].reverse();
+  const count = oldestFirst.findIndex((section) => section.trailer.has('Encrypt'));
+  if (count <= 0) return undefined;
+
+  const last = oldestFirst[count - 1];
+  const end = await findRevisionEnd(reader, last.offset);
+  if (end === undefined) return undefined;
+  const encrypted = oldestFirst.slice(count);
+  const inOrder = encrypted.every(
+    (section) =>
+      section.offset >= end &&
+      section.entries.every(([, entry]) => entry.type !== 1 || entry.offset >= end),
+  );
+  if (!inOrder) return undefined;
+
+  const redefined = new Set(encrypted.flatMap((section) => section.entries.map(([num]) => num)));
+  const kept = new Set();
+  for (const section of oldestFirst.slice(0, count)) {
+    for (const [num] of section.entries) if (!redefined.has(num)) kept.add(num);
+  }
+  return { end, xrefOffset: last.offset, kept };
+};
+
+/**
+ * First pass: locate every object and work out what changes, before any output
+ * is produced, so unsupported input fails while a fallback is still possible
+ */
+const planObjects = async (reader, xref, handler, encryptNum, kept) => {
+  const { entries, xrefStreams } = xref;
+  const resolveLength = createLengthResolver(reader, entries, handler);
+  const located = [...entries]
+    .filter(([num, entry]) => entry.type === 1 && num !== 0 && !kept.has(num))
+    .filter(([num]) => num !== encryptNum && !xrefStreams.has(num))
+    .sort(([, a], [, b]) => a.offset - b.offset);
+
+  const plan = [];
+  for (const [num, entry] of located) {
+    if (entry.offset >= reader.size) throw new Error(`Object ${num} is past end of file`);
+    const object = await readIndirectObject(reader, entry.offset, { resolveLength });
+    if (object.num !== num || object.gen !== entry.gen) {
+      throw new Error(`Object ${num} ${entry.gen} not found at ${entry.offset}`);
+    }
+    const isStream = object.dataStart !== undefined;
+    if (isStream && isName(object.value.get('Type'), 'XRef')) continue;
+
+    const replacements = handler.encryptsStrings
+      ? collectStrings(object.value, []).map((string) => ({
+          start: string.start,
+          end: string.end,
+          bytes: serializeString(handler.decryptString(num, object.gen, string.bytes)),
+        }))
+      : [];
+
+    plan.push({
+      num,
+      gen: object.gen,
+      start: object.start,
+      end: object.end,
+      streamStart: object.streamStart,
+      dataStart: object.dataStart,
+      dataEnd: object.dataEnd,
+      lengthSpan: isStream ? object.value.spans.get('Length') : undefined,
+      encrypted: isStream && handler.isStreamEncrypted(object.value),
+      replacements,
+    });
+  }
+  return plan;
+};
+
+const copyRange = async (reader, writer, start, end) => {
+  for (let position = start; position < end; position += COPY_CHUNK_SIZE) {
+    writer.write(await reader.read(position, Math.min(COPY_CHUNK_SIZE, end - position)));
+    await writer.drain();
+  }
+};
+
+// Copy [start, end) with the planned replacements spliced in
+const writeWithReplacements = async (reader, writer, start, end, replacements) => {
+  let position = start;
+  for (const { start: from, end: to, bytes } of replacements) {
+    await copyRange(reader, writer, position, from);
+    writer.write(bytes);
+    position = to;
+  }
+  await copyRange(reader, writer, position, end);
+};
+
+const writeObject = async (reader, writer, handler, item) => {
+  const isStream = item.dataStart !== undefined;
+  if (!item.replacements.length && !item.encrypted) {
+    await copyRange(reader, writer, item.start, item.end);
+    writer.writeText('\n');
+    return;
+  }
+
+  if (!isStream) {
+    await writeWithReplacements(reader, writer, item.start, item.end, item.replacements);
+    writer.writeText('\n');
+    return;
+  }
+
+  const raw = await reader.read(item.dataStart, item.dataEnd - item.dataStart);
+  const data = item.encrypted ? await handler.decryptStream(item.num, item.gen, raw) : raw;
+  const replacements = [...item.replacements];
+  if (data.length !== raw.length) {
+    // AES drops the IV and padding; the dictionary gets a direct /Length
+    const [start, end] = item.lengthSpan;
+    replacements.push({ start, end, bytes: encodeLatin1(String(data.length)) });
+  }
+  replacements.sort((a, b) => a.start - b.start);
+
+  await writeWithReplacements(reader, writer, item.start, item.streamStart, replacements);
+  writer.writeText('stream\n');
+  writer.write(data);
+  writer.writeText('\nendstream\nendobj\n');
+};
+
+const buildTrailerEntries = (trailer, size, prev) => {
+  const entries = [`/Size ${size}`];
+  for (const key of ['Root', 'Info', 'ID']) {
+    if (trailer.has(key)) entries.push(`/${key} ${serializeValue(trailer.get(key))}`);
+  }
+  if (prev !== undefined) entries.push(`/Prev ${prev}`);
+  return entries.join(' ');
+};
+
+// Runs of consecutive rows as [first, count]; an update leaves kept objects out
+const subsections = (rows) => {
+  const runs = [];
+  rows.forEach((row, num) => {
+    if (!row) return;
+    const run = runs[runs.length - 1];
+    if (run && run[0] + run[1] === num) run[1]++;
+    else runs.push([num, 1]);
+  });
+  return runs;
+};
+
+const writeXrefTable = (writer, rows, trailer, prev) => {
+  const xrefOffset = writer.position;
+  const line = ({ type, field2, field3 }) => {
+    const offset = String(type === 1 ? field2 : 0).padStart(10, '0');
+    return `${offset} ${String(field3).padStart(5, '0')} ${type === 1 ? 'n' : 'f'}\r\n`;
+  };
+  const sections = subsections(rows).map(
+    ([first, count]) => `${first} ${count}\n${rows.slice(first, first + count).map(line).join('')}`,
+  );
+  writer.writeText(`xref\n${sections.join('')}`);
+  writer.writeText(`trailer\n<< ${buildTrailerEntries(trailer, rows.length, prev)} >>\n`);
+  writer.writeText(`startxref\n${xrefOffset}\n%%EOF\n`);
+};
+
+const writeXrefStream = (writer, rows, trailer, prev) => {
+  const num = rows.length - 1;
+  const xrefOffset = writer.position;
+  rows[num] = { type: 1, field2: xrefOffset, field3: 0 };
+  const present = rows.filter(Boolean);
+
+  // Reduced rather than spread: a large table would exceed the argument limit
+  const largest = (field) => present.reduce((max, row) => Math.max(max, row[field]), 0);
+  const widths = [1, bytesNeeded(largest('field2')), bytesNeeded(largest('field3'))];
+  const rowWidth = widths[0] + widths[1] + widths[2];
+  const data = new Uint8Array(present.length * rowWidth);
+  present.forEach((row, index) => {
+    let offset = index * rowWidth;
+    [row.type, row.field2, row.field3].forEach((value, field) => {
+      for (let i = widths[field] - 1; i >= 0; i--) {
+        data[offset + i] = value % 256;
+        value = Math.floor(value / 256);
+      }
+      offset += widths[field];
+    });
+  });
+
+  const runs = subsections(rows);
+  const index = runs.length === 1 && runs[0][0] === 0 ? '' : ` /Index [${runs.flat().join(' ')}]`;
+  const dict =
+    `/Type /XRef ${buildTrailerEntries(trailer, rows.length, prev)}${index} ` +
+    `/W [${widths.join(' ')}]`;
+  writer.writeText(`${num} 0 obj\n<< ${dict} /Length ${data.length} >>\nstream\n`);
+  writer.write(data);
+  writer.writeText(`\nendstream\nendobj\nstartxref\n${xrefOffset}\n%%EOF\n`);
+};
+
+/**
+ * Remove the standard security handler from a PDF
+ * @param {ArrayBuffer|Blob} source - PDF bytes or a File/Blob (read in windows)
+ * @param {string} password - User or owner password
+ * @param {Object} [options]
+ * @param {(chunk: Uint8Array) => void|Promise<void>} [options.onChunk] - Streaming sink (see
+ *   createChunkWriter: a returned promise holds the next object back)
+ * @param {(progress: {bytesWritten: number, objectsDone: number, objectsTotal: number}) => void}
+ *   [options.onProgress] - Called after each object is written
+ * @returns {Promise<ArrayBuffer|null>} - Decrypted PDF (the input itself when not
+ *   encrypted), or null when the output was streamed through `onChunk`
+ * @throws {IncorrectPasswordError} When the password matches neither password
+ */
+export const stripSecurity = async (source, password, { onChunk, onProgress } = {}) => {
+  const reader = createRangeReader(source);
+  const version = await readVersion(reader);
+  const xref = await readXref(reader);
+  const { entries, trailer } = xref;
+
+  const encrypt = await resolveEncrypt(reader, entries, trailer);
+  if (!encrypt) return passThrough(source, onChunk);
+
+  const id = readDocumentId(trailer);
+  const handler = await createSecurityHandler(encrypt.dict, id, password || '');
+
+  const plain = await findPlainRevisions(reader, xref);
+  const kept = plain ? plain.kept : new Set();
+  const plan = await planObjects(reader, xref, handler, encrypt.num, kept);
+
+  const writer = createChunkWriter({ onChunk });
+  if (plain) {
+    await copyRange(reader, writer, 0, plain.end);
+    const [last] = await reader.read(plain.end - 1, 1);
+    if (last !== 0x0a && last !== 0x0d) writer.writeText('\n');
+  } else {
+    writer.writeText(`%PDF-${version}\n${BINARY_COMMENT}`);
+  }
+  const written = new Map();
+  for (const [index, item] of plan.entries()) {
+    written.set(item.num, { type: 1, field2: writer.position, field3: item.gen });
+    await writeObject(reader, writer, handler, item);
+    await writer.drain();
+    if (onProgress) {
+      const objectsDone = index + 1;
+      onProgress({ bytesWritten: writer.position, objectsDone, objectsTotal: plan.length });
+    }
+  }
+
+  // Compressed objects stay in their (now decrypted) object streams
+  let maxNum = 0;
+  for (const num of entries.keys()) maxNum = Math.max(maxNum, num);
+  const size = Math.max(trailer.get('Size') || 0, maxNum + 1) + (xref.hasCompressed ? 1 : 0);
+  const rows = Array.from({ length: size }, (_, num) => {
+    // Kept objects are found through /Prev, in the revisions they come from
+    if (kept.has(num)) return undefined;
+    if (written.has(num)) return written.get(num);
+    const entry = entries.get(num);
+    if (entry && entry.type === 2 && written.has(entry.stream)) {
+      return { type: 2, field2: entry.stream, field3: entry.index };
+    }
+    return { type: 0, field2: 0, field3: num === 0 ? 65535 : 0 };
+  });
+
+  const prev = plain ? plain.xrefOffset : undefined;
+  if (xref.hasCompressed) {
+    writeXrefStream(writer, rows, trailer, prev);
+  } else {
+    writeXrefTable(writer, rows, trailer, prev);
+  }
+
+  if (onChunk) {
+    writer.flush();
+    return null;
+  }
+  return writer.toArrayBuffer();
+};
@@ -0,0 +1,193 @@
+/**
+ * Unit tests for the security-strip engine
+ * Tests decryption of the protected fixture end to end, updates over plain
+ * revisions, and the error paths callers rely on to fall back to PDFium
+ */
+
+import { stripSecurity } from './stripSecurity';
+import { IncorrectPasswordError } from './securityHandler';
+import { createRangeReader } from './rangeReader';
+import { readIndirectObject } from './objectReader';
+import { readXref } from './xref';
+import { decodeStream } from './filters';
+import { isName } from './objects';
+import { md5 } from './md5';
+import { rc4 } from './rc4';
+import { encodeLatin1 } from './writer';
+import { appendFreeEntries, fixture, PLAIN, PROTECTED, xrefRow } from './testPdf';
+
+const concatChunks = (chunks) => {
+  const out = new Uint8Array(chunks.reduce((sum, chunk) => sum + chunk.length, 0));
+  let offset = 0;
+  for (const chunk of chunks) {
+    out.set(chunk, offset);
+    offset += chunk.length;
+  }
+  return out;
+};
+
+const PADDING = Uint8Array.from([
+  0x28, 0xbf, 0x4e, 0x5e, 0x4e, 0x75, 0x8a, 0x41, 0x64, 0x00, 0x4e, 0x56, 0xff, 0xfa, 0x01, 0x08,
+  0x2e, 0x2e, 0x00, 0xb6, 0xd0, 0x68, 0x3e, 0x80, 0x2f, 0x0c, 0xa9, 0xfe, 0x64, 0x53, 0x69, 0x7a,
+]);
+const ID = Uint8Array.from({ length: 16 }, (_, i) => i * 7);
+
+const concat = (...parts) => Uint8Array.from(parts.flatMap((part) => Array.from(part)));
+const latin1 = (bytes) => String.fromCharCode(...bytes);
+const hex = (bytes) => Array.from(bytes, (byte) => byte.toString(16).padStart(2, '0')).join('');
+
+/**
+ * A plain original revision (catalog, page, content) and an incremental
+ * update that replaces the content and adds an info dictionary, encrypted with
+ * revision 2 RC4 under an empty user password
+ */
+const buildEncryptedUpdate = () => {
+  const owner = rc4(md5(PADDING).subarray(0, 5), PADDING);
+  const permissions = Uint8Array.from([0xfc, 0xff, 0xff, 0xff]);
+  const fileKey = md5(concat(PADDING, owner, permissions, ID)).subarray(0, 5);
+  const encrypt = (num, data) =>
+    rc4(md5(concat(fileKey, [num, 0, 0, 0, 0])).subarray(0, 10), encodeLatin1(data));
+
+  let pdf = '%PDF-1.4\n';
+  const offsets = {};
+  const add = (num, body) => {
+    offsets[num] = pdf.length;
+    pdf += `${num} 0 obj\n${body}\nendobj\n`;
+  };
+  add(1, '<< /Type /Catalog /Pages 2 0 R >>');
+  add(2, '<< /Type /Pages /Kids [3 0 R] /Count 1 >>');
+  add(3, '<< /Type /Page /Parent 2 0 R /Contents 4 0 R >>');
+  add(4, '<< /Length 11 >>\nstream\nBT (old) ET\nendstream');
+  const firstXref = pdf.length;
+  const rows = (nums) => nums.map((num) => xrefRow(offsets[num])).join('');
+  pdf += `xref\n0 5\n0000000000 65535 f\r\n${rows([1, 2, 3, 4])}`;
+  pdf += `trailer\n<< /Size 5 /Root 1 0 R >>\nstartxref\n${firstXref}\n%%EOF\n`;
+  const original = pdf;
+
+  add(4, `<< /Length 11 >>\nstream\n${latin1(encrypt(4, 'BT (new) ET'))}\nendstream`);
+  add(5, `<< /Title <${hex(encrypt(5, 'Updated'))}> >>`);
+  const user = rc4(fileKey, PADDING);
+  add(6, `<< /Filter /Standard /V 1 /R 2 /O <${hex(owner)}> /U <${hex(user)}> /P -4 >>`);
+  const secondXref = pdf.length;
+  pdf += `xref\n4 3\n${rows([4, 5, 6])}`;
+  pdf += `trailer\n<< /Size 7 /Root 1 0 R /Info 5 0 R /Encrypt 6 0 R `;
+  pdf += `/ID [<${hex(ID)}> <${hex(ID)}>] /Prev ${firstXref} >>\n`;
+  pdf += `startxref\n${secondXref}\n%%EOF\n`;
+  return { bytes: encodeLatin1(pdf), original: encodeLatin1(original) };
+};
+
+describe('stripSecurity', () => {
+  it('should write a decrypted file without /Encrypt', async () => {
+    const output = await stripSecurity(fixture(PROTECTED), 'password');
+    const reader = createRangeReader(output);
+    const xref = await readXref(reader);
+
+    expect(String.fromCharCode(...new Uint8Array(output, 0, 8))).toBe('%PDF-1.6');
+    expect(xref.trailer.has('Encrypt')).toBe(false);
+    expect(xref.trailer.has('Root')).toBe(true);
+
+    // Encrypted data would not inflate
+    let decoded = 0;
+    for (const entry of xref.entries.values()) {
+      if (entry.type !== 1) continue;
+      const object = await readIndirectObject(reader, entry.offset);
+      if (object.dataStart === undefined || !isName(object.value.get('Filter'), 'FlateDecode')) {
+        continue;
+      }
+      const raw = await reader.read(object.dataStart, object.dataEnd - object.dataStart);
+      await decodeStream(object.value, raw);
+      decoded++;
+    }
+    expect(decoded).toBeGreaterThan(0);
+  });
+
+  it('should stream the same bytes it returns when buffered', async () => {
+    const buffered = new Uint8Array(await stripSecurity(fixture(PROTECTED), 'password'));
+    const chunks = [];
+    const result = await stripSecurity(fixture(PROTECTED), 'password', {
+      onChunk: (chunk) => chunks.push(chunk),
+    });
+
+    expect(result).toBeNull();
+    expect(concatChunks(chunks)).toEqual(buffered);
+  });
+
+  it('should report progress after every object it writes', async () => {
+    const onProgress = jest.fn();
+    const output = await stripSecurity(fixture(PROTECTED), 'password', { onProgress });
+
+    const last = onProgress.mock.calls[onProgress.mock.calls.length - 1][0];
+    expect(onProgress).toHaveBeenCalledTimes(last.objectsTotal);
+    expect(last.objectsDone).toBe(last.objectsTotal);
+    expect(last.bytesWritten).toBeLessThanOrEqual(output.byteLength);
+  });
+
+  it('should reject a wrong password before producing output', async () => {
+    const onChunk = jest.fn();
+
+    await expect(stripSecurity(fixture(PROTECTED), 'wrong', { onChunk })).rejects.toBeInstanceOf(
+      IncorrectPasswordError,
+    );
+    expect(onChunk).not.toHaveBeenCalled();
+  });
+
+  it('should hand unencrypted files back unchanged', async () => {
+    const source = fixture(PLAIN);
+
+    expect(await stripSecurity(source, 'password')).toBe(source);
+  });
+
+  it('should rewrite every revision when the original is encrypted', async () => {
+    const output = await stripSecurity(fixture(PROTECTED), 'password');
+
+    expect((await readXref(createRangeReader(output))).sections).toHaveLength(1);
+  });
+
+  it('should write a cross-reference stream too large to spread as arguments', async () => {
+    const source = await appendFreeEntries(fixture(PROTECTED), 250000);
+
+    const output = await stripSecurity(source, 'password');
+
+    const xref = await readXref(createRangeReader(output));
+    expect(xref.trailer.has('Encrypt')).toBe(false);
+    expect(xref.entries.size).toBeGreaterThan(250000);
+  });
+
+  describe('Updates over plain revisions', () => {
+    it('should keep the plain revision byte for byte and add one update', async () => {
+      const { bytes, original } = buildEncryptedUpdate();
+
+      const output = new Uint8Array(await stripSecurity(bytes.buffer, ''));
+
+      expect(output.subarray(0, original.length)).toEqual(original);
+      const xref = await readXref(createRangeReader(output.buffer));
+      expect(xref.sections).toHaveLength(2);
+      expect(xref.trailer.has('Encrypt')).toBe(false);
+      expect(xref.trailer.get('Prev')).toBe(xref.sections[1].offset);
+      expect(xref.entries.get(1).offset).toBeLessThan(original.length);
+      expect(xref.entries.get(4).offset).toBeGreaterThanOrEqual(original.length);
+    });
+
+    it('should decrypt only the objects of the encrypted update', async () => {
+      const { bytes } = buildEncryptedUpdate();
+      const onProgress = jest.fn();
+
+      const output = await stripSecurity(bytes.buffer, '', { onProgress });
+
+      const reader = createRangeReader(output);
+      const { entries } = await readXref(reader);
+      const content = await readIndirectObject(reader, entries.get(4).offset);
+      const data = await reader.read(content.dataStart, content.dataEnd - content.dataStart);
+      const info = await readIndirectObject(reader, entries.get(5).offset);
+      expect(latin1(data)).toBe('BT (new) ET');
+      expect(latin1(info.value.get('Title').bytes)).toBe('Updated');
+      expect(onProgress).toHaveBeenLastCalledWith(
+        expect.objectContaining({ objectsDone: 2, objectsTotal: 2 }),
+      );
+    });
+  });
+
+  it('should reject input that is not a PDF', async () => {
+    await expect(stripSecurity(new ArrayBuffer(64), 'password')).rejects.toThrow('%PDF');
+  });
+});
@@ -0,0 +1,115 @@
+/**
+ * Test helpers shared by the pdf/ unit tests: the e2e fixtures, builders for
+ * small files with classic cross-reference tables, and an update that makes
+ * any file's cross-reference very large
+ */
+
+import fs from 'fs';
+import path from 'path';
+import { concatBytes, encodeLatin1, serializeValue } from './writer';
+import { createRangeReader } from './rangeReader';
+import { findStartXref, readXref } from './xref';
+
+export const PLAIN = 'file-sample_150kB.pdf';
+export const PROTECTED = 'file-sample_150kB-protected.pdf';
+
+/**
+ * Bytes of an e2e fixture, as a fresh ArrayBuffer
+ */
+export const fixture = (name) =>
+  new Uint8Array(fs.readFileSync(path.join(process.cwd(), 'e2e/assets', name))).buffer;
+
+/**
+ * Latin-1 text of a buffer
+ */
+export const text = (buffer) => String.fromCharCode(...new Uint8Array(buffer));
+
+/**
+ * One in-use row of a cross-reference table
+ */
+export const xrefRow = (offset) => `${String(offset).padStart(10, '0')} 00000 n\r\n`;
+
+/**
+ * Minimal PDF with a classic cross-reference table; bodies are objects 1..n
+ * @param {string[]} bodies
+ * @param {Object} [options]
+ * @param {string} [options.trailer] - Trailer entries besides /Size
+ * @param {string} [options.version] - Header version
+ * @returns {ArrayBuffer}
+ */
+export const buildPdf = (bodies, { trailer = '/Root 1 0 R', version = '1.4' } = {}) => {
+  let pdf = `%PDF-${version}\n`;
+  const offsets = bodies.map((body, index) => {
+    const offset = pdf.length;
+    pdf += `${index + 1} 0 obj\n${body}\nendobj\n`;
+    return offset;
+  });
+  const xrefOffset = pdf.length;
+  pdf += `xref\n0 ${bodies.length + 1}\n0000000000 65535 f\r\n${offsets.map(xrefRow).join('')}`;
+  pdf += `trailer\n<< /Size ${bodies.length + 1} ${trailer} >>\nstartxref\n${xrefOffset}\n%%EOF\n`;
+  return encodeLatin1(pdf).buffer;
+};
+
+/**
+ * Linearized layout of buildPdf's file: a first-page section at the front holds
+ * the linearization dictionary (object n+1) and the trailer, the main table
+ * with objects 1..n comes last, and the final `startxref` points at the front
+ * @param {string[]} bodies
+ * @param {Object} [options]
+ * @param {string} [options.trailer] - First-page trailer entries besides /Size and /Prev
+ * @returns {ArrayBuffer}
+ */
+export const buildLinearizedPdf = (bodies, { trailer = '/Root 1 0 R' } = {}) => {
+  const size = bodies.length + 2;
+  const header = '%PDF-1.4\n';
+  const hint = `${size - 1} 0 obj\n<< /Linearized 1 >>\nendobj\n`;
+  const firstXref = header.length + hint.length;
+  // /Prev is padded to a fixed width, as linearizers do, so the front can be patched in place
+  const front = (prev) =>
+    `xref\n${size - 1} 1\n${xrefRow(header.length)}` +
+    `trailer\n<< /Size ${size} ${trailer} /Prev ${String(prev).padEnd(10)} >>\n` +
+    'startxref\n0\n%%EOF\n';
+
+  let pdf = header + hint + front(0);
+  const offsets = bodies.map((body, index) => {
+    const offset = pdf.length;
+    pdf += `${index + 1} 0 obj\n${body}\nendobj\n`;
+    return offset;
+  });
+  const mainXref = pdf.length;
+  pdf += `xref\n0 ${size - 1}\n0000000000 65535 f\r\n${offsets.map(xrefRow).join('')}`;
+  pdf += `trailer\n<< /Size ${size - 1} >>\nstartxref\n${firstXref}\n%%EOF\n`;
+  pdf = header + hint + front(mainXref) + pdf.slice(firstXref + front(0).length);
+  return encodeLatin1(pdf).buffer;
+};
+
+/**
+ * `source` with an unencrypted update whose cross-reference stream adds `count`
+ * free entries past its last object, and nothing else
+ * @param {ArrayBuffer} source
+ * @param {number} count
+ * @returns {Promise<ArrayBuffer>}
+ */
+export const appendFreeEntries = async (source, count) => {
+  const reader = createRangeReader(source);
+  const { trailer } = await readXref(reader);
+  const first = trailer.get('Size');
+  const num = first + count;
+  const kept = ['Root', 'Info', 'Encrypt', 'ID']
+    .filter((key) => trailer.has(key))
+    .map((key) => `/${key} ${serializeValue(trailer.get(key))}`);
+
+  // Rows of /W [1 4 1]: all free but the last, the stream itself
+  const data = new Uint8Array((count + 1) * 6);
+  data[count * 6] = 1;
+  new DataView(data.buffer).setUint32(count * 6 + 1, source.byteLength);
+  const dict =
+    `<< /Type /XRef /Size ${num + 1} /W [1 4 1] /Index [${first} ${count + 1}] ` +
+    `/Prev ${await findStartXref(reader)} ${kept.join(' ')} /Length ${data.length} >>`;
+  return concatBytes([
+    new Uint8Array(source),
+    encodeLatin1(`${num} 0 obj\n${dict}\nstream\n`),
+    data,
+    encodeLatin1(`\nendstream\nendobj\nstartxref\n${source.byteLength}\n%%EOF\n`),
+  ]).buffer;
+};
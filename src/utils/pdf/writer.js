@@ -0,0 +1,165 @@
+/**
+ * Output side of the security-strip engine and the rewriters
+ *
+ * Coalesces the many small writes (object headers, rewritten dictionaries)
+ * into fixed-size chunks, and serializes the few values the engines have to
+ * emit themselves: strings, numbers, renumbered objects and the trailer.
+ */
+
+import { PdfDict, PdfName, PdfRef, PdfString } from './objects';
+
+const CHUNK_SIZE = 1024 * 1024;
+
+/**
+ * @param {Object} [options]
+ * @param {(chunk: Uint8Array) => void|Promise<void>} [options.onChunk] - Receives standalone
+ *   chunks; without it everything is kept for `toArrayBuffer`. A promise it returns asks the
+ *   engine to hold off, and is what `drain` waits for
+ * @param {number} [options.chunkSize]
+ */
+export const createChunkWriter = ({ onChunk, chunkSize = CHUNK_SIZE } = {}) => {
+  const chunks = [];
+  let pending;
+  const emit = onChunk
+    ? (chunk) => {
+        pending = onChunk(chunk);
+      }
+    : (chunk) => chunks.push(chunk);
+  let buffer = new Uint8Array(chunkSize);
+  let used = 0;
+  let position = 0;
+
+  // Every emitted chunk owns its whole ArrayBuffer, so it can be transferred as is
+  const flush = () => {
+    if (!used) return;
+    if (used === chunkSize) {
+      emit(buffer);
+      buffer = new Uint8Array(chunkSize);
+    } else {
+      emit(buffer.slice(0, used));
+    }
+    used = 0;
+  };
+
+  const write = (bytes) => {
+    position += bytes.length;
+    if (bytes.length >= chunkSize) {
+      flush();
+      // Large blocks skip the staging buffer; copy only views into a bigger buffer
+      const owned = bytes.byteOffset === 0 && bytes.byteLength === bytes.buffer.byteLength;
+      emit(owned ? bytes : bytes.slice());
+      return;
+    }
+    if (used + bytes.length > chunkSize) flush();
+    buffer.set(bytes, used);
+    used += bytes.length;
+  };
+
+  return {
+    write,
+    writeText: (text) => write(encodeLatin1(text)),
+    /** Bytes written so far, i.e. the offset of the next write */
+    get position() {
+      return position;
+    },
+    flush,
+    /** Settles once the sink is ready for more; engines await it between objects */
+    drain: () => Promise.resolve(pending),
+    toArrayBuffer: () => {
+      flush();
+      const out = new Uint8Array(position);
+      let offset = 0;
+      for (const chunk of chunks) {
+        out.set(chunk, offset);
+        offset += chunk.length;
+      }
+      return out.buffer;
+    },
+  };
+};
+
+/**
+ * One byte per character (names, keywords and numbers are ASCII)
+ */
+export const encodeLatin1 = (text) => {
+  const bytes = new Uint8Array(text.length);
+  for (let i = 0; i < text.length; i++) bytes[i] = text.charCodeAt(i);
+  return bytes;
+};
+
+export const concatBytes = (parts) => {
+  const out = new Uint8Array(parts.reduce((sum, part) => sum + part.length, 0));
+  let offset = 0;
+  for (const part of parts) {
+    out.set(part, offset);
+    offset += part.length;
+  }
+  return out;
+};
+
+/**
+ * Source bytes of a loaded object's value with its references renumbered
+ * @param {Object} object - `{bytes, base, references}` (see loadObjects)
+ * @param {(ref: PdfRef) => number|undefined} renumber - New number of a reference; `null`
+ *   is written for references it cannot place
+ * @returns {Uint8Array}
+ */
+export const renderValue = ({ bytes, base, references }, renumber) => {
+  const parts = [];
+  let position = 0;
+  for (const { ref, start, end } of references) {
+    parts.push(bytes.subarray(position, start - base));
+    const target = renumber(ref);
+    parts.push(encodeLatin1(target === undefined ? 'null' : `${target} 0 R`));
+    position = end - base;
+  }
+  parts.push(bytes.subarray(position));
+  return concatBytes(parts);
+};
+
+/**
+ * Literal string syntax, escaping delimiters and end-of-line bytes
+ * @param {Uint8Array} bytes
+ * @returns {Uint8Array}
+ */
+export const serializeString = (bytes) => {
+  const out = [0x28];
+  for (const byte of bytes) {
+    if (byte === 0x28 || byte === 0x29 || byte === 0x5c) {
+      out.push(0x5c, byte);
+    } else if (byte === 0x0d) {
+      out.push(0x5c, 0x72); // \r
+    } else if (byte === 0x0a) {
+      out.push(0x5c, 0x6e); // \n
+    } else {
+      out.push(byte);
+    }
+  }
+  out.push(0x29);
+  return Uint8Array.from(out);
+};
+
+const toHex = (bytes) => Array.from(bytes, (byte) => byte.toString(16).padStart(2, '0')).join('');
+
+// Regular printable characters stay, everything else becomes #xx
+const NAME_ESCAPE = /[^!-~]|[#%()/<>[\]{}]/g;
+const escapeNameChar = (char) => `#${char.charCodeAt(0).toString(16).padStart(2, '0')}`;
+const serializeName = (name) => `/${name.replace(NAME_ESCAPE, escapeNameChar)}`;
+
+/**
+ * Serialize a direct value (used for trailer entries)
+ */
+export const serializeValue = (value) => {
+  if (value instanceof PdfRef) return `${value.num} ${value.gen} R`;
+  if (value instanceof PdfName) return serializeName(value.name);
+  if (value instanceof PdfString) return `<${toHex(value.bytes)}>`;
+  if (value instanceof PdfDict) {
+    const entries = [...value.entries].map(
+      ([key, item]) => `${serializeName(key)} ${serializeValue(item)}`,
+    );
+    return `<< ${entries.join(' ')} >>`;
+  }
+  if (Array.isArray(value)) return `[${value.map(serializeValue).join(' ')}]`;
+  if (value === null) return 'null';
+  return String(value);
+};
@@ -0,0 +1,81 @@
+/**
+ * Unit tests for the strip engine's output writer
+ * Tests chunk coalescing, chunk ownership, sink backpressure and value serialization
+ */
+
+import { createChunkWriter, encodeLatin1, serializeString, serializeValue } from './writer';
+import { PdfDict, PdfName, PdfRef, PdfString } from './objects';
+
+const text = (bytes) => String.fromCharCode(...new Uint8Array(bytes));
+
+describe('writer', () => {
+  describe('createChunkWriter', () => {
+    it('should collect writes and track the position', () => {
+      const writer = createChunkWriter({ chunkSize: 8 });
+      writer.writeText('%PDF-');
+      expect(writer.position).toBe(5);
+      writer.writeText('1.7\n');
+      writer.write(encodeLatin1('0123456789abcdef'));
+
+      expect(writer.position).toBe(25);
+      expect(text(writer.toArrayBuffer())).toBe('%PDF-1.7\n0123456789abcdef');
+    });
+
+    it('should emit chunks that own their whole buffer', () => {
+      const chunks = [];
+      const writer = createChunkWriter({ chunkSize: 8, onChunk: (chunk) => chunks.push(chunk) });
+      const large = encodeLatin1('xxABCDEFGHIJxx').subarray(2, 12);
+      writer.writeText('abc');
+      writer.writeText('defgh');
+      writer.writeText('ij');
+      writer.write(large);
+      writer.writeText('k');
+      writer.flush();
+
+      expect(chunks.map(text)).toEqual(['abcdefgh', 'ij', 'ABCDEFGHIJ', 'k']);
+      for (const chunk of chunks) {
+        expect(chunk.byteOffset).toBe(0);
+        expect(chunk.byteLength).toBe(chunk.buffer.byteLength);
+      }
+    });
+
+    it('should drain once the promise the sink returned for the last chunk settles', async () => {
+      let release;
+      const writer = createChunkWriter({
+        chunkSize: 4,
+        onChunk: () => new Promise((resolve) => (release = resolve)),
+      });
+      await writer.drain();
+
+      writer.writeText('abcd');
+      let drained = false;
+      const draining = writer.drain().then(() => (drained = true));
+      await Promise.resolve();
+      expect(drained).toBe(false);
+
+      release();
+      await draining;
+      expect(drained).toBe(true);
+    });
+  });
+
+  describe('serializeString', () => {
+    it('should escape delimiters and end-of-line bytes', () => {
+      expect(text(serializeString(encodeLatin1('a(b)\\c\r\nd')))).toBe('(a\\(b\\)\\\\c\\r\\nd)');
+    });
+  });
+
+  describe('serializeValue', () => {
+    it('should serialize trailer values', () => {
+      const dict = new PdfDict();
+      dict.set('Type', new PdfName('Catalog'), 0, 0);
+      dict.set('Pages', new PdfRef(3, 0), 0, 0);
+
+      expect(serializeValue(dict)).toBe('<< /Type /Catalog /Pages 3 0 R >>');
+      expect(serializeValue([new PdfString(Uint8Array.from([0, 171]), 0, 0), 1, null])).toBe(
+        '[<00ab> 1 null]',
+      );
+      expect(serializeValue(new PdfName('A B#'))).toBe('/A#20B#23');
+    });
+  });
+});
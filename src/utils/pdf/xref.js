@@ -0,0 +1,219 @@
+/**
+ * Cross-reference reader
+ *
+ * Follows the startxref / Prev chain through classic tables, cross-reference
+ * streams and hybrid files, and merges the sections newest first. Only the
+ * tail of the file and the sections themselves are read.
+ */
+
+import { PdfDict, isName } from './objects';
+import { decodeStream } from './filters';
+import { parseAt, readIndirectObject } from './objectReader';
+
+const TAIL_LENGTH = 1024;
+
+const STARTXREF = [0x73, 0x74, 0x61, 0x72, 0x74, 0x78, 0x72, 0x65, 0x66]; // "startxref"
+const EOF_MARKER = [0x25, 0x25, 0x45, 0x4f, 0x46]; // "%%EOF"
+const SCAN_WINDOW = 64 * 1024;
+
+const lastIndexOf = (bytes, pattern) => {
+  for (let i = bytes.length - pattern.length; i >= 0; i--) {
+    let match = true;
+    for (let j = 0; j < pattern.length && match; j++) match = bytes[i + j] === pattern[j];
+    if (match) return i;
+  }
+  return -1;
+};
+
+const indexOf = (bytes, pattern) => {
+  for (let i = 0; i + pattern.length <= bytes.length; i++) {
+    let match = true;
+    for (let j = 0; j < pattern.length && match; j++) match = bytes[i + j] === pattern[j];
+    if (match) return i;
+  }
+  return -1;
+};
+
+/**
+ * Offset recorded after the last `startxref`
+ */
+export const findStartXref = async (reader) => {
+  const tailStart = Math.max(0, reader.size - TAIL_LENGTH);
+  const tail = await reader.read(tailStart, TAIL_LENGTH);
+  const index = lastIndexOf(tail, STARTXREF);
+  if (index < 0) throw new Error('startxref not found');
+
+  return parseAt(reader, tailStart + index + STARTXREF.length, (parser) => parser.readInteger());
+};
+
+// Classic `xref` table followed by its trailer dictionary
+const readTable = (reader, offset) =>
+  parseAt(reader, offset, (parser) => {
+    parser.expectKeyword('xref');
+    const entries = [];
+    while (!parser.matchKeyword('trailer')) {
+      const first = parser.readInteger();
+      const count = parser.readInteger();
+      for (let i = 0; i < count; i++) {
+        const entryOffset = parser.readInteger();
+        const gen = parser.readInteger();
+        parser.skipWhitespace();
+        const type = parser.readRegular();
+        if (type === 'n') {
+          entries.push([first + i, { type: 1, offset: entryOffset, gen }]);
+        } else if (type === 'f') {
+          entries.push([first + i, { type: 0, gen }]);
+        } else {
+          throw new SyntaxError(`Malformed xref entry at ${parser.offset}`);
+        }
+      }
+    }
+    const trailer = parser.parseValue();
+    if (!(trailer instanceof PdfDict)) throw new SyntaxError('Malformed trailer');
+    return { entries, trailer };
+  });
+
+const readField = (data, offset, width) => {
+  let value = 0;
+  for (let i = 0; i < width; i++) value = value * 256 + data[offset + i];
+  return value;
+};
+
+// Cross-reference stream (never encrypted)
+const readXrefStream = async (reader, offset) => {
+  const object = await readIndirectObject(reader, offset);
+  const dict = object.value;
+  if (object.dataStart === undefined || !isName(dict.get('Type'), 'XRef')) {
+    throw new Error(`No cross-reference section at ${offset}`);
+  }
+
+  const raw = await reader.read(object.dataStart, object.dataEnd - object.dataStart);
+  const data = await decodeStream(dict, raw);
+  const widths = dict.get('W');
+  if (!Array.isArray(widths) || widths.length < 3) throw new Error('Malformed xref stream /W');
+  const [typeWidth, secondWidth, thirdWidth] = widths;
+  const rowWidth = typeWidth + secondWidth + thirdWidth;
+  const index = dict.get('Index') || [0, dict.get('Size')];
+
+  const entries = [];
+  let row = 0;
+  for (let i = 0; i + 1 < index.length; i += 2) {
+    for (let num = index[i]; num < index[i] + index[i + 1]; num++, row += rowWidth) {
+      if (row + rowWidth > data.length) throw new Error('Truncated xref stream');
+      // Type defaults to 1 when its field is absent
+      const type = typeWidth ? readField(data, row, typeWidth) : 1;
+      const second = readField(data, row + typeWidth, secondWidth);
+      const third = readField(data, row + typeWidth + secondWidth, thirdWidth);
+      if (type === 0) entries.push([num, { type: 0, gen: third }]);
+      else if (type === 1) entries.push([num, { type: 1, offset: second, gen: third }]);
+      else if (type === 2) entries.push([num, { type: 2, stream: second, index: third }]);
+    }
+  }
+  return { entries, trailer: dict, objectNum: object.num };
+};
+
+const isTableAt = async (reader, offset) => {
+  const head = await reader.read(offset, 4);
+  return String.fromCharCode(...head) === 'xref';
+};
+
+/**
+ * Newest trailer dictionary, without following the Prev chain
+ * The section `startxref` points at is read on its own: a classic table with
+ * its trailer, or only the dictionary of a cross-reference stream. The trailer
+ * in the tail is not taken on trust, since in a linearized file it belongs to
+ * the main table while `startxref` points at the first-page one at the front
+ * @param {Object} reader - See createRangeReader
+ * @returns {Promise<PdfDict>}
+ */
+export const readTrailer = async (reader) => {
+  const offset = await findStartXref(reader);
+  if (await isTableAt(reader, offset)) return (await readTable(reader, offset)).trailer;
+
+  const dict = await parseAt(reader, offset, (parser) => {
+    parser.parseObjectHeader();
+    return parser.parseValue();
+  });
+  if (!(dict instanceof PdfDict) || !isName(dict.get('Type'), 'XRef')) {
+    throw new Error(`No cross-reference section at ${offset}`);
+  }
+  return dict;
+};
+
+/**
+ * End of the revision whose cross-reference section starts at `offset`: just
+ * past the first `%%EOF` after it and the end-of-line marker that follows
+ * @param {Object} reader - See createRangeReader
+ * @param {number} offset
+ * @returns {Promise<number|undefined>} Undefined when no `%%EOF` follows
+ */
+export const findRevisionEnd = async (reader, offset) => {
+  for (let start = offset; start < reader.size; start += SCAN_WINDOW - EOF_MARKER.length) {
+    const index = indexOf(await reader.read(start, SCAN_WINDOW), EOF_MARKER);
+    if (index < 0) continue;
+    let end = start + index + EOF_MARKER.length;
+    const [next, after] = await reader.read(end, 2);
+    if (next === 0x0d) end += after === 0x0a ? 2 : 1;
+    else if (next === 0x0a) end += 1;
+    return end;
+  }
+  return undefined;
+};
+
+/**
+ * Read and merge every cross-reference section
+ * @param {Object} reader - See createRangeReader
+ * @returns {Promise<{entries: Map<number, Object>, trailer: PdfDict, xrefStreams: Set<number>,
+ *   hasCompressed: boolean, sections: Array<Object>}>} `trailer` is the newest one;
+ *   `xrefStreams` lists the object numbers of cross-reference streams, which are dropped on
+ *   rewrite. `sections` holds `{offset, trailer, entries}` for each section, newest first,
+ *   with the entries it defines itself (a hybrid file's stream entries included)
+ */
+export const readXref = async (reader) => {
+  const entries = new Map();
+  const xrefStreams = new Set();
+  const visited = new Set();
+  const sections = [];
+  let trailer = null;
+  let offset = await findStartXref(reader);
+
+  const merge = (sectionEntries) => {
+    // Newer sections come first, so the first entry seen for an object wins
+    for (const [num, entry] of sectionEntries) {
+      if (!entries.has(num)) entries.set(num, entry);
+    }
+  };
+
+  while (offset !== undefined) {
+    if (visited.has(offset)) throw new Error('Cross-reference chain loops');
+    visited.add(offset);
+
+    let section;
+    const sectionEntries = [];
+    if (await isTableAt(reader, offset)) {
+      section = await readTable(reader, offset);
+      // Hybrid file: the stream holds the compressed objects the table leaves out
+      const xrefStm = section.trailer.get('XRefStm');
+      if (Number.isInteger(xrefStm)) {
+        const stream = await readXrefStream(reader, xrefStm);
+        xrefStreams.add(stream.objectNum);
+        merge(stream.entries);
+        // Pushed one by one: spreading a large section would exceed the argument limit
+        for (const entry of stream.entries) sectionEntries.push(entry);
+      }
+    } else {
+      section = await readXrefStream(reader, offset);
+      xrefStreams.add(section.objectNum);
+    }
+
+    merge(section.entries);
+    for (const entry of section.entries) sectionEntries.push(entry);
+    sections.push({ offset, trailer: section.trailer, entries: sectionEntries });
+    trailer = trailer || section.trailer;
+    const prev = section.trailer.get('Prev');
+    offset = Number.isInteger(prev) ? prev : undefined;
+  }
+
+  const hasCompressed = [...entries.values()].some((entry) => entry.type === 2);
+  return { entries, trailer, xrefStreams, hasCompressed, sections };
+};
@@ -0,0 +1,155 @@
+/**
+ * Unit tests for cross-reference reading
+ * Tests classic tables, update chains, revision bounds and cross-reference streams
+ */
+
+import { findRevisionEnd, findStartXref, readTrailer, readXref } from './xref';
+import { createRangeReader } from './rangeReader';
+import { PdfRef } from './objects';
+import {
+  appendFreeEntries,
+  buildLinearizedPdf,
+  fixture,
+  PLAIN,
+  PROTECTED,
+  xrefRow,
+} from './testPdf';
+
+const ascii = (text) => Uint8Array.from(text, (char) => char.charCodeAt(0));
+
+// Minimal file with an original section and one incremental update
+const buildUpdatedFile = () => {
+  const parts = ['%PDF-1.4\n'];
+  const offsets = [];
+  const add = (text) => {
+    offsets.push(parts.join('').length);
+    parts.push(text);
+  };
+
+  add('1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n');
+  add('2 0 obj\n<< /Type /Pages /Kids [] /Count 0 >>\nendobj\n');
+  const firstXref = parts.join('').length;
+  parts.push(`xref\n0 3\n0000000000 65535 f\r\n${xrefRow(offsets[0])}${xrefRow(offsets[1])}`);
+  parts.push(`trailer\n<< /Size 3 /Root 1 0 R >>\nstartxref\n${firstXref}\n%%EOF\n`);
+
+  add('2 0 obj\n<< /Type /Pages /Kids [] /Count 0 /Updated true >>\nendobj\n');
+  const secondXref = parts.join('').length;
+  parts.push(`xref\n2 1\n${xrefRow(offsets[2])}`);
+  parts.push(`trailer\n<< /Size 3 /Root 1 0 R /Prev ${firstXref} >>\n`);
+  parts.push(`startxref\n${secondXref}\n%%EOF\n`);
+  return { bytes: ascii(parts.join('')), offsets, firstXref, secondXref };
+};
+
+describe('xref', () => {
+  describe('findStartXref', () => {
+    it('should find the last startxref offset', async () => {
+      const { bytes, secondXref } = buildUpdatedFile();
+
+      expect(await findStartXref(createRangeReader(bytes.buffer))).toBe(secondXref);
+    });
+
+    it('should reject files without startxref', async () => {
+      const reader = createRangeReader(ascii('%PDF-1.4\n%%EOF\n').buffer);
+
+      await expect(findStartXref(reader)).rejects.toThrow('startxref');
+    });
+  });
+
+  describe('readTrailer', () => {
+    it('should read the newest classic trailer from the tail', async () => {
+      const { bytes } = buildUpdatedFile();
+      const trailer = await readTrailer(createRangeReader(bytes.buffer));
+
+      expect(trailer.get('Prev')).toBeGreaterThan(0);
+      expect(trailer.get('Root')).toBeInstanceOf(PdfRef);
+    });
+
+    it('should read a cross-reference stream dictionary without its entries', async () => {
+      const reader = createRangeReader(fixture(PROTECTED));
+      const trailer = await readTrailer(reader);
+
+      expect(trailer.getName('Type')).toBe('XRef');
+      expect(trailer.get('Encrypt')).toBeInstanceOf(PdfRef);
+    });
+
+    it('should read the first-page trailer of a linearized file', async () => {
+      const file = buildLinearizedPdf(
+        ['<< /Type /Catalog /Pages 2 0 R >>', '<< /Type /Pages /Kids [] /Count 0 >>', '<< >>'],
+        { trailer: '/Root 1 0 R /Encrypt 3 0 R' },
+      );
+      const trailer = await readTrailer(createRangeReader(file));
+
+      // The main table's trailer in the tail has neither
+      expect(trailer.get('Encrypt')).toBeInstanceOf(PdfRef);
+      expect(trailer.get('Prev')).toBeGreaterThan(0);
+    });
+
+    it('should find a trailer that does not fit in the tail', async () => {
+      const { bytes } = buildUpdatedFile();
+      const padding = ` /Pad (${'x'.repeat(2000)})`;
+      const text = String.fromCharCode(...bytes).replace('/Prev', `${padding} /Prev`);
+      const trailer = await readTrailer(createRangeReader(ascii(text).buffer));
+
+      expect(trailer.has('Pad')).toBe(true);
+    });
+  });
+
+  describe('findRevisionEnd', () => {
+    it('should end a revision after its %%EOF line', async () => {
+      const { bytes, firstXref, offsets } = buildUpdatedFile();
+      const reader = createRangeReader(bytes.buffer);
+
+      // The update's first object starts where the original revision ends
+      expect(await findRevisionEnd(reader, firstXref)).toBe(offsets[2]);
+      expect(await findRevisionEnd(reader, bytes.length - 3)).toBeUndefined();
+    });
+  });
+
+  describe('readXref', () => {
+    it('should merge an update chain with newer entries winning', async () => {
+      const { bytes, offsets } = buildUpdatedFile();
+      const xref = await readXref(createRangeReader(bytes.buffer));
+
+      expect(xref.entries.get(1)).toEqual({ type: 1, offset: offsets[0], gen: 0 });
+      expect(xref.entries.get(2)).toEqual({ type: 1, offset: offsets[2], gen: 0 });
+      expect(xref.trailer.has('Prev')).toBe(true);
+      expect(xref.hasCompressed).toBe(false);
+    });
+
+    it('should list the sections newest first with the entries each defines', async () => {
+      const { bytes, firstXref, secondXref } = buildUpdatedFile();
+      const { sections } = await readXref(createRangeReader(bytes.buffer));
+
+      expect(sections.map((section) => section.offset)).toEqual([secondXref, firstXref]);
+      expect(sections[0].entries.map(([num]) => num)).toEqual([2]);
+      expect(sections[1].entries.map(([num]) => num)).toEqual([0, 1, 2]);
+      expect(sections[0].trailer.get('Prev')).toBe(firstXref);
+    });
+
+    it('should read a classic table with its trailer', async () => {
+      const xref = await readXref(createRangeReader(fixture(PLAIN)));
+
+      expect(xref.trailer.get('Root')).toBeInstanceOf(PdfRef);
+      expect(xref.trailer.has('Encrypt')).toBe(false);
+      expect(xref.xrefStreams.size).toBe(0);
+    });
+
+    it('should read cross-reference streams with compressed objects', async () => {
+      const xref = await readXref(createRangeReader(fixture(PROTECTED)));
+      const compressed = [...xref.entries.values()].filter((entry) => entry.type === 2);
+
+      expect(xref.trailer.get('Encrypt')).toBeInstanceOf(PdfRef);
+      expect(xref.xrefStreams.size).toBeGreaterThan(0);
+      expect(xref.hasCompressed).toBe(true);
+      expect(compressed.length).toBeGreaterThan(0);
+    });
+
+    it('should read a section with more entries than a call takes arguments', async () => {
+      const source = await appendFreeEntries(fixture(PROTECTED), 250000);
+      const { entries, sections } = await readXref(createRangeReader(source));
+
+      expect(sections[0].entries).toHaveLength(250001);
+      expect(entries.get(sections[0].entries[0][0])).toEqual({ type: 0, gen: 0 });
+    });
+  });
+});
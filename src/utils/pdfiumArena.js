@@ -0,0 +1,146 @@
+/**
+ * Per-instance wasm heap arena
+ *
+ * Jobs on one module instance share an input buffer and a single registered
+ * FPDF_FILEWRITE struct instead of allocating both per call. The input buffer
+ * only grows, in whole steps, so a run of similarly sized files stops churning
+ * the allocator and the heap stops fragmenting between jobs.
+ *
+ * wasm memory never shrinks. Once the heap is much larger than the biggest
+ * input it has served, the arena reports the instance as due for recycling,
+ * and the engine replaces its worker.
+ */
+
+import { getPointerSize, setPointer } from './pdfiumMemory64';
+
+// struct FPDF_FILEWRITE { int version; int (*WriteBlock)(...); }: the function
+// pointer is pointer-aligned, so both fields take a pointer's size
+const FILEWRITE_VERSION = 1;
+const FILEWRITE_CALLBACK_SUCCESS = 1;
+const FILEWRITE_CALLBACK_FAILURE = 0;
+
+// Input capacity is rounded up to this, so small size differences reuse the buffer
+const INPUT_CAPACITY_STEP = 1024 * 1024;
+
+// Recycle once the heap passes both of these
+export const RECYCLE_MIN_HEAP_BYTES = 512 * 1024 * 1024;
+export const RECYCLE_HEAP_RATIO = 8;
+
+const arenas = new WeakMap();
+
+const createArena = (pdfium) => {
+  const wasmExports = pdfium.pdfium.wasmExports;
+  const pointerSize = getPointerSize(pdfium);
+
+  let inputPtr = 0;
+  let inputCapacity = 0;
+  let inputBusy = false;
+  let largestInput = 0;
+
+  let fileWritePtr = 0;
+  let onWrite = null;
+
+  /**
+   * Borrow heap space for `size` input bytes
+   * A nested borrow (the shared buffer is still in use) gets a buffer of its own
+   * @returns {{ptr: number, reused: boolean, release: () => void}}
+   */
+  const acquireInput = (size) => {
+    largestInput = Math.max(largestInput, size);
+
+    if (inputBusy) {
+      const ptr = wasmExports.malloc(size);
+      if (!ptr) throw new Error(`Out of wasm memory for a ${size} byte input`);
+      return { ptr, reused: false, release: () => wasmExports.free(ptr) };
+    }
+
+    const reused = inputPtr !== 0 && size <= inputCapacity;
+    if (!reused) {
+      // Free first so the allocator can merge the old block into the new one
+      if (inputPtr) wasmExports.free(inputPtr);
+      inputCapacity = Math.ceil(Math.max(size, 1) / INPUT_CAPACITY_STEP) * INPUT_CAPACITY_STEP;
+      inputPtr = wasmExports.malloc(inputCapacity);
+      if (!inputPtr) {
+        inputCapacity = 0;
+        throw new Error(`Out of wasm memory for a ${size} byte input`);
+      }
+    }
+
+    inputBusy = true;
+    return {
+      ptr: inputPtr,
+      reused,
+      release: () => {
+        inputBusy = false;
+      },
+    };
+  };
+
+  const writeBlock = (pThis, dataPtr, size) => {
+    if (!onWrite) return FILEWRITE_CALLBACK_FAILURE;
+    try {
+      // Re-read memory.buffer on every call: the heap may have grown during the save
+      onWrite(new Uint8Array(wasmExports.memory.buffer, dataPtr, size));
+      return FILEWRITE_CALLBACK_SUCCESS;
+    } catch (err) {
+      console.error('[PDFium] WriteBlock error:', err);
+      return FILEWRITE_CALLBACK_FAILURE;
+    }
+  };
+
+  /**
+   * Point the shared FPDF_FILEWRITE at `handler` for one save
+   * The struct and its callback are registered on first use and kept for the
+   * lifetime of the instance. FPDF_SaveAsCopy is synchronous, so saves never overlap
+   * @param {(data: Uint8Array) => void} handler - Receives a heap view of each block;
+   *   copy it before returning
+   * @returns {{ptr: number, release: () => void}}
+   */
+  const acquireWriter = (handler) => {
+    if (!fileWritePtr) {
+      const callback = pdfium.pdfium.addFunction(writeBlock, 'iiii');
+      fileWritePtr = wasmExports.malloc(2 * pointerSize);
+      const view = new DataView(wasmExports.memory.buffer);
+      view.setInt32(fileWritePtr, FILEWRITE_VERSION, true);
+      setPointer(view, fileWritePtr + pointerSize, callback, pointerSize);
+    }
+    onWrite = handler;
+    return {
+      ptr: fileWritePtr,
+      release: () => {
+        onWrite = null;
+      },
+    };
+  };
+
+  /**
+   * Whether the heap has outgrown what the inputs seen so far need
+   */
+  const isRecycleDue = () => {
+    const heapBytes = wasmExports.memory.buffer.byteLength;
+    return (
+      heapBytes > RECYCLE_MIN_HEAP_BYTES && heapBytes > RECYCLE_HEAP_RATIO * largestInput
+    );
+  };
+
+  /**
+   * Input bytes the next borrow can take without allocating: the shared buffer's
+   * capacity while it is idle, 0 while a job holds it
+   */
+  const getReusableInputCapacity = () => (inputBusy ? 0 : inputCapacity);
+
+  return { acquireInput, acquireWriter, isRecycleDue, getReusableInputCapacity };
+};
+
+/**
+ * Arena of an initialized PDFium module (created on first use)
+ * @param {Object} pdfium - Initialized PDFium module
+ */
+export const getPdfiumArena = (pdfium) => {
+  let arena = arenas.get(pdfium);
+  if (!arena) {
+    arena = createArena(pdfium);
+    arenas.set(pdfium, arena);
+  }
+  return arena;
+};
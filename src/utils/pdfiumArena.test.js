@@ -0,0 +1,169 @@
+/**
+ * Unit tests for the per-instance wasm heap arena
+ * Tests input buffer reuse, the shared FPDF_FILEWRITE and the recycle threshold
+ */
+
+import { init } from '@embedpdf/pdfium';
+import { getPdfiumArena, RECYCLE_HEAP_RATIO, RECYCLE_MIN_HEAP_BYTES } from './pdfiumArena';
+
+// The @embedpdf/pdfium module is mocked in setupTests.js
+
+describe('getPdfiumArena', () => {
+  const MB = 1024 * 1024;
+  let pdfium;
+  let wasmExports;
+
+  beforeEach(async () => {
+    pdfium = await init({ wasmBinary: new ArrayBuffer(8) });
+    wasmExports = pdfium.pdfium.wasmExports;
+    let next = 4096;
+    wasmExports.malloc.mockImplementation(() => (next += 4096));
+  });
+
+  it('should return one arena per module instance', async () => {
+    const other = await init({ wasmBinary: new ArrayBuffer(8) });
+
+    expect(getPdfiumArena(pdfium)).toBe(getPdfiumArena(pdfium));
+    expect(getPdfiumArena(other)).not.toBe(getPdfiumArena(pdfium));
+  });
+
+  describe('acquireInput', () => {
+    it('should reuse the input buffer for inputs that fit', () => {
+      const arena = getPdfiumArena(pdfium);
+
+      const first = arena.acquireInput(100);
+      first.release();
+      const second = arena.acquireInput(MB);
+      second.release();
+
+      expect(second.ptr).toBe(first.ptr);
+      expect(second.reused).toBe(true);
+      expect(wasmExports.malloc).toHaveBeenCalledTimes(1);
+      expect(wasmExports.malloc).toHaveBeenCalledWith(MB);
+      expect(wasmExports.free).not.toHaveBeenCalled();
+    });
+
+    it('should replace the buffer when an input outgrows it', () => {
+      const arena = getPdfiumArena(pdfium);
+
+      const small = arena.acquireInput(100);
+      small.release();
+      const large = arena.acquireInput(MB + 1);
+
+      expect(large.reused).toBe(false);
+      expect(wasmExports.free).toHaveBeenCalledWith(small.ptr);
+      expect(wasmExports.malloc).toHaveBeenLastCalledWith(2 * MB);
+    });
+
+    it('should give a nested borrow a buffer of its own', () => {
+      const arena = getPdfiumArena(pdfium);
+
+      const outer = arena.acquireInput(100);
+      const inner = arena.acquireInput(100);
+      inner.release();
+
+      expect(inner.ptr).not.toBe(outer.ptr);
+      expect(wasmExports.free).toHaveBeenCalledWith(inner.ptr);
+    });
+
+    it('should report the idle buffer as reusable capacity', () => {
+      const arena = getPdfiumArena(pdfium);
+      expect(arena.getReusableInputCapacity()).toBe(0);
+
+      const input = arena.acquireInput(100);
+      expect(arena.getReusableInputCapacity()).toBe(0);
+      input.release();
+
+      expect(arena.getReusableInputCapacity()).toBe(MB);
+    });
+
+    it('should throw when malloc fails', () => {
+      wasmExports.malloc.mockReturnValue(0);
+
+      expect(() => getPdfiumArena(pdfium).acquireInput(100)).toThrow('Out of wasm memory');
+    });
+  });
+
+  describe('acquireWriter', () => {
+    it('should register the write callback and struct once', () => {
+      const arena = getPdfiumArena(pdfium);
+
+      const first = arena.acquireWriter(jest.fn());
+      first.release();
+      const second = arena.acquireWriter(jest.fn());
+
+      const view = new DataView(wasmExports.memory.buffer);
+      expect(second.ptr).toBe(first.ptr);
+      expect(view.getInt32(first.ptr, true)).toBe(1); // FPDF_FILEWRITE version
+      expect(view.getInt32(first.ptr + 4, true)).toBe(1); // function id from addFunction
+      expect(pdfium.pdfium.addFunction).toHaveBeenCalledTimes(1);
+      expect(pdfium.pdfium.addFunction).toHaveBeenCalledWith(expect.any(Function), 'iiii');
+    });
+
+    it('should lay out an 8-byte function pointer for the memory64 build', () => {
+      pdfium.pointerSize = 8;
+
+      const writer = getPdfiumArena(pdfium).acquireWriter(jest.fn());
+
+      const view = new DataView(wasmExports.memory.buffer);
+      expect(wasmExports.malloc).toHaveBeenCalledWith(16);
+      expect(view.getInt32(writer.ptr, true)).toBe(1);
+      expect(view.getBigUint64(writer.ptr + 8, true)).toBe(1n);
+    });
+
+    it('should hand blocks to the current handler only', () => {
+      const arena = getPdfiumArena(pdfium);
+      const handler = jest.fn();
+      new Uint8Array(wasmExports.memory.buffer, 65536, 3).set([1, 2, 3]);
+
+      const writer = arena.acquireWriter(handler);
+      const writeBlock = pdfium.pdfium.addFunction.mock.calls[0][0];
+
+      expect(writeBlock(writer.ptr, 65536, 3)).toBe(1);
+      expect(handler).toHaveBeenCalledWith(new Uint8Array([1, 2, 3]));
+
+      writer.release();
+      expect(writeBlock(writer.ptr, 65536, 3)).toBe(0);
+      expect(handler).toHaveBeenCalledTimes(1);
+    });
+
+    it('should fail the block when the handler throws', () => {
+      const writer = getPdfiumArena(pdfium).acquireWriter(() => {
+        throw new Error('sink closed');
+      });
+      const writeBlock = pdfium.pdfium.addFunction.mock.calls[0][0];
+
+      expect(writeBlock(writer.ptr, 65536, 3)).toBe(0);
+    });
+  });
+
+  describe('isRecycleDue', () => {
+    const setHeapSize = (byteLength) => {
+      wasmExports.memory = { buffer: { byteLength } };
+    };
+
+    it('should not recycle a heap below the minimum', () => {
+      const arena = getPdfiumArena(pdfium);
+      setHeapSize(RECYCLE_MIN_HEAP_BYTES);
+
+      expect(arena.isRecycleDue()).toBe(false);
+    });
+
+    it('should recycle a heap that outgrew the largest input', () => {
+      const arena = getPdfiumArena(pdfium);
+      arena.acquireInput(MB).release();
+      setHeapSize(RECYCLE_MIN_HEAP_BYTES + MB);
+
+      expect(arena.isRecycleDue()).toBe(true);
+    });
+
+    it('should keep a heap that large inputs still need', () => {
+      const arena = getPdfiumArena(pdfium);
+      const heapSize = RECYCLE_MIN_HEAP_BYTES + MB;
+      arena.acquireInput(Math.ceil(heapSize / RECYCLE_HEAP_RATIO)).release();
+      setHeapSize(heapSize);
+
+      expect(arena.isRecycleDue()).toBe(false);
+    });
+  });
+});
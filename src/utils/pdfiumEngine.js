@@ -0,0 +1,386 @@
+/**
+ * Main-thread client for the PDFium worker engine
+ *
+ * Wraps the worker message protocol in promises. Input buffers are transferred
+ * to the worker (the caller's ArrayBuffer is detached afterwards) and output
+ * buffers are transferred back, so no document bytes are copied on this thread.
+ *
+ * A worker whose PDFium heap has outgrown its workload flags its replies with
+ * `recycle`. New requests then go to a fresh worker, and the old one is
+ * terminated once its last job has settled, so long sessions keep a flat
+ * memory profile (wasm memory never shrinks within a worker). A retired worker
+ * that still holds open documents stays up until they are closed.
+ *
+ * A job cannot be interrupted inside its worker (FPDF_SaveAsCopy is synchronous),
+ * so aborting one terminates that worker: its heap is released at once and the
+ * next request gets a fresh worker.
+ *
+ * A remove the worker turns away because its heap is too full (see
+ * pdfiumPlanner.js planHeap) is sent once more to a fresh worker.
+ */
+
+import { createPdfiumWorker } from './createPdfiumWorker';
+import { MEMORY_ERROR_NAME } from './pdfiumPlanner';
+
+/**
+ * Error an aborted signal rejects with: its reason, or a DOMException named 'AbortError'
+ * @param {AbortSignal} signal
+ */
+export const abortReason = (signal) =>
+  signal.reason ?? new DOMException('The operation was aborted', 'AbortError');
+
+// Streamed output the worker may post ahead of the sink before it waits for acks
+const STREAM_WINDOW_BYTES = 16 * 1024 * 1024;
+
+// Output rewrites a job asks for (see removeSecurity); left out of the payload when off
+const outputOptions = ({ linearize, compact }) => ({
+  ...(linearize && { linearize: true }),
+  ...(compact && { compact: true }),
+});
+
+/**
+ * Create an engine backed by its own worker (spawned lazily on first request)
+ * @param {Object} [options]
+ * @param {() => Worker} [options.createWorker] - Worker factory
+ * @param {(metrics: Object) => void} [options.onMetrics] - Receives every job report
+ */
+export const createPdfiumEngine = ({ createWorker = createPdfiumWorker, onMetrics } = {}) => {
+  // Worker new requests are posted to; retired workers only finish their jobs
+  let worker = null;
+  let nextId = 1;
+  const pending = new Map();
+  // Open document id -> worker holding it
+  const documents = new Map();
+  const metricsListeners = new Set(onMetrics ? [onMetrics] : []);
+
+  // Worker-side report plus the round trip as seen from this thread
+  const emitMetrics = (metrics, job) => {
+    if (!metrics) return;
+    const report = { ...metrics, roundTripMs: performance.now() - job.start };
+    metricsListeners.forEach((listener) => listener(report));
+  };
+
+  const rejectJobs = (err, target) => {
+    pending.forEach((job, id) => {
+      if (target && job.worker !== target) return;
+      pending.delete(id);
+      job.reject(err);
+    });
+  };
+
+  const hasJobs = (target) =>
+    [...pending.values()].some((job) => job.worker === target) ||
+    [...documents.values()].includes(target);
+
+  // Stop sending work to `target`; terminate it once it has nothing in flight
+  const retire = (target) => {
+    if (worker === target) {
+      console.log('[Engine] Recycling worker');
+      worker = null;
+    }
+    if (!hasJobs(target)) target.terminate();
+  };
+
+  const handleMessage = ({ data }) => {
+    const job = pending.get(data.id);
+    if (!job) return;
+
+    if (data.type === 'chunk') {
+      const ack = (bytes) =>
+        job.worker.postMessage({ id: data.id, type: 'ack', payload: { bytes } });
+      job.onChunk(data.chunk, ack);
+      return;
+    }
+    if (data.type === 'progress') {
+      if (job.onProgress) job.onProgress(data.progress);
+      return;
+    }
+
+    pending.delete(data.id);
+    const recycle = data.type === 'error' ? data.recycle : data.result && data.result.recycle;
+    if (recycle || job.worker !== worker) retire(job.worker);
+    emitMetrics(data.type === 'error' ? data.metrics : data.result && data.result.metrics, job);
+    if (data.type === 'error') {
+      const err = new Error(data.error.message);
+      err.name = data.error.name;
+      if (data.input) err.input = data.input;
+      job.reject(err);
+    } else {
+      job.resolve(data.result);
+    }
+  };
+
+  // Terminate `target` along with the documents it holds, failing its jobs with `err`
+  const stopWorker = (target, err) => {
+    target.terminate();
+    if (worker === target) worker = null;
+    documents.forEach((holder, id) => holder === target && documents.delete(id));
+    rejectJobs(err, target);
+  };
+
+  const handleError = (target, event) => {
+    console.error('[Engine] Worker crashed:', event.message);
+    stopWorker(target, new Error(`PDFium worker failed: ${event.message || 'unknown error'}`));
+  };
+
+  const cancel = (id, reason) => {
+    const job = pending.get(id);
+    if (!job) return;
+    console.log('[Engine] Job cancelled, stopping its worker');
+    pending.delete(id);
+    job.reject(reason);
+    stopWorker(job.worker, new Error('PDFium worker stopped: a job on it was cancelled'));
+  };
+
+  const getWorker = () => {
+    if (!worker) {
+      const spawned = createWorker();
+      spawned.onmessage = handleMessage;
+      spawned.onerror = (event) => handleError(spawned, event);
+      worker = spawned;
+    }
+    return worker;
+  };
+
+  const request = (type, payload = {}, transfer = [], options = {}) =>
+    new Promise((resolve, reject) => {
+      const { onChunk, onProgress, signal } = options;
+      if (signal && signal.aborted) {
+        reject(abortReason(signal));
+        return;
+      }
+      const target = options.target || getWorker();
+      const id = nextId++;
+      const onAbort = () => cancel(id, abortReason(signal));
+      const settle = (callback) => (value) => {
+        if (signal) signal.removeEventListener('abort', onAbort);
+        callback(value);
+      };
+      pending.set(id, {
+        resolve: settle(resolve),
+        reject: settle(reject),
+        onChunk,
+        onProgress,
+        start: performance.now(),
+        worker: target,
+      });
+      if (signal) signal.addEventListener('abort', onAbort, { once: true });
+      target.postMessage({ id, type, payload }, transfer);
+    });
+
+  /**
+   * Load pdfium.wasm inside the worker
+   * @returns {Promise<{ready: boolean, metrics: Object}>} Readiness plus time-to-ready metrics
+   */
+  const init = () => request('init');
+
+  // Remove request for raw input or an open document (routed to the worker holding it)
+  const postRemove = (pdfData, payloadOptions, callbacks = {}) => {
+    const options = { ...payloadOptions, ...(callbacks.onProgress && { progress: true }) };
+    if (pdfData && pdfData.documentId !== undefined) {
+      const target = documents.get(pdfData.documentId);
+      if (!target) return Promise.reject(new Error('PDF document is no longer open'));
+      const payload = { document: pdfData.workerDocument, ...options };
+      return request('remove', payload, [], { ...callbacks, target });
+    }
+    const transfer = pdfData instanceof ArrayBuffer ? [pdfData] : [];
+    return request('remove', { pdfData, ...options }, transfer, callbacks);
+  };
+
+  // A worker whose heap is too full for the job turns it away before copying it and
+  // asks to be recycled; the job then runs once more, on a fresh worker
+  const requestRemove = async (pdfData, payloadOptions, callbacks) => {
+    try {
+      return await postRemove(pdfData, payloadOptions, callbacks);
+    } catch (err) {
+      const input = pdfData instanceof Blob ? pdfData : err.input;
+      if (err.name !== MEMORY_ERROR_NAME || !input) throw err;
+      console.warn('[Engine] Worker heap too full for the job, retrying on a fresh worker');
+      return postRemove(input, payloadOptions, callbacks);
+    }
+  };
+
+  /**
+   * Keep a PDF resident in the worker for repeated password attempts
+   * Bytes are copied into the worker's wasm heap once; removePassword and
+   * removePasswordToStream accept the returned handle in place of the bytes, and
+   * each attempt then only reloads the document from that copy
+   * @param {ArrayBuffer|File} pdfData - PDF bytes, transferred (detached) on call, or a File
+   * @returns {Promise<{documentId: number, size: number}>} Handle; close it with closeDocument
+   */
+  const openDocument = async (pdfData) => {
+    const size = pdfData.byteLength ?? pdfData.size;
+    const target = getWorker();
+    const transfer = pdfData instanceof ArrayBuffer ? [pdfData] : [];
+    const { document } = await request('open', { pdfData }, transfer, { target });
+    const documentId = nextId++;
+    documents.set(documentId, target);
+    return { documentId, workerDocument: document, size };
+  };
+
+  /**
+   * Release a handle from openDocument and the worker memory behind it
+   * @param {{documentId: number}} handle
+   */
+  const closeDocument = async (handle) => {
+    const target = documents.get(handle.documentId);
+    if (!target) return;
+    documents.delete(handle.documentId);
+    try {
+      await request('close', { document: handle.workerDocument }, [], { target });
+    } catch {
+      // The worker is gone, and the document with it
+    }
+  };
+
+  /**
+   * Remove password encryption in the worker
+   * @param {ArrayBuffer|File|Object} pdfData - PDF bytes, transferred (detached) on call, a
+   *   File the worker reads on demand (only a handle is cloned, never the contents), or a
+   *   handle from openDocument
+   * @param {string} password - PDF password
+   * @param {Object} [options]
+   * @param {AbortSignal} [options.signal] - Aborting rejects with the signal's reason and
+   *   terminates the worker running the job
+   * @param {(progress: Object) => void} [options.onProgress] - Receives `{engine, bytesWritten,
+   *   bytesTotal}` (plus `objectsDone` / `objectsTotal` from the strip engine) as the output is
+   *   written; `bytesTotal` is the input size, an estimate of the output's
+   * @param {boolean} [options.linearize] - Save for fast web view (see removeSecurity)
+   * @param {boolean} [options.compact] - Save compacted (see removeSecurity)
+   * @returns {Promise<Blob>} The decrypted PDF
+   */
+  const removePassword = async (pdfData, password, { signal, onProgress, ...output } = {}) => {
+    const payload = { password, ...outputOptions(output) };
+    const { buffer } = await requestRemove(pdfData, payload, { signal, onProgress });
+    return new Blob([buffer], { type: 'application/pdf' });
+  };
+
+  /**
+   * Remove password encryption and stream the output into a WritableStream
+   * Chunks are written as the worker produces them, each once `writable` is
+   * ready, and acked back so the worker holds further output until fewer than
+   * STREAM_WINDOW_BYTES are in flight. Only the strip engine and the rewrites
+   * can wait: PDFium produces its output inside one synchronous call, so a sink
+   * slower than it queues that output on this thread
+   * @param {ArrayBuffer|File|Object} pdfData - PDF bytes, transferred (detached) on call, a
+   *   File, or a handle from openDocument
+   * @param {string} password - PDF password
+   * @param {WritableStream} writable - Output sink (e.g. FileSystemWritableFileStream)
+   * @param {Object} [options] - `signal`, `onProgress`, `linearize` and `compact`, as for
+   *   removePassword; an abort also aborts `writable`
+   * @returns {Promise<{size: number}>} Number of bytes written
+   */
+  const removePasswordToStream = async (
+    pdfData,
+    password,
+    writable,
+    { linearize, compact, signal, ...callbacks } = {},
+  ) => {
+    const writer = writable.getWriter();
+    let writing = Promise.resolve();
+    // A failed write stops the job, which would otherwise wait for acks that never come
+    const stop = new AbortController();
+    const onAbort = () => stop.abort(abortReason(signal));
+    if (signal && signal.aborted) onAbort();
+    else if (signal) signal.addEventListener('abort', onAbort, { once: true });
+
+    try {
+      const { size } = await requestRemove(
+        pdfData,
+        {
+          password,
+          stream: true,
+          streamWindow: STREAM_WINDOW_BYTES,
+          ...outputOptions({ linearize, compact }),
+        },
+        {
+          ...callbacks,
+          signal: stop.signal,
+          onChunk: (chunk, ack) => {
+            writing = writing.then(async () => {
+              await writer.ready;
+              await writer.write(new Uint8Array(chunk));
+              ack(chunk.byteLength);
+            });
+            writing.catch((err) => stop.abort(err));
+          },
+        },
+      );
+      await writing;
+      await writer.close();
+      return { size };
+    } catch (err) {
+      writing.catch(() => {});
+      await writer.abort(err).catch(() => {});
+      throw err;
+    } finally {
+      if (signal) signal.removeEventListener('abort', onAbort);
+    }
+  };
+
+  /**
+   * Test candidate passwords in the worker with the key check alone
+   * @param {{encrypt: string, id: Uint8Array}} encryption - From readEncryption (pdf/encryption)
+   * @param {string[]} passwords - Candidates, tried in order
+   * @returns {Promise<number>} Index of the first candidate that verifies, or -1
+   */
+  const checkPasswords = async (encryption, passwords) => {
+    const { index } = await request('checkPasswords', { encryption, passwords });
+    return index;
+  };
+
+  /**
+   * Read triage metadata in the worker without loading a page (see pdf/probe.js)
+   * @param {ArrayBuffer|File} pdfData - PDF bytes (cloned, so the caller keeps them) or a
+   *   File, of which only the tail and a few objects are read
+   * @returns {Promise<{size: number, version: string|null, pageCount: number|null,
+   *   encrypted: boolean, encryption: Object|null}>} See probeDocument
+   */
+  const probe = (pdfData) => request('probe', { pdfData });
+
+  /**
+   * Subscribe to job reports: stage spans, wasm heap high-water mark, output chunk
+   * histogram and bytes in/out (see pdfiumMetrics.js), plus `roundTripMs`
+   * @param {(metrics: Object) => void} listener
+   * @returns {() => void} Unsubscribe
+   */
+  const addMetricsListener = (listener) => {
+    metricsListeners.add(listener);
+    return () => metricsListeners.delete(listener);
+  };
+
+  /**
+   * Stop every worker and fail any request still in flight
+   */
+  const terminate = () => {
+    const workers = new Set([...pending.values()].map((job) => job.worker));
+    documents.forEach((holder) => workers.add(holder));
+    if (worker) workers.add(worker);
+    worker = null;
+    documents.clear();
+    workers.forEach((target) => target.terminate());
+    rejectJobs(new Error('PDFium engine terminated'));
+  };
+
+  return {
+    init,
+    removePassword,
+    removePasswordToStream,
+    openDocument,
+    closeDocument,
+    checkPasswords,
+    probe,
+    addMetricsListener,
+    terminate,
+  };
+};
+
+let sharedEngine = null;
+
+/**
+ * Engine shared by the whole app (one worker, created on first use)
+ */
+export const getPdfiumEngine = () => {
+  if (!sharedEngine) sharedEngine = createPdfiumEngine();
+  return sharedEngine;
+};
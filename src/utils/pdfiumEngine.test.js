@@ -0,0 +1,448 @@
+/**
+ * Unit tests for the PDFium engine client
+ * Tests request/response matching, buffer transfer, worker failure handling and retries
+ * of jobs a full heap turned away
+ */
+
+import { createPdfiumEngine } from './pdfiumEngine';
+import { MEMORY_ERROR_NAME } from './pdfiumPlanner';
+
+describe('createPdfiumEngine', () => {
+  // Minimal fake worker that lets each test decide how to reply
+  const createFakeWorker = () => {
+    const worker = {
+      onmessage: null,
+      onerror: null,
+      postMessage: jest.fn(),
+      terminate: jest.fn(),
+      reply: (message) => worker.onmessage({ data: message }),
+    };
+    return worker;
+  };
+
+  it('should spawn the worker lazily on the first request', async () => {
+    const worker = createFakeWorker();
+    const createWorker = jest.fn(() => worker);
+    const engine = createPdfiumEngine({ createWorker });
+
+    expect(createWorker).not.toHaveBeenCalled();
+
+    const ready = engine.init();
+    const [{ id }] = worker.postMessage.mock.calls[0];
+    worker.reply({ id, type: 'result', result: { ready: true } });
+
+    await expect(ready).resolves.toEqual({ ready: true });
+    expect(createWorker).toHaveBeenCalledTimes(1);
+  });
+
+  it('should transfer the input buffer and resolve with a PDF Blob', async () => {
+    const worker = createFakeWorker();
+    const engine = createPdfiumEngine({ createWorker: () => worker });
+    const pdfData = new ArrayBuffer(8);
+
+    const pending = engine.removePassword(pdfData, 'secret');
+    const [message, transfer] = worker.postMessage.mock.calls[0];
+
+    expect(message.type).toBe('remove');
+    expect(message.payload).toEqual({ pdfData, password: 'secret' });
+    expect(transfer).toEqual([pdfData]);
+
+    worker.reply({ id: message.id, type: 'result', result: { buffer: new ArrayBuffer(4) } });
+
+    const blob = await pending;
+    expect(blob).toBeInstanceOf(Blob);
+    expect(blob.type).toBe('application/pdf');
+    expect(blob.size).toBe(4);
+  });
+
+  it('should ask the worker for output rewrites on request', () => {
+    const worker = createFakeWorker();
+    const engine = createPdfiumEngine({ createWorker: () => worker });
+    const pdfData = new ArrayBuffer(8);
+
+    engine.removePassword(pdfData, 'secret', { linearize: true, compact: true });
+    const [message] = worker.postMessage.mock.calls[0];
+
+    expect(message.payload).toEqual({
+      pdfData,
+      password: 'secret',
+      linearize: true,
+      compact: true,
+    });
+  });
+
+  it('should hand job metrics to listeners with the round trip time', async () => {
+    const worker = createFakeWorker();
+    const onMetrics = jest.fn();
+    const engine = createPdfiumEngine({ createWorker: () => worker, onMetrics });
+    const listener = jest.fn();
+    const unsubscribe = engine.addMetricsListener(listener);
+    const metrics = { engine: 'pdfium', bytesIn: 8, spans: [] };
+
+    const first = engine.removePassword(new ArrayBuffer(8), 'secret');
+    const [message] = worker.postMessage.mock.calls[0];
+    const result = { buffer: new ArrayBuffer(4), metrics };
+    worker.reply({ id: message.id, type: 'result', result });
+    await first;
+
+    const report = { ...metrics, roundTripMs: expect.any(Number) };
+    expect(onMetrics).toHaveBeenCalledWith(report);
+    expect(listener).toHaveBeenCalledWith(report);
+
+    unsubscribe();
+    const second = engine.removePassword(new ArrayBuffer(8), 'wrong');
+    const [retry] = worker.postMessage.mock.calls[1];
+    worker.reply({
+      id: retry.id,
+      type: 'error',
+      error: { name: 'Error', message: 'Password required or incorrect password' },
+      metrics: { ...metrics, error: 'Password required or incorrect password' },
+    });
+    await expect(second).rejects.toThrow('incorrect password');
+
+    expect(onMetrics).toHaveBeenLastCalledWith(
+      expect.objectContaining({ error: expect.any(String) }),
+    );
+    expect(listener).toHaveBeenCalledTimes(1);
+  });
+
+  it('should write streamed chunks in order and close the sink', async () => {
+    const worker = createFakeWorker();
+    const engine = createPdfiumEngine({ createWorker: () => worker });
+    const written = [];
+    const writer = {
+      write: jest.fn(async (chunk) => written.push(Array.from(chunk))),
+      close: jest.fn(async () => {}),
+      abort: jest.fn(async () => {}),
+    };
+    const writable = { getWriter: () => writer };
+
+    const pending = engine.removePasswordToStream(new ArrayBuffer(8), 'secret', writable);
+    const [message] = worker.postMessage.mock.calls[0];
+
+    expect(message.payload.stream).toBe(true);
+
+    worker.reply({ id: message.id, type: 'chunk', chunk: new Uint8Array([1, 2]).buffer });
+    worker.reply({ id: message.id, type: 'chunk', chunk: new Uint8Array([3]).buffer });
+    worker.reply({ id: message.id, type: 'result', result: { size: 3 } });
+
+    await expect(pending).resolves.toEqual({ size: 3 });
+    expect(written).toEqual([[1, 2], [3]]);
+    expect(writer.close).toHaveBeenCalled();
+    expect(writer.abort).not.toHaveBeenCalled();
+  });
+
+  it('should ack each streamed chunk once the sink has written it', async () => {
+    const worker = createFakeWorker();
+    const engine = createPdfiumEngine({ createWorker: () => worker });
+    let ready;
+    const writer = {
+      ready: new Promise((resolve) => (ready = resolve)),
+      write: jest.fn(async () => {}),
+      close: jest.fn(async () => {}),
+      abort: jest.fn(async () => {}),
+    };
+
+    const pending = engine.removePasswordToStream(new ArrayBuffer(8), 'secret', {
+      getWriter: () => writer,
+    });
+    const [message] = worker.postMessage.mock.calls[0];
+    expect(message.payload.streamWindow).toBeGreaterThan(0);
+
+    worker.reply({ id: message.id, type: 'chunk', chunk: new Uint8Array([1, 2]).buffer });
+    await Promise.resolve();
+    // Nothing is written, let alone acked, while the sink is not ready
+    expect(writer.write).not.toHaveBeenCalled();
+    expect(worker.postMessage).toHaveBeenCalledTimes(1);
+
+    ready();
+    worker.reply({ id: message.id, type: 'result', result: { size: 2 } });
+    await pending;
+    expect(worker.postMessage).toHaveBeenLastCalledWith({
+      id: message.id,
+      type: 'ack',
+      payload: { bytes: 2 },
+    });
+  });
+
+  it('should stop the job when the sink fails', async () => {
+    const worker = createFakeWorker();
+    const engine = createPdfiumEngine({ createWorker: () => worker });
+    const writer = {
+      write: jest.fn(async () => {
+        throw new Error('disk full');
+      }),
+      close: jest.fn(),
+      abort: jest.fn(async () => {}),
+    };
+
+    const pending = engine.removePasswordToStream(new ArrayBuffer(8), 'secret', {
+      getWriter: () => writer,
+    });
+    const [{ id }] = worker.postMessage.mock.calls[0];
+    worker.reply({ id, type: 'chunk', chunk: new Uint8Array([1]).buffer });
+
+    // The worker would wait for an ack forever, so it is stopped
+    await expect(pending).rejects.toThrow('disk full');
+    expect(worker.terminate).toHaveBeenCalled();
+    expect(writer.abort).toHaveBeenCalled();
+  });
+
+  it('should abort the sink when a streamed job fails', async () => {
+    const worker = createFakeWorker();
+    const engine = createPdfiumEngine({ createWorker: () => worker });
+    const writer = { write: jest.fn(), close: jest.fn(), abort: jest.fn(async () => {}) };
+
+    const pending = engine.removePasswordToStream(new ArrayBuffer(8), 'wrong', {
+      getWriter: () => writer,
+    });
+    const [{ id }] = worker.postMessage.mock.calls[0];
+    worker.reply({ id, type: 'error', error: { name: 'Error', message: 'bad password' } });
+
+    await expect(pending).rejects.toThrow('bad password');
+    expect(writer.abort).toHaveBeenCalled();
+    expect(writer.close).not.toHaveBeenCalled();
+  });
+
+  it('should match out-of-order responses to their requests', async () => {
+    const worker = createFakeWorker();
+    const engine = createPdfiumEngine({ createWorker: () => worker });
+
+    const first = engine.removePassword(new ArrayBuffer(1), 'a');
+    const second = engine.removePassword(new ArrayBuffer(1), 'b');
+    const [[firstMessage], [secondMessage]] = worker.postMessage.mock.calls;
+
+    worker.reply({ id: secondMessage.id, type: 'result', result: { buffer: new ArrayBuffer(2) } });
+    worker.reply({ id: firstMessage.id, type: 'result', result: { buffer: new ArrayBuffer(1) } });
+
+    expect((await first).size).toBe(1);
+    expect((await second).size).toBe(2);
+  });
+
+  it('should reject with the worker error name and message', async () => {
+    const worker = createFakeWorker();
+    const engine = createPdfiumEngine({ createWorker: () => worker });
+
+    const pending = engine.removePassword(new ArrayBuffer(1), 'wrong');
+    const [{ id }] = worker.postMessage.mock.calls[0];
+    worker.reply({
+      id,
+      type: 'error',
+      error: { name: 'Error', message: 'Password required or incorrect password' },
+    });
+
+    await expect(pending).rejects.toThrow('Password required or incorrect password');
+  });
+
+  it('should reject pending requests and respawn after a worker crash', async () => {
+    const crashed = createFakeWorker();
+    const replacement = createFakeWorker();
+    const createWorker = jest.fn().mockReturnValueOnce(crashed).mockReturnValueOnce(replacement);
+    const engine = createPdfiumEngine({ createWorker });
+
+    const pending = engine.init();
+    crashed.onerror({ message: 'out of memory' });
+
+    await expect(pending).rejects.toThrow('PDFium worker failed: out of memory');
+    expect(crashed.terminate).toHaveBeenCalled();
+
+    engine.init();
+    expect(createWorker).toHaveBeenCalledTimes(2);
+    expect(replacement.postMessage).toHaveBeenCalled();
+  });
+
+  it('should move to a fresh worker once a reply asks for recycling', async () => {
+    const retired = createFakeWorker();
+    const replacement = createFakeWorker();
+    const createWorker = jest.fn().mockReturnValueOnce(retired).mockReturnValueOnce(replacement);
+    const engine = createPdfiumEngine({ createWorker });
+
+    const first = engine.removePassword(new ArrayBuffer(8), 'pw');
+    const second = engine.removePassword(new ArrayBuffer(8), 'pw');
+    const [[firstMessage], [secondMessage]] = retired.postMessage.mock.calls;
+    const buffer = new ArrayBuffer(4);
+    retired.reply({ id: firstMessage.id, type: 'result', result: { buffer, recycle: true } });
+    await first;
+
+    // New work goes to the replacement; the retired worker finishes what it has
+    engine.init();
+    expect(createWorker).toHaveBeenCalledTimes(2);
+    expect(replacement.postMessage).toHaveBeenCalled();
+    expect(retired.terminate).not.toHaveBeenCalled();
+
+    retired.reply({ id: secondMessage.id, type: 'result', result: { buffer: new ArrayBuffer(4) } });
+    await second;
+    expect(retired.terminate).toHaveBeenCalled();
+    expect(replacement.terminate).not.toHaveBeenCalled();
+  });
+
+  it('should recycle the worker when a failed job asks for it', async () => {
+    const worker = createFakeWorker();
+    const engine = createPdfiumEngine({ createWorker: () => worker });
+
+    const pending = engine.removePassword(new ArrayBuffer(8), 'pw');
+    const [message] = worker.postMessage.mock.calls[0];
+    worker.reply({
+      id: message.id,
+      type: 'error',
+      error: { name: 'RuntimeError', message: 'memory access out of bounds' },
+      recycle: true,
+    });
+
+    await expect(pending).rejects.toThrow('memory access out of bounds');
+    expect(worker.terminate).toHaveBeenCalled();
+  });
+
+  it('should run a job a full heap turned away once more on a fresh worker', async () => {
+    const full = createFakeWorker();
+    const fresh = createFakeWorker();
+    const createWorker = jest.fn().mockReturnValueOnce(full).mockReturnValueOnce(fresh);
+    const engine = createPdfiumEngine({ createWorker });
+    const warn = jest.spyOn(console, 'warn').mockImplementation(() => {});
+    const pdfData = new ArrayBuffer(8);
+
+    const pending = engine.removePassword(pdfData, 'pw');
+    const [message] = full.postMessage.mock.calls[0];
+    // The worker hands the untouched input back with the error
+    full.reply({
+      id: message.id,
+      type: 'error',
+      error: { name: MEMORY_ERROR_NAME, message: 'Not enough PDFium memory left' },
+      recycle: true,
+      input: pdfData,
+    });
+    await new Promise((resolve) => setTimeout(resolve, 0));
+
+    expect(full.terminate).toHaveBeenCalled();
+    const [retry, transfer] = fresh.postMessage.mock.calls[0];
+    expect(retry.payload).toEqual({ pdfData, password: 'pw' });
+    expect(transfer).toEqual([pdfData]);
+
+    fresh.reply({ id: retry.id, type: 'result', result: { buffer: new ArrayBuffer(4) } });
+    expect(await pending).toBeInstanceOf(Blob);
+    warn.mockRestore();
+  });
+
+  it('should fail a job a fresh heap turns away too', async () => {
+    const createWorker = jest.fn(createFakeWorker);
+    const engine = createPdfiumEngine({ createWorker });
+    const warn = jest.spyOn(console, 'warn').mockImplementation(() => {});
+    const file = new File(['%PDF'], 'input.pdf');
+    const turnAway = (worker) => {
+      const [message] = worker.postMessage.mock.calls[0];
+      worker.reply({
+        id: message.id,
+        type: 'error',
+        error: { name: MEMORY_ERROR_NAME, message: 'Not enough PDFium memory left' },
+        recycle: true,
+      });
+    };
+
+    const pending = engine.removePassword(file, 'pw');
+    turnAway(createWorker.mock.results[0].value);
+    await new Promise((resolve) => setTimeout(resolve, 0));
+    turnAway(createWorker.mock.results[1].value);
+
+    await expect(pending).rejects.toThrow('Not enough PDFium memory left');
+    expect(createWorker).toHaveBeenCalledTimes(2);
+    warn.mockRestore();
+  });
+
+  it('should keep a worker holding an open document until it is closed', async () => {
+    const holder = createFakeWorker();
+    const replacement = createFakeWorker();
+    const createWorker = jest.fn().mockReturnValueOnce(holder).mockReturnValueOnce(replacement);
+    const engine = createPdfiumEngine({ createWorker });
+    const reply = (worker, result) => {
+      const [message] = worker.postMessage.mock.calls[worker.postMessage.mock.calls.length - 1];
+      worker.reply({ id: message.id, type: 'result', result });
+      return message;
+    };
+
+    const opening = engine.openDocument(new ArrayBuffer(8));
+    reply(holder, { document: 1 });
+    const handle = await opening;
+    expect(handle.size).toBe(8);
+
+    const removing = engine.removePassword(handle, 'pw');
+    const message = reply(holder, { buffer: new ArrayBuffer(4), recycle: true });
+    await removing;
+    expect(message.payload).toEqual({ document: 1, password: 'pw' });
+    expect(holder.postMessage.mock.calls[1][1]).toEqual([]);
+    expect(holder.terminate).not.toHaveBeenCalled();
+
+    // New input goes to a fresh worker; the handle still reaches its holder
+    engine.init();
+    expect(replacement.postMessage).toHaveBeenCalledTimes(1);
+    engine.removePassword(handle, 'pw');
+    expect(holder.postMessage).toHaveBeenCalledTimes(3);
+    reply(holder, { buffer: new ArrayBuffer(4) });
+
+    const closing = engine.closeDocument(handle);
+    expect(reply(holder, { closed: true }).type).toBe('close');
+    await closing;
+    expect(holder.terminate).toHaveBeenCalled();
+    await expect(engine.removePassword(handle, 'pw')).rejects.toThrow('no longer open');
+  });
+
+  it('should forward progress updates to the job that asked for them', async () => {
+    const worker = createFakeWorker();
+    const engine = createPdfiumEngine({ createWorker: () => worker });
+    const onProgress = jest.fn();
+
+    const pending = engine.removePassword(new ArrayBuffer(8), 'secret', { onProgress });
+    const [message] = worker.postMessage.mock.calls[0];
+    const progress = { engine: 'pdfium', bytesWritten: 2, bytesTotal: 8 };
+    worker.reply({ id: message.id, type: 'progress', progress });
+    worker.reply({ id: message.id, type: 'result', result: { buffer: new ArrayBuffer(4) } });
+    await pending;
+
+    expect(message.payload.progress).toBe(true);
+    expect(onProgress).toHaveBeenCalledWith(progress);
+  });
+
+  it('should stop the worker of an aborted job and move on to a fresh one', async () => {
+    const workers = [createFakeWorker(), createFakeWorker()];
+    const createWorker = jest.fn(() => workers[createWorker.mock.calls.length - 1]);
+    const engine = createPdfiumEngine({ createWorker });
+    const controller = new AbortController();
+
+    const aborted = engine.removePassword(new ArrayBuffer(8), 'secret', {
+      signal: controller.signal,
+    });
+    const other = engine.removePassword(new ArrayBuffer(8), 'secret');
+    controller.abort();
+
+    await expect(aborted).rejects.toMatchObject({ name: 'AbortError' });
+    await expect(other).rejects.toThrow('a job on it was cancelled');
+    expect(workers[0].terminate).toHaveBeenCalled();
+
+    const next = engine.init();
+    const [message] = workers[1].postMessage.mock.calls[0];
+    workers[1].reply({ id: message.id, type: 'result', result: { ready: true } });
+    await expect(next).resolves.toEqual({ ready: true });
+  });
+
+  it('should reject at once when the signal is already aborted', async () => {
+    const worker = createFakeWorker();
+    const engine = createPdfiumEngine({ createWorker: () => worker });
+    const controller = new AbortController();
+    controller.abort();
+
+    await expect(
+      engine.removePassword(new ArrayBuffer(8), 'secret', { signal: controller.signal }),
+    ).rejects.toMatchObject({ name: 'AbortError' });
+    expect(worker.postMessage).not.toHaveBeenCalled();
+  });
+
+  it('should reject in-flight requests on terminate', async () => {
+    const worker = createFakeWorker();
+    const engine = createPdfiumEngine({ createWorker: () => worker });
+
+    const pending = engine.init();
+    engine.terminate();
+
+    await expect(pending).rejects.toThrow('PDFium engine terminated');
+    expect(worker.terminate).toHaveBeenCalled();
+  });
+});
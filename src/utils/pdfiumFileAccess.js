@@ -0,0 +1,87 @@
+/**
+ * FPDF_FILEACCESS bridge for FPDF_LoadCustomDocument
+ *
+ * Lets PDFium pull byte ranges on demand through `m_GetBlock` instead of
+ * copying the whole document into the wasm heap. Reads go through an LRU block
+ * cache, so heap usage follows PDFium's working set rather than the file size.
+ *
+ * FileReaderSync is only available inside workers, which is where the engine
+ * runs; the callback PDFium invokes is synchronous. Runtimes without it (Node)
+ * register a synchronous reader for each Blob they hand in.
+ */
+
+import { createBlockCache } from './blockCache';
+import { getPointerSize, setPointer } from './pdfiumMemory64';
+
+// struct FPDF_FILEACCESS { unsigned long m_FileLen; int (*m_GetBlock)(...); void* m_Param; }
+// Three pointer-sized fields: 12 bytes on wasm32, 24 on the memory64 build
+const FILEACCESS_FIELDS = 3;
+const GETBLOCK_SUCCESS = 1;
+const GETBLOCK_FAILURE = 0;
+
+// Readers registered for Blobs that FileReaderSync cannot serve
+const registeredReaders = new WeakMap();
+
+/**
+ * Serve on-demand reads of `blob` from `readBlock` instead of FileReaderSync
+ * @param {Blob} blob - Source handed to the engine (e.g. from fs.openAsBlob)
+ * @param {(position: number, length: number) => Uint8Array} readBlock - Synchronous reader
+ */
+export const registerFileRangeReader = (blob, readBlock) => {
+  registeredReaders.set(blob, readBlock);
+};
+
+/**
+ * Synchronous range reader over a File/Blob
+ * @param {Blob} file - Source file
+ * @returns {(position: number, length: number) => Uint8Array}
+ */
+export const createFileRangeReader = (file) => {
+  const registered = registeredReaders.get(file);
+  if (registered) return registered;
+  const reader = new FileReaderSync();
+  return (position, length) =>
+    new Uint8Array(reader.readAsArrayBuffer(file.slice(position, position + length)));
+};
+
+/**
+ * Allocate an FPDF_FILEACCESS struct whose m_GetBlock serves reads from `readBlock`
+ * The struct must stay alive until FPDF_CloseDocument has been called
+ * @param {Object} pdfium - Initialized PDFium module
+ * @param {Object} options
+ * @param {number} options.size - Document size in bytes
+ * @param {(position: number, length: number) => Uint8Array} options.readBlock - Synchronous reader
+ * @param {number} [options.blockSize] - Cache block size
+ * @param {number} [options.maxBlocks] - Cache capacity in blocks
+ * @returns {{ptr: number, cache: Object, release: () => void}}
+ */
+export const createFileAccess = (pdfium, { size, readBlock, blockSize, maxBlocks }) => {
+  const wasmExports = pdfium.pdfium.wasmExports;
+  const cache = createBlockCache({ size, readBlock, blockSize, maxBlocks });
+
+  const getBlockCallback = pdfium.pdfium.addFunction((param, position, bufPtr, length) => {
+    try {
+      // Re-read memory.buffer on every call: the heap may have grown since the last one
+      const target = new Uint8Array(wasmExports.memory.buffer, bufPtr, length);
+      return cache.read(position, target) ? GETBLOCK_SUCCESS : GETBLOCK_FAILURE;
+    } catch (err) {
+      console.error('[PDFium] GetBlock error:', err);
+      return GETBLOCK_FAILURE;
+    }
+  }, 'iiiii');
+
+  const pointerSize = getPointerSize(pdfium);
+  const ptr = wasmExports.malloc(FILEACCESS_FIELDS * pointerSize);
+  const view = new DataView(wasmExports.memory.buffer);
+  setPointer(view, ptr, size, pointerSize);
+  setPointer(view, ptr + pointerSize, getBlockCallback, pointerSize);
+  setPointer(view, ptr + 2 * pointerSize, 0, pointerSize);
+
+  const release = () => {
+    pdfium.pdfium.removeFunction(getBlockCallback);
+    wasmExports.free(ptr);
+    cache.clear();
+  };
+
+  return { ptr, cache, release };
+};
@@ -0,0 +1,109 @@
+/**
+ * Unit tests for the FPDF_FILEACCESS bridge
+ * Tests struct layout and the m_GetBlock callback
+ */
+
+import { init } from '@embedpdf/pdfium';
+import {
+  createFileAccess,
+  createFileRangeReader,
+  registerFileRangeReader,
+} from './pdfiumFileAccess';
+
+// The @embedpdf/pdfium module is mocked in setupTests.js
+
+describe('pdfiumFileAccess', () => {
+  const source = Uint8Array.from({ length: 300 }, (_, i) => i % 256);
+  let pdfium;
+
+  beforeEach(async () => {
+    pdfium = await init({ wasmBinary: new ArrayBuffer(8) });
+    pdfium.pdfium.wasmExports.malloc.mockReturnValue(1024);
+  });
+
+  describe('createFileAccess', () => {
+    it('should fill FPDF_FILEACCESS with the file length and callback', () => {
+      const fileAccess = createFileAccess(pdfium, {
+        size: source.length,
+        readBlock: (position, length) => source.slice(position, position + length),
+      });
+      const view = new DataView(pdfium.pdfium.wasmExports.memory.buffer);
+
+      expect(fileAccess.ptr).toBe(1024);
+      expect(view.getUint32(1024, true)).toBe(300);
+      expect(view.getInt32(1028, true)).toBe(1); // function id from addFunction
+      expect(pdfium.pdfium.addFunction).toHaveBeenCalledWith(expect.any(Function), 'iiiii');
+    });
+
+    it('should lay out 8-byte fields for the memory64 build', () => {
+      pdfium.pointerSize = 8;
+      createFileAccess(pdfium, { size: 5 * 2 ** 30, readBlock: jest.fn() });
+      const view = new DataView(pdfium.pdfium.wasmExports.memory.buffer);
+
+      expect(pdfium.pdfium.wasmExports.malloc).toHaveBeenCalledWith(24);
+      expect(view.getBigUint64(1024, true)).toBe(BigInt(5 * 2 ** 30));
+      expect(view.getBigUint64(1032, true)).toBe(1n);
+      expect(view.getBigUint64(1040, true)).toBe(0n);
+    });
+
+    it('should copy requested ranges into the wasm heap', () => {
+      createFileAccess(pdfium, {
+        size: source.length,
+        readBlock: (position, length) => source.slice(position, position + length),
+      });
+      const getBlock = pdfium.pdfium.addFunction.mock.calls[0][0];
+
+      expect(getBlock(0, 100, 4096, 50)).toBe(1);
+
+      const heap = new Uint8Array(pdfium.pdfium.wasmExports.memory.buffer, 4096, 50);
+      expect(heap).toEqual(source.slice(100, 150));
+    });
+
+    it('should fail reads past the end of the file', () => {
+      createFileAccess(pdfium, {
+        size: source.length,
+        readBlock: (position, length) => source.slice(position, position + length),
+      });
+      const getBlock = pdfium.pdfium.addFunction.mock.calls[0][0];
+
+      expect(getBlock(0, 290, 4096, 20)).toBe(0);
+    });
+
+    it('should release the callback and struct', () => {
+      const fileAccess = createFileAccess(pdfium, { size: 1, readBlock: jest.fn() });
+
+      fileAccess.release();
+
+      expect(pdfium.pdfium.removeFunction).toHaveBeenCalledWith(1);
+      expect(pdfium.pdfium.wasmExports.free).toHaveBeenCalledWith(1024);
+    });
+  });
+
+  describe('createFileRangeReader', () => {
+    afterEach(() => {
+      delete global.FileReaderSync;
+    });
+
+    it('should read slices synchronously with FileReaderSync', () => {
+      const readAsArrayBuffer = jest.fn(() => new Uint8Array([7, 8]).buffer);
+      global.FileReaderSync = jest.fn(() => ({ readAsArrayBuffer }));
+      const file = new Blob([source]);
+      const sliceSpy = jest.spyOn(file, 'slice');
+
+      const readRange = createFileRangeReader(file);
+
+      expect(readRange(10, 2)).toEqual(new Uint8Array([7, 8]));
+      expect(sliceSpy).toHaveBeenCalledWith(10, 12);
+    });
+
+    it('should prefer a reader registered for the Blob', () => {
+      const file = new Blob([source]);
+      const readBlock = jest.fn(() => new Uint8Array([9]));
+
+      registerFileRangeReader(file, readBlock);
+
+      expect(createFileRangeReader(file)(4, 1)).toEqual(new Uint8Array([9]));
+      expect(readBlock).toHaveBeenCalledWith(4, 1);
+    });
+  });
+});
@@ -0,0 +1,98 @@
+/**
+ * Bindings for the memory64 PDFium build
+ *
+ * @embedpdf/pdfium only wraps wasm32 modules, so the memory64 build ships its
+ * own Emscripten glue (see .config/pdfium/build.sh) and this module adapts it
+ * to the same shape: the FPDF_* entry points at the top level, and
+ * `wasmExports` and `addFunction` under `pdfium`, all taking and returning
+ * Numbers. The raw wasm64 exports pass pointers and `unsigned long`s as BigInt.
+ *
+ * Structs shared with PDFium still hold 8-byte pointers, so the module reports
+ * its `pointerSize` for pdfiumArena and pdfiumFileAccess to lay them out.
+ */
+
+import { getMissingExports } from './pdfiumVariants';
+
+const encoder = new TextEncoder();
+
+/**
+ * Pointer (and `unsigned long`) size in bytes of an initialized PDFium module
+ */
+export const getPointerSize = (pdfium) => pdfium.pointerSize || 4;
+
+/**
+ * Write a pointer-sized field of a struct in the wasm heap
+ */
+export const setPointer = (view, offset, value, pointerSize) => {
+  if (pointerSize === 8) view.setBigUint64(offset, BigInt(value), true);
+  else view.setUint32(offset, value, true);
+};
+
+/**
+ * Adapt an instantiated memory64 Emscripten module to the @embedpdf/pdfium shape
+ * @param {Object} module - Module returned by the glue's factory
+ * @returns {Object} Initialized PDFium module
+ */
+export const bindMemory64 = (module) => {
+  const raw = module.wasmExports;
+  const missingExports = getMissingExports(raw);
+  if (missingExports.length > 0) {
+    throw new Error(`PDFium build is missing exports: ${missingExports.join(', ')}`);
+  }
+
+  // NUL-terminated password in the heap for the duration of one call
+  const withString = (text, run) => {
+    if (!text) return run(0n);
+    const bytes = encoder.encode(`${text}\0`);
+    const ptr = raw.malloc(BigInt(bytes.length));
+    if (!ptr) throw new Error('Out of wasm memory for the password');
+    new Uint8Array(raw.memory.buffer, Number(ptr), bytes.length).set(bytes);
+    try {
+      return run(ptr);
+    } finally {
+      raw.free(ptr);
+    }
+  };
+
+  return {
+    pointerSize: 8,
+    pdfium: {
+      wasmExports: {
+        memory: raw.memory,
+        malloc: (size) => Number(raw.malloc(BigInt(size))),
+        free: (ptr) => raw.free(BigInt(ptr)),
+      },
+      // Every callback parameter PDFium passes is a pointer or an unsigned long
+      addFunction: (fn, signature) =>
+        module.addFunction(
+          (...args) => fn(...args.map(Number)),
+          signature[0] + 'j'.repeat(signature.length - 1),
+        ),
+      removeFunction: (index) => module.removeFunction(index),
+    },
+    PDFiumExt_Init: () => raw.PDFiumExt_Init(),
+    // `size` is a C int: documents past 2 GiB go through FPDF_LoadCustomDocument
+    FPDF_LoadMemDocument: (dataPtr, size, password) =>
+      Number(withString(password, (ptr) => raw.FPDF_LoadMemDocument(BigInt(dataPtr), size, ptr))),
+    FPDF_LoadCustomDocument: (fileAccessPtr, password) =>
+      Number(
+        withString(password, (ptr) => raw.FPDF_LoadCustomDocument(BigInt(fileAccessPtr), ptr)),
+      ),
+    FPDF_GetLastError: () => Number(raw.FPDF_GetLastError()),
+    FPDF_GetPageCount: (document) => raw.FPDF_GetPageCount(BigInt(document)),
+    FPDF_SaveAsCopy: (document, fileWritePtr, flags) =>
+      raw.FPDF_SaveAsCopy(BigInt(document), BigInt(fileWritePtr), BigInt(flags)),
+    FPDF_CloseDocument: (document) => raw.FPDF_CloseDocument(BigInt(document)),
+  };
+};
+
+/**
+ * Load the memory64 glue and instantiate the build
+ * @param {string} glueUrl - URL of the Emscripten ES module glue
+ * @param {Object} moduleOverrides - From loadPdfiumWasm (wasmBinary or instantiateWasm)
+ * @returns {Promise<Object>} Initialized PDFium module
+ */
+export const initMemory64 = async (glueUrl, moduleOverrides) => {
+  const { default: createModule } = await import(/* webpackIgnore: true */ glueUrl);
+  return bindMemory64(await createModule(moduleOverrides));
+};
@@ -0,0 +1,83 @@
+/**
+ * Unit tests for the memory64 PDFium bindings
+ * Tests BigInt conversion at the wasm64 boundary, password strings and callback signatures
+ */
+
+import { bindMemory64, getPointerSize, setPointer } from './pdfiumMemory64';
+import { REQUIRED_EXPORTS } from './pdfiumVariants';
+
+describe('pdfiumMemory64', () => {
+  let module;
+  let raw;
+
+  beforeEach(() => {
+    // Raw wasm64 exports: pointers and unsigned longs in and out as BigInt
+    raw = Object.fromEntries(REQUIRED_EXPORTS.map((name) => [name, jest.fn(() => 0n)]));
+    raw.memory = new WebAssembly.Memory({ initial: 1 });
+    raw.malloc.mockReturnValue(4096n);
+    raw.FPDF_LoadMemDocument.mockReturnValue(8192n);
+    raw.FPDF_GetLastError.mockReturnValue(4n);
+    module = { wasmExports: raw, addFunction: jest.fn(() => 7), removeFunction: jest.fn() };
+  });
+
+  describe('bindMemory64', () => {
+    it('should convert pointers to and from BigInt', () => {
+      const pdfium = bindMemory64(module);
+
+      expect(pdfium.pdfium.wasmExports.malloc(100)).toBe(4096);
+      expect(raw.malloc).toHaveBeenCalledWith(100n);
+      expect(pdfium.FPDF_LoadMemDocument(4096, 100, 0)).toBe(8192);
+      expect(raw.FPDF_LoadMemDocument).toHaveBeenCalledWith(4096n, 100, 0n);
+      expect(pdfium.FPDF_GetLastError()).toBe(4);
+      pdfium.FPDF_SaveAsCopy(8192, 64, 3);
+      expect(raw.FPDF_SaveAsCopy).toHaveBeenCalledWith(8192n, 64n, 3n);
+    });
+
+    it('should pass the password as a NUL-terminated heap string', () => {
+      let password = null;
+      raw.FPDF_LoadCustomDocument.mockImplementation((_, ptr) => {
+        password = Array.from(new Uint8Array(raw.memory.buffer, Number(ptr), 5));
+        return 1n;
+      });
+
+      bindMemory64(module).FPDF_LoadCustomDocument(64, 'pass');
+
+      expect(password).toEqual([112, 97, 115, 115, 0]);
+      expect(raw.free).toHaveBeenCalledWith(4096n);
+    });
+
+    it('should register callbacks with i64 parameters and Number arguments', () => {
+      const callback = jest.fn(() => 1);
+
+      expect(bindMemory64(module).pdfium.addFunction(callback, 'iiii')).toBe(7);
+
+      const [wrapped, signature] = module.addFunction.mock.calls[0];
+      expect(signature).toBe('ijjj');
+      expect(wrapped(16n, 32n, 3n)).toBe(1);
+      expect(callback).toHaveBeenCalledWith(16, 32, 3);
+    });
+
+    it('should reject a build missing required exports', () => {
+      delete raw.FPDF_SaveAsCopy;
+
+      expect(() => bindMemory64(module)).toThrow('missing exports: FPDF_SaveAsCopy');
+    });
+
+    it('should report 8-byte pointers', () => {
+      expect(getPointerSize(bindMemory64(module))).toBe(8);
+      expect(getPointerSize({})).toBe(4);
+    });
+  });
+
+  describe('setPointer', () => {
+    it('should write 4 or 8 little-endian bytes', () => {
+      const view = new DataView(new ArrayBuffer(16));
+
+      setPointer(view, 0, 0x01020304, 4);
+      setPointer(view, 8, 2 ** 33, 8);
+
+      expect(view.getUint32(0, true)).toBe(0x01020304);
+      expect(view.getBigUint64(8, true)).toBe(2n ** 33n);
+    });
+  });
+});
@@ -0,0 +1,132 @@
+/**
+ * Per-job instrumentation for the removal engines
+ *
+ * Every stage of a job runs inside a span that is also recorded as a
+ * performance.measure entry, so it shows up in the DevTools performance panel
+ * and to PerformanceObservers on the thread that ran it. The collected report
+ * is plain data: it crosses the worker boundary with the job result and can be
+ * handed to any telemetry backend as is.
+ */
+
+const SPAN_PREFIX = 'pdfium';
+
+// Upper bounds (inclusive) of the WriteBlock chunk size histogram; the last
+// bucket counts everything larger
+export const CHUNK_SIZE_BOUNDS = [1024, 4096, 16384, 65536, 262144, 1048576];
+
+const canMeasure = typeof performance !== 'undefined' && typeof performance.measure === 'function';
+
+/**
+ * Record a finished span on the performance timeline
+ * The entry is cleared right away so long sessions keep a flat timeline;
+ * observers and DevTools have already seen it by then
+ * @param {string} name - Stage name, prefixed with "pdfium:"
+ * @param {number} start - performance.now() at the start
+ * @param {number} end - performance.now() at the end
+ */
+export const measureSpan = (name, start, end) => {
+  if (!canMeasure) return;
+  const entryName = `${SPAN_PREFIX}:${name}`;
+  try {
+    performance.measure(entryName, { start, end });
+    performance.clearMeasures(entryName);
+  } catch {
+    // User Timing Level 3 (measure with timestamps) is unavailable
+  }
+};
+
+/**
+ * Create the collector for one job
+ * @param {Object} [options]
+ * @param {number} [options.bytesIn] - Input size
+ * @returns {Object} Collector; `finish()` returns the report
+ */
+export const createJobMetrics = ({ bytesIn = 0 } = {}) => {
+  const jobStart = performance.now();
+  const spans = [];
+  const chunkCounts = new Array(CHUNK_SIZE_BOUNDS.length + 1).fill(0);
+  const fields = { engine: null, variant: null, memoryPlan: null };
+  let chunkBytes = 0;
+  let memory = null;
+  let heapStart = 0;
+  let heapPeak = 0;
+
+  const sampleHeap = () => {
+    if (memory) heapPeak = Math.max(heapPeak, memory.buffer.byteLength);
+  };
+
+  const endSpan = (name, start) => {
+    const end = performance.now();
+    spans.push({ name, startMs: start - jobStart, durationMs: end - start });
+    measureSpan(name, start, end);
+    sampleHeap();
+  };
+
+  /**
+   * Time `run` (sync or async) as stage `name`
+   * @returns {*} Whatever `run` returns
+   */
+  const span = (name, run) => {
+    const start = performance.now();
+    let result;
+    try {
+      result = run();
+    } catch (err) {
+      endSpan(name, start);
+      throw err;
+    }
+    if (result && typeof result.then === 'function') {
+      return result.finally(() => endSpan(name, start));
+    }
+    endSpan(name, start);
+    return result;
+  };
+
+  return {
+    span,
+
+    /** Engine ('strip' | 'pdfium'), PDFium build and heap plan (see planHeap) of the job */
+    set: (values) => Object.assign(fields, values),
+
+    /** Start tracking a wasm heap; it only ever grows, so its size is the high-water mark */
+    trackMemory: (wasmMemory) => {
+      if (memory === wasmMemory) return;
+      memory = wasmMemory;
+      heapStart = heapStart || memory.buffer.byteLength;
+      sampleHeap();
+    },
+
+    /** Count one output chunk */
+    recordChunk: (size) => {
+      let bucket = CHUNK_SIZE_BOUNDS.findIndex((bound) => size <= bound);
+      if (bucket < 0) bucket = CHUNK_SIZE_BOUNDS.length;
+      chunkCounts[bucket] += 1;
+      chunkBytes += size;
+      sampleHeap();
+    },
+
+    /**
+     * @param {Object} [outcome]
+     * @param {number} [outcome.bytesOut] - Output size
+     * @param {Error} [outcome.error] - Failure, if the job failed
+     */
+    finish: ({ bytesOut = 0, error } = {}) => {
+      sampleHeap();
+      return {
+        ...fields,
+        bytesIn,
+        bytesOut,
+        totalMs: performance.now() - jobStart,
+        spans,
+        wasmHeap: memory ? { startBytes: heapStart, peakBytes: heapPeak } : null,
+        chunks: {
+          count: chunkCounts.reduce((sum, count) => sum + count, 0),
+          bytes: chunkBytes,
+          bounds: CHUNK_SIZE_BOUNDS,
+          counts: chunkCounts,
+        },
+        ...(error ? { error: error.message } : {}),
+      };
+    },
+  };
+};
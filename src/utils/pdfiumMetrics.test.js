@@ -0,0 +1,72 @@
+/**
+ * Unit tests for the per-job instrumentation
+ * Tests span timing, the chunk histogram, wasm heap tracking and the report shape
+ */
+
+import { CHUNK_SIZE_BOUNDS, createJobMetrics } from './pdfiumMetrics';
+
+describe('createJobMetrics', () => {
+  it('should time sync and async spans in order', async () => {
+    const metrics = createJobMetrics({ bytesIn: 10 });
+
+    expect(metrics.span('copy', () => 'copied')).toBe('copied');
+    await expect(metrics.span('load', async () => 'loaded')).resolves.toBe('loaded');
+
+    const { spans, bytesIn, totalMs } = metrics.finish({ bytesOut: 5 });
+    expect(spans.map((span) => span.name)).toEqual(['copy', 'load']);
+    expect(spans[1].startMs).toBeGreaterThanOrEqual(spans[0].startMs);
+    spans.forEach((span) => expect(span.durationMs).toBeGreaterThanOrEqual(0));
+    expect(bytesIn).toBe(10);
+    expect(totalMs).toBeGreaterThanOrEqual(0);
+  });
+
+  it('should close spans that throw and report the error', async () => {
+    const metrics = createJobMetrics();
+
+    expect(() =>
+      metrics.span('load', () => {
+        throw new Error('bad');
+      }),
+    ).toThrow('bad');
+    const failing = metrics.span('save', async () => Promise.reject(new Error('worse')));
+    await expect(failing).rejects.toThrow('worse');
+
+    const report = metrics.finish({ error: new Error('worse') });
+    expect(report.spans.map((span) => span.name)).toEqual(['load', 'save']);
+    expect(report.error).toBe('worse');
+  });
+
+  it('should bucket chunk sizes by inclusive upper bound', () => {
+    const metrics = createJobMetrics();
+    [1, 1024, 1025, 2_000_000].forEach((size) => metrics.recordChunk(size));
+
+    const { chunks } = metrics.finish();
+    expect(chunks.bounds).toEqual(CHUNK_SIZE_BOUNDS);
+    expect(chunks.count).toBe(4);
+    expect(chunks.bytes).toBe(1 + 1024 + 1025 + 2_000_000);
+    expect(chunks.counts).toEqual([2, 1, 0, 0, 0, 0, 1]);
+  });
+
+  it('should track the wasm heap high-water mark', () => {
+    const metrics = createJobMetrics();
+    const memory = { buffer: { byteLength: 100 } };
+
+    expect(metrics.finish().wasmHeap).toBeNull();
+
+    metrics.trackMemory(memory);
+    metrics.span('load', () => {
+      memory.buffer = { byteLength: 300 };
+    });
+
+    expect(metrics.finish().wasmHeap).toEqual({ startBytes: 100, peakBytes: 300 });
+  });
+
+  it('should carry the engine and variant set during the job', () => {
+    const metrics = createJobMetrics();
+    metrics.set({ engine: 'pdfium', variant: 'lite' });
+
+    const report = metrics.finish();
+    expect(report).toMatchObject({ engine: 'pdfium', variant: 'lite', bytesOut: 0 });
+    expect(report).not.toHaveProperty('error');
+  });
+});
@@ -0,0 +1,149 @@
+/**
+ * Per-job planning from file size and device memory
+ *
+ * Decides, before a file is opened, how PDFium takes it and how many jobs may
+ * run side by side. A job on the in-memory path holds its input in the wasm
+ * heap next to the saved output; one on the on-demand path (a custom document
+ * read through FPDF_FILEACCESS) holds only the output. Small files take the
+ * in-memory path, which is faster; the size where on-demand starts scales with
+ * the device's memory, and so does the budget the pool keeps its running jobs
+ * under.
+ *
+ * navigator.deviceMemory is rounded and capped (at 8 GB) by the browsers that
+ * report it; the others are planned for as a DEFAULT_DEVICE_MEMORY device.
+ */
+
+const GIB = 1024 * 1024 * 1024;
+
+// On-demand threshold on a DEFAULT_DEVICE_MEMORY device: Files at least this
+// large are handed to the engine as-is and read on demand
+export const LARGE_FILE_SIZE = 64 * 1024 * 1024;
+
+// Device memory assumed when the browser does not report it, in GB; at this
+// size LARGE_FILE_SIZE is the on-demand threshold
+export const DEFAULT_DEVICE_MEMORY = 4;
+// Share of device memory running jobs may take together
+const MEMORY_BUDGET_SHARE = 0.5;
+// The on-demand threshold moves with device memory, within these factors of LARGE_FILE_SIZE
+const MIN_THRESHOLD_FACTOR = 0.25;
+const MAX_THRESHOLD_FACTOR = 4;
+// Heap of an engine before it loads a document: the module and PDFium's own state
+export const ENGINE_BASELINE_MEMORY = 64 * 1024 * 1024;
+const DEFAULT_CORES = 4;
+
+/**
+ * What this runtime offers for planning
+ * @returns {{memory: number, cores: number, blobStreams: boolean}} Device memory in GB,
+ *   logical cores, and whether Blobs can be streamed into the heap without a full copy
+ */
+export const getDeviceProfile = () => {
+  const nav = typeof navigator !== 'undefined' ? navigator : {};
+  return {
+    memory: nav.deviceMemory || DEFAULT_DEVICE_MEMORY,
+    cores: Math.max(1, nav.hardwareConcurrency || DEFAULT_CORES),
+    blobStreams: typeof Blob !== 'undefined' && typeof Blob.prototype.stream === 'function',
+  };
+};
+
+/**
+ * Bytes the running jobs may hold together
+ * @param {Object} [device] - As returned by getDeviceProfile
+ */
+export const getMemoryBudget = (device = getDeviceProfile()) =>
+  device.memory * GIB * MEMORY_BUDGET_SHARE;
+
+/**
+ * Size from which a File is read on demand rather than copied into the heap
+ * @param {Object} [device] - As returned by getDeviceProfile
+ */
+export const getOnDemandThreshold = (device = getDeviceProfile()) => {
+  const scaled = (LARGE_FILE_SIZE * device.memory) / DEFAULT_DEVICE_MEMORY;
+  return Math.min(
+    Math.max(scaled, LARGE_FILE_SIZE * MIN_THRESHOLD_FACTOR),
+    LARGE_FILE_SIZE * MAX_THRESHOLD_FACTOR,
+  );
+};
+
+/**
+ * Plan one job
+ * Only Files and Blobs can be read on demand; buffers are already in memory
+ * @param {ArrayBuffer|Blob} source - The PDF as it will reach the engine
+ * @param {Object} [device] - As returned by getDeviceProfile
+ * @returns {{onDemand: boolean, memory: number}} Whether PDFium reads the document on
+ *   demand, and the bytes the job is expected to hold at its peak
+ */
+export const planJob = (source, device = getDeviceProfile()) => {
+  const size = source.byteLength ?? source.size;
+  const onDemand = source instanceof Blob && size >= getOnDemandThreshold(device);
+  // Output, plus the heap copy of the input; without Blob streams the copy is staged once more
+  let copies = 1;
+  if (!onDemand) copies += source instanceof Blob && !device.blobStreams ? 2 : 1;
+  return { onDemand, memory: ENGINE_BASELINE_MEMORY + copies * size };
+};
+
+/**
+ * Worker count: one per logical core, as many as the budget has engine baselines for
+ * @param {Object} [device] - As returned by getDeviceProfile
+ */
+export const planPoolSize = (device = getDeviceProfile()) =>
+  Math.max(1, Math.min(device.cores, Math.floor(getMemoryBudget(device) / ENGINE_BASELINE_MEMORY)));
+
+// Heap PDFium needs besides the input, relative to its size: the parsed
+// object table and the stream it is decrypting at the time
+const PDFIUM_WORKING_SET_RATIO = 0.25;
+
+// Name of the errors the heap check fails jobs with
+export const MEMORY_ERROR_NAME = 'MemoryPressureError';
+
+/**
+ * Check a PDFium job against the wasm heap before anything is allocated
+ * The heap never shrinks, so all of it counts as taken, except the arena's idle
+ * input buffer (see pdfiumArena.js): the heap copy reuses it in place, and only
+ * what the input needs beyond it is new. A job that only fits without the heap
+ * copy is routed to the on-demand path when it has a File; one that only fits
+ * a fresh heap is queued for a new worker
+ * @param {Object} job
+ * @param {number} job.size - Input bytes
+ * @param {boolean} job.onDemand - Whether planJob already sent it on demand
+ * @param {boolean} job.canStream - Whether it can be read on demand (a File or Blob)
+ * @param {number} job.heapBytes - The heap's current size (memory.buffer.byteLength)
+ * @param {number} job.heapLimit - Largest heap the build can grow to
+ * @param {number} [job.reusableBytes] - Idle arena input capacity inside `heapBytes`
+ * @returns {{decision: 'admit'|'stream'|'queue'|'reject', estimatedPeakBytes: number}}
+ */
+export const planHeap = ({
+  size,
+  onDemand,
+  canStream,
+  heapBytes,
+  heapLimit,
+  reusableBytes = 0,
+}) => {
+  const working = size * PDFIUM_WORKING_SET_RATIO;
+  const copy = Math.max(0, size - reusableBytes);
+
+  if (!onDemand && heapBytes + working + copy <= heapLimit) {
+    return { decision: 'admit', estimatedPeakBytes: heapBytes + working + copy };
+  }
+  if (canStream && heapBytes + working <= heapLimit) {
+    return { decision: onDemand ? 'admit' : 'stream', estimatedPeakBytes: heapBytes + working };
+  }
+  // A fresh heap has no input buffer to reuse
+  const fresh = ENGINE_BASELINE_MEMORY + working + (canStream ? 0 : size);
+  return {
+    decision: fresh <= heapLimit ? 'queue' : 'reject',
+    estimatedPeakBytes: heapBytes + (canStream ? working : working + copy),
+  };
+};
+
+/**
+ * Whether a job failed for lack of memory, so running it again on its own may succeed:
+ * the heap check, a trap inside PDFium, or an allocation that failed (V8 reports those
+ * as "Array buffer allocation failed", Firefox and Safari as out of memory). Other
+ * RangeErrors, such as an output past its limit, fail the same way on any retry
+ * @param {Error} err - As rethrown on the main thread (only name and message survive)
+ */
+export const isMemoryError = (err) =>
+  err.name === MEMORY_ERROR_NAME ||
+  err.name === 'RuntimeError' ||
+  /Array buffer allocation failed|out of (wasm )?memory/i.test(err.message);
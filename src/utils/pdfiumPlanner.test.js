@@ -0,0 +1,173 @@
+/**
+ * Unit tests for job planning
+ * Tests the device profile, the on-demand threshold, per-job memory estimates,
+ * the worker count the memory budget allows and the heap check
+ */
+
+import {
+  DEFAULT_DEVICE_MEMORY,
+  ENGINE_BASELINE_MEMORY,
+  getDeviceProfile,
+  getMemoryBudget,
+  getOnDemandThreshold,
+  isMemoryError,
+  LARGE_FILE_SIZE,
+  MEMORY_ERROR_NAME,
+  planHeap,
+  planJob,
+  planPoolSize,
+} from './pdfiumPlanner';
+
+const GIB = 1024 * 1024 * 1024;
+
+const device = (memory, cores = 4) => ({ memory, cores, blobStreams: true });
+
+// A File of any size without allocating it
+const fileOfSize = (size) => {
+  const file = new File(['PDF'], 'input.pdf');
+  Object.defineProperty(file, 'size', { value: size });
+  return file;
+};
+
+describe('pdfiumPlanner', () => {
+  describe('getDeviceProfile', () => {
+    afterEach(() => {
+      delete navigator.deviceMemory;
+      delete navigator.hardwareConcurrency;
+    });
+
+    it('should read device memory and cores from navigator', () => {
+      Object.defineProperty(navigator, 'deviceMemory', { value: 8, configurable: true });
+      Object.defineProperty(navigator, 'hardwareConcurrency', { value: 32, configurable: true });
+
+      expect(getDeviceProfile()).toMatchObject({ memory: 8, cores: 32 });
+    });
+
+    it('should assume a default device where navigator does not tell', () => {
+      Object.defineProperty(navigator, 'deviceMemory', { value: undefined, configurable: true });
+      Object.defineProperty(navigator, 'hardwareConcurrency', { value: 0, configurable: true });
+
+      expect(getDeviceProfile()).toMatchObject({ memory: DEFAULT_DEVICE_MEMORY, cores: 4 });
+    });
+  });
+
+  describe('getOnDemandThreshold', () => {
+    it('should be LARGE_FILE_SIZE on a default device', () => {
+      expect(getOnDemandThreshold(device(DEFAULT_DEVICE_MEMORY))).toBe(LARGE_FILE_SIZE);
+    });
+
+    it('should scale with device memory within bounds', () => {
+      expect(getOnDemandThreshold(device(2))).toBe(LARGE_FILE_SIZE / 2);
+      expect(getOnDemandThreshold(device(8))).toBe(LARGE_FILE_SIZE * 2);
+      expect(getOnDemandThreshold(device(0.25))).toBe(LARGE_FILE_SIZE / 4);
+      expect(getOnDemandThreshold(device(64))).toBe(LARGE_FILE_SIZE * 4);
+    });
+  });
+
+  describe('planJob', () => {
+    it('should keep small files in memory and read large ones on demand', () => {
+      expect(planJob(fileOfSize(LARGE_FILE_SIZE - 1), device(4)).onDemand).toBe(false);
+      expect(planJob(fileOfSize(LARGE_FILE_SIZE), device(4)).onDemand).toBe(true);
+      // The same file fits in memory on a larger device
+      expect(planJob(fileOfSize(LARGE_FILE_SIZE), device(8)).onDemand).toBe(false);
+    });
+
+    it('should never read a buffer on demand', () => {
+      expect(planJob(new ArrayBuffer(16), { ...device(1), memory: 0 }).onDemand).toBe(false);
+    });
+
+    it('should count the heap copy only on the in-memory path', () => {
+      const size = 10 * 1024 * 1024;
+
+      expect(planJob(fileOfSize(size), device(4)).memory).toBe(ENGINE_BASELINE_MEMORY + 2 * size);
+      expect(planJob(fileOfSize(size * 10), device(4)).memory).toBe(
+        ENGINE_BASELINE_MEMORY + size * 10,
+      );
+    });
+
+    it('should count the staging copy when Blobs cannot be streamed', () => {
+      const size = 1024;
+      const noStreams = { ...device(4), blobStreams: false };
+
+      expect(planJob(fileOfSize(size), noStreams).memory).toBe(ENGINE_BASELINE_MEMORY + 3 * size);
+      expect(planJob(new ArrayBuffer(size), noStreams).memory).toBe(
+        ENGINE_BASELINE_MEMORY + 2 * size,
+      );
+    });
+  });
+
+  describe('planPoolSize', () => {
+    it('should take every core while the budget allows', () => {
+      expect(planPoolSize(device(8, 32))).toBe(32);
+      expect(getMemoryBudget(device(8))).toBe(4 * GIB);
+    });
+
+    it('should stop at the engines the memory budget can hold', () => {
+      expect(planPoolSize(device(0.25, 32))).toBe(GIB / 8 / ENGINE_BASELINE_MEMORY);
+      expect(planPoolSize(device(0.0625, 8))).toBe(1);
+    });
+  });
+
+  describe('planHeap', () => {
+    const MIB = 1024 * 1024;
+    const job = (values) => ({
+      size: 100 * MIB,
+      onDemand: false,
+      canStream: true,
+      heapBytes: 16 * MIB,
+      heapLimit: 2 * GIB,
+      ...values,
+    });
+
+    it('should admit a job whose copy fits the heap', () => {
+      expect(planHeap(job())).toEqual({ decision: 'admit', estimatedPeakBytes: 141 * MIB });
+      expect(planHeap(job({ onDemand: true }))).toEqual({
+        decision: 'admit',
+        estimatedPeakBytes: 41 * MIB,
+      });
+    });
+
+    it('should send a File on demand when only its copy does not fit', () => {
+      expect(planHeap(job({ heapBytes: 2 * GIB - 50 * MIB })).decision).toBe('stream');
+    });
+
+    it('should queue a job a fresh heap could take', () => {
+      const plan = planHeap(job({ canStream: false, heapBytes: 2 * GIB - 50 * MIB }));
+
+      expect(plan).toEqual({ decision: 'queue', estimatedPeakBytes: 2 * GIB + 75 * MIB });
+    });
+
+    it('should count the idle arena input buffer as free for the next copy', () => {
+      // Heap left by a first 1 GiB job, whose input buffer the second one reuses
+      const second = job({ size: GIB, canStream: false, heapBytes: 1.5 * GIB });
+
+      expect(planHeap(second).decision).toBe('queue');
+      expect(planHeap({ ...second, reusableBytes: GIB })).toEqual({
+        decision: 'admit',
+        estimatedPeakBytes: 1.75 * GIB,
+      });
+      // A larger file only needs what the buffer cannot hold
+      expect(planHeap({ ...second, size: 1.1 * GIB, reusableBytes: GIB }).decision).toBe('admit');
+    });
+
+    it('should reject a job no heap of the build could take', () => {
+      expect(planHeap(job({ size: 1.9 * GIB, canStream: false })).decision).toBe('reject');
+      expect(planHeap(job({ size: 8 * GIB, heapLimit: 16 * GIB })).decision).toBe('admit');
+    });
+  });
+
+  describe('isMemoryError', () => {
+    it('should tell memory failures from other errors', () => {
+      const named = (name, message = '') => Object.assign(new Error(message), { name });
+
+      expect(isMemoryError(named(MEMORY_ERROR_NAME))).toBe(true);
+      expect(isMemoryError(named('RuntimeError', 'unreachable'))).toBe(true);
+      expect(isMemoryError(named('RangeError', 'Array buffer allocation failed'))).toBe(true);
+      expect(isMemoryError(new Error('Out of wasm memory for a 10 byte input'))).toBe(true);
+      expect(isMemoryError(named('RangeError', 'out of memory'))).toBe(true);
+      expect(isMemoryError(new Error('Password required or incorrect password'))).toBe(false);
+      expect(isMemoryError(named('RangeError', 'Output exceeds 2147483648 bytes'))).toBe(false);
+      expect(isMemoryError(named('RangeError', 'Maximum call stack size exceeded'))).toBe(false);
+    });
+  });
+});
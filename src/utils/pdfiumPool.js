@@ -0,0 +1,304 @@
+/**
+ * Pool of PDFium worker engines for batch decryption
+ *
+ * Each pool slot owns one engine (one worker) and a local deque of pending jobs.
+ * New jobs land on the least-loaded deque; a slot that runs dry steals from the
+ * tail of the most-loaded one, so a few huge files cannot stall the rest.
+ *
+ * Jobs carry the memory the planner expects them to hold, and one only starts
+ * while the running ones leave room for it under the pool's memory budget; a
+ * job on its own always runs, however large. A batch file that runs out of
+ * memory next to others is retried once with the budget to itself.
+ */
+
+import { abortReason, createPdfiumEngine } from './pdfiumEngine';
+import { loadEncryption } from './loadEncryption';
+import { getMemoryBudget, isMemoryError, planJob, planPoolSize } from './pdfiumPlanner';
+
+/**
+ * Default worker count: one per logical core, within the memory budget
+ */
+export const getDefaultPoolSize = () => planPoolSize();
+
+/**
+ * Create a worker pool
+ * @param {Object} [options]
+ * @param {number} [options.size] - Number of workers
+ * @param {number} [options.memoryBudget] - Bytes the running jobs may hold together
+ * @param {(options: object) => object} [options.createEngine] - Engine factory (one per slot),
+ *   called with `{ onMetrics }`
+ */
+export const createPdfiumPool = ({
+  size = getDefaultPoolSize(),
+  memoryBudget = getMemoryBudget(),
+  createEngine = createPdfiumEngine,
+} = {}) => {
+  const slots = Array.from({ length: size }, () => ({
+    engine: null,
+    queue: [],
+    busy: false,
+  }));
+  // Memory held by the running jobs
+  let reserved = 0;
+
+  const metricsListeners = new Set();
+  const emitMetrics = (metrics) => metricsListeners.forEach((listener) => listener(metrics));
+
+  const backlog = (slot) => slot.queue.length + (slot.busy ? 1 : 0);
+
+  const getEngine = (slot) => {
+    if (!slot.engine) slot.engine = createEngine({ onMetrics: emitMetrics });
+    return slot.engine;
+  };
+
+  // The most-loaded other slot with queued jobs
+  const findVictim = (thief) => {
+    let victim = null;
+    slots.forEach((slot) => {
+      if (slot !== thief && slot.queue.length > 0) {
+        if (!victim || slot.queue.length > victim.queue.length) victim = slot;
+      }
+    });
+    return victim;
+  };
+
+  const fits = (job) => reserved === 0 || reserved + job.memory <= memoryBudget;
+
+  // Run the slot's next job, or the newest one of the most-loaded other slot
+  const drain = (slot) => {
+    if (slot.busy) return;
+
+    const victim = slot.queue.length > 0 ? null : findVictim(slot);
+    const job = victim ? victim.queue[victim.queue.length - 1] : slot.queue[0];
+    // A job that does not fit yet waits for running ones to release memory
+    if (!job || !fits(job)) return;
+    if (victim) victim.queue.pop();
+    else slot.queue.shift();
+
+    slot.busy = true;
+    reserved += job.memory;
+    Promise.resolve()
+      .then(() => job.run(getEngine(slot)))
+      .then(job.resolve, job.reject)
+      .finally(() => {
+        slot.busy = false;
+        reserved -= job.memory;
+        // The memory released may let jobs waiting on other slots start
+        slots.forEach(drain);
+      });
+  };
+
+  /**
+   * Queue a job on the least-loaded slot
+   * @param {(engine: object) => Promise<any>} run - Job body, receives the slot's engine
+   * @param {Object} [options]
+   * @param {number} [options.memory=0] - Bytes the job is expected to hold (see planJob)
+   * @returns {Promise<any>} Job result
+   */
+  const submit = (run, { memory = 0 } = {}) =>
+    new Promise((resolve, reject) => {
+      const target = slots.reduce((best, slot) => (backlog(slot) < backlog(best) ? slot : best));
+      target.queue.push({ run, memory, resolve, reject });
+
+      // Wake every idle slot so it can pick up (or steal) the new job
+      slots.forEach(drain);
+    });
+
+  /**
+   * Remove the password from many files in parallel
+   * @param {File[]} files - PDFs to unlock
+   * @param {string} password - Password shared by every file
+   * @param {Object} [callbacks]
+   * @param {Function} [callbacks.onFileProgress] - Per file: { index, file, status, error },
+   *   repeated while 'processing' with the engine's `progress` (see engine.removePassword)
+   * @param {Function} [callbacks.onProgress] - Aggregate: { completed, failed, total, bytes }
+   * @param {AbortSignal} [callbacks.signal] - Aborting stops the workers of running files and
+   *   settles queued ones without starting them; they count as failed, status 'cancelled'.
+   *   A file failing for lack of memory (see isMemoryError) is run once more on its own
+   * @param {Function} [callbacks.onResult] - (file, blob) => Promise, called as each file
+   *   finishes (e.g. to append it to a ZIP). Its worker takes no new job until the promise
+   *   settles, and the blob is not kept in the results, so memory stays bounded by the jobs
+   *   in flight rather than by the batch size
+   * @param {boolean} [callbacks.linearize] - Save every file for fast web view
+   * @param {boolean} [callbacks.compact] - Save every file compacted
+   * @returns {Promise<Array<{file: File, blob?: Blob, error?: Error}>>} Results in input order
+   */
+  const runBatch = async (
+    files,
+    password,
+    { onFileProgress, onProgress, signal, onResult, linearize, compact } = {},
+  ) => {
+    const progress = {
+      completed: 0,
+      failed: 0,
+      total: files.length,
+      bytesDone: 0,
+      bytesTotal: files.reduce((sum, file) => sum + file.size, 0),
+    };
+    const report = (index, status, error, fileProgress) => {
+      if (onFileProgress) {
+        onFileProgress({ index, file: files[index], status, error, progress: fileProgress });
+      }
+    };
+
+    // Largest files first keeps the tail of the batch short
+    const order = files.map((_, index) => index).sort((a, b) => files[b].size - files[a].size);
+    order.forEach((index) => report(index, 'queued'));
+    if (onProgress) onProgress({ ...progress });
+
+    // Files whose result has reached onResult; they are never run again
+    const handedOver = new Set();
+    // Each job holds its share of the memory budget until onResult has taken its blob
+    const runFile = (index, memory) =>
+      submit(
+        async (engine) => {
+          if (signal && signal.aborted) throw abortReason(signal);
+          report(index, 'processing');
+          // Only the File handle is posted; the worker reads it into its heap once
+          // it starts the job, so memory stays bounded
+          const blob = await engine.removePassword(files[index], password, {
+            signal,
+            linearize,
+            compact,
+            onProgress:
+              onFileProgress &&
+              ((fileProgress) => report(index, 'processing', undefined, fileProgress)),
+          });
+          if (!onResult) return blob;
+          handedOver.add(index);
+          await onResult(files[index], blob);
+          return undefined;
+        },
+        { memory },
+      );
+
+    const results = new Array(files.length);
+    await Promise.all(
+      order.map((index) =>
+        runFile(index, planJob(files[index]).memory)
+          .catch((error) => {
+            // Out of memory next to other jobs: once more, with the whole budget to itself
+            if (!isMemoryError(error) || handedOver.has(index) || (signal && signal.aborted)) {
+              throw error;
+            }
+            console.warn(`[Engine] ${files[index].name} ran out of memory, retrying it alone`);
+            return runFile(index, memoryBudget);
+          })
+          .then((blob) => {
+            results[index] = blob ? { file: files[index], blob } : { file: files[index] };
+            progress.completed += 1;
+            report(index, 'done');
+          })
+          .catch((error) => {
+            results[index] = { file: files[index], error };
+            progress.failed += 1;
+            report(index, error.name === 'AbortError' ? 'cancelled' : 'error', error);
+          })
+          .finally(() => {
+            progress.bytesDone += files[index].size;
+            if (onProgress) onProgress({ ...progress });
+          }),
+      ),
+    );
+
+    return results;
+  };
+
+  /**
+   * Find which of several candidate passwords opens a PDF
+   * Only /Encrypt and the trailer /ID are read; the candidates are split into one
+   * slice per worker and checked there with the key derivation alone, so no
+   * document is loaded until the caller decrypts with the winner
+   * @param {ArrayBuffer|Blob} source - PDF bytes or a File (read in windows, not copied)
+   * @param {string[]} passwords - Candidates
+   * @returns {Promise<{encrypted: boolean, index: number, password: string|null}>} The first
+   *   verified candidate found (`index` -1 when none verifies, or the file is not encrypted)
+   * @throws {Error} When the file uses a security handler the key check does not support
+   */
+  const findPassword = async (source, passwords) => {
+    const { readEncryption } = await loadEncryption();
+    const encryption = await readEncryption(source);
+    if (!encryption) return { encrypted: false, index: -1, password: null };
+
+    const sliceCount = Math.min(size, passwords.length);
+    if (!sliceCount) return { encrypted: true, index: -1, password: null };
+    const sliceLength = Math.ceil(passwords.length / sliceCount);
+    const slices = [];
+    for (let offset = 0; offset < passwords.length; offset += sliceLength) {
+      slices.push({ offset, candidates: passwords.slice(offset, offset + sliceLength) });
+    }
+
+    return new Promise((resolve, reject) => {
+      const checks = slices.map(({ offset, candidates }) =>
+        submit((engine) => engine.checkPasswords(encryption, candidates)).then((index) => {
+          // The first slice to verify a candidate wins; later replies are ignored
+          if (index < 0) return;
+          resolve({ encrypted: true, index: offset + index, password: candidates[index] });
+        }),
+      );
+      Promise.allSettled(checks).then((outcomes) => {
+        const failed = outcomes.find((outcome) => outcome.status === 'rejected');
+        if (failed) reject(failed.reason);
+        else resolve({ encrypted: true, index: -1, password: null });
+      });
+    });
+  };
+
+  /**
+   * Read triage metadata for many files, spread across the workers
+   * Each probe reads the trailer, /Encrypt and the page-tree root only (see
+   * pdf/probe.js), so a batch of thousands stays cheap; no PDFium is loaded
+   * @param {File[]} files - PDFs to probe
+   * @returns {Promise<Array<{file: File, probe?: Object, error?: Error}>>} In input order;
+   *   `probe` as from engine.probe, `error` for files whose trailer could not be read
+   */
+  const probeBatch = (files) =>
+    Promise.all(
+      files.map((file) =>
+        submit((engine) => engine.probe(file)).then(
+          (probe) => ({ file, probe }),
+          (error) => ({ file, error }),
+        ),
+      ),
+    );
+
+  /**
+   * Subscribe to the job reports of every worker in the pool
+   * @param {(metrics: Object) => void} listener - See pdfiumEngine addMetricsListener
+   * @returns {() => void} Unsubscribe
+   */
+  const addMetricsListener = (listener) => {
+    metricsListeners.add(listener);
+    return () => metricsListeners.delete(listener);
+  };
+
+  /**
+   * Stop every worker in the pool
+   */
+  const terminate = () => {
+    slots.forEach((slot) => {
+      if (slot.engine) slot.engine.terminate();
+      slot.engine = null;
+    });
+  };
+
+  return {
+    size,
+    submit,
+    runBatch,
+    findPassword,
+    probeBatch,
+    addMetricsListener,
+    terminate,
+  };
+};
+
+let sharedPool = null;
+
+/**
+ * Pool shared by the whole app (workers spawn on demand)
+ */
+export const getPdfiumPool = () => {
+  if (!sharedPool) sharedPool = createPdfiumPool();
+  return sharedPool;
+};
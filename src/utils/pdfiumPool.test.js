@@ -0,0 +1,416 @@
+/**
+ * Unit tests for the PDFium worker pool
+ * Tests job distribution, work stealing, the memory budget, batch progress reporting and
+ * batch probes
+ */
+
+import fs from 'fs';
+import path from 'path';
+import { createPdfiumPool } from './pdfiumPool';
+import { checkPasswords } from './pdf/encryption';
+import { probeDocument } from './pdf/probe';
+
+describe('createPdfiumPool', () => {
+  // Engine whose jobs stay pending until the test resolves them
+  const createDeferredEngine = () => {
+    const calls = [];
+    return {
+      calls,
+      terminate: jest.fn(),
+      removePassword: jest.fn(
+        (pdfData, password) =>
+          new Promise((resolve, reject) => calls.push({ pdfData, password, resolve, reject })),
+      ),
+    };
+  };
+
+  const flush = () => new Promise((resolve) => setTimeout(resolve, 0));
+
+  it('should size itself to navigator.hardwareConcurrency by default', () => {
+    Object.defineProperty(navigator, 'hardwareConcurrency', { value: 6, configurable: true });
+
+    expect(createPdfiumPool({ createEngine: createDeferredEngine }).size).toBe(6);
+
+    delete navigator.hardwareConcurrency;
+  });
+
+  it('should run one job per worker at a time', async () => {
+    const engines = [];
+    const pool = createPdfiumPool({
+      size: 2,
+      createEngine: () => {
+        const engine = createDeferredEngine();
+        engines.push(engine);
+        return engine;
+      },
+    });
+
+    const run = (engine) => engine.removePassword(new ArrayBuffer(1), 'pw');
+    pool.submit(run);
+    pool.submit(run);
+    pool.submit(run);
+    await flush();
+
+    expect(engines).toHaveLength(2);
+    expect(engines[0].calls).toHaveLength(1);
+    expect(engines[1].calls).toHaveLength(1);
+  });
+
+  it('should let an idle worker steal queued jobs from a busy one', async () => {
+    const engines = [];
+    const pool = createPdfiumPool({
+      size: 2,
+      createEngine: () => {
+        const engine = createDeferredEngine();
+        engines.push(engine);
+        return engine;
+      },
+    });
+
+    const run = (engine) => engine.removePassword(new ArrayBuffer(1), 'pw');
+    const jobs = [pool.submit(run), pool.submit(run), pool.submit(run), pool.submit(run)];
+    await flush();
+
+    // First worker finishes quickly, the second stays stuck on a huge file
+    engines[0].calls[0].resolve('a');
+    await flush();
+    engines[0].calls[1].resolve('b');
+    await flush();
+
+    expect(engines[0].calls).toHaveLength(3);
+    expect(engines[1].calls).toHaveLength(1);
+
+    engines[0].calls[2].resolve('c');
+    engines[1].calls[0].resolve('d');
+    await expect(Promise.all(jobs)).resolves.toHaveLength(4);
+  });
+
+  it('should hold jobs back while running ones fill the memory budget', async () => {
+    const engines = [];
+    const pool = createPdfiumPool({
+      size: 3,
+      memoryBudget: 100,
+      createEngine: () => {
+        const engine = createDeferredEngine();
+        engines.push(engine);
+        return engine;
+      },
+    });
+
+    const run = (engine) => engine.removePassword(new ArrayBuffer(1), 'pw');
+    const jobs = [
+      pool.submit(run, { memory: 60 }),
+      pool.submit(run, { memory: 60 }),
+      pool.submit(run, { memory: 30 }),
+    ];
+    await flush();
+
+    // The second job would take the pool over budget; the third still fits
+    expect(engines.map((engine) => engine.calls.length)).toEqual([1, 1]);
+
+    // Once the first job releases its memory, the second starts
+    engines[0].calls[0].resolve('a');
+    await flush();
+    expect(engines[0].calls).toHaveLength(2);
+
+    engines[0].calls[1].resolve('b');
+    engines[1].calls[0].resolve('c');
+    await expect(Promise.all(jobs)).resolves.toEqual(['a', 'b', 'c']);
+  });
+
+  it('should run a job larger than the whole budget on its own', async () => {
+    const engine = createDeferredEngine();
+    const pool = createPdfiumPool({ size: 2, memoryBudget: 10, createEngine: () => engine });
+
+    const job = pool.submit((e) => e.removePassword(new ArrayBuffer(1), 'pw'), { memory: 50 });
+    await flush();
+    expect(engine.calls).toHaveLength(1);
+
+    engine.calls[0].resolve('done');
+    await expect(job).resolves.toBe('done');
+  });
+
+  it('should retry a file that ran out of memory on its own', async () => {
+    const engines = [];
+    const pool = createPdfiumPool({
+      size: 2,
+      createEngine: () => {
+        const engine = createDeferredEngine();
+        engines.push(engine);
+        return engine;
+      },
+    });
+    const files = [new File(['aa'], 'a.pdf'), new File(['b'], 'b.pdf')];
+    const outOfMemory = Object.assign(new Error('No room'), { name: 'MemoryPressureError' });
+
+    const batch = pool.runBatch(files, 'pw');
+    await flush();
+    engines[0].calls[0].reject(outOfMemory);
+    await flush();
+
+    // The retry waits for the other file to finish
+    expect(engines.flatMap((engine) => engine.calls)).toHaveLength(2);
+    engines[1].calls[0].resolve(new Blob(['b']));
+    await flush();
+
+    expect(engines[0].calls).toHaveLength(2);
+    engines[0].calls[1].resolve(new Blob(['a']));
+    const results = await batch;
+
+    expect(results.every((result) => result.blob instanceof Blob)).toBe(true);
+  });
+
+  it('should report per-file and aggregate batch progress', async () => {
+    const pool = createPdfiumPool({
+      size: 2,
+      createEngine: () => ({
+        terminate: jest.fn(),
+        removePassword: jest.fn(async (pdfData, password) => {
+          if (password !== 'correct') throw new Error('Password required or incorrect password');
+          return new Blob([pdfData], { type: 'application/pdf' });
+        }),
+      }),
+    });
+
+    const files = [new File(['a'], 'a.pdf'), new File(['bbb'], 'b.pdf')];
+    const onFileProgress = jest.fn();
+    const onProgress = jest.fn();
+
+    const results = await pool.runBatch(files, 'correct', { onFileProgress, onProgress });
+
+    expect(results.map((result) => result.file)).toEqual(files);
+    expect(results.every((result) => result.blob instanceof Blob)).toBe(true);
+    expect(onFileProgress).toHaveBeenCalledWith(
+      expect.objectContaining({ index: 0, status: 'done' }),
+    );
+    expect(onProgress).toHaveBeenLastCalledWith({
+      completed: 2,
+      failed: 0,
+      total: 2,
+      bytesDone: 4,
+      bytesTotal: 4,
+    });
+  });
+
+  it('should hand each File to its worker without reading it', async () => {
+    const removePassword = jest.fn(async () => new Blob());
+    const pool = createPdfiumPool({
+      size: 1,
+      createEngine: () => ({ terminate: jest.fn(), removePassword }),
+    });
+    const file = new File(['a'], 'a.pdf');
+    const arrayBuffer = jest.spyOn(file, 'arrayBuffer');
+
+    await pool.runBatch([file], 'pw');
+
+    expect(removePassword).toHaveBeenCalledWith(file, 'pw', expect.any(Object));
+    expect(arrayBuffer).not.toHaveBeenCalled();
+  });
+
+  it('should keep going when a file fails', async () => {
+    const pool = createPdfiumPool({
+      size: 1,
+      createEngine: () => ({
+        terminate: jest.fn(),
+        removePassword: jest.fn(async () => {
+          throw new Error('Password required or incorrect password');
+        }),
+      }),
+    });
+
+    const files = [new File(['a'], 'a.pdf'), new File(['b'], 'b.pdf')];
+    const results = await pool.runBatch(files, 'wrong');
+
+    expect(results).toHaveLength(2);
+    expect(results.every((result) => result.error instanceof Error)).toBe(true);
+  });
+
+  it('should hand each result to onResult before the worker takes its next file', async () => {
+    const engine = createDeferredEngine();
+    const pool = createPdfiumPool({ size: 1, createEngine: () => engine });
+    const written = [];
+    let finishWrite;
+    const onResult = jest.fn(
+      (file) =>
+        new Promise((resolve) => {
+          finishWrite = () => {
+            written.push(file.name);
+            resolve();
+          };
+        }),
+    );
+
+    const files = [new File(['aa'], 'a.pdf'), new File(['b'], 'b.pdf')];
+    const batch = pool.runBatch(files, 'pw', { onResult });
+    await flush();
+    engine.calls[0].resolve(new Blob(['a']));
+    await flush();
+
+    // The first result is still being written, so the second file has not started
+    expect(engine.removePassword).toHaveBeenCalledTimes(1);
+    finishWrite();
+    await flush();
+    engine.calls[1].resolve(new Blob(['b']));
+    await flush();
+    finishWrite();
+    const results = await batch;
+
+    expect(written).toEqual(['a.pdf', 'b.pdf']);
+    expect(results).toEqual([{ file: files[0] }, { file: files[1] }]);
+  });
+
+  it('should mark files cancelled and skip queued ones when the batch is aborted', async () => {
+    const removePassword = jest.fn(
+      (pdfData, password, { signal }) =>
+        new Promise((resolve, reject) => {
+          signal.addEventListener('abort', () => reject(signal.reason));
+        }),
+    );
+    const pool = createPdfiumPool({
+      size: 1,
+      createEngine: () => ({ terminate: jest.fn(), removePassword }),
+    });
+    const controller = new AbortController();
+    const onFileProgress = jest.fn();
+
+    const files = [new File(['aa'], 'a.pdf'), new File(['b'], 'b.pdf')];
+    const batch = pool.runBatch(files, 'pw', { onFileProgress, signal: controller.signal });
+    await flush();
+    controller.abort();
+    const results = await batch;
+
+    expect(removePassword).toHaveBeenCalledTimes(1);
+    expect(results.every((result) => result.error.name === 'AbortError')).toBe(true);
+    const statuses = onFileProgress.mock.calls.map(([update]) => update.status);
+    expect(statuses.filter((status) => status === 'cancelled')).toHaveLength(2);
+  });
+
+  it('should forward job metrics from every engine to pool listeners', async () => {
+    const factories = [];
+    const pool = createPdfiumPool({
+      size: 2,
+      createEngine: ({ onMetrics }) => {
+        factories.push(onMetrics);
+        return { terminate: jest.fn(), removePassword: jest.fn(async () => new Blob()) };
+      },
+    });
+    const listener = jest.fn();
+    pool.addMetricsListener(listener);
+
+    await pool.runBatch([new File(['a'], 'a.pdf'), new File(['b'], 'b.pdf')], 'pw');
+    factories.forEach((onMetrics, index) => onMetrics({ engine: 'pdfium', bytesIn: index }));
+
+    expect(factories).toHaveLength(2);
+    expect(listener).toHaveBeenCalledWith({ engine: 'pdfium', bytesIn: 0 });
+    expect(listener).toHaveBeenCalledWith({ engine: 'pdfium', bytesIn: 1 });
+  });
+
+  describe('findPassword', () => {
+    const fixture = (name) =>
+      new Uint8Array(fs.readFileSync(path.join(process.cwd(), 'e2e/assets', name))).buffer;
+
+    // Engine whose key checks run in-process
+    const createCheckingEngine = () => ({
+      terminate: jest.fn(),
+      checkPasswords: jest.fn(checkPasswords),
+    });
+
+    it('should split the candidates across the workers', async () => {
+      const engines = [];
+      const pool = createPdfiumPool({
+        size: 2,
+        createEngine: () => {
+          const engine = createCheckingEngine();
+          engines.push(engine);
+          return engine;
+        },
+      });
+      const candidates = ['a', 'b', 'c', 'password'];
+
+      const match = await pool.findPassword(fixture('file-sample_150kB-protected.pdf'), candidates);
+
+      expect(match).toEqual({ encrypted: true, index: 3, password: 'password' });
+      const slices = engines.flatMap((engine) =>
+        engine.checkPasswords.mock.calls.map(([, passwords]) => passwords),
+      );
+      expect(slices).toEqual(expect.arrayContaining([['a', 'b'], ['c', 'password']]));
+    });
+
+    it('should report when no candidate verifies', async () => {
+      const pool = createPdfiumPool({ size: 3, createEngine: createCheckingEngine });
+
+      const candidates = ['a', 'b', 'c', 'd', 'e'];
+
+      const match = await pool.findPassword(fixture('file-sample_150kB-protected.pdf'), candidates);
+
+      expect(match).toEqual({ encrypted: true, index: -1, password: null });
+    });
+
+    it('should not ask the workers about unencrypted files', async () => {
+      const createEngine = jest.fn(createCheckingEngine);
+      const pool = createPdfiumPool({ size: 2, createEngine });
+
+      const match = await pool.findPassword(fixture('file-sample_150kB.pdf'), ['a']);
+
+      expect(match).toEqual({ encrypted: false, index: -1, password: null });
+      expect(createEngine).not.toHaveBeenCalled();
+    });
+
+    it('should reject when the key check is unsupported', async () => {
+      const pool = createPdfiumPool({
+        size: 2,
+        createEngine: () => ({
+          terminate: jest.fn(),
+          checkPasswords: jest.fn(async () => {
+            throw new Error('Unsupported security handler Adobe.PubSec');
+          }),
+        }),
+      });
+
+      await expect(
+        pool.findPassword(fixture('file-sample_150kB-protected.pdf'), ['a', 'b']),
+      ).rejects.toThrow('Unsupported security handler');
+    });
+  });
+
+  describe('probeBatch', () => {
+    const fixtureFile = (name) =>
+      new File([fs.readFileSync(path.join(process.cwd(), 'e2e/assets', name))], name);
+
+    it('should probe every file across the workers, in input order', async () => {
+      const engines = [];
+      const pool = createPdfiumPool({
+        size: 2,
+        createEngine: () => {
+          const engine = { terminate: jest.fn(), probe: jest.fn(probeDocument) };
+          engines.push(engine);
+          return engine;
+        },
+      });
+      const files = [
+        fixtureFile('file-sample_150kB.pdf'),
+        fixtureFile('file-sample_150kB-protected.pdf'),
+        new File(['not a PDF'], 'broken.pdf'),
+      ];
+
+      const results = await pool.probeBatch(files);
+
+      expect(results.map((result) => result.file)).toEqual(files);
+      expect(results[0].probe).toMatchObject({ pageCount: 4, encrypted: false });
+      expect(results[1].probe).toMatchObject({ encrypted: true, encryption: { revision: 4 } });
+      expect(results[2].error.message).toMatch('startxref');
+      expect(engines).toHaveLength(2);
+    });
+  });
+
+  it('should terminate every spawned engine', async () => {
+    const engine = createDeferredEngine();
+    const pool = createPdfiumPool({ size: 1, createEngine: () => engine });
+
+    pool.submit((e) => e.removePassword(new ArrayBuffer(1), 'pw'));
+    await flush();
+    pool.terminate();
+
+    expect(engine.terminate).toHaveBeenCalled();
+  });
+});
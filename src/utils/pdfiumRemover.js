@@ -11,73 +11,372 @@
  */
 
 import { init } from '@embedpdf/pdfium';
+import { createFileAccess, createFileRangeReader } from './pdfiumFileAccess';
+import { loadPdfiumWasm } from './pdfiumWasmLoader';
+import { passThrough } from './passThrough';
+import { stripSecurity } from './pdf/stripSecurity';
+import { compact as compactPdf } from './pdf/compact';
+import { linearize as linearizePdf } from './pdf/linearize';
+import { sniffEncryption } from './pdf/encryption';
+import {
+  getLargeDocumentVariant,
+  getMissingExports,
+  getPdfiumVariants,
+  LARGE_DOCUMENT_SIZE,
+  MEMORY64_MAX_HEAP_SIZE,
+  WASM32_MAX_FILE_SIZE,
+  WASM32_MAX_HEAP_SIZE,
+} from './pdfiumVariants';
+import { getPointerSize, initMemory64 } from './pdfiumMemory64';
+import { createJobMetrics } from './pdfiumMetrics';
+import { getPdfiumArena } from './pdfiumArena';
+import { createOutputBuffer } from './createOutputBuffer';
+import { MEMORY_ERROR_NAME, planHeap, planJob } from './pdfiumPlanner';
 
 // Constants
-const PDFIUM_WASM_URL = 'https://feijo.dev/pdf-password-remover/pdfium.wasm';
 const FPDF_REMOVE_SECURITY = 3;
 const FPDF_ERROR_PASSWORD_REQUIRED = 4;
 const FPDF_ERROR_NO_ERROR = 0;
 const FPDF_ERROR_UNKNOWN = 1;
-const FILEWRITE_STRUCT_SIZE = 8; // 4 bytes version + 4 bytes function pointer
-const FILEWRITE_VERSION = 1;
-const FILEWRITE_CALLBACK_SUCCESS = 1;
-const FILEWRITE_CALLBACK_FAILURE = 0;
+const PASSWORD_ERROR_MESSAGE = 'Password required or incorrect password';
+const TOO_LARGE_ERROR_MESSAGE =
+  'PDF is too large for this browser: it needs the 64-bit (memory64) PDFium build';
+const HEAP_FULL_ERROR_MESSAGE = 'Not enough PDFium memory left in this worker for the PDF';
+const HEAP_TOO_SMALL_ERROR_MESSAGE = 'PDF is too large for the memory PDFium can use here';
 
+// Promises of module instances by variant name, shared by concurrent callers
+const pdfiumInstances = new Map();
+// Promise of the preferred instance (first variant that loads)
 let pdfiumInstance = null;
+let activeVariant = null;
+let initMetrics = null;
+let recycleDue = false;
+
+// Documents kept in this context between password attempts, by id
+const residentDocuments = new Map();
+let nextDocumentId = 1;
+
+/**
+ * Time-to-ready of the current module instance
+ * `source` is 'cache', 'network' or 'file' (Node); `loadMs` covers fetch + compile, `initMs`
+ * instantiation
+ * @returns {{variant, source, streaming, loadMs, initMs, totalMs}|null}
+ */
+export const getPdfiumInitMetrics = () => initMetrics;
+
+/**
+ * Whether a PDFium heap in this context has outgrown its workload (see pdfiumArena.js)
+ * wasm memory never shrinks, so the owner should replace the worker
+ * @returns {boolean}
+ */
+export const isPdfiumRecycleDue = () => recycleDue;
+
+const loadVariant = async (variant) => {
+  const start = performance.now();
+  const { moduleOverrides, metrics, instantiationFailure } = await loadPdfiumWasm(variant.url, {
+    hash: variant.hash,
+  });
+
+  const initStart = performance.now();
+  // Builds with their own glue (memory64) check their exports when binding
+  const initializing = variant.glueUrl
+    ? initMemory64(variant.glueUrl, moduleOverrides)
+    : init(moduleOverrides);
+  const pdfium = await (instantiationFailure
+    ? Promise.race([initializing, instantiationFailure])
+    : initializing);
+
+  // Trimmed builds are only usable if they kept every entry point this path calls
+  if (variant.name !== 'full' && !variant.glueUrl) {
+    const missing = getMissingExports(pdfium.pdfium.wasmExports);
+    if (missing.length) {
+      throw new Error(`${variant.file} is missing ${missing.join(', ')}`);
+    }
+  }
+  pdfium.PDFiumExt_Init();
+
+  const end = performance.now();
+  return {
+    pdfium,
+    metrics: { variant: variant.name, ...metrics, initMs: end - initStart, totalMs: end - start },
+  };
+};
+
+const getVariantInstance = (variant) => {
+  if (!pdfiumInstances.has(variant.name)) {
+    pdfiumInstances.set(
+      variant.name,
+      loadVariant(variant).catch((err) => {
+        pdfiumInstances.delete(variant.name);
+        throw err;
+      }),
+    );
+  }
+  return pdfiumInstances.get(variant.name);
+};
+
+// Try each variant in order; the full build is last and its failure is final
+const loadPdfium = async () => {
+  const variants = getPdfiumVariants();
+
+  for (const [index, variant] of variants.entries()) {
+    try {
+      const { pdfium, metrics } = await getVariantInstance(variant);
+      activeVariant = variant.name;
+      initMetrics = metrics;
+      console.log(
+        '[PDFium] Ready in',
+        Math.round(metrics.totalMs),
+        'ms from',
+        metrics.source,
+        `(${variant.name})`,
+      );
+      return pdfium;
+    } catch (err) {
+      if (index === variants.length - 1) throw err;
+      console.warn(`[PDFium] ${variant.name} build unavailable, falling back:`, err.message);
+    }
+  }
+};
 
 /**
  * Initialize pdfium WebAssembly module
+ * Safe to call repeatedly; a failed load is retried on the next call
+ * @param {Object} [options]
+ * @param {string} [options.variant] - Load this build instead of the preferred one
  */
-const initPdfium = async () => {
-  if (pdfiumInstance) return pdfiumInstance;
+export const initPdfium = ({ variant } = {}) => {
+  if (variant) {
+    const match = [...getPdfiumVariants(), getLargeDocumentVariant()].find(
+      (candidate) => candidate && candidate.name === variant,
+    );
+    if (!match) return Promise.reject(new Error(`Unknown PDFium build: ${variant}`));
+    return getVariantInstance(match).then((instance) => instance.pdfium);
+  }
 
-  try {
-    const response = await fetch(PDFIUM_WASM_URL);
-    const wasmBinary = await response.arrayBuffer();
+  if (!pdfiumInstance) {
+    pdfiumInstance = loadPdfium().catch((err) => {
+      console.error('[PDFium] Failed to initialize:', err);
+      pdfiumInstance = null;
+      throw err;
+    });
+  }
+  return pdfiumInstance;
+};
 
-    pdfiumInstance = await init({ wasmBinary });
-    pdfiumInstance.PDFiumExt_Init();
+const sizeOf = (source) => source.byteLength ?? source.size;
 
-    return pdfiumInstance;
-  } catch (err) {
-    console.error('[PDFium] Failed to initialize:', err);
-    throw err;
+// Small files are read into the heap; from a size set by device memory, on demand
+const isOnDemand = (source) => planJob(source).onDemand;
+
+/**
+ * Build for one PDFium job, picked before anything is downloaded
+ * From LARGE_DOCUMENT_SIZE up the memory64 build is used when the bundle ships
+ * one this browser can run. Otherwise a wasm32 build takes heap copies up to its
+ * heap limit and on-demand Files up to the 32-bit FPDF_FILEACCESS length
+ * @returns {string|undefined} Variant name, or undefined for the preferred build
+ * @throws {Error} When no build can take the document
+ */
+const selectVariant = (source) => {
+  const size = sizeOf(source);
+  if (size >= LARGE_DOCUMENT_SIZE) {
+    const large = getLargeDocumentVariant();
+    if (large) return large.name;
   }
+  const limit = isOnDemand(source) ? WASM32_MAX_FILE_SIZE : WASM32_MAX_HEAP_SIZE;
+  if (size > limit) throw new Error(TOO_LARGE_ERROR_MESSAGE);
+  return undefined;
 };
 
+// Largest heap `pdfium`'s build can grow to
+const heapLimitOf = (pdfium) =>
+  getPointerSize(pdfium) === 8 ? MEMORY64_MAX_HEAP_SIZE : WASM32_MAX_HEAP_SIZE;
+
+const memoryError = (message) => Object.assign(new Error(message), { name: MEMORY_ERROR_NAME });
+
 /**
- * Remove password from encrypted PDF using FPDF_SaveAsCopy
- * @param {ArrayBuffer} pdfData - PDF file as ArrayBuffer
- * @param {string} password - PDF password
- * @returns {Promise<Blob>} - Decrypted PDF as Blob
+ * Check a job against the heap of `pdfium` (see planHeap)
  */
-export const pdfiumRemover = async (pdfData, password) => {
-  const pdfium = await initPdfium();
-  const wasmExports = pdfium.pdfium.wasmExports;
-  const wasmMemory = pdfium.pdfium.wasmExports.memory.buffer;
+const checkHeap = (pdfium, source) =>
+  planHeap({
+    size: sizeOf(source),
+    onDemand: isOnDemand(source),
+    canStream: source instanceof Blob,
+    heapBytes: pdfium.pdfium.wasmExports.memory.buffer.byteLength,
+    heapLimit: heapLimitOf(pdfium),
+    reusableBytes: getPdfiumArena(pdfium).getReusableInputCapacity(),
+  });
+
+/**
+ * Admit a job onto `pdfium` before anything is allocated for it, so a file the
+ * heap cannot take fails this job alone instead of trapping inside malloc
+ * @returns {boolean} Whether to load the document on demand
+ * @throws {Error} When no heap of this build can take the job; named
+ *   MEMORY_ERROR_NAME when only this one is too full, and the worker is then
+ *   flagged for recycling so the job can run again on a fresh one
+ */
+const admitJob = (pdfium, source, metrics) => {
+  const plan = checkHeap(pdfium, source);
+  metrics.set({ memoryPlan: plan });
+  if (plan.decision === 'queue') {
+    recycleDue = true;
+    throw memoryError(HEAP_FULL_ERROR_MESSAGE);
+  }
+  if (plan.decision === 'reject') throw new Error(HEAP_TOO_SMALL_ERROR_MESSAGE);
+  if (plan.decision === 'stream') {
+    console.warn('[PDFium] No heap room for a copy, reading the file on demand');
+    return true;
+  }
+  return isOnDemand(source);
+};
 
-  // Allocate memory for PDF data
-  const pdfSize = pdfData.byteLength;
-  const filePtr = wasmExports.malloc(pdfSize);
-  const heapBytes = new Uint8Array(wasmMemory, filePtr, pdfSize);
-  heapBytes.set(new Uint8Array(pdfData));
+/**
+ * Copy an input into the heap at `ptr`
+ * A File/Blob is read from its stream chunk by chunk straight into the heap, so
+ * its bytes are copied once, with no intermediate ArrayBuffer
+ */
+const copyIntoHeap = async (wasmExports, source, ptr) => {
+  if (!(source instanceof Blob)) {
+    new Uint8Array(wasmExports.memory.buffer, ptr, source.byteLength).set(new Uint8Array(source));
+    return;
+  }
+  if (typeof source.stream !== 'function') {
+    // No Blob streams: one intermediate buffer
+    const bytes = new Uint8Array(await source.arrayBuffer());
+    new Uint8Array(wasmExports.memory.buffer, ptr, source.size).set(bytes);
+    return;
+  }
+
+  const reader = source.stream().getReader();
+  let offset = 0;
+  for (;;) {
+    const { done, value } = await reader.read();
+    if (done) break;
+    if (offset + value.length > source.size) throw new Error('File changed while reading');
+    // A fresh view per chunk: the heap may grow between reads
+    new Uint8Array(wasmExports.memory.buffer, ptr + offset, value.length).set(value);
+    offset += value.length;
+  }
+  if (offset !== source.size) throw new Error('File changed while reading');
+};
+
+/**
+ * Keep a document in this context for repeated password attempts
+ * The input is copied into the heap once, here, so later attempts only rerun
+ * FPDF_LoadMemDocument; the source also stays available to the strip engine.
+ * Files the planner sends on demand stay a handle that PDFium reads as needed
+ * @param {ArrayBuffer|Blob} source - PDF bytes or a File/Blob
+ * @returns {Promise<number>} Document id for removeSecurity's `document` option
+ */
+export const openDocument = async (source) => {
+  const document = { source, heap: null };
+  const pdfium = isOnDemand(source) ? null : await initPdfium();
+  // Without room for a copy the job decides later, on the heap it finds then
+  if (pdfium && checkHeap(pdfium, source).decision === 'admit') {
+    const wasmExports = pdfium.pdfium.wasmExports;
+    const size = sizeOf(source);
+    const ptr = wasmExports.malloc(size);
+    if (!ptr) throw new Error(`Out of wasm memory for a ${size} byte input`);
+    try {
+      await copyIntoHeap(wasmExports, source, ptr);
+    } catch (err) {
+      wasmExports.free(ptr);
+      throw err;
+    }
+    document.heap = { pdfium, ptr };
+  }
+  const id = nextDocumentId++;
+  residentDocuments.set(id, document);
+  return id;
+};
+
+/**
+ * Release a document kept by openDocument, including its heap copy
+ * @returns {boolean} Whether the document was open
+ */
+export const closeDocument = (id) => {
+  const document = residentDocuments.get(id);
+  if (!document) return false;
+  residentDocuments.delete(id);
+  if (document.heap) document.heap.pdfium.pdfium.wasmExports.free(document.heap.ptr);
+  return true;
+};
+
+/**
+ * Load a document from a heap copy, or on demand for large files
+ * The returned `release` must run after FPDF_CloseDocument
+ * @param {{pdfium: Object, ptr: number}} [resident] - Heap copy made by openDocument
+ * @returns {Promise<{docPtr: number, release: () => void}>}
+ * @throws {Error} When the heap cannot take the job (see admitJob)
+ */
+const loadDocument = async (pdfium, source, password, metrics, resident) => {
+  const wasmExports = pdfium.pdfium.wasmExports;
 
   // Use password string directly or undefined for no password
   const passwordPtr = password || 0;
 
+  // Resident copies belong to one module instance; a retry on another build copies again
+  if (resident && resident.pdfium === pdfium) {
+    const docPtr = metrics.span('load', () =>
+      pdfium.FPDF_LoadMemDocument(resident.ptr, sizeOf(source), passwordPtr),
+    );
+    return { docPtr, release: () => {} };
+  }
+
+  if (admitJob(pdfium, source, metrics)) {
+    // Ranges are read from the file as PDFium asks for them
+    const fileAccess = createFileAccess(pdfium, {
+      size: source.size,
+      readBlock: createFileRangeReader(source),
+    });
+    const docPtr = metrics.span('load', () =>
+      pdfium.FPDF_LoadCustomDocument(fileAccess.ptr, passwordPtr),
+    );
+    return { docPtr, release: fileAccess.release };
+  }
+
+  // Copy into the arena's input buffer, reused across jobs on this instance
+  const pdfSize = sizeOf(source);
+  const input = getPdfiumArena(pdfium).acquireInput(pdfSize);
+
   try {
-    // Load PDF document with password
-    const docPtr = pdfium.FPDF_LoadMemDocument(filePtr, pdfSize, passwordPtr);
+    await metrics.span('copy', () => copyIntoHeap(wasmExports, source, input.ptr));
+    const docPtr = metrics.span('load', () =>
+      pdfium.FPDF_LoadMemDocument(input.ptr, pdfSize, passwordPtr),
+    );
+    return { docPtr, release: input.release };
+  } catch (err) {
+    input.release();
+    throw err;
+  }
+};
+
+/**
+ * Decrypt-and-save on one module instance
+ */
+const saveWithoutSecurity = async (
+  pdfium,
+  source,
+  password,
+  { onChunk, onProgress, metrics, resident },
+) => {
+  const wasmExports = pdfium.pdfium.wasmExports;
+  metrics.trackMemory(wasmExports.memory);
+
+  // Load PDF document with password
+  const { docPtr, release } = await loadDocument(pdfium, source, password, metrics, resident);
+  let writer = null;
 
+  try {
     if (!docPtr) {
       const errorCode = pdfium.FPDF_GetLastError();
 
       if (errorCode === FPDF_ERROR_PASSWORD_REQUIRED) {
-        throw new Error('Password required or incorrect password');
+        throw new Error(PASSWORD_ERROR_MESSAGE);
       }
       if (errorCode === FPDF_ERROR_NO_ERROR || errorCode === FPDF_ERROR_UNKNOWN) {
         // PDF has no password or error loading, return as-is
-        return new Blob([pdfData], { type: 'application/pdf' });
+        return await passThrough(source, onChunk);
       }
       throw new Error(`Failed to load PDF: error code ${errorCode}`);
     }
@@ -88,55 +387,254 @@ export const pdfiumRemover = async (pdfData, password) => {
       throw new Error('Invalid PDF or unable to access pages');
     }
 
-    // Collect PDF output chunks
-    const savedPdfChunks = [];
-
-    // Create FPDF_FILEWRITE structure
-    const fileWritePtr = wasmExports.malloc(FILEWRITE_STRUCT_SIZE);
-    const view = new DataView(wasmMemory);
-    view.setInt32(fileWritePtr, FILEWRITE_VERSION, true);
+    // Buffered output is appended straight from the heap; the output is usually
+    // close to the input in size, so it may be as large as the documents the build takes
+    const sizeHint = sizeOf(source);
+    const output = onChunk
+      ? null
+      : createOutputBuffer({ sizeHint, maxByteLength: heapLimitOf(pdfium) });
 
-    // Write callback for PDF chunks
-    const writeBlockCallback = pdfium.pdfium.addFunction((pThis, dataPtr, size) => {
+    // Route the instance's shared FPDF_FILEWRITE to this job
+    let bytesWritten = 0;
+    let writeError = null;
+    writer = getPdfiumArena(pdfium).acquireWriter((data) => {
+      metrics.recordChunk(data.length);
+      bytesWritten += data.length;
+      if (onProgress) onProgress({ bytesWritten });
       try {
-        const data = new Uint8Array(wasmMemory, dataPtr, size);
-        savedPdfChunks.push(new Uint8Array(data));
-        return FILEWRITE_CALLBACK_SUCCESS;
+        if (onChunk) {
+          onChunk(new Uint8Array(data));
+        } else {
+          output.append(data);
+        }
       } catch (err) {
-        console.error('[PDFium] WriteBlock error:', err);
-        return FILEWRITE_CALLBACK_FAILURE;
+        writeError = err;
+        throw err;
       }
-    }, 'iiii');
-
-    view.setInt32(fileWritePtr + 4, writeBlockCallback, true);
+    });
 
     // Save PDF without security
-    const saveResult = pdfium.FPDF_SaveAsCopy(docPtr, fileWritePtr, FPDF_REMOVE_SECURITY);
+    const saveResult = metrics.span('save', () =>
+      pdfium.FPDF_SaveAsCopy(docPtr, writer.ptr, FPDF_REMOVE_SECURITY),
+    );
 
     if (!saveResult) {
-      throw new Error('Failed to save PDF copy');
-    }
-
-    // Combine chunks into single buffer
-    const totalSize = savedPdfChunks.reduce((sum, chunk) => sum + chunk.length, 0);
-    const savedPdfData = new Uint8Array(totalSize);
-    let offset = 0;
-    for (const chunk of savedPdfChunks) {
-      savedPdfData.set(chunk, offset);
-      offset += chunk.length;
+      // A failed write (e.g. the output buffer could not grow) explains the failure best
+      throw writeError || new Error('Failed to save PDF copy');
     }
 
-    // Cleanup
-    pdfium.pdfium.removeFunction(writeBlockCallback);
-    wasmExports.free(fileWritePtr);
-    pdfium.FPDF_CloseDocument(docPtr);
+    // Streamed output has already been handed to the sink chunk by chunk
+    if (onChunk) return null;
 
-    return new Blob([savedPdfData], { type: 'application/pdf' });
+    return metrics.span('finish', () => output.finish());
   } catch (err) {
     console.error('[PDFium] Decryption error:', err.message);
     throw err;
   } finally {
-    // Always clean up allocated memory
-    wasmExports.free(filePtr);
+    // Always clean up, document first: a custom input must outlive it
+    if (writer) writer.release();
+    if (docPtr) pdfium.FPDF_CloseDocument(docPtr);
+    release();
+    if (getPdfiumArena(pdfium).isRecycleDue()) recycleDue = true;
+  }
+};
+
+// Engine selection and fallbacks for one job
+const runRemoveSecurity = async (
+  source,
+  password,
+  { onChunk, onProgress, mode, metrics, resident },
+) => {
+  let streamed = false;
+  const sink = onChunk
+    ? (chunk) => {
+        streamed = true;
+        return onChunk(chunk);
+      }
+    : undefined;
+  const progressOf = (engine) => onProgress && ((update) => onProgress({ engine, ...update }));
+
+  // Unencrypted files go back as they are, before either engine reads them
+  const encrypted = await metrics.span('sniff', () => sniffEncryption(source).catch(() => null));
+  if (encrypted === false) {
+    metrics.set({ engine: 'passthrough' });
+    return passThrough(source, sink);
+  }
+
+  if (mode !== 'pdfium') {
+    try {
+      metrics.set({ engine: 'strip' });
+      const stripSink = sink
+        ? (chunk) => {
+            metrics.recordChunk(chunk.byteLength);
+            return sink(chunk);
+          }
+        : undefined;
+      return await metrics.span('strip', () =>
+        stripSecurity(source, password, { onChunk: stripSink, onProgress: progressOf('strip') }),
+      );
+    } catch (err) {
+      // PDFium has the last word, including on passwords, unless output already left
+      if (mode === 'strip' || streamed) throw err;
+      console.warn('[PDFium] Security strip unavailable, using PDFium:', err.message);
+    }
   }
+
+  const variant = selectVariant(source);
+  const pdfium = await metrics.span('init', () => initPdfium({ variant }));
+  metrics.set({ engine: 'pdfium', variant: variant || activeVariant });
+  try {
+    return await saveWithoutSecurity(pdfium, source, password, {
+      onChunk: sink,
+      onProgress: progressOf('pdfium'),
+      metrics,
+      resident,
+    });
+  } catch (err) {
+    // A trimmed build gets one retry on the full build, unless output already left;
+    // the full build cannot take what needed the memory64 one, nor a job the heap refused
+    if (
+      variant ||
+      activeVariant === 'full' ||
+      streamed ||
+      err.message === PASSWORD_ERROR_MESSAGE ||
+      err.message === HEAP_TOO_SMALL_ERROR_MESSAGE ||
+      err.name === MEMORY_ERROR_NAME
+    ) {
+      throw err;
+    }
+    console.warn(`[PDFium] ${activeVariant} build failed, retrying with the full build`);
+    const fullPdfium = await metrics.span('init', () => initPdfium({ variant: 'full' }));
+    metrics.set({ variant: 'full' });
+    return saveWithoutSecurity(fullPdfium, source, password, {
+      onChunk: sink,
+      onProgress: progressOf('pdfium'),
+      metrics,
+      resident,
+    });
+  }
+};
+
+// Optional rewrites of an unlocked file, in the order they run
+const OUTPUT_REWRITES = [
+  { name: 'compact', label: 'Compaction', rewrite: compactPdf },
+  { name: 'linearize', label: 'Linearization', rewrite: linearizePdf },
+];
+
+/**
+ * Run the rewrites `options` asks for over an unlocked file; one that is not
+ * possible leaves the file as it was. Only the last one streams to `onChunk`
+ */
+const rewriteOutput = async (unlocked, options, onChunk, metrics) => {
+  const steps = OUTPUT_REWRITES.filter(({ name }) => options[name]);
+  let result = unlocked;
+  for (const [index, { name, label, rewrite }] of steps.entries()) {
+    const sink = index === steps.length - 1 ? onChunk : undefined;
+    try {
+      result = await metrics.span(name, () => rewrite(result, { onChunk: sink }));
+    } catch (err) {
+      console.warn(`[PDFium] ${label} unavailable, saving as is:`, err.message);
+      result = await passThrough(result, sink);
+    }
+  }
+  return result;
+};
+
+/**
+ * Remove password from encrypted PDF using FPDF_SaveAsCopy
+ * @param {ArrayBuffer|Blob} source - PDF bytes, or a File/Blob: read from its stream into
+ *   the heap, or when large for this device (see planJob) loaded on demand through
+ *   FPDF_LoadCustomDocument (worker only, needs FileReaderSync or a reader from
+ *   registerFileRangeReader). Documents
+ *   from LARGE_DOCUMENT_SIZE up go to the memory64 build where there is one (see selectVariant)
+ * @param {string} password - PDF password
+ * @param {Object} [options]
+ * @param {(chunk: Uint8Array) => void|Promise<void>} [options.onChunk] - Streaming sink; when
+ *   set, every chunk is handed over as it is produced and nothing is buffered here. The strip
+ *   engine and the rewrites hold the next object back until a promise it returns settles;
+ *   PDFium writes from inside FPDF_SaveAsCopy and cannot wait
+ * @param {'auto'|'strip'|'pdfium'} [options.mode='auto'] - Engine: 'strip' rewrites only the
+ *   encrypted strings and streams (src/utils/pdf), 'pdfium' re-saves through FPDF_SaveAsCopy,
+ *   'auto' tries the strip first and falls back to PDFium
+ * @param {(metrics: Object) => void} [options.onMetrics] - Receives the job report (stage
+ *   spans, wasm heap high-water mark, chunk histogram, bytes in/out), also on failure;
+ *   see pdfiumMetrics.js
+ * @param {number} [options.document] - Id from openDocument; its bytes replace `source`
+ *   and its heap copy is loaded in place
+ * @param {(progress: Object) => void} [options.onProgress] - Called as output is written:
+ *   `{engine, bytesWritten, bytesTotal}`, plus `objectsDone` / `objectsTotal` from the strip
+ *   engine. `bytesTotal` is the input size, an estimate of the output's; PDFium writes
+ *   objects from inside FPDF_SaveAsCopy without reporting them, so bytes are its measure
+ * @param {boolean} [options.linearize] - Rewrite the output for fast web view (first page
+ *   up front, see pdf/linearize.js). The unlocked file is buffered for the rewrite, and
+ *   saved as it is when it cannot be linearized
+ * @param {boolean} [options.compact] - Rewrite the output to take less space: identical
+ *   streams merged, other objects packed into object streams (see pdf/compact.js). Buffered
+ *   like `linearize`, and runs before it; linearization unpacks the object streams again,
+ *   so together only the merging remains
+ * @returns {Promise<ArrayBuffer|null>} - Decrypted PDF bytes (the input itself when not
+ *   encrypted), or null when the output was streamed through `onChunk`
+ */
+export const removeSecurity = async (
+  source,
+  password,
+  {
+    onChunk,
+    mode = 'auto',
+    onMetrics,
+    document,
+    onProgress,
+    linearize = false,
+    compact = false,
+  } = {},
+) => {
+  const resident = document === undefined ? null : residentDocuments.get(document);
+  if (document !== undefined && !resident) throw new Error(`Document ${document} is not open`);
+  const input = resident ? resident.source : source;
+
+  const metrics = createJobMetrics({ bytesIn: sizeOf(input) });
+  const bytesTotal = sizeOf(input);
+  let streamedBytes = 0;
+  const report = (outcome) => {
+    if (onMetrics) onMetrics(metrics.finish(outcome));
+  };
+
+  const sink =
+    onChunk &&
+    ((chunk) => {
+      streamedBytes += chunk.byteLength;
+      // Chunks are transferred; a view of resident bytes has to be copied first
+      return onChunk(resident && chunk.buffer === input ? chunk.slice() : chunk);
+    });
+
+  try {
+    let result = await runRemoveSecurity(input, password, {
+      onChunk: linearize || compact ? undefined : sink,
+      onProgress: onProgress && ((update) => onProgress({ ...update, bytesTotal })),
+      mode,
+      metrics,
+      resident: resident && resident.heap,
+    });
+    if (linearize || compact) {
+      result = await rewriteOutput(result, { compact, linearize }, sink, metrics);
+    }
+    // Unencrypted input comes back as is; resident bytes must survive the transfer too
+    if (resident && result === input) result = input.slice(0);
+    report({ bytesOut: result ? result.byteLength : streamedBytes });
+    return result;
+  } catch (err) {
+    report({ bytesOut: streamedBytes, error: err });
+    throw err;
+  }
+};
+
+/**
+ * Remove password from encrypted PDF using FPDF_SaveAsCopy
+ * @param {ArrayBuffer|Blob} pdfData - PDF file as ArrayBuffer, or a File to load on demand
+ * @param {string} password - PDF password
+ * @returns {Promise<Blob>} - Decrypted PDF as Blob
+ */
+export const pdfiumRemover = async (pdfData, password) => {
+  const savedPdfData = await removeSecurity(pdfData, password);
+  return new Blob([savedPdfData], { type: 'application/pdf' });
 };
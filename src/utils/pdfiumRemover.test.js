@@ -7,10 +7,34 @@
  * the function is callable and handles basic error cases.
  */
 
-import { pdfiumRemover } from './pdfiumRemover';
+import fs from 'fs';
+import path from 'path';
+import {
+  closeDocument,
+  initPdfium,
+  isPdfiumRecycleDue,
+  openDocument,
+  pdfiumRemover,
+  removeSecurity,
+} from './pdfiumRemover';
+import { WASM32_MAX_HEAP_SIZE } from './pdfiumVariants';
+import { getPdfiumArena } from './pdfiumArena';
+import { buildLinearizedPdf } from './pdf/testPdf';
 
 // The @embedpdf/pdfium module is mocked in setupTests.js
 
+// Files from 64 bytes up count as large, so tests can cover on-demand loading
+jest.mock('./pdfiumPlanner', () => {
+  const actual = jest.requireActual('./pdfiumPlanner');
+  return {
+    ...actual,
+    planJob: (source, device) => ({
+      ...actual.planJob(source, device),
+      onDemand: source.size >= 64,
+    }),
+  };
+});
+
 describe('pdfiumRemover', () => {
   beforeEach(() => {
     jest.clearAllMocks();
@@ -27,7 +51,7 @@ describe('pdfiumRemover', () => {
         // Acceptable - function still attempts to fetch
       }
 
-      expect(mockFetch).toHaveBeenCalledWith('https://feijo.dev/pdf-password-remover/pdfium.wasm');
+      expect(mockFetch).toHaveBeenCalledWith('http://localhost/pdfium.wasm');
     });
   });
 
@@ -99,4 +123,399 @@ describe('pdfiumRemover', () => {
       }
     });
   });
+
+  describe('On-demand Input', () => {
+    beforeEach(() => {
+      global.FileReaderSync = jest.fn(() => ({
+        readAsArrayBuffer: (blob) => new ArrayBuffer(blob.size),
+      }));
+    });
+
+    afterEach(() => {
+      delete global.FileReaderSync;
+    });
+
+    it('should load File inputs through FPDF_LoadCustomDocument', async () => {
+      const file = new File([new Uint8Array(100)], 'large.pdf');
+
+      await removeSecurity(file, 'password').catch(() => {});
+
+      const pdfium = await initPdfium();
+      expect(pdfium.FPDF_LoadCustomDocument).toHaveBeenCalledWith(expect.any(Number), 'password');
+      expect(pdfium.FPDF_LoadMemDocument).not.toHaveBeenCalled();
+    });
+  });
+
+  describe('Large Documents', () => {
+    it('should fail fast when no build can take the document', async () => {
+      const file = new File([new Uint8Array(100)], 'huge.pdf');
+      Object.defineProperty(file, 'size', { value: 5 * 1024 * 1024 * 1024 });
+
+      await expect(removeSecurity(file, 'password', { mode: 'pdfium' })).rejects.toThrow(
+        'too large for this browser',
+      );
+
+      const pdfium = await initPdfium();
+      expect(pdfium.FPDF_LoadCustomDocument).not.toHaveBeenCalled();
+    });
+  });
+
+  describe('Memory Guard', () => {
+    let pdfium;
+    let memory;
+    let reusable;
+
+    // Make the heap look `byteLength` bytes large for the next job
+    const fillHeap = (byteLength) => {
+      const buffer = new ArrayBuffer(memory.buffer.byteLength);
+      Object.defineProperty(buffer, 'byteLength', { value: byteLength });
+      pdfium.pdfium.wasmExports.memory = { buffer };
+    };
+
+    beforeEach(async () => {
+      pdfium = await initPdfium();
+      memory = pdfium.pdfium.wasmExports.memory;
+      // Earlier jobs leave an input buffer behind; these cases start without one
+      reusable = jest.spyOn(getPdfiumArena(pdfium), 'getReusableInputCapacity');
+      reusable.mockReturnValue(0);
+    });
+
+    afterEach(() => {
+      reusable.mockRestore();
+      pdfium.pdfium.wasmExports.memory = memory;
+      delete global.FileReaderSync;
+    });
+
+    it('should read a File on demand when the heap has no room for a copy', async () => {
+      global.FileReaderSync = jest.fn(() => ({
+        readAsArrayBuffer: (blob) => new ArrayBuffer(blob.size),
+      }));
+      fillHeap(WASM32_MAX_HEAP_SIZE - 16);
+      const onMetrics = jest.fn();
+
+      await removeSecurity(new File([new Uint8Array(32)], 'small.pdf'), 'password', {
+        mode: 'pdfium',
+        onMetrics,
+      }).catch(() => {});
+
+      expect(pdfium.FPDF_LoadCustomDocument).toHaveBeenCalled();
+      expect(pdfium.FPDF_LoadMemDocument).not.toHaveBeenCalled();
+      expect(onMetrics.mock.calls[0][0].memoryPlan).toEqual({
+        decision: 'stream',
+        estimatedPeakBytes: WASM32_MAX_HEAP_SIZE - 8,
+      });
+    });
+
+    it('should fail a job only this heap is too full for and ask for a fresh worker', async () => {
+      fillHeap(WASM32_MAX_HEAP_SIZE - 1024);
+
+      const error = await removeSecurity(new ArrayBuffer(1024), 'password', {
+        mode: 'pdfium',
+      }).catch((err) => err);
+
+      expect(error.name).toBe('MemoryPressureError');
+      expect(isPdfiumRecycleDue()).toBe(true);
+      expect(pdfium.pdfium.wasmExports.malloc).not.toHaveBeenCalledWith(1024);
+    });
+
+    it('should admit a buffer that fits the idle input buffer of a full heap', async () => {
+      fillHeap(WASM32_MAX_HEAP_SIZE - 1024);
+      reusable.mockReturnValue(1024 * 1024);
+
+      await removeSecurity(new ArrayBuffer(1024), 'password', { mode: 'pdfium' }).catch(() => {});
+
+      expect(pdfium.FPDF_LoadMemDocument).toHaveBeenCalled();
+    });
+
+    it('should refuse a buffer no heap of the build can take before allocating', async () => {
+      const huge = new ArrayBuffer(8);
+      Object.defineProperty(huge, 'byteLength', { value: WASM32_MAX_HEAP_SIZE - 1024 });
+
+      await expect(removeSecurity(huge, 'password', { mode: 'pdfium' })).rejects.toThrow(
+        'too large for the memory PDFium can use',
+      );
+      expect(pdfium.FPDF_LoadMemDocument).not.toHaveBeenCalled();
+    });
+  });
+
+  describe('File Input', () => {
+    it('should read small Files from their stream straight into the heap', async () => {
+      const pdfium = await initPdfium();
+      const chunks = [Uint8Array.of(1, 2, 3), new Uint8Array(45).fill(4)];
+      const file = new File([new Uint8Array(48)], 'small.pdf');
+      file.stream = () => ({
+        getReader: () => ({
+          read: async () => (chunks.length ? { value: chunks.shift() } : { done: true }),
+        }),
+      });
+      file.arrayBuffer = jest.fn();
+
+      await removeSecurity(file, 'password', { mode: 'pdfium' }).catch(() => {});
+
+      const [ptr, size] = pdfium.FPDF_LoadMemDocument.mock.calls[0];
+      const heap = new Uint8Array(pdfium.pdfium.wasmExports.memory.buffer, ptr, size);
+      expect(size).toBe(48);
+      expect(Array.from(heap.subarray(0, 4))).toEqual([1, 2, 3, 4]);
+      expect(file.arrayBuffer).not.toHaveBeenCalled();
+    });
+
+    it('should reject a File that changed size while being read', async () => {
+      const file = new File([new Uint8Array(8)], 'small.pdf');
+      const chunks = [new Uint8Array(16)];
+      file.stream = () => ({
+        getReader: () => ({
+          read: async () => (chunks.length ? { value: chunks.shift() } : { done: true }),
+        }),
+      });
+
+      await expect(removeSecurity(file, 'password', { mode: 'pdfium' })).rejects.toThrow(
+        'File changed while reading',
+      );
+    });
+  });
+
+  describe('Resident Documents', () => {
+    it('should copy the document into the heap once across attempts', async () => {
+      const pdfium = await initPdfium();
+      const { malloc } = pdfium.pdfium.wasmExports;
+      const document = await openDocument(new ArrayBuffer(100));
+      const ptr = malloc.mock.results[0].value;
+
+      await removeSecurity(null, 'wrong', { mode: 'pdfium', document }).catch(() => {});
+      await removeSecurity(null, 'password', { mode: 'pdfium', document }).catch(() => {});
+
+      expect(malloc.mock.calls.filter(([size]) => size === 100)).toHaveLength(1);
+      expect(pdfium.FPDF_LoadMemDocument).toHaveBeenCalledTimes(2);
+      expect(pdfium.FPDF_LoadMemDocument).toHaveBeenNthCalledWith(1, ptr, 100, 'wrong');
+      expect(pdfium.FPDF_LoadMemDocument).toHaveBeenNthCalledWith(2, ptr, 100, 'password');
+
+      expect(closeDocument(document)).toBe(true);
+      expect(pdfium.pdfium.wasmExports.free).toHaveBeenCalledWith(ptr);
+    });
+
+    it('should reject documents that are not open', async () => {
+      const document = await openDocument(new ArrayBuffer(100));
+      closeDocument(document);
+
+      await expect(removeSecurity(null, 'password', { document })).rejects.toThrow(
+        `Document ${document} is not open`,
+      );
+      expect(closeDocument(document)).toBe(false);
+    });
+  });
+
+  describe('Security Strip', () => {
+    const readFixture = () =>
+      new Uint8Array(
+        fs.readFileSync(path.join(process.cwd(), 'e2e/assets/file-sample_150kB-protected.pdf')),
+      ).buffer;
+    const containsText = (buffer, text) => {
+      const bytes = new Uint8Array(buffer);
+      const codes = Array.from(text, (char) => char.charCodeAt(0));
+      return bytes.some((_, i) => codes.every((code, j) => bytes[i + j] === code));
+    };
+
+    it('should decrypt supported files without PDFium', async () => {
+      const pdfium = await initPdfium();
+      const result = await removeSecurity(readFixture(), 'password');
+
+      expect(containsText(result, '/Encrypt')).toBe(false);
+      expect(pdfium.FPDF_LoadMemDocument).not.toHaveBeenCalled();
+    });
+
+    it('should fall back to PDFium when the strip engine fails', async () => {
+      const pdfium = await initPdfium();
+      await removeSecurity(readFixture(), 'wrong').catch(() => {});
+
+      expect(pdfium.FPDF_LoadMemDocument).toHaveBeenCalled();
+    });
+
+    it('should not fall back in strip mode', async () => {
+      const pdfium = await initPdfium();
+
+      await expect(
+        removeSecurity(new ArrayBuffer(64), 'password', { mode: 'strip' }),
+      ).rejects.toThrow('%PDF');
+      expect(pdfium.FPDF_LoadMemDocument).not.toHaveBeenCalled();
+    });
+
+    it('should pass unencrypted files through without either engine', async () => {
+      const pdfium = await initPdfium();
+      const source = new Uint8Array(
+        fs.readFileSync(path.join(process.cwd(), 'e2e/assets/file-sample_150kB.pdf')),
+      ).buffer;
+      const onMetrics = jest.fn();
+
+      const result = await removeSecurity(source, '', { mode: 'pdfium', onMetrics });
+
+      expect(result).toBe(source);
+      expect(pdfium.FPDF_LoadMemDocument).not.toHaveBeenCalled();
+      expect(onMetrics).toHaveBeenCalledWith(expect.objectContaining({ engine: 'passthrough' }));
+    });
+
+    it('should not pass a linearized encrypted file through', async () => {
+      const source = buildLinearizedPdf(['<< /Type /Catalog >>', '<< /Filter /Standard >>'], {
+        trailer: '/Root 1 0 R /Encrypt 2 0 R',
+      });
+      const onMetrics = jest.fn();
+
+      const result = await removeSecurity(source, '', { mode: 'strip', onMetrics }).catch(
+        (err) => err,
+      );
+
+      expect(result).not.toBe(source);
+      expect(onMetrics).toHaveBeenCalledWith(expect.objectContaining({ engine: 'strip' }));
+    });
+
+    it('should report progress against the input size', async () => {
+      const source = readFixture();
+      const onProgress = jest.fn();
+
+      await removeSecurity(source, 'password', { onProgress });
+
+      expect(onProgress).toHaveBeenLastCalledWith(
+        expect.objectContaining({
+          engine: 'strip',
+          bytesTotal: source.byteLength,
+          objectsDone: expect.any(Number),
+        }),
+      );
+    });
+
+    it('should skip the strip engine in pdfium mode', async () => {
+      const pdfium = await initPdfium();
+      await removeSecurity(readFixture(), 'password', { mode: 'pdfium' }).catch(() => {});
+
+      expect(pdfium.FPDF_LoadMemDocument).toHaveBeenCalled();
+    });
+  });
+
+  describe('Job Metrics', () => {
+    it('should report the stages of a strip job', async () => {
+      const source = new Uint8Array(
+        fs.readFileSync(path.join(process.cwd(), 'e2e/assets/file-sample_150kB-protected.pdf')),
+      ).buffer;
+      const onMetrics = jest.fn();
+
+      const result = await removeSecurity(source, 'password', { mode: 'strip', onMetrics });
+
+      const [metrics] = onMetrics.mock.calls[0];
+      expect(metrics).toMatchObject({
+        engine: 'strip',
+        bytesIn: source.byteLength,
+        bytesOut: result.byteLength,
+        wasmHeap: null,
+      });
+      expect(metrics.spans.map((span) => span.name)).toContain('strip');
+    });
+
+    it('should report failed jobs with their error', async () => {
+      const onMetrics = jest.fn();
+
+      await expect(
+        removeSecurity(new ArrayBuffer(64), 'password', { mode: 'strip', onMetrics }),
+      ).rejects.toThrow();
+
+      expect(onMetrics).toHaveBeenCalledWith(
+        expect.objectContaining({ bytesIn: 64, bytesOut: 0, error: expect.any(String) }),
+      );
+    });
+  });
+
+  describe('Fast Web View', () => {
+    const readFixture = (name) =>
+      new Uint8Array(fs.readFileSync(path.join(process.cwd(), 'e2e/assets', name))).buffer;
+    const header = (buffer) => String.fromCharCode(...new Uint8Array(buffer, 0, 256));
+
+    it('should linearize the unlocked file', async () => {
+      const source = readFixture('file-sample_150kB-protected.pdf');
+      const onMetrics = jest.fn();
+
+      const result = await removeSecurity(source, 'password', {
+        mode: 'strip',
+        onMetrics,
+        linearize: true,
+      });
+
+      expect(header(result)).toContain('/Linearized 1');
+      expect(onMetrics.mock.calls[0][0].spans.map((span) => span.name)).toEqual(
+        expect.arrayContaining(['strip', 'linearize']),
+      );
+    });
+
+    it('should save the file as it is when it cannot be linearized', async () => {
+      const warn = jest.spyOn(console, 'warn').mockImplementation(() => {});
+      const source = new TextEncoder().encode(
+        '%PDF-1.4\n1 0 obj\n<< /Type /Catalog >>\nendobj\nxref\n0 2\n' +
+          '0000000000 65535 f\r\n0000000009 00000 n\r\n' +
+          'trailer\n<< /Size 2 /Root 1 0 R >>\nstartxref\n45\n%%EOF\n',
+      ).buffer;
+
+      const result = await removeSecurity(source, '', { linearize: true });
+
+      expect(new Uint8Array(result)).toEqual(new Uint8Array(source));
+      expect(warn).toHaveBeenCalledWith(
+        '[PDFium] Linearization unavailable, saving as is:',
+        expect.stringContaining('page tree'),
+      );
+      warn.mockRestore();
+    });
+  });
+
+  describe('Compact Output', () => {
+    const readFixture = () =>
+      new Uint8Array(
+        fs.readFileSync(path.join(process.cwd(), 'e2e/assets/file-sample_150kB-protected.pdf')),
+      ).buffer;
+
+    it('should compact the unlocked file', async () => {
+      const onMetrics = jest.fn();
+      const plain = await removeSecurity(readFixture(), 'password', { mode: 'strip' });
+
+      const result = await removeSecurity(readFixture(), 'password', {
+        mode: 'strip',
+        onMetrics,
+        compact: true,
+      });
+
+      expect(result.byteLength).toBeLessThan(plain.byteLength);
+      expect(onMetrics.mock.calls[0][0].spans.map((span) => span.name)).toContain('compact');
+    });
+
+    it('should compact before linearizing when asked for both', async () => {
+      const onMetrics = jest.fn();
+
+      const result = await removeSecurity(readFixture(), 'password', {
+        mode: 'strip',
+        onMetrics,
+        compact: true,
+        linearize: true,
+      });
+
+      const names = onMetrics.mock.calls[0][0].spans.map((span) => span.name);
+      expect(names.indexOf('compact')).toBeLessThan(names.indexOf('linearize'));
+      expect(String.fromCharCode(...new Uint8Array(result, 0, 256))).toContain('/Linearized 1');
+    });
+  });
+
+  describe('Build Variants', () => {
+    afterEach(() => {
+      delete process.env.PDFIUM_WASM_VARIANTS;
+    });
+
+    it('should fall back to the full build when a trimmed build lacks exports', async () => {
+      process.env.PDFIUM_WASM_VARIANTS = JSON.stringify([
+        { name: 'lite', file: 'pdfium-lite.wasm' },
+      ]);
+
+      await jest.isolateModulesAsync(async () => {
+        const remover = await import('./pdfiumRemover');
+        await remover.initPdfium();
+
+        expect(global.fetch).toHaveBeenCalledWith('http://localhost/pdfium-lite.wasm');
+        expect(global.fetch).toHaveBeenLastCalledWith('http://localhost/pdfium.wasm');
+        expect(remover.getPdfiumInitMetrics().variant).toBe('full');
+      });
+    });
+  });
 });
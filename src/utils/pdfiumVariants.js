@@ -0,0 +1,125 @@
+/**
+ * PDFium wasm build variants
+ *
+ * The bundle can ship several builds of pdfium.wasm next to the general-purpose
+ * one (see .config/pdfium). The build step reports which ones exist together
+ * with their content hashes and the wasm features they need; at runtime the
+ * ones this browser can run are tried in order, and the full build is always
+ * the last resort.
+ *
+ * Variants marked `largeDocuments` (the memory64 build) are left out of that
+ * order: they are only loaded for documents the wasm32 builds cannot take.
+ */
+
+// The bundle's public path, injected at build time, so the builds shipped next to
+// the app are used (and kept by pdfiumWasmLoader's cache). Hosts outside a bundle
+// (the CLI, the benchmark) set it to their own copy; otherwise it is relative to
+// the page, never a deployed site
+export const PDFIUM_WASM_BASE_URL = process.env.PDFIUM_WASM_BASE_URL || './';
+
+// The general-purpose build from @embedpdf/pdfium, always shipped
+const FULL_VARIANT = { name: 'full', file: 'pdfium.wasm', hash: process.env.PDFIUM_WASM_HASH };
+
+// From this size a document goes to a large-document build when there is one
+export const LARGE_DOCUMENT_SIZE = 1024 * 1024 * 1024;
+// wasm32 limits: the heap stops at 2 GiB, FPDF_FILEACCESS.m_FileLen is 32-bit
+export const WASM32_MAX_HEAP_SIZE = 2 * 1024 * 1024 * 1024;
+export const WASM32_MAX_FILE_SIZE = 2 ** 32 - 1;
+// MAXIMUM_MEMORY of the memory64 build (.config/pdfium/build.sh)
+export const MEMORY64_MAX_HEAP_SIZE = 16 * 1024 * 1024 * 1024;
+
+// Exports a trimmed build must provide for the decrypt-and-save path
+export const REQUIRED_EXPORTS = [
+  'malloc',
+  'free',
+  'PDFiumExt_Init',
+  'FPDF_LoadMemDocument',
+  'FPDF_LoadCustomDocument',
+  'FPDF_GetLastError',
+  'FPDF_GetPageCount',
+  'FPDF_SaveAsCopy',
+  'FPDF_CloseDocument',
+];
+
+// Smallest modules using each optional feature, checked with WebAssembly.validate
+const FEATURE_PROBES = {
+  // (func (result v128) i32.const 0 i8x16.splat i8x16.popcnt)
+  simd: new Uint8Array([
+    0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253,
+    15, 253, 98, 11,
+  ]),
+  // (memory i64 1)
+  memory64: new Uint8Array([0, 97, 115, 109, 1, 0, 0, 0, 5, 3, 1, 4, 1]),
+};
+
+const supportedFeatures = new Map();
+
+/**
+ * Whether this runtime can compile modules using a wasm feature
+ * @param {string} feature - Key of FEATURE_PROBES, e.g. 'simd'
+ */
+export const isWasmFeatureSupported = (feature) => {
+  if (!supportedFeatures.has(feature)) {
+    let supported = false;
+    try {
+      supported = Boolean(FEATURE_PROBES[feature]) && WebAssembly.validate(FEATURE_PROBES[feature]);
+    } catch {
+      supported = false;
+    }
+    supportedFeatures.set(feature, supported);
+  }
+  return supportedFeatures.get(feature);
+};
+
+/**
+ * Variants known to this bundle, most specialized first
+ * Injected at build time as JSON: [{name, file, hash, features, glue, largeDocuments}]
+ */
+const readBuildVariants = () => {
+  try {
+    const variants = JSON.parse(process.env.PDFIUM_WASM_VARIANTS || '[]');
+    return Array.isArray(variants) ? variants : [];
+  } catch {
+    return [];
+  }
+};
+
+const isVariantSupported = (variant) =>
+  variant.name !== FULL_VARIANT.name &&
+  (variant.features || []).every((feature) => isWasmFeatureSupported(feature));
+
+// `glue` is the Emscripten ES module of builds @embedpdf/pdfium cannot drive
+const withUrls = (variant) => ({
+  ...variant,
+  url: `${PDFIUM_WASM_BASE_URL}${variant.file}`,
+  ...(variant.glue && { glueUrl: `${PDFIUM_WASM_BASE_URL}${variant.glue}` }),
+});
+
+/**
+ * Ordered list of variants this runtime can use, ending with the full build
+ * Variants needing a wasm feature the runtime lacks, and large-document
+ * variants, are left out
+ * @param {Array<{name: string, file: string, hash?: string, features?: string[]}>} [variants]
+ * @returns {Array<{name: string, file: string, hash?: string, url: string}>}
+ */
+export const getPdfiumVariants = (variants = readBuildVariants()) =>
+  [
+    ...variants.filter((variant) => !variant.largeDocuments && isVariantSupported(variant)),
+    FULL_VARIANT,
+  ].map(withUrls);
+
+/**
+ * Large-document variant this runtime can use, if the bundle ships one
+ * @param {Array<Object>} [variants] - As for getPdfiumVariants
+ * @returns {{name: string, file: string, url: string, glueUrl?: string}|null}
+ */
+export const getLargeDocumentVariant = (variants = readBuildVariants()) => {
+  const variant = variants.find((item) => item.largeDocuments && isVariantSupported(item));
+  return variant ? withUrls(variant) : null;
+};
+
+/**
+ * Names of the required exports missing from an instantiated variant
+ */
+export const getMissingExports = (wasmExports) =>
+  REQUIRED_EXPORTS.filter((name) => typeof wasmExports[name] !== 'function');
@@ -0,0 +1,142 @@
+/**
+ * Unit tests for the PDFium build variant table
+ * Tests variant ordering, the large-document build, wasm feature detection and the export
+ * check for trimmed builds
+ */
+
+import {
+  getLargeDocumentVariant,
+  getMissingExports,
+  getPdfiumVariants,
+  isWasmFeatureSupported,
+  REQUIRED_EXPORTS,
+} from './pdfiumVariants';
+
+describe('pdfiumVariants', () => {
+  afterEach(() => {
+    delete process.env.PDFIUM_WASM_VARIANTS;
+  });
+
+  describe('getPdfiumVariants', () => {
+    it('should fall back to the full build only when no variants were built', () => {
+      expect(getPdfiumVariants()).toEqual([
+        expect.objectContaining({
+          name: 'full',
+          url: './pdfium.wasm',
+        }),
+      ]);
+    });
+
+    it('should try specialized builds first and keep the full build last', () => {
+      process.env.PDFIUM_WASM_VARIANTS = JSON.stringify([
+        { name: 'full', file: 'pdfium.wasm', hash: 'f' },
+        { name: 'lite', file: 'pdfium-lite.wasm', hash: 'l' },
+      ]);
+
+      const variants = getPdfiumVariants();
+
+      expect(variants.map((variant) => variant.name)).toEqual(['lite', 'full']);
+      expect(variants[0]).toEqual({
+        name: 'lite',
+        file: 'pdfium-lite.wasm',
+        hash: 'l',
+        url: './pdfium-lite.wasm',
+      });
+    });
+
+    it('should leave out variants needing wasm features the runtime lacks', () => {
+      const variants = [
+        { name: 'simd', file: 'pdfium-simd.wasm', features: ['simd'] },
+        { name: 'future', file: 'pdfium-future.wasm', features: ['unknown-feature'] },
+        { name: 'lite', file: 'pdfium-lite.wasm' },
+      ];
+
+      expect(getPdfiumVariants(variants).map((variant) => variant.name)).toEqual([
+        'simd',
+        'lite',
+        'full',
+      ]);
+    });
+
+    it('should keep large-document variants out of the default order', () => {
+      const variants = [
+        { name: 'memory64', file: 'pdfium-memory64.wasm', largeDocuments: true },
+        { name: 'lite', file: 'pdfium-lite.wasm' },
+      ];
+
+      expect(getPdfiumVariants(variants).map((variant) => variant.name)).toEqual([
+        'lite',
+        'full',
+      ]);
+    });
+
+    it('should ignore a malformed variant list', () => {
+      process.env.PDFIUM_WASM_VARIANTS = 'not json';
+
+      expect(getPdfiumVariants().map((variant) => variant.name)).toEqual(['full']);
+    });
+  });
+
+  describe('getLargeDocumentVariant', () => {
+    it('should return the large-document variant with its wasm and glue URLs', () => {
+      const variants = [
+        { name: 'lite', file: 'pdfium-lite.wasm' },
+        {
+          name: 'memory64',
+          file: 'pdfium-memory64.wasm',
+          glue: 'pdfium-memory64.js',
+          largeDocuments: true,
+        },
+      ];
+
+      expect(getLargeDocumentVariant(variants)).toEqual(
+        expect.objectContaining({
+          name: 'memory64',
+          url: './pdfium-memory64.wasm',
+          glueUrl: './pdfium-memory64.js',
+        }),
+      );
+    });
+
+    it('should return null when the runtime cannot run it', () => {
+      const variants = [
+        { name: 'future', file: 'pdfium-future.wasm', features: ['unknown-feature'] },
+      ].map((variant) => ({ ...variant, largeDocuments: true }));
+
+      expect(getLargeDocumentVariant(variants)).toBeNull();
+      expect(getLargeDocumentVariant()).toBeNull();
+    });
+  });
+
+  describe('isWasmFeatureSupported', () => {
+    it('should detect SIMD with WebAssembly.validate', () => {
+      expect(isWasmFeatureSupported('simd')).toBe(
+        WebAssembly.validate(
+          new Uint8Array([
+            0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65,
+            0, 253, 15, 253, 98, 11,
+          ]),
+        ),
+      );
+    });
+
+    it('should detect memory64 with WebAssembly.validate', () => {
+      expect(isWasmFeatureSupported('memory64')).toBe(
+        WebAssembly.validate(new Uint8Array([0, 97, 115, 109, 1, 0, 0, 0, 5, 3, 1, 4, 1])),
+      );
+    });
+
+    it('should report unknown features as unsupported', () => {
+      expect(isWasmFeatureSupported('unknown-feature')).toBe(false);
+    });
+  });
+
+  describe('getMissingExports', () => {
+    it('should list required exports that are not functions', () => {
+      const wasmExports = Object.fromEntries(REQUIRED_EXPORTS.map((name) => [name, () => 0]));
+      delete wasmExports.FPDF_LoadCustomDocument;
+
+      expect(getMissingExports(wasmExports)).toEqual(['FPDF_LoadCustomDocument']);
+    });
+  });
+});
@@ -0,0 +1,132 @@
+/**
+ * pdfium.wasm loader with streaming compilation and a persistent byte cache
+ *
+ * The raw wasm response is kept in Cache Storage under a key derived from its
+ * content hash (computed at build time), so repeat visits never touch the
+ * network. Compiling with WebAssembly.compileStreaming from that cached
+ * response also lets the browser reuse its own compiled-code cache, skipping
+ * most of the compile on warm starts.
+ *
+ * Under Node (the CLI) the builds are `file:` URLs and are read from disk.
+ */
+
+const WASM_CACHE_NAME = 'pdfium-wasm';
+
+/**
+ * Cache key for a given wasm URL and content hash
+ */
+export const getWasmCacheKey = (url, hash) => `${url}${url.includes('?') ? '&' : '?'}v=${hash}`;
+
+// Cache keys come back absolute; the bundle hands over paths relative to the page
+const resolveUrl = (url) =>
+  typeof location === 'undefined' ? url : new URL(url, location.href).href;
+
+const isSameFile = (cachedUrl, url) => cachedUrl.split('?')[0] === url.split('?')[0];
+
+const openWasmCache = async () => {
+  if (typeof caches === 'undefined') return null;
+  try {
+    return await caches.open(WASM_CACHE_NAME);
+  } catch (err) {
+    // Cache Storage is unavailable in some private browsing modes
+    console.warn('[PDFium] Cache Storage unavailable:', err);
+    return null;
+  }
+};
+
+// Fetch the wasm response, preferring the content-addressed cache entry
+const fetchWasmResponse = async (url, hash) => {
+  const cache = hash ? await openWasmCache() : null;
+  const key = cache ? getWasmCacheKey(url, hash) : null;
+
+  if (cache) {
+    const cached = await cache.match(key);
+    if (cached) return { response: cached, source: 'cache' };
+  }
+
+  const response = await fetch(url);
+  if (!response.ok) {
+    throw new Error(`Failed to fetch ${url}: HTTP ${response.status}`);
+  }
+  if (cache) {
+    try {
+      await cache.put(key, response.clone());
+
+      // Drop older builds of this file; other variants keep their entries
+      const keys = await cache.keys();
+      const stale = keys.filter((req) => req.url !== key && isSameFile(req.url, url));
+      await Promise.all(stale.map((req) => cache.delete(req)));
+    } catch (err) {
+      console.warn('[PDFium] Failed to cache pdfium.wasm:', err);
+    }
+  }
+  return { response, source: 'network' };
+};
+
+// Node's fetch has no file: support; the import stays out of the bundle
+const readWasmFile = async (url) => {
+  const { readFile } = await import(/* webpackIgnore: true */ 'node:fs/promises');
+  return readFile(new URL(url));
+};
+
+const canCompileStreaming = (response) =>
+  typeof WebAssembly.compileStreaming === 'function' &&
+  typeof Response !== 'undefined' &&
+  response instanceof Response &&
+  (response.headers.get('content-type') || '').startsWith('application/wasm');
+
+/**
+ * Load pdfium.wasm and produce Emscripten module overrides for `init`
+ * @param {string} url - Location of pdfium.wasm, absolute or relative to this context
+ * @param {Object} [options]
+ * @param {string} [options.hash] - Content hash of the build; enables the persistent cache
+ * @returns {Promise<{moduleOverrides: Object, metrics: Object, instantiationFailure?:
+ *   Promise<never>}>} `instantiationFailure` comes with a streamed compile: Emscripten never
+ *   settles its factory when the `instantiateWasm` override fails, so callers race the
+ *   factory against this promise, which rejects with the error then
+ */
+export const loadPdfiumWasm = async (url, { hash } = {}) => {
+  const start = performance.now();
+  if (url.startsWith('file:')) {
+    const wasmBinary = await readWasmFile(url);
+    return {
+      moduleOverrides: { wasmBinary },
+      metrics: { source: 'file', streaming: false, loadMs: performance.now() - start },
+    };
+  }
+
+  const { response, source } = await fetchWasmResponse(resolveUrl(url), hash);
+
+  if (canCompileStreaming(response)) {
+    // Compile while the bytes are still arriving
+    const module = await WebAssembly.compileStreaming(response);
+    let failInstantiation;
+    const instantiationFailure = new Promise((_, reject) => (failInstantiation = reject));
+    // Handled here as well, in case the factory fails first and nothing awaits this
+    instantiationFailure.catch(() => {});
+    const moduleOverrides = {
+      instantiateWasm: (imports, receiveInstance) => {
+        WebAssembly.instantiate(module, imports).then(
+          (instance) => receiveInstance(instance, module),
+          (err) => {
+            console.error('[PDFium] Failed to instantiate pdfium.wasm:', err);
+            failInstantiation(err);
+          },
+        );
+        return {};
+      },
+    };
+    return {
+      moduleOverrides,
+      metrics: { source, streaming: true, loadMs: performance.now() - start },
+      instantiationFailure,
+    };
+  }
+
+  // Fallback: hand the raw bytes to Emscripten
+  const wasmBinary = await response.arrayBuffer();
+  return {
+    moduleOverrides: { wasmBinary },
+    metrics: { source, streaming: false, loadMs: performance.now() - start },
+  };
+};
@@ -0,0 +1,183 @@
+/**
+ * Unit tests for the pdfium.wasm loader
+ * Tests the content-addressed Cache Storage entry, streaming compilation and file: URLs
+ */
+
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { pathToFileURL } from 'url';
+import { getWasmCacheKey, loadPdfiumWasm } from './pdfiumWasmLoader';
+
+describe('loadPdfiumWasm', () => {
+  const WASM_URL = 'https://example.test/pdfium.wasm';
+  const wasmBytes = new Uint8Array([0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00]).buffer;
+
+  const createCache = (entries = {}) => ({
+    match: jest.fn(async (key) => entries[key]),
+    put: jest.fn(async () => {}),
+    keys: jest.fn(async () => Object.keys(entries).map((url) => ({ url }))),
+    delete: jest.fn(async () => true),
+  });
+
+  beforeEach(() => {
+    jest.clearAllMocks();
+  });
+
+  afterEach(() => {
+    delete global.caches;
+  });
+
+  it('should fall back to raw bytes when streaming compilation is not possible', async () => {
+    const { moduleOverrides, metrics } = await loadPdfiumWasm(
+      'https://feijo.dev/pdf-password-remover/pdfium.wasm',
+    );
+
+    expect(moduleOverrides.wasmBinary.byteLength).toBe(8);
+    expect(metrics).toEqual({ source: 'network', streaming: false, loadMs: expect.any(Number) });
+  });
+
+  it('should serve repeat loads from Cache Storage without touching the network', async () => {
+    const cache = createCache({
+      [getWasmCacheKey(WASM_URL, 'abc')]: { arrayBuffer: async () => wasmBytes },
+    });
+    global.caches = { open: jest.fn(async () => cache) };
+
+    const { metrics } = await loadPdfiumWasm(WASM_URL, { hash: 'abc' });
+
+    expect(metrics.source).toBe('cache');
+    expect(global.fetch).not.toHaveBeenCalled();
+  });
+
+  it('should store the network response under the hashed key and drop stale builds', async () => {
+    const staleKey = getWasmCacheKey(WASM_URL, 'old');
+    const cache = createCache({ [staleKey]: { arrayBuffer: async () => wasmBytes } });
+    cache.match.mockResolvedValue(undefined);
+    global.caches = { open: jest.fn(async () => cache) };
+    global.fetch.mockResolvedValueOnce({
+      ok: true,
+      clone: () => ({ cloned: true }),
+      arrayBuffer: async () => wasmBytes,
+    });
+
+    const { metrics } = await loadPdfiumWasm(WASM_URL, { hash: 'new' });
+
+    expect(metrics.source).toBe('network');
+    expect(cache.put).toHaveBeenCalledWith(getWasmCacheKey(WASM_URL, 'new'), { cloned: true });
+    expect(cache.delete).toHaveBeenCalledWith({ url: staleKey });
+  });
+
+  it('should resolve bundle-relative URLs before fetching and keying the cache', async () => {
+    const absoluteUrl = new URL('/pdf-password-remover/pdfium.wasm', location.href).href;
+    const staleKey = getWasmCacheKey(absoluteUrl, 'old');
+    const cache = createCache({ [staleKey]: { arrayBuffer: async () => wasmBytes } });
+    cache.match.mockResolvedValue(undefined);
+    global.caches = { open: jest.fn(async () => cache) };
+    global.fetch.mockResolvedValueOnce({
+      ok: true,
+      clone: () => ({ cloned: true }),
+      arrayBuffer: async () => wasmBytes,
+    });
+
+    await loadPdfiumWasm('/pdf-password-remover/pdfium.wasm', { hash: 'new' });
+
+    expect(global.fetch).toHaveBeenCalledWith(absoluteUrl);
+    expect(cache.delete).toHaveBeenCalledWith({ url: staleKey });
+  });
+
+  it('should keep cache entries of other build variants', async () => {
+    const liteKey = getWasmCacheKey('https://example.test/pdfium-lite.wasm', 'lite');
+    const cache = createCache({ [liteKey]: { arrayBuffer: async () => wasmBytes } });
+    cache.match.mockResolvedValue(undefined);
+    global.caches = { open: jest.fn(async () => cache) };
+    global.fetch.mockResolvedValueOnce({
+      ok: true,
+      clone: () => ({ cloned: true }),
+      arrayBuffer: async () => wasmBytes,
+    });
+
+    await loadPdfiumWasm(WASM_URL, { hash: 'new' });
+
+    expect(cache.delete).not.toHaveBeenCalled();
+  });
+
+  it('should read file: URLs from disk without fetching', async () => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'pdfium-'));
+    fs.writeFileSync(path.join(dir, 'pdfium.wasm'), new Uint8Array(wasmBytes));
+
+    const { moduleOverrides, metrics } = await loadPdfiumWasm(
+      pathToFileURL(path.join(dir, 'pdfium.wasm')).href,
+    );
+
+    expect(new Uint8Array(moduleOverrides.wasmBinary)).toEqual(new Uint8Array(wasmBytes));
+    expect(metrics.source).toBe('file');
+    expect(global.fetch).not.toHaveBeenCalled();
+    fs.rmSync(dir, { recursive: true });
+  });
+
+  it('should reject when the build is not served', async () => {
+    global.fetch.mockResolvedValueOnce({ ok: false, status: 404 });
+
+    await expect(loadPdfiumWasm(WASM_URL)).rejects.toThrow('HTTP 404');
+  });
+
+  it('should compile with compileStreaming for application/wasm responses', async () => {
+    const originalResponse = global.Response;
+    const originalCompileStreaming = WebAssembly.compileStreaming;
+    global.Response = class {
+      constructor() {
+        this.ok = true;
+        this.headers = { get: () => 'application/wasm' };
+      }
+    };
+    const compiled = {};
+    WebAssembly.compileStreaming = jest.fn(async () => compiled);
+    global.fetch.mockResolvedValueOnce(new global.Response());
+
+    const { moduleOverrides, metrics } = await loadPdfiumWasm(WASM_URL);
+
+    expect(WebAssembly.compileStreaming).toHaveBeenCalled();
+    expect(typeof moduleOverrides.instantiateWasm).toBe('function');
+    expect(metrics.streaming).toBe(true);
+
+    global.Response = originalResponse;
+    WebAssembly.compileStreaming = originalCompileStreaming;
+  });
+
+  it('should reject instead of hanging when the streamed module fails to instantiate', async () => {
+    const originalResponse = global.Response;
+    const originalCompileStreaming = WebAssembly.compileStreaming;
+    const originalInstantiate = WebAssembly.instantiate;
+    global.Response = class {
+      constructor() {
+        this.ok = true;
+        this.headers = { get: () => 'application/wasm' };
+      }
+    };
+    WebAssembly.compileStreaming = jest.fn(async () => ({}));
+    WebAssembly.instantiate = jest.fn(async () => {
+      throw new WebAssembly.LinkError('import object field missing');
+    });
+    jest.spyOn(console, 'error').mockImplementation(() => {});
+    global.fetch.mockResolvedValueOnce(new global.Response());
+
+    const { moduleOverrides, instantiationFailure } = await loadPdfiumWasm(WASM_URL);
+    const receiveInstance = jest.fn();
+    moduleOverrides.instantiateWasm({}, receiveInstance);
+
+    await expect(instantiationFailure).rejects.toThrow('import object field missing');
+    expect(receiveInstance).not.toHaveBeenCalled();
+
+    console.error.mockRestore();
+    global.Response = originalResponse;
+    WebAssembly.compileStreaming = originalCompileStreaming;
+    WebAssembly.instantiate = originalInstantiate;
+  });
+});
+
+describe('getWasmCacheKey', () => {
+  it('should append the content hash as a query parameter', () => {
+    expect(getWasmCacheKey('/pdfium.wasm', 'abc')).toBe('/pdfium.wasm?v=abc');
+    expect(getWasmCacheKey('/pdfium.wasm?x=1', 'abc')).toBe('/pdfium.wasm?x=1&v=abc');
+  });
+});
@@ -0,0 +1,207 @@
+/**
+ * Message dispatcher for the PDFium worker engine
+ *
+ * Runs inside a dedicated worker that owns exactly one PDFium module instance.
+ * Every request carries an `id` that is echoed back on the response so the
+ * main thread can match replies to pending promises.
+ *
+ * Protocol:
+ * - request:  { id, type, payload }
+ * - response: { id, type: 'result', result }
+ *   | { id, type: 'error', error, metrics?, recycle?, input? }
+ * - stream:   { id, type: 'chunk', chunk } (zero or more, before the response)
+ * - progress: { id, type: 'progress', progress } (remove requests with `progress: true`,
+ *   at most one per PROGRESS_INTERVAL_MS)
+ * - ack:      { id, type: 'ack', payload: { bytes } } (main thread to worker, no reply)
+ *
+ * A streaming remove with `streamWindow` set keeps at most that many posted
+ * bytes unacknowledged: the main thread acks each chunk once it is written, and
+ * the strip engine and the rewrites wait for acks before the next object.
+ * PDFium writes from inside FPDF_SaveAsCopy and cannot wait, so its output may
+ * run ahead of the window.
+ *
+ * Remove results carry the job's `metrics` report (see pdfiumMetrics.js), and
+ * so do remove errors. Results set `recycle: true` once the PDFium heap has
+ * outgrown its workload (see pdfiumArena.js): the main thread should retire
+ * this worker once its jobs are done. Failed jobs set it on the error when the
+ * heap has outgrown its workload or the module trapped. A remove turned away
+ * because this heap is too full (MEMORY_ERROR_NAME, see pdfiumPlanner.js) hands
+ * its input buffer back as `input`, so the main thread can retry elsewhere.
+ *
+ * A job cannot be interrupted here: FPDF_SaveAsCopy runs synchronously, so the
+ * main thread cancels by terminating the worker.
+ *
+ * `checkPasswords` and `probe` read only the few objects they need, without
+ * initializing PDFium.
+ *
+ * `open` keeps a document resident in the worker and answers its `document` id;
+ * `remove` requests pass `{ document }` instead of `pdfData` until `close`.
+ *
+ * Output buffers are listed as transferables so they move to the main thread
+ * without a structured-clone copy.
+ */
+
+import {
+  closeDocument,
+  getPdfiumInitMetrics,
+  initPdfium,
+  isPdfiumRecycleDue,
+  openDocument,
+  removeSecurity,
+} from './pdfiumRemover';
+import { checkPasswords } from './pdf/encryption';
+import { probeDocument } from './pdf/probe';
+import { MEMORY_ERROR_NAME } from './pdfiumPlanner';
+
+const PROGRESS_INTERVAL_MS = 100;
+
+// Post progress updates, dropping those that arrive within PROGRESS_INTERVAL_MS of the last
+const createProgressPoster = (post) => {
+  let last = -Infinity;
+  return (progress) => {
+    const now = performance.now();
+    if (now - last < PROGRESS_INTERVAL_MS) return;
+    last = now;
+    post({ type: 'progress', progress });
+  };
+};
+
+// Bytes a streaming job has posted and not yet had acknowledged
+const createStreamWindow = (limit) => {
+  let unacked = 0;
+  let resume = null;
+  let waiting = null;
+  return {
+    // Count a posted chunk; past `limit` the returned promise settles once acks make room
+    take: (bytes) => {
+      unacked += bytes;
+      if (unacked <= limit) return undefined;
+      if (!waiting) waiting = new Promise((resolve) => (resume = resolve));
+      return waiting;
+    },
+    give: (bytes) => {
+      unacked -= bytes;
+      if (!waiting || unacked > limit) return;
+      waiting = null;
+      resume();
+    },
+  };
+};
+
+const withRecycle = (result) => (isPdfiumRecycleDue() ? { ...result, recycle: true } : result);
+
+const handlers = {
+  init: async () => {
+    await initPdfium();
+    return { result: { ready: true, metrics: getPdfiumInitMetrics() } };
+  },
+
+  // Key check only: no PDFium, no document load
+  checkPasswords: async ({ encryption, passwords }) => ({
+    result: { index: await checkPasswords(encryption, passwords) },
+  }),
+
+  // Triage metadata only: trailer, /Encrypt and page-tree root, no PDFium
+  probe: async ({ pdfData }) => ({ result: await probeDocument(pdfData) }),
+
+  open: async ({ pdfData }) => ({ result: { document: await openDocument(pdfData) } }),
+
+  close: async ({ document }) => ({ result: { closed: closeDocument(document) } }),
+
+  remove: async (
+    { pdfData, document, password, stream, streamWindow, mode, progress, linearize, compact },
+    { post, onAck },
+  ) => {
+    let metrics = null;
+    const onMetrics = (report) => {
+      metrics = report;
+    };
+    const onProgress = progress ? createProgressPoster(post) : undefined;
+
+    try {
+      if (stream) {
+        // Each chunk leaves the worker as soon as it is written
+        let size = 0;
+        const window = streamWindow ? createStreamWindow(streamWindow) : null;
+        if (window) onAck(window.give);
+        await removeSecurity(pdfData, password, {
+          mode,
+          linearize,
+          compact,
+          document,
+          onMetrics,
+          onProgress,
+          onChunk: (chunk) => {
+            const bytes = chunk.byteLength;
+            size += bytes;
+            post({ type: 'chunk', chunk: chunk.buffer }, [chunk.buffer]);
+            return window ? window.take(bytes) : undefined;
+          },
+        });
+        return { result: withRecycle({ size, metrics }) };
+      }
+
+      const buffer = await removeSecurity(pdfData, password, {
+        mode,
+        linearize,
+        compact,
+        document,
+        onMetrics,
+        onProgress,
+      });
+      return { result: withRecycle({ buffer, metrics }), transfer: [buffer] };
+    } catch (err) {
+      err.metrics = metrics;
+      // A trap (e.g. out of memory inside PDFium) leaves the module unusable
+      err.recycle = isPdfiumRecycleDue() || err instanceof WebAssembly.RuntimeError;
+      // Turned away before the heap copy: hand the bytes back for a retry on a fresh worker
+      if (err.name === MEMORY_ERROR_NAME && pdfData instanceof ArrayBuffer) err.input = pdfData;
+      throw err;
+    }
+  },
+};
+
+/**
+ * Create the worker `onmessage` handler
+ * @param {(message: object, transfer?: Transferable[]) => void} postMessage - Reply channel
+ * @returns {(event: MessageEvent) => Promise<void>}
+ */
+export const createPdfiumWorkerHandler = (postMessage) => {
+  // Request id -> ack listener of a streaming job in flight
+  const ackListeners = new Map();
+
+  return async ({ data }) => {
+    const { id, type, payload = {} } = data;
+    if (type === 'ack') {
+      const listener = ackListeners.get(id);
+      if (listener) listener(payload.bytes);
+      return;
+    }
+
+    try {
+      const handler = handlers[type];
+      if (!handler) {
+        throw new Error(`Unknown engine request: ${type}`);
+      }
+
+      const post = (message, transfer = []) => postMessage({ id, ...message }, transfer);
+      const onAck = (listener) => ackListeners.set(id, listener);
+      const { result, transfer = [] } = await handler(payload, { post, onAck });
+      postMessage({ id, type: 'result', result }, transfer);
+    } catch (err) {
+      postMessage(
+        {
+          id,
+          type: 'error',
+          error: { name: err.name, message: err.message },
+          ...(err.metrics ? { metrics: err.metrics } : {}),
+          ...(err.recycle ? { recycle: true } : {}),
+          ...(err.input ? { input: err.input } : {}),
+        },
+        err.input ? [err.input] : [],
+      );
+    } finally {
+      ackListeners.delete(id);
+    }
+  };
+};
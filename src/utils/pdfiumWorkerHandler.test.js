@@ -0,0 +1,275 @@
+/**
+ * Unit tests for the PDFium worker message handler
+ * Tests request dispatch, result transfer, streaming acks and error replies
+ */
+
+import fs from 'fs';
+import path from 'path';
+import { createPdfiumWorkerHandler } from './pdfiumWorkerHandler';
+import { initPdfium } from './pdfiumRemover';
+import { readEncryption } from './pdf/encryption';
+import { getPdfiumArena } from './pdfiumArena';
+import { MEMORY_ERROR_NAME } from './pdfiumPlanner';
+import { WASM32_MAX_HEAP_SIZE } from './pdfiumVariants';
+import { buildPdf } from './pdf/testPdf';
+
+// The @embedpdf/pdfium module is mocked in setupTests.js
+
+describe('createPdfiumWorkerHandler', () => {
+  beforeEach(() => {
+    jest.clearAllMocks();
+  });
+
+  it('should reply to init with a ready result', async () => {
+    const postMessage = jest.fn();
+    const handleMessage = createPdfiumWorkerHandler(postMessage);
+
+    await handleMessage({ data: { id: 1, type: 'init' } });
+
+    expect(postMessage).toHaveBeenCalledWith(
+      {
+        id: 1,
+        type: 'result',
+        result: { ready: true, metrics: expect.objectContaining({ totalMs: expect.any(Number) }) },
+      },
+      [],
+    );
+  });
+
+  it('should transfer the output buffer of a remove request', async () => {
+    const postMessage = jest.fn();
+    const handleMessage = createPdfiumWorkerHandler(postMessage);
+
+    await handleMessage({
+      data: { id: 2, type: 'remove', payload: { pdfData: new ArrayBuffer(100), password: 'pw' } },
+    });
+
+    const [message, transfer] = postMessage.mock.calls[0];
+    expect(message.id).toBe(2);
+    expect(message.type).toBe('result');
+    expect(message.result.buffer).toBeInstanceOf(ArrayBuffer);
+    expect(transfer).toEqual([message.result.buffer]);
+  });
+
+  it('should answer a streamed remove with the byte count instead of a buffer', async () => {
+    const postMessage = jest.fn();
+    const handleMessage = createPdfiumWorkerHandler(postMessage);
+
+    await handleMessage({
+      data: {
+        id: 4,
+        type: 'remove',
+        payload: { pdfData: new ArrayBuffer(100), password: 'pw', stream: true },
+      },
+    });
+
+    const [message, transfer] = postMessage.mock.calls[postMessage.mock.calls.length - 1];
+    expect(message).toEqual({
+      id: 4,
+      type: 'result',
+      result: { size: expect.any(Number), metrics: expect.any(Object) },
+    });
+    expect(transfer).toEqual([]);
+  });
+
+  it('should hold streamed output back until the main thread acks it', async () => {
+    const postMessage = jest.fn();
+    const handleMessage = createPdfiumWorkerHandler(postMessage);
+    // Unencrypted, so it is passed through in 4 MiB slices
+    const data = 'x'.repeat(9 * 1024 * 1024);
+    const stream = `<< /Length ${data.length} >>\nstream\n${data}\nendstream`;
+    const pdfData = new File([buildPdf(['<< /Type /Catalog >>', stream])], 'large.pdf');
+    const payload = { pdfData, password: '', stream: true, streamWindow: 1 };
+    const chunks = () => postMessage.mock.calls.filter(([message]) => message.type === 'chunk');
+    const ackLast = () => {
+      const [[{ chunk }]] = chunks().slice(-1);
+      handleMessage({ data: { id: 8, type: 'ack', payload: { bytes: chunk.byteLength } } });
+    };
+    const settle = () => new Promise((resolve) => setTimeout(resolve, 20));
+
+    const done = handleMessage({ data: { id: 8, type: 'remove', payload } });
+    await settle();
+    expect(chunks()).toHaveLength(1);
+
+    ackLast();
+    await settle();
+    expect(chunks()).toHaveLength(2);
+
+    ackLast();
+    await settle();
+    ackLast();
+    await done;
+    expect(chunks()).toHaveLength(3);
+    expect(postMessage).toHaveBeenLastCalledWith(
+      { id: 8, type: 'result', result: expect.objectContaining({ size: pdfData.size }) },
+      [],
+    );
+  });
+
+  it('should post progress for removes that ask for it', async () => {
+    const postMessage = jest.fn();
+    const handleMessage = createPdfiumWorkerHandler(postMessage);
+
+    const pdfData = new Uint8Array(
+      fs.readFileSync(path.join(process.cwd(), 'e2e/assets/file-sample_150kB-protected.pdf')),
+    ).buffer;
+
+    await handleMessage({
+      data: { id: 6, type: 'remove', payload: { pdfData, password: 'password', progress: true } },
+    });
+
+    const types = postMessage.mock.calls.map(([message]) => message.type);
+    expect(types[0]).toBe('progress');
+    expect(types[types.length - 1]).toBe('result');
+    expect(postMessage).toHaveBeenCalledWith(
+      {
+        id: 6,
+        type: 'progress',
+        progress: expect.objectContaining({ engine: 'strip', bytesTotal: pdfData.byteLength }),
+      },
+      [],
+    );
+  });
+
+  it('should attach the job metrics to remove results', async () => {
+    const postMessage = jest.fn();
+    const handleMessage = createPdfiumWorkerHandler(postMessage);
+
+    await handleMessage({
+      data: { id: 5, type: 'remove', payload: { pdfData: new ArrayBuffer(100), password: 'pw' } },
+    });
+
+    const [{ result }] = postMessage.mock.calls[0];
+    expect(result.metrics).toEqual(
+      expect.objectContaining({ engine: 'pdfium', bytesIn: 100, spans: expect.any(Array) }),
+    );
+    expect(result.metrics.spans.map((span) => span.name)).toEqual(
+      expect.arrayContaining(['copy', 'load', 'save', 'finish']),
+    );
+  });
+
+  it('should serve repeated removes from an open document', async () => {
+    const postMessage = jest.fn();
+    const handleMessage = createPdfiumWorkerHandler(postMessage);
+    const pdfData = new ArrayBuffer(100);
+
+    await handleMessage({ data: { id: 8, type: 'open', payload: { pdfData } } });
+    const [[{ result: opened }]] = postMessage.mock.calls;
+    for (const id of [9, 10]) {
+      await handleMessage({
+        data: { id, type: 'remove', payload: { document: opened.document, password: 'pw' } },
+      });
+    }
+    await handleMessage({
+      data: { id: 11, type: 'close', payload: { document: opened.document } },
+    });
+
+    const messages = postMessage.mock.calls.map(([message]) => message);
+    expect(messages[1].result.metrics.bytesIn).toBe(100);
+    expect(messages[2].result.buffer).toBeInstanceOf(ArrayBuffer);
+    expect(messages[2].result.metrics.spans.map((span) => span.name)).not.toContain('copy');
+    expect(messages[3]).toEqual({ id: 11, type: 'result', result: { closed: true } });
+  });
+
+  it('should ask for a recycle when PDFium traps', async () => {
+    const pdfium = await initPdfium();
+    pdfium.FPDF_LoadMemDocument.mockImplementationOnce(() => {
+      throw new WebAssembly.RuntimeError('memory access out of bounds');
+    });
+    const postMessage = jest.fn();
+    const handleMessage = createPdfiumWorkerHandler(postMessage);
+
+    await handleMessage({
+      data: { id: 6, type: 'remove', payload: { pdfData: new ArrayBuffer(100), password: 'pw' } },
+    });
+
+    expect(postMessage).toHaveBeenCalledWith(
+      expect.objectContaining({ id: 6, type: 'error', recycle: true }),
+      [],
+    );
+  });
+
+  it('should answer key checks without loading the document', async () => {
+    const postMessage = jest.fn();
+    const handleMessage = createPdfiumWorkerHandler(postMessage);
+    const source = fs.readFileSync(
+      path.join(process.cwd(), 'e2e/assets/file-sample_150kB-protected.pdf'),
+    );
+    const encryption = await readEncryption(new Uint8Array(source).buffer);
+    const passwords = ['a', 'password'];
+
+    await handleMessage({
+      data: { id: 7, type: 'checkPasswords', payload: { encryption, passwords } },
+    });
+
+    expect(postMessage).toHaveBeenCalledWith({ id: 7, type: 'result', result: { index: 1 } }, []);
+  });
+
+  it('should answer probes from the trailer and page tree', async () => {
+    const postMessage = jest.fn();
+    const handleMessage = createPdfiumWorkerHandler(postMessage);
+    const source = fs.readFileSync(path.join(process.cwd(), 'e2e/assets/file-sample_150kB.pdf'));
+
+    await handleMessage({
+      data: { id: 8, type: 'probe', payload: { pdfData: new Uint8Array(source).buffer } },
+    });
+
+    expect(postMessage).toHaveBeenCalledWith(
+      {
+        id: 8,
+        type: 'result',
+        result: expect.objectContaining({ pageCount: 4, encrypted: false, encryption: null }),
+      },
+      [],
+    );
+  });
+
+  it('should hand the input back when the heap is too full for it', async () => {
+    const pdfium = await initPdfium();
+    const { memory } = pdfium.pdfium.wasmExports;
+    const reusable = jest.spyOn(getPdfiumArena(pdfium), 'getReusableInputCapacity');
+    reusable.mockReturnValue(0);
+    const buffer = new ArrayBuffer(memory.buffer.byteLength);
+    Object.defineProperty(buffer, 'byteLength', { value: WASM32_MAX_HEAP_SIZE - 1024 });
+    pdfium.pdfium.wasmExports.memory = { buffer };
+    const postMessage = jest.fn();
+    const handleMessage = createPdfiumWorkerHandler(postMessage);
+    const pdfData = new ArrayBuffer(1024);
+
+    try {
+      await handleMessage({
+        data: { id: 12, type: 'remove', payload: { pdfData, password: 'pw', mode: 'pdfium' } },
+      });
+    } finally {
+      pdfium.pdfium.wasmExports.memory = memory;
+      reusable.mockRestore();
+    }
+
+    expect(postMessage).toHaveBeenCalledWith(
+      expect.objectContaining({
+        id: 12,
+        type: 'error',
+        error: expect.objectContaining({ name: MEMORY_ERROR_NAME }),
+        recycle: true,
+        input: pdfData,
+      }),
+      [pdfData],
+    );
+  });
+
+  it('should reply with an error for unknown request types', async () => {
+    const postMessage = jest.fn();
+    const handleMessage = createPdfiumWorkerHandler(postMessage);
+
+    await handleMessage({ data: { id: 3, type: 'explode' } });
+
+    expect(postMessage).toHaveBeenCalledWith(
+      {
+        id: 3,
+        type: 'error',
+        error: { name: 'Error', message: 'Unknown engine request: explode' },
+      },
+      [],
+    );
+  });
+});
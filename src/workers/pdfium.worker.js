@@ -0,0 +1,10 @@
+/**
+ * Dedicated worker hosting one PDFium engine instance
+ * All heavy PDFium calls run here so the UI thread never blocks on a decrypt
+ */
+
+import { createPdfiumWorkerHandler } from '../utils/pdfiumWorkerHandler';
+
+self.onmessage = createPdfiumWorkerHandler((message, transfer) =>
+  self.postMessage(message, transfer),
+);